@@ -0,0 +1,33 @@
+#
+#    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+#
+#	You should have received a copy of the LICENSE-FMUChecker.txt
+#   along with this program. If not, contact Modelon AB.
+#
+
+#   File: FmuCheckExitCode.cmake
+#   Exit code test script, run by CTest with "cmake -P".
+#
+#   Runs the checker with the space separated ARGS on an FMU and fails unless
+#   it exits with EXIT_CODE. The checker output is only printed when the exit
+#   code is the expected one, so that a PASS_REGULAR_EXPRESSION on the test
+#   checks both.
+#
+#   Parameters (-D): CHECKER, FMU, ARGS, EXIT_CODE.
+
+foreach(param CHECKER FMU EXIT_CODE)
+	if(NOT DEFINED ${param})
+		message(FATAL_ERROR "${param} must be defined")
+	endif()
+endforeach()
+
+separate_arguments(args UNIX_COMMAND "${ARGS}")
+execute_process(
+	COMMAND ${CHECKER} ${args} ${FMU}
+	RESULT_VARIABLE checker_result
+	OUTPUT_VARIABLE checker_output
+	ERROR_VARIABLE checker_output)
+if(NOT checker_result EQUAL EXIT_CODE)
+	message(FATAL_ERROR "Checker exited with ${checker_result}, expected ${EXIT_CODE}")
+endif()
+message("${checker_output}")
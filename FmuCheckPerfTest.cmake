@@ -0,0 +1,126 @@
+#
+#    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+#
+#	You should have received a copy of the LICENSE-FMUChecker.txt
+#   along with this program. If not, contact Modelon AB.
+#
+
+#   File: FmuCheckPerfTest.cmake
+#   Performance regression test script, run by CTest with "cmake -P".
+#
+#   Runs the checker on an FMU with --stats and compares the wall clock time,
+#   the number of FMI calls (reported by the synthetic test FMUs) and the peak
+#   resident set size with the JSON baseline. The test fails if a metric is
+#   more than TOLERANCE percent above the baseline. Time differences below
+#   MIN_TIME_MS and memory differences below MIN_RSS_KB are ignored.
+#   The baseline is written if it does not exist or if the environment
+#   variable FMUCHK_PERF_UPDATE_BASELINE is set.
+#
+#   Parameters (-D): CHECKER, FMU, NAME, OUT_DIR, BASELINE, TOLERANCE,
+#   MIN_TIME_MS, MIN_RSS_KB.
+
+foreach(param CHECKER FMU NAME OUT_DIR BASELINE)
+	if(NOT DEFINED ${param})
+		message(FATAL_ERROR "${param} must be defined")
+	endif()
+endforeach()
+if(NOT DEFINED TOLERANCE)
+	set(TOLERANCE 25)
+endif()
+if(NOT DEFINED MIN_TIME_MS)
+	set(MIN_TIME_MS 100)
+endif()
+if(NOT DEFINED MIN_RSS_KB)
+	set(MIN_RSS_KB 1024)
+endif()
+
+set(stats_file ${OUT_DIR}/${NAME}_stats.json)
+set(calls_file ${OUT_DIR}/${NAME}_calls.txt)
+set(result_file ${OUT_DIR}/${NAME}.json)
+file(REMOVE ${stats_file} ${calls_file})
+
+execute_process(
+	COMMAND ${CMAKE_COMMAND} -E env FMUCHK_SYNTHETIC_CALLS_FILE=${calls_file}
+		${CHECKER} --stats ${stats_file} -o ${OUT_DIR}/${NAME}.csv -e ${OUT_DIR}/${NAME}.log ${FMU}
+	WORKING_DIRECTORY ${OUT_DIR}
+	RESULT_VARIABLE checker_result)
+if(NOT checker_result EQUAL 0)
+	message(FATAL_ERROR "Checker failed (${checker_result}), see ${OUT_DIR}/${NAME}.log")
+endif()
+if(NOT EXISTS ${stats_file})
+	message(FATAL_ERROR "Checker did not write ${stats_file}")
+endif()
+
+# Seconds with (at least) three decimals from the stats file converted to milliseconds
+function(read_stats_ms json key variable)
+	string(REGEX MATCH "\"${key}\": ([0-9]+)\\.([0-9][0-9][0-9])" match "${json}")
+	if(NOT match)
+		message(FATAL_ERROR "No ${key} in ${stats_file}")
+	endif()
+	math(EXPR ms "${CMAKE_MATCH_1} * 1000 + ${CMAKE_MATCH_2}")
+	set(${variable} ${ms} PARENT_SCOPE)
+endfunction()
+
+# Integer value from a JSON object written by the checker or by this script
+function(read_json_int json key variable)
+	string(REGEX MATCH "\"${key}\": ([0-9]+)" match "${json}")
+	if(match)
+		set(${variable} ${CMAKE_MATCH_1} PARENT_SCOPE)
+	else()
+		set(${variable} "" PARENT_SCOPE)
+	endif()
+endfunction()
+
+file(READ ${stats_file} stats)
+read_stats_ms("${stats}" wall_time wall_time_ms)
+read_stats_ms("${stats}" cpu_time cpu_time_ms)
+read_json_int("${stats}" peak_rss_kb peak_rss_kb)
+
+# One line per FMU instance
+set(fmi_calls 0)
+if(EXISTS ${calls_file})
+	file(STRINGS ${calls_file} calls_lines)
+	foreach(n ${calls_lines})
+		math(EXPR fmi_calls "${fmi_calls} + ${n}")
+	endforeach()
+endif()
+
+set(result
+"{
+	\"fmu\": \"${FMU}\",
+	\"wall_time_ms\": ${wall_time_ms},
+	\"cpu_time_ms\": ${cpu_time_ms},
+	\"peak_rss_kb\": ${peak_rss_kb},
+	\"fmi_calls\": ${fmi_calls}
+}
+")
+file(WRITE ${result_file} "${result}")
+message(STATUS "${NAME}: ${wall_time_ms} ms, ${cpu_time_ms} ms CPU, ${peak_rss_kb} kB peak RSS, ${fmi_calls} FMI calls")
+
+if(NOT EXISTS ${BASELINE} OR NOT "$ENV{FMUCHK_PERF_UPDATE_BASELINE}" STREQUAL "")
+	file(WRITE ${BASELINE} "${result}")
+	message(STATUS "Baseline written to ${BASELINE}")
+	return()
+endif()
+
+file(READ ${BASELINE} baseline)
+set(regressions)
+set(min_diff_wall_time_ms ${MIN_TIME_MS})
+set(min_diff_fmi_calls 0)
+set(min_diff_peak_rss_kb ${MIN_RSS_KB})
+foreach(metric wall_time_ms fmi_calls peak_rss_kb)
+	read_json_int("${baseline}" ${metric} base)
+	if(NOT base STREQUAL "")
+		set(current ${${metric}})
+		math(EXPR limit "${base} + ${base} * ${TOLERANCE} / 100")
+		math(EXPR diff "${current} - ${base}")
+		if(current GREATER limit AND diff GREATER min_diff_${metric})
+			set(regressions "${regressions}\n  ${metric}: ${current} (baseline ${base}, limit ${limit})")
+		endif()
+	endif()
+endforeach()
+
+if(regressions)
+	message(FATAL_ERROR "Performance regression against ${BASELINE}:${regressions}\n"
+		"Set FMUCHK_PERF_UPDATE_BASELINE=1 when running ctest to accept the new values.")
+endif()
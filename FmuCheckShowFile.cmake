@@ -0,0 +1,25 @@
+#
+#    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+#
+#	You should have received a copy of the LICENSE-FMUChecker.txt
+#   along with this program. If not, contact Modelon AB.
+#
+
+#   File: FmuCheckShowFile.cmake
+#   Output file test script, run by CTest with "cmake -P".
+#
+#   Prints the contents of FILE so that the PASS_REGULAR_EXPRESSION and
+#   FAIL_REGULAR_EXPRESSION properties of the test can check what the
+#   checker wrote. Fails if the file does not exist.
+#
+#   Parameters (-D): FILE.
+
+if(NOT DEFINED FILE)
+	message(FATAL_ERROR "FILE must be defined")
+endif()
+if(NOT EXISTS ${FILE})
+	message(FATAL_ERROR "${FILE} does not exist")
+endif()
+
+file(READ ${FILE} contents)
+message("${contents}")
@@ -0,0 +1,102 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmi2_column_plan.h
+	Selection of the FMI 2.0 variables written to the output file (--vars option).
+
+	The output columns are resolved once after the model description is parsed.
+	By default the outputs (or all variables with -f) are written, but all
+	variables are read at each output point so that a get call that does not
+	return OK is reported for any variable. With --vars only the variables whose
+	names match one of the patterns are read and written.
+	A pattern may use '*' (any sequence of characters) and '?' (any single
+	character); all other characters, including brackets, match literally.
+	The columns are kept in the order of the model variables.
+
+	The plan is read-only during the simulation and also serves as the row
+	formatter: the values of a row are read with one get call per value type
+	and formatted into a line buffer that is written with a single call.
+*/
+
+#ifndef fmi2_column_plan_h
+#define fmi2_column_plan_h
+
+#include <fmilib.h>
+
+/** One output column */
+typedef struct fmi2_column_t {
+	fmi2_import_variable_t* var;
+	fmi2_base_type_enu_t type;
+	fmi2_value_reference_t vr;
+	/** Index of the column among the columns of the same value type (enumerations count as integers) */
+	size_t index;
+	/** Declared type of an enumeration column (NULL otherwise) */
+	fmi2_import_enumeration_typedef_t* enumType;
+	/** Column name as written to the header: separator excluded, quoted or mangled (-m).
+		NULL for a column that is only read. */
+	const char* header;
+} fmi2_column_t;
+
+/** Output columns of an FMU with the value references grouped by value type */
+typedef struct fmi2_column_plan_t {
+	/** Number of columns written to the output file, they come first in cols */
+	size_t numCols;
+	/** Number of columns read at each output point, numCols or more */
+	size_t numReadCols;
+	fmi2_column_t* cols;
+
+	size_t numReals, numInts, numBools, numStrs;
+	fmi2_value_reference_t* vrReals;
+	/** Integer and enumeration value references */
+	fmi2_value_reference_t* vrInts;
+	fmi2_value_reference_t* vrBools;
+	fmi2_value_reference_t* vrStrs;
+} fmi2_column_plan_t;
+
+/** Values of the output columns at one time point, indexed by fmi2_column_t.index */
+typedef struct fmi2_column_values_t {
+	fmi2_real_t* reals;
+	/** Integer and enumeration values */
+	fmi2_integer_t* ints;
+	fmi2_boolean_t* bools;
+	/** String values (owned by the FMU or the caller) */
+	fmi2_string_t* strs;
+} fmi2_column_values_t;
+
+/** Per-instance buffers for writing output rows. Set up on first use. */
+typedef struct fmi2_row_writer_t {
+	int setUp;
+	fmi2_column_values_t values;
+	/** Line buffer, grows when a row with longer strings is written */
+	char* line;
+	size_t lineSize;
+} fmi2_row_writer_t;
+
+/**
+	Build the output column plan of cdata->fmu2 from cdata->vl2 into cdata->fmu2_columns.
+	Memory is taken from the checker arena. Patterns that match no variable are reported
+	as warnings.
+*/
+jm_status_enu_t fmi2_build_column_plan(fmu_check_data_t* cdata);
+
+/** Allocate value buffers for the columns of the plan from the arena */
+jm_status_enu_t fmi2_alloc_column_values(fmu_check_data_t* cdata, fmi2_column_values_t* values);
+
+/**
+	Read the values of all the columns of the plan, also the ones that are not written, with
+	one get call per value type. If a call does not return OK the values of that type are
+	read one by one to report the variables.
+*/
+void fmi2_read_column_values(fmu_check_data_t* cdata, fmi2_column_values_t* values);
+
+/** Format the row for the given time and values into the line buffer of cdata->fmu2_row and write it */
+jm_status_enu_t fmi2_write_csv_row(fmu_check_data_t* cdata, double time, const fmi2_column_values_t* values);
+
+/** Match a variable name against a pattern with '*' and '?' wildcards */
+int fmi2_column_pattern_match(const char* pattern, const char* name);
+
+#endif
@@ -0,0 +1,70 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmi2_determinism.h
+	Determinism check of FMI 2.0 simulations (--determinism option).
+
+	The simulation is run again with a new instance (and with
+	--determinism-reset once more after fmi2Reset) and the output rows are
+	compared bitwise with the first run. The first run writes the output
+	file as usual and keeps the time and the bits of each numeric value per
+	row (a 64-bit hash for strings); the later runs only compare their rows
+	and report the first time and variable that differ.
+*/
+
+#ifndef fmi2_determinism_h
+#define fmi2_determinism_h
+
+#include <fmilib.h>
+
+/** What is done with the output rows */
+typedef enum fmi2_determinism_mode_enu_t {
+	/** Rows are only written (no determinism check) */
+	fmi2_determinism_off = 0,
+	/** Rows are written and their values kept */
+	fmi2_determinism_record,
+	/** Rows are compared with the kept values and not written */
+	fmi2_determinism_compare
+} fmi2_determinism_mode_enu_t;
+
+/** Rows of the first run and the state of the comparison */
+typedef struct fmi2_determinism_t {
+	fmi2_determinism_mode_enu_t mode;
+
+	/** Rows kept from the first run */
+	size_t numRows;
+	size_t capacity;
+	double* times;
+	/** Bits of each column value (hash of a string), numCols per row */
+	unsigned long long* cells;
+	size_t numCols;
+	/** Set if memory for the rows could not be allocated */
+	int outOfMemory;
+
+	/** Rows of the current run that were compared */
+	size_t row;
+	/** First difference in the current run */
+	int diverged;
+	double divergedTime;
+	/** Column that differs, -1 for the time */
+	long divergedCol;
+} fmi2_determinism_t;
+
+/**
+	Run the simulation of the loaded FMU kind (fmi2_fmu_kind_me or
+	fmi2_fmu_kind_cs) repeatedly and compare the outputs. Differences
+	are logged as errors. Returns the status of the simulations.
+*/
+jm_status_enu_t fmi2_determinism_check(fmu_check_data_t* cdata, fmi2_fmu_kind_enu_t kind);
+
+/** Keep or compare an output row (called by fmi2_write_csv_row()) */
+void fmi2_determinism_row(fmu_check_data_t* cdata, double time, const fmi2_column_values_t* values);
+
+/** Release the kept rows */
+void fmi2_determinism_free(fmu_check_data_t* cdata);
+
+#endif
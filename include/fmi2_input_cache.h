@@ -0,0 +1,43 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmi2_input_cache.h
+	Binary cache of parsed FMI 2.0 input files (--input-cache switch).
+
+	After an input file is parsed the data are saved next to it in
+	<input file>.fmuchk: a header identifying the source file (size,
+	modification time and a hash of its first and last blocks), the input
+	variables by name, value reference and type, the time stamps and the
+	real, integer and boolean values, each type as one block of rows.
+	Later runs map the cache file into memory and use the rows in place
+	instead of parsing the input file again.
+*/
+
+#ifndef fmi2_input_cache_h
+#define fmi2_input_cache_h
+
+/** Extension appended to the input file name */
+#define FMI2_INPUT_CACHE_EXT ".fmuchk"
+
+/** Opaque memory mapped cache file */
+typedef struct fmi2_input_cache_map_t fmi2_input_cache_map_t;
+
+/**
+	Load the input data of cdata->inputFileName from a valid cache file.
+	Returns jm_status_success if the data were loaded into cdata->fmu2_inputData,
+	jm_status_warning if there is no valid cache file (the input file must then
+	be parsed) and jm_status_error on failure.
+*/
+jm_status_enu_t fmi2_input_cache_load(fmu_check_data_t* cdata);
+
+/** Save the parsed input data of cdata->inputFileName. Failures are reported as warnings. */
+void fmi2_input_cache_save(fmu_check_data_t* cdata);
+
+/** Unmap a cache file loaded by fmi2_input_cache_load() */
+void fmi2_input_cache_unmap(fmi2_input_cache_map_t* map);
+
+#endif
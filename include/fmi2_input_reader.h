@@ -15,6 +15,8 @@
 
 #include <JM/jm_vector.h>
 #include <fmilib.h>
+#include "fmi2_input_stream.h"
+#include "fmi2_input_cache.h"
 
 /** Structure incapsulating information on input data*/
 typedef struct fmi2_csv_input_t {
@@ -58,6 +60,14 @@ typedef struct fmi2_csv_input_t {
 	size_t eventIndex1; /** first data element index for interpolation */
 	size_t eventIndex2; /** first data element index for interpolation */
 
+	/** Streaming reader (--stream-input switch). The data rows are then kept in its window
+	    instead of the vectors above and the indices above are absolute row numbers. */
+	fmi2_input_stream_t* stream;
+	/** Set if the input data could not be read during the simulation */
+	int readError;
+	/** Mapped cache file holding the data rows if they were loaded from the cache (--input-cache switch) */
+	fmi2_input_cache_map_t* cacheMap;
+
 } fmi2_csv_input_t;
 
 //typedef struct fmu_check_data_t fmu_check_data_t;
@@ -71,6 +81,9 @@ void fmi2_free_input_data(fmi2_csv_input_t* indata);
 /** update the interpolation coefficients inside the input data */
 void fmi2_update_input_interpolation(fmi2_csv_input_t* indata, double t);
 
+/** go back to the first time stamp so that the input data can be used for another simulation run */
+void fmi2_rewind_input_data(fmi2_csv_input_t* indata);
+
 /** set inputs on the fmu */ 
 fmi2_status_t fmi2_set_inputs(fmu_check_data_t* cdata, double time);
 
@@ -79,4 +92,20 @@ jm_status_enu_t fmi2_read_input_file( fmu_check_data_t* cdata);
 
 /** check input data interval for event trigger from data */
 jm_status_enu_t fmi2_check_external_events(fmi2_real_t tcur, fmi2_real_t tnext,fmi2_event_info_t* eventInfo,fmi2_csv_input_t* indata);
+
+/** check if there are input data */
+int fmi2_input_has_data(fmi2_csv_input_t* indata);
+
+/** integer and boolean input values at the current interpolation time */
+const fmi2_integer_t* fmi2_input_discrete_ints(fmi2_csv_input_t* indata);
+const fmi2_boolean_t* fmi2_input_discrete_bools(fmi2_csv_input_t* indata);
+
+/**
+	Parse one data line of an input file: the time and the values of allInputs.
+	Returns 1 if a row was read and 0 if there are no more rows. Returns -1 if a value
+	could not be parsed and -2 if a separator is missing (the rest of the row is not set);
+	*badVar is then the index of the variable in allInputs.
+*/
+int fmi2_parse_input_row(FILE* infile, char sep, fmi2_import_variable_list_t* allInputs, double* time,
+						 fmi2_real_t* realData, fmi2_integer_t* intData, fmi2_boolean_t* boolData, size_t* badVar);
 #endif
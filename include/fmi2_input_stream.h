@@ -0,0 +1,76 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmi2_input_stream.h
+	Streaming reader for FMI 2.0 input files (--stream-input switch).
+
+	Instead of loading the whole input file before the simulation the rows
+	are parsed by a background thread into a window of rows. The window holds
+	the rows from the interpolation cursor and the rows read ahead of it.
+	Rows before the cursor are dropped as the simulation time advances, which
+	makes room for the reader. The window only grows if a single simulation
+	step spans more rows than fit into it.
+
+	Rows are addressed with absolute indices (0 is the first data line of the
+	file) so that the cursors of the input reader stay valid while rows are
+	dropped.
+*/
+
+#ifndef fmi2_input_stream_h
+#define fmi2_input_stream_h
+
+#include <stdio.h>
+#include <fmilib.h>
+
+/** Initial number of rows in the window */
+#define FMI2_INPUT_STREAM_WINDOW_ROWS 4096
+
+/** Opaque streaming reader */
+typedef struct fmi2_input_stream_t fmi2_input_stream_t;
+
+/**
+	Start reading the data lines of an input file in a background thread.
+	The file must be positioned after the header and is closed by the stream.
+	The values of each line are read in the order of allInputs, which must
+	stay valid while the stream is open.
+	Returns NULL (after logging an error) on failure. The file is closed
+	in that case too.
+*/
+fmi2_input_stream_t* fmi2_input_stream_open(jm_callbacks* cb, FILE* infile, char sep, fmi2_import_variable_list_t* allInputs,
+											size_t numReals, size_t numInts, size_t numBools);
+
+/** Stop the reader thread, log the statistics and release the stream */
+void fmi2_input_stream_close(fmi2_input_stream_t* s);
+
+/**
+	Wait until the window holds a row with a time after t or the last row of the file.
+	Logs the problems reported by the reader. Returns jm_status_error if the data
+	could not be read up to that row.
+	On success *endRow is set to the absolute index after the last row in the window and
+	*complete is set if that is the last row of the file.
+*/
+jm_status_enu_t fmi2_input_stream_fill(fmi2_input_stream_t* s, double t, size_t* endRow, int* complete);
+
+/** Drop the rows before the given absolute row index from the window */
+void fmi2_input_stream_release(fmi2_input_stream_t* s, size_t row);
+
+/** Read the file again from the first data line */
+jm_status_enu_t fmi2_input_stream_restart(fmi2_input_stream_t* s);
+
+/** Absolute index of the first row in the window */
+size_t fmi2_input_stream_first_row(fmi2_input_stream_t* s);
+
+/** Time of the first row of the file. Only valid after a successful fmi2_input_stream_fill() returned rows. */
+double fmi2_input_stream_start_time(fmi2_input_stream_t* s);
+
+/** Values of a row in the window. The row must be in the range returned by the last fmi2_input_stream_fill(). */
+double fmi2_input_stream_time(fmi2_input_stream_t* s, size_t row);
+fmi2_real_t* fmi2_input_stream_reals(fmi2_input_stream_t* s, size_t row);
+fmi2_integer_t* fmi2_input_stream_ints(fmi2_input_stream_t* s, size_t row);
+fmi2_boolean_t* fmi2_input_stream_bools(fmi2_input_stream_t* s, size_t row);
+
+#endif
@@ -0,0 +1,35 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmi2_multi_instance.h
+	Concurrent multi-instance check of FMI 2.0 CS FMUs (--instances option).
+
+	The standard allows separate instances of an FMU to run concurrently, but
+	an FMU that keeps state in global variables breaks when they do. After the
+	simulation the FMU is loaded K times, each from its own import of the
+	unpacked FMU, and the instances are simulated concurrently, one thread per
+	instance. A first run with a single instance on the checker thread is the
+	reference: the values read for the output file (see fmi2_column_plan.h) of
+	every instance are compared bitwise with it after each communication
+	step, and a difference is reported as a possible data race between the
+	instances.
+
+	The runs use 1, 2, 4, ... and K instances and the throughput (communication
+	steps per second over all instances) of each run is reported as a scaling
+	curve. Inputs (-i) are not set and string outputs are not compared.
+*/
+
+#ifndef fmi2_multi_instance_h
+#define fmi2_multi_instance_h
+
+/** Largest number of instances (--instances) */
+#define FMI2_MULTI_INSTANCE_MAX 1024
+
+/** Run the check with cdata->numInstances instances of the CS FMU in cdata->tmpPath */
+jm_status_enu_t fmi2_multi_instance_check(fmu_check_data_t* cdata);
+
+#endif
@@ -0,0 +1,170 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmi2_reference.h
+	Comparison of the FMI 2.0 simulation output with a reference result (--reference option).
+
+	The reference file is a CSV file with the time in the first column and
+	the variable names in the header, as written by the checker. Reference
+	columns are matched by name with the output columns (see --vars and -f).
+	Each output row is compared with the reference while simulating:
+
+	- The tolerance of a signal is absTol + relTol * (largest absolute
+	  reference value, 1 if the reference is zero). The tolerances may be
+	  given per signal (--ref-tol).
+	- Around each output time t the reference values in [t - w, t + w] are
+	  taken, including the values interpolated at both ends (tube method).
+	  A value passes if it is within the tolerance of the smallest and the
+	  largest of them, so small time shifts of discontinuities do not fail.
+	  The half width w is a fraction of the reference time span (--ref-tube).
+	- Rows outside of the reference time span are not compared.
+
+	The reference is stored row by row so that the bounds of all signals are
+	updated in tight loops over contiguous values.
+
+	For FMUs with both ME and CS the ME output can be kept in memory and used
+	as the reference of the CS output in the same check (--compare-me-cs).
+	The same tolerances and tube apply. When the CS run is on another thread
+	(see fmi2_reference_share()), each CS row waits until the ME output has
+	passed its tube. The ME time span is not known then, so the tube width is
+	relative to the simulated time span and the tolerance to the largest
+	absolute ME value kept so far.
+*/
+
+#ifndef fmi2_reference_h
+#define fmi2_reference_h
+
+#include <fmilib.h>
+
+/** Default relative tolerance (--ref-tol) */
+#define FMI2_REFERENCE_DEFAULT_REL_TOL 1e-3
+/** Default tube half width relative to the reference time span (--ref-tube) */
+#define FMI2_REFERENCE_DEFAULT_TUBE 1e-3
+
+/** What is done with the output rows */
+typedef enum fmi2_reference_mode_enu_t {
+	fmi2_reference_off,
+	/** Keep the rows as the reference (--compare-me-cs, ME run) */
+	fmi2_reference_record,
+	/** Compare the rows with the reference */
+	fmi2_reference_compare
+} fmi2_reference_mode_enu_t;
+
+/** Lock and progress of kept output shared with another thread */
+typedef struct fmi2_reference_shared_t fmi2_reference_shared_t;
+
+/** One compared signal and its result */
+typedef struct fmi2_reference_signal_t {
+	/** Output column of the signal */
+	const fmi2_column_t* col;
+	double relTol;
+	double absTol;
+
+	/** Values outside of the tube in the current run */
+	size_t numViolations;
+	/** First violation */
+	double firstTime;
+	double firstValue;
+	double firstLow;
+	double firstHigh;
+	/** Largest distance outside of the tube */
+	double maxDeviation;
+} fmi2_reference_signal_t;
+
+/** Reference data and the state of the comparison */
+typedef struct fmi2_reference_t {
+	fmi2_reference_mode_enu_t mode;
+	size_t numRows;
+	size_t numSignals;
+	double* times;
+	/** Reference values, numSignals per row */
+	double* values;
+	fmi2_reference_signal_t* signals;
+	/** Absolute tolerance of each signal */
+	double* tol;
+	/** Tube half width in seconds */
+	double tubeWidth;
+	/** Allocated rows of kept output (zero for a loaded reference, which is in the arena) */
+	size_t capacity;
+	/** Set if the output could not be kept */
+	int outOfMemory;
+
+	/** Output kept by another thread that is compared while it grows, NULL otherwise */
+	struct fmi2_reference_t* source;
+	/** Set for both the kept and the compared output while they are shared */
+	fmi2_reference_shared_t* shared;
+	/** Largest absolute value of each signal in the first numNominalRows rows of the source */
+	double* nominal;
+	size_t numNominalRows;
+
+	/** Work arrays for one output row */
+	double* sample;
+	double* low;
+	double* high;
+	double* interp;
+
+	/** First reference row that may be in the tube of the next output row */
+	size_t cursor;
+	/** Output rows compared in the current run */
+	size_t numCompared;
+	/** Violations of all signals in the current run */
+	size_t numViolations;
+} fmi2_reference_t;
+
+/**
+	Read the reference file (cdata->referenceFileName) and match its columns with
+	the output columns. Memory is taken from the checker arena.
+*/
+jm_status_enu_t fmi2_reference_load(fmu_check_data_t* cdata);
+
+/**
+	Start keeping the output rows as the reference. All the numeric output columns
+	are compared, with the tolerances given by --ref-tol.
+*/
+jm_status_enu_t fmi2_reference_record_start(fmu_check_data_t* cdata);
+
+/**
+	Stop keeping the output and compare the following rows with it. The argument
+	names the kept output in messages. Returns jm_status_error if nothing was kept.
+*/
+jm_status_enu_t fmi2_reference_record_end(fmu_check_data_t* cdata, const char* what);
+
+/**
+	Compare the output of the check data "other" with the output kept by cdata on
+	another thread. Called after fmi2_reference_record_start() and before the
+	threads start. The comparison of "other" is started.
+*/
+jm_status_enu_t fmi2_reference_share(fmu_check_data_t* cdata, fmu_check_data_t* other);
+
+/** No more output is kept: the rows still waiting are compared with what there is */
+void fmi2_reference_share_end(fmu_check_data_t* cdata);
+
+/** Release the shared state after both threads are done */
+void fmi2_reference_unshare(fmu_check_data_t* cdata, fmu_check_data_t* other);
+
+/** Reset the comparison for a new simulation run */
+void fmi2_reference_start(fmu_check_data_t* cdata);
+
+/**
+	Compare an output row with the reference (or keep it). Returns jm_status_error to
+	stop the simulation when the number of violations reaches --ref-max-violations.
+*/
+jm_status_enu_t fmi2_reference_row(fmu_check_data_t* cdata, double time, const fmi2_column_values_t* values);
+
+/**
+	Log the result of each signal and the first difference. The title starts the
+	messages, e.g., "ME reference comparison". Returns jm_status_error if a signal failed.
+*/
+jm_status_enu_t fmi2_reference_report(fmu_check_data_t* cdata, const char* title);
+
+/** Check if the output is only compared with the reference and not written (--reference without -o) */
+int fmi2_reference_only(fmu_check_data_t* cdata);
+
+/** Free the kept output */
+void fmi2_reference_free(fmu_check_data_t* cdata);
+
+#endif
@@ -0,0 +1,70 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmi2_resample.h
+	Resampling of the FMI 2.0 simulation output onto a fixed time grid (--resample option).
+
+	Without resampling an output row is written at the first step at or after
+	each output time. With resampling the outputs are read at every step and
+	the rows are written at the exact output times: real values are linearly
+	interpolated between the two surrounding steps and discrete values
+	(integer, boolean, enumeration and string) hold the value of the earlier
+	step. The grid has maxOutputPts intervals from the start time to the stop
+	time (see the -n option).
+*/
+
+#ifndef fmi2_resample_h
+#define fmi2_resample_h
+
+#include <fmilib.h>
+
+/** Output values at one step */
+typedef struct fmi2_resample_sample_t {
+	double time;
+	fmi2_real_t* reals;
+	/** Integer and enumeration values */
+	fmi2_integer_t* ints;
+	fmi2_boolean_t* bools;
+	/** Offsets of the string values in strBuf */
+	size_t* strOffsets;
+	char* strBuf;
+	size_t strBufSize;
+} fmi2_resample_sample_t;
+
+/** Resampling state of one simulation run */
+typedef struct fmi2_resample_t {
+	/** Buffers are set up on the first sample. The columns are taken from the output column plan. */
+	int setUp;
+	/** Set when the current run has at least one sample */
+	int haveSample;
+
+	/** Values of the row being written (interpolated reals and the strings of the sample).
+		The strings returned by the FMU are also read here before they are copied to the sample. */
+	fmi2_column_values_t row;
+
+	/** Samples of the previous and the current step (point into samples) */
+	fmi2_resample_sample_t* prev;
+	fmi2_resample_sample_t* cur;
+	fmi2_resample_sample_t samples[2];
+
+	/** Output grid */
+	double gridStart;
+	double gridEnd;
+	size_t gridPoints;
+	size_t nextGridPoint;
+} fmi2_resample_t;
+
+/** Start resampling for a new simulation run. The first sample defines the start of the grid. */
+void fmi2_resample_start(fmu_check_data_t* cdata);
+
+/** Check if the output of the current run is resampled (--resample option with output points) */
+int fmi2_resample_enabled(fmu_check_data_t* cdata);
+
+/** Read the outputs at the given time and write the rows for the grid points up to that time */
+jm_status_enu_t fmi2_resample_write(fmu_check_data_t* cdata, double time);
+
+#endif
@@ -0,0 +1,30 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmi2_state_cache.h
+	Cache of serialized FMU states after initialization (--state-cache option).
+*/
+
+#ifndef fmi2_state_cache_h
+#define fmi2_state_cache_h
+
+#include <fmilib.h>
+
+/**
+	Set the inputs and parameters for the start time and initialize the FMU
+	instance (fmi2SetupExperiment, fmi2EnterInitializationMode and
+	fmi2ExitInitializationMode). The FMU type selects the capability flags
+	that are checked.
+
+	With a state cache directory (cdata->stateCacheDir) and an FMU that can
+	serialize its state, the state after initialization is saved in the cache.
+	Later runs with the same GUID, start time, tolerance, parameter values and
+	start inputs restore the saved state instead of initializing again.
+*/
+fmi2_status_t fmi2_initialize_fmu(fmu_check_data_t* cdata, fmi2_type_t fmuType, fmi2_boolean_t toleranceControlled, fmi2_real_t relativeTolerance, fmi2_real_t tstart);
+
+#endif
@@ -0,0 +1,46 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmi2_sweep.h
+	Parameter sets for the parameter sweep mode (--sweep option).
+*/
+
+#ifndef fmi2_sweep_h
+#define fmi2_sweep_h
+
+#include <fmilib.h>
+
+/** Parameter sets read from the parameter file. Values are stored row by row. */
+typedef struct fmi2_param_sets_t {
+	/** Number of parameter sets (rows) */
+	size_t numSets;
+
+	size_t numReal;
+	fmi2_value_reference_t* realVr;
+	fmi2_real_t* realValues;
+
+	/** Integers and enumerations */
+	size_t numInt;
+	fmi2_value_reference_t* intVr;
+	fmi2_integer_t* intValues;
+
+	size_t numBool;
+	fmi2_value_reference_t* boolVr;
+	fmi2_boolean_t* boolValues;
+} fmi2_param_sets_t;
+
+/** Set the values of the current parameter set (cdata->fmu2_param_set) on the FMU. Does nothing outside a sweep. */
+fmi2_status_t fmi2_set_parameters(fmu_check_data_t* cdata);
+
+/**
+	Get an FMU instance for a simulation run. An instance kept from the
+	previous run (see fmu2_reuse_instance) is reset with fmi2Reset,
+	otherwise a new instance is created.
+*/
+jm_status_enu_t fmi2_instantiate_or_reset(fmu_check_data_t* cdata, fmi2_string_t instanceName, fmi2_type_t fmuType, fmi2_boolean_t visible);
+
+#endif
@@ -18,6 +18,23 @@
 
 #include "fmi1_input_reader.h"
 #include "fmi2_input_reader.h"
+#include "fmi2_sweep.h"
+#include "fmi2_state_cache.h"
+#include "fmi2_column_plan.h"
+#include "fmi2_resample.h"
+#include "fmi2_determinism.h"
+#include "fmi2_reference.h"
+#include "fmi2_multi_instance.h"
+#include "fmu_check_log_filter.h"
+#include "fmu_check_arena.h"
+#include "fmu_check_thread.h"
+#include "fmu_check_stats.h"
+#include "fmu_check_watchdog.h"
+#include "fmu_check_realtime.h"
+#include "fmu_check_stream.h"
+#include "fmu_check_input_chunks.h"
+#include "fmu_check_zip.h"
+#include "fmu_check_unpack.h"
 
 /** string constant used for logging. */
 extern const char* fmu_checker_module;
@@ -68,8 +85,13 @@ struct fmu_check_data_t {
 	/** A flag that makes instance name error appear only once */
 	int printed_instance_name_error_flg;
 
+	/** Filter for repeated FMU log messages (-r switch) */
+	fmu_check_log_filter_t fmu_log_filter;
+
 	/** FMIL callbacks*/
 	jm_callbacks callbacks;
+	/** Arena for the memory owned by the checker. Released in clear_fmu_check_data() */
+	fmu_check_arena_t arena;
 	/** FMIL context */
 	fmi_import_context_t* context;
 
@@ -100,6 +122,24 @@ struct fmu_check_data_t {
     double nextOutputTime;
     /** Next output step number*/
     double nextOutputStep;
+	/** Interpolate the output onto the output time grid instead of taking the steps (--resample switch) */
+	int resampleOutput;
+	/** Simulate again and compare the output bitwise: 1 with a new instance, 2 also after fmi2Reset (--determinism and --determinism-reset switches) */
+	int determinism;
+	/** Reference result file the output is compared with (--reference switch, NULL for none) */
+	const char* referenceFileName;
+	/** Tolerances for the reference comparison: "<relTol>[,<absTol>]" or "@<file>" (--ref-tol switch, NULL for defaults) */
+	const char* referenceTolSpec;
+	/** Tube half width relative to the reference time span (--ref-tube switch) */
+	double referenceTube;
+	/** Stop the simulation after this many violations of the reference. Zero means no limit (--ref-max-violations switch) */
+	size_t referenceMaxViolations;
+	/** Compare the CS output with the ME output (--compare-me-cs switch) */
+	int compareMeCs;
+	/** Largest number of concurrent instances in the multi-instance check, 0 for no check (--instances switch) */
+	size_t numInstances;
+	/** Variable name patterns or @file selecting the output variables (--vars switch, NULL for default) */
+	const char* outputVarsSpec;
 	/** separator character to use */
 	char CSV_separator;
 
@@ -114,13 +154,53 @@ struct fmu_check_data_t {
 	char* output_file_name;
 	/** Output file stream */
 	FILE* out_file;
+	/** Compressed output file (.gz or .zst output file name), used instead of out_file */
+	fmu_check_stream_t* out_stream;
 	/** Name of the log file (NULL is stderr)*/
 	char* log_file_name;
 	/** Log file stream */
 	FILE* log_file;
+	/** Compressed log file (.gz or .zst log file name), used instead of log_file */
+	fmu_check_stream_t* log_stream;
 
     /** input data file name */
     char* inputFileName;
+	/** Read the FMI 2.0 input file during the simulation keeping only a window of rows in memory (--stream-input switch) */
+	int streamInput;
+	/** Keep the parsed FMI 2.0 input data in a binary cache file next to the input file (--input-cache switch) */
+	int inputCache;
+	/** Smallest chunk of the input file parsed by one thread (undocumented --input-chunk-size switch used by the tests) */
+	size_t inputChunkSize;
+
+	/** Parameter file for a parameter sweep (--sweep switch) */
+	char* sweepFileName;
+
+	/** Directory for FMU states saved after initialization (--state-cache switch) */
+	char* stateCacheDir;
+
+	/** File for the run statistics in JSON format (--stats switch) */
+	char* statsFileName;
+
+	/** Limit on the wall clock time of the whole run in seconds. Zero means no limit (--timeout switch) */
+	double totalTimeout;
+
+	/** Limit on the wall clock time of a single FMI call in seconds. Zero means no limit (--call-timeout switch) */
+	double callTimeout;
+
+	/** Maximum number of fmi2NewDiscreteStates calls in one event iteration (--max-event-iterations switch) */
+	unsigned int maxEventIterations;
+
+	/** Time of the phases of the check (fmu_check_phase_begin()) */
+	fmu_check_phase_times_t phases;
+
+	/** FMI call in progress, checked by the watchdog */
+	fmu_check_watch_t watch;
+
+	/** Simulated seconds per wall clock second for real-time pacing. Zero means no pacing (--realtime switch) */
+	double realtimeFactor;
+
+	/** Real-time pacing state and step statistics */
+	fmu_check_realtime_t realtime;
 
 	/** Should simulation be done (or only XML checking) */
 	int do_simulate_flg;
@@ -146,9 +226,27 @@ struct fmu_check_data_t {
 	/** should variables be printed before event handling (-d switch) */
     int print_all_event_vars;
 
+	/** Co-simulate the FMUs listed in the connection file given as the last argument (--cosim switch) */
+	int do_cosim;
+
+	/** Number of threads to use. Zero means one per processor (-j switch) */
+	size_t num_threads;
+
+	/** Checker data for additional FMU instances (e.g., the FMUs in co-simulation).
+		Used to find the data for an FMU from its component environment. */
+	fmu_check_data_t** instance_data;
+	size_t num_instance_data;
+
 	/** FMI standard version of the FMU */
 	fmi_version_enu_t version;
 
+	/** Central directory of the FMU archive (NULL if it could not be read) */
+	fmu_check_zip_t* fmuZip;
+	/** Background extraction of the binaries and resources (NULL if the FMU was unpacked up front) */
+	fmu_check_unpack_t* unpack;
+	/** Unpack the whole FMU up front (--extract-all switch) */
+	int extractAll;
+
 	/** FMI1 main struct */
 	fmi1_import_t* fmu1;
 	/** Kind of the FMI */
@@ -166,6 +264,24 @@ struct fmu_check_data_t {
     fmi2_csv_input_t fmu2_inputData;
 	/** model variables */
 	fmi2_import_variable_list_t* vl2;
+	/** Parameter sets in a parameter sweep (NULL otherwise) */
+	const fmi2_param_sets_t* fmu2_params;
+	/** Index of the parameter set used in the current run */
+	size_t fmu2_param_set;
+	/** Keep the FMU instance after a successful run and reset it for the next one */
+	int fmu2_reuse_instance;
+	/** Set when an instance is kept from the previous run */
+	int fmu2_instance_alive;
+	/** Output resampling state (--resample switch) */
+	fmi2_resample_t fmu2_resample;
+	/** Variables written to the output file, built after parsing the XML */
+	fmi2_column_plan_t fmu2_columns;
+	/** Buffers for the output rows */
+	fmi2_row_writer_t fmu2_row;
+	/** Row hashes for the determinism check (--determinism switch) */
+	fmi2_determinism_t fmu2_determinism;
+	/** Reference data for the comparison of the output (--reference switch) */
+	fmi2_reference_t fmu2_reference;
 } ;
 
 
@@ -181,6 +297,21 @@ void init_fmu_check_data(fmu_check_data_t* cdata);
 /** Release allocated resources */ 
 void clear_fmu_check_data(fmu_check_data_t* cdata, int close_log);
 
+/** Init checker data for an additional FMU or instance. Options and the output and log streams are taken from the parent. */
+void init_fmu_check_child_data(fmu_check_data_t* cdata, fmu_check_data_t* parent);
+
+/** Release resources of checker data set up with init_fmu_check_child_data(). Message counts are added to the parent. */
+void clear_fmu_check_child_data(fmu_check_data_t* cdata, fmu_check_data_t* parent);
+
+/** Get the checker data for the FMU with the given component environment. Returns the global data if there is no match. */
+fmu_check_data_t* fmu_check_get_instance_data(void* componentEnvironment);
+
+/** Print the message counts of the run ("FMU check summary") to the log */
+void fmu_check_print_summary(fmu_check_data_t* cdata);
+
+/** Check if output should be written at the given time and advance to the next output point (see -n option). */
+int check_output_time(fmu_check_data_t* cdata, double time);
+
 /** Logger function for FMI library */
 void checker_logger(jm_callbacks* c, jm_string module, jm_log_level_enu_t log_level, jm_string message);
 
@@ -198,6 +329,18 @@ jm_status_enu_t checked_print_quoted_str(fmu_check_data_t* cdata, const char* st
 /** Write out the data into the output file */
 jm_status_enu_t checked_fprintf(fmu_check_data_t* cdata, const char* fmt, ...);
 
+/** Write out len bytes into the output file */
+jm_status_enu_t checked_fwrite(fmu_check_data_t* cdata, const char* buf, size_t len);
+
+/** Open the output file. File names ending with .gz or .zst are written compressed. The caller logs a failure to open a plain file. */
+jm_status_enu_t fmu_check_open_output(fmu_check_data_t* cdata, const char* fileName);
+
+/** Close the output file opened with fmu_check_open_output() and go back to standard output */
+jm_status_enu_t fmu_check_close_output(fmu_check_data_t* cdata);
+
+/** Format a variable name for the CSV header: quoted or mangled (-m). buf must hold 2*strlen(vn) + 3 characters. */
+void check_format_var_name(fmu_check_data_t* cdata, const char* vn, char* buf);
+
 /** Write out separator and variable name. Variable name is quoted/mangled if needed */
 jm_status_enu_t check_fprintf_var_name(fmu_check_data_t* cdata, const char* vn);
 
@@ -214,6 +357,21 @@ jm_status_enu_t fmi1_write_csv_data(fmu_check_data_t* cdata, double time);
 /** Check an FMI 2.0 FMU */
 jm_status_enu_t fmi2_check(fmu_check_data_t* cdata);
 
+/** Parse the model description of an unpacked FMI 2.0 FMU and log model information */
+jm_status_enu_t fmi2_check_parse_xml(fmu_check_data_t* cdata);
+
+/** Load the FMU binary for the given kind (ME or CS) and check version and platform */
+jm_status_enu_t fmi2_check_load_dll(fmu_check_data_t* cdata, fmi2_fmu_kind_enu_t kind);
+
+/** FMU logger callback. The component environment is the checker data of the instance. */
+void fmi2_checker_logger(fmi2_component_environment_t c, fmi2_string_t instanceName, fmi2_status_t status, fmi2_string_t category, fmi2_string_t message, ...);
+
+/** Co-simulate the FMI 2.0 CS FMUs listed in the connection file (cdata->FMUPath) */
+jm_status_enu_t fmi2_cosim_check(fmu_check_data_t* cdata);
+
+/** Simulate an FMI 2.0 FMU once for each parameter set in the parameter file (cdata->sweepFileName) */
+jm_status_enu_t fmi2_sweep_check(fmu_check_data_t* cdata);
+
 /** Simulate an FMI 2.0 ME FMU */
 jm_status_enu_t fmi2_me_simulate(fmu_check_data_t* cdata);
 
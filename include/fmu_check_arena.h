@@ -0,0 +1,75 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmu_check_arena.h
+	Run-scoped bump allocator for memory owned by the checker.
+
+	Memory is taken from large blocks and is never released individually.
+	All blocks are freed in one call when the checker data is cleared.
+	Memory allocated for a single task (e.g., one run in a parameter sweep)
+	can be released by going back to a mark set before the task.
+	The arena is used for the checker's own buffers only. Memory handed out
+	to the FMU goes through check_calloc()/check_free() so that leaks in
+	the FMU are still detected.
+*/
+
+#ifndef FMU_CHECK_ARENA_H_
+#define FMU_CHECK_ARENA_H_
+
+#include <JM/jm_portability.h>
+
+/** Default size of the arena blocks */
+#define FMU_CHECK_ARENA_BLOCK_SIZE (64*1024)
+
+typedef struct fmu_check_arena_block_t fmu_check_arena_block_t;
+
+/** Arena allocator state */
+typedef struct fmu_check_arena_t {
+	/** callbacks used to allocate the blocks */
+	jm_callbacks* cb;
+	/** block currently used for allocations */
+	fmu_check_arena_block_t* head;
+	/** minimum size of a block */
+	size_t blockSize;
+	/** total number of bytes handed out */
+	size_t bytesUsed;
+	/** total number of bytes in the blocks */
+	size_t bytesReserved;
+	/** number of blocks allocated so far (used to number the blocks) */
+	size_t numBlocks;
+} fmu_check_arena_t;
+
+/** Arena position saved by fmu_check_arena_mark() */
+typedef struct fmu_check_arena_mark_t {
+	fmu_check_arena_block_t* head;
+	size_t used;
+	size_t numBlocks;
+	size_t bytesUsed;
+} fmu_check_arena_mark_t;
+
+/** Initialize an empty arena. No memory is allocated until the first request. */
+void fmu_check_arena_init(fmu_check_arena_t* arena, jm_callbacks* cb);
+
+/** Allocate size bytes aligned for any basic type. Returns NULL if out of memory. */
+void* fmu_check_arena_alloc(fmu_check_arena_t* arena, size_t size);
+
+/** Allocate zero-initialized memory for nobj objects of the given size */
+void* fmu_check_arena_calloc(fmu_check_arena_t* arena, size_t nobj, size_t size);
+
+/** Copy a string into the arena */
+char* fmu_check_arena_strdup(fmu_check_arena_t* arena, const char* str);
+
+/** Release all memory allocated in the arena. The arena can be reused afterwards. */
+void fmu_check_arena_free(fmu_check_arena_t* arena);
+
+/** Save the current position of the arena */
+void fmu_check_arena_mark(fmu_check_arena_t* arena, fmu_check_arena_mark_t* mark);
+
+/** Release all memory allocated since the mark was set */
+void fmu_check_arena_release(fmu_check_arena_t* arena, const fmu_check_arena_mark_t* mark);
+
+#endif
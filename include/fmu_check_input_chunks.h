@@ -0,0 +1,71 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmu_check_input_chunks.h
+	Parallel parsing of the data lines of input files.
+
+	The data section of an input file (everything after the header) is split
+	into chunks of about equal size. Each chunk is parsed by a task in the
+	thread pool with its own file handle: a task skips the line that starts
+	before its chunk and parses all the lines that start within it. The rows
+	of the chunks are then copied in order into contiguous storage with one
+	block per value type. Problems are reported in line order, as if the file
+	had been parsed from start to end, and parsing stops at the first bad line.
+*/
+
+#ifndef FMU_CHECK_INPUT_CHUNKS_H_
+#define FMU_CHECK_INPUT_CHUNKS_H_
+
+#include <stdio.h>
+#include <JM/jm_vector.h>
+
+/** Number of value blocks in a row: reals, integers and booleans */
+#define FMU_CHECK_INPUT_NUM_PARTS 3
+
+/**
+	Default smallest chunk (cdata->inputChunkSize). Files with less data than two chunks are
+	parsed by the calling thread.
+*/
+#ifndef FMU_CHECK_INPUT_MIN_CHUNK_SIZE
+#define FMU_CHECK_INPUT_MIN_CHUNK_SIZE (4*1024*1024)
+#endif
+
+/**
+	Parse one data line into the given value blocks.
+	Returns 1 if a row was read and 0 if there are no more rows. Returns -1 if a value
+	could not be parsed and -2 if a separator is missing (the rest of the row is not
+	set); *badVar is then the index of the variable.
+*/
+typedef int (*fmu_check_input_row_parser_ft)(void* context, FILE* file, double* time, void* parts[FMU_CHECK_INPUT_NUM_PARTS], size_t* badVar);
+
+/** Data lines of an input file */
+typedef struct fmu_check_input_rows_t {
+	size_t numRows;
+	/** Values of all the rows, partSize bytes per row in each block. Allocated in the checker arena. */
+	char* parts[FMU_CHECK_INPUT_NUM_PARTS];
+
+	/** Set if a value could not be parsed: line number (as counted by the sequential reader), time and variable */
+	size_t badLine;
+	double badTime;
+	size_t badVar;
+} fmu_check_input_rows_t;
+
+/**
+	Parse the data lines of fileName starting at dataOffset. The time stamps are
+	stored in timeStamps and the values in rows. partSize gives the number of bytes
+	per row for each value block and sep is the field separator (for the messages).
+	Uses cdata->num_threads threads (one per processor if zero).
+	Returns jm_status_error on failure. Problems are logged, except for a value that
+	could not be parsed, which is reported in rows->badLine for the caller to log
+	with the variable name.
+*/
+jm_status_enu_t fmu_check_parse_input_chunks(fmu_check_data_t* cdata, const char* fileName, long dataOffset, char sep,
+											 const size_t partSize[FMU_CHECK_INPUT_NUM_PARTS],
+											 fmu_check_input_row_parser_ft parser, void* context,
+											 jm_vector(double)* timeStamps, fmu_check_input_rows_t* rows);
+
+#endif
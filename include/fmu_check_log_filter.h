@@ -0,0 +1,98 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmu_check_log_filter.h
+	Suppression of repeated FMU log messages.
+
+	Messages are keyed by (category, status, format string). The key is checked
+	before the message is formatted so that a suppressed message costs a single
+	hash lookup.
+*/
+
+#ifndef FMU_CHECK_LOG_FILTER_H_
+#define FMU_CHECK_LOG_FILTER_H_
+
+#include <JM/jm_portability.h>
+
+/** Default number of "suppressed" messages between two reports */
+#define DEFAULT_LOG_REPEAT_REPORT_INTERVAL 1000
+#define DEFAULT_LOG_REPEAT_REPORT_INTERVAL_STR "1000"
+
+/** Statistics for a single message key */
+typedef struct fmu_check_log_key_t {
+	unsigned long hash;
+	int status;
+	/** status as string for the summary */
+	const char* statusStr;
+	char* category;
+	char* format;
+	/** number of times the FMU has logged the message */
+	size_t count;
+	/** number of times the message was not printed */
+	size_t suppressed;
+	/** suppressed since the last report line */
+	size_t unreported;
+} fmu_check_log_key_t;
+
+/** Repeat filter state */
+typedef struct fmu_check_log_filter_t {
+	jm_callbacks* cb;
+	/** Number of times a message is printed before it is suppressed. Zero turns filtering off. */
+	size_t maxRepeats;
+	/** A "suppressed N repeats" line is printed for every reportInterval suppressed messages */
+	size_t reportInterval;
+	/** Open addressing hash table */
+	fmu_check_log_key_t* keys;
+	size_t capacity;
+	size_t size;
+	/** Set when the table could not grow. Filtering is off from then on. */
+	int outOfMemory;
+} fmu_check_log_filter_t;
+
+/** Outcome of fmu_check_log_filter_pass() */
+typedef enum fmu_check_log_filter_enu_t {
+	/** print the message */
+	fmu_check_log_print = 0,
+	/** print the message, it is the last one before suppression starts */
+	fmu_check_log_print_last,
+	/** do not print */
+	fmu_check_log_suppress,
+	/** do not print but report the number of suppressed repeats */
+	fmu_check_log_report
+} fmu_check_log_filter_enu_t;
+
+/** Initialize the filter. Filtering is off until maxRepeats is set. */
+void fmu_check_log_filter_init(fmu_check_log_filter_t* filter, jm_callbacks* cb);
+
+/** Free memory allocated by the filter */
+void fmu_check_log_filter_free(fmu_check_log_filter_t* filter);
+
+/**
+	Register a message and decide if it should be printed.
+	\param category Message category (may be NULL).
+	\param status FMU status the message was logged with.
+	\param statusStr Static string for the status used in the reports.
+	\param format The unformatted message as passed by the FMU.
+	\param key Output: the key for the message (NULL if filtering is off).
+*/
+fmu_check_log_filter_enu_t fmu_check_log_filter_pass(fmu_check_log_filter_t* filter,
+	const char* category, int status, const char* statusStr, const char* format, fmu_check_log_key_t** key);
+
+/**
+	Log a report line for a key returned by fmu_check_log_filter_pass().
+	Prints the number of suppressed repeats since the last report, or a note
+	that suppression starts if nothing was suppressed yet.
+*/
+void fmu_check_log_filter_report(fmu_check_log_filter_t* filter, fmu_check_log_key_t* key);
+
+/** Move the message statistics of another filter into this one. The other filter is left empty. */
+void fmu_check_log_filter_merge(fmu_check_log_filter_t* filter, fmu_check_log_filter_t* other);
+
+/** Log the per-key counts for messages that were suppressed */
+void fmu_check_log_filter_summary(fmu_check_log_filter_t* filter);
+
+#endif
@@ -0,0 +1,57 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmu_check_realtime.h
+	Real-time pacing of the simulation loops (--realtime option).
+
+	Each communication step gets an absolute wall clock deadline computed from
+	the simulation time and the real-time factor. After the step is computed
+	the loop sleeps until the deadline. The compute time and slack of each
+	step, the missed deadlines and the release jitter (how late the next step
+	starts with respect to its deadline) are collected and reported at the end.
+*/
+
+#ifndef fmu_check_realtime_h
+#define fmu_check_realtime_h
+
+#include <fmilib.h>
+
+/** Number of bins in the release jitter histogram */
+#define FMUCHK_REALTIME_JITTER_BINS 6
+
+/** Pacing state and step statistics of one simulation run */
+typedef struct fmu_check_realtime_t {
+	/** Wall clock time of the simulation start time */
+	double wallStart;
+	double simStart;
+	/** Wall clock time when the current step was started */
+	double stepStart;
+
+	size_t numSteps;
+	size_t numMisses;
+	double sumCompute;
+	/** Longest step compute time (WCET estimate) */
+	double maxCompute;
+	/** Smallest slack (negative if a deadline was missed) */
+	double minSlack;
+	/** Steps by release jitter, see fmu_check_realtime_report() for the bin limits */
+	size_t jitter[FMUCHK_REALTIME_JITTER_BINS];
+} fmu_check_realtime_t;
+
+/** Start pacing at the given simulation time. Does nothing unless cdata->realtimeFactor is set. */
+void fmu_check_realtime_start(fmu_check_data_t* cdata, double simTime);
+
+/**
+	Record the end of a step that advanced the simulation to simTime and
+	sleep until the deadline of that time.
+*/
+void fmu_check_realtime_step(fmu_check_data_t* cdata, double simTime);
+
+/** Log the step statistics: WCET estimate, slack, missed deadlines and the jitter histogram */
+void fmu_check_realtime_report(fmu_check_data_t* cdata);
+
+#endif
@@ -0,0 +1,85 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmu_check_stats.h
+	Resource usage of the checker process and the run statistics file (--stats option).
+
+	The time of the phases of a check (unzip, XML parsing, loading the
+	binary, ...) is measured as elapsed and CPU time, printed in the summary
+	and written to the statistics file. The CPU time is that of the whole
+	process, so it includes the background threads (e.g., unpacking).
+*/
+
+#ifndef fmu_check_stats_h
+#define fmu_check_stats_h
+
+#include <fmilib.h>
+
+/** Timed phases of a check, in the order they happen */
+typedef enum fmu_check_phase_enu_t {
+	/** FMU version detection and unzip */
+	fmu_check_phase_unzip,
+	/** Parsing modelDescription.xml */
+	fmu_check_phase_xml,
+	/** Loading the binary and looking up the FMI functions */
+	fmu_check_phase_load,
+	/** Instantiating the model */
+	fmu_check_phase_instantiate,
+	/** Setup experiment and initialization mode (or fmiInitialize) */
+	fmu_check_phase_initialize,
+	/** Simulation loop */
+	fmu_check_phase_simulate,
+	/** Terminating and freeing the instance */
+	fmu_check_phase_terminate,
+	/** Unloading the binary and removing the temporary files */
+	fmu_check_phase_cleanup,
+	fmu_check_num_phases
+} fmu_check_phase_enu_t;
+
+/** Accumulated time of the phases */
+typedef struct fmu_check_phase_times_t {
+	/** Elapsed (wall clock) time in seconds */
+	double wall[fmu_check_num_phases];
+	/** Process CPU time in seconds */
+	double cpu[fmu_check_num_phases];
+	/** Number of times the phase was entered (e.g., ME and CS each instantiate) */
+	unsigned count[fmu_check_num_phases];
+
+	/** Phase being timed and when it started */
+	int running;
+	fmu_check_phase_enu_t current;
+	double wallStart;
+	double cpuStart;
+} fmu_check_phase_times_t;
+
+/** CPU time (user and system) used by the process in seconds */
+double fmu_check_cpu_time(void);
+
+/** Peak resident set size of the process in kilobytes. Zero if not available. */
+size_t fmu_check_peak_rss_kb(void);
+
+/** Name of a phase as used in the summary and in the statistics file */
+const char* fmu_check_phase_name(fmu_check_phase_enu_t phase);
+
+/** Start timing a phase. The phase being timed, if any, ends. */
+void fmu_check_phase_begin(fmu_check_data_t* cdata, fmu_check_phase_enu_t phase);
+
+/** End the phase being timed (if any) */
+void fmu_check_phase_end(fmu_check_data_t* cdata);
+
+/** Print the time of the phases that were entered as part of the check summary */
+void fmu_check_print_phase_times(fmu_check_data_t* cdata);
+
+/**
+	Write the statistics of the run to cdata->statsFileName as a JSON object:
+	the FMU path, the exit code, the wall clock time since wallStart, the CPU
+	time, the peak resident set size, the message counts and the time of the
+	phases.
+*/
+jm_status_enu_t fmu_check_write_stats(fmu_check_data_t* cdata, int exitCode, double wallStart);
+
+#endif
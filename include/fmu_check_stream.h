@@ -0,0 +1,68 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmu_check_stream.h
+	Compressed output and log files.
+
+	Output and log file names ending with ".gz" are written gzip compressed
+	and names ending with ".zst" are written zstd compressed (if the checker
+	is built with zstd). The writers copy the data into large buffers. Full
+	buffers are compressed and written to the file by a separate thread so
+	that the simulation does not wait for the compression unless all the
+	buffers are in use. The stream can be written from several threads.
+*/
+
+#ifndef FMU_CHECK_STREAM_H_
+#define FMU_CHECK_STREAM_H_
+
+#include <stdarg.h>
+#include <JM/jm_portability.h>
+
+/** Size of the buffers handed to the compression thread */
+#define FMU_CHECK_STREAM_BUFFER_SIZE (256*1024)
+/** Number of buffers: one is filled while the others wait for or are in compression */
+#define FMU_CHECK_STREAM_NUM_BUFFERS 4
+
+typedef enum fmu_check_stream_kind_enu_t {
+	fmu_check_stream_plain,
+	fmu_check_stream_gzip,
+	fmu_check_stream_zstd
+} fmu_check_stream_kind_enu_t;
+
+/** Opaque compressed stream */
+typedef struct fmu_check_stream_t fmu_check_stream_t;
+
+/** Compression given by the file name extension (.gz or .zst) */
+fmu_check_stream_kind_enu_t fmu_check_stream_kind(const char* fileName);
+
+/**
+	Open a compressed file for writing and start the compression thread.
+	Returns NULL (after logging a fatal error) if the file cannot be opened
+	or the compression is not supported.
+*/
+fmu_check_stream_t* fmu_check_stream_open(jm_callbacks* cb, const char* fileName, fmu_check_stream_kind_enu_t kind);
+
+/** Write len bytes. Returns 0 on success and -1 if the stream is finished or writing the file failed. */
+int fmu_check_stream_write(fmu_check_stream_t* s, const char* buf, size_t len);
+
+/** Formatted write. Returns the number of characters written or a negative value on failure. */
+int fmu_check_stream_vprintf(fmu_check_stream_t* s, const char* fmt, va_list args);
+
+/** Formatted write, see fmu_check_stream_vprintf() */
+int fmu_check_stream_printf(fmu_check_stream_t* s, const char* fmt, ...);
+
+/**
+	Compress the remaining data, end the compressed stream and close the file.
+	Later writes fail. Can be called more than once, e.g., by the watchdog
+	before the stream is freed. Returns 0 if all the data were written.
+*/
+int fmu_check_stream_finish(fmu_check_stream_t* s);
+
+/** Finish the stream (if not done) and release it. Returns 0 if all the data were written. */
+int fmu_check_stream_close(fmu_check_stream_t* s);
+
+#endif
@@ -0,0 +1,87 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmu_check_thread.h
+	Portable threads, locks, thread pool and wall clock used by the checker.
+*/
+
+#ifndef FMU_CHECK_THREAD_H_
+#define FMU_CHECK_THREAD_H_
+
+#include <JM/jm_portability.h>
+
+#if defined(_WIN32) || defined(WIN32)
+	#include <windows.h>
+	typedef SRWLOCK fmu_check_mutex_t;
+	typedef CONDITION_VARIABLE fmu_check_cond_t;
+#else
+	#include <pthread.h>
+	typedef pthread_mutex_t fmu_check_mutex_t;
+	typedef pthread_cond_t fmu_check_cond_t;
+#endif
+
+/** Thread function */
+typedef void (*fmu_check_thread_ft)(void* data);
+
+/** Opaque thread handle */
+typedef struct fmu_check_thread_t fmu_check_thread_t;
+
+/** Start a new thread running func(data). Returns NULL on failure. */
+fmu_check_thread_t* fmu_check_thread_start(jm_callbacks* cb, fmu_check_thread_ft func, void* data);
+
+/** Wait for the thread to finish and release the handle */
+void fmu_check_thread_join(fmu_check_thread_t* thread);
+
+void fmu_check_mutex_init(fmu_check_mutex_t* mutex);
+void fmu_check_mutex_destroy(fmu_check_mutex_t* mutex);
+void fmu_check_mutex_lock(fmu_check_mutex_t* mutex);
+void fmu_check_mutex_unlock(fmu_check_mutex_t* mutex);
+
+void fmu_check_cond_init(fmu_check_cond_t* cond);
+void fmu_check_cond_destroy(fmu_check_cond_t* cond);
+void fmu_check_cond_wait(fmu_check_cond_t* cond, fmu_check_mutex_t* mutex);
+/** Wait at most the given number of seconds. Returns 0 on timeout. */
+int fmu_check_cond_timed_wait(fmu_check_cond_t* cond, fmu_check_mutex_t* mutex, double seconds);
+void fmu_check_cond_signal(fmu_check_cond_t* cond);
+void fmu_check_cond_broadcast(fmu_check_cond_t* cond);
+
+/** Process wide lock. Used to protect the global memory accounting. */
+void fmu_check_global_lock(void);
+void fmu_check_global_unlock(void);
+
+/** Number of logical processors */
+size_t fmu_check_get_num_cpus(void);
+
+/** Monotonic wall clock time in seconds */
+double fmu_check_wall_clock(void);
+
+/** Sleep until fmu_check_wall_clock() reaches the given time. Returns immediately if it has passed. */
+void fmu_check_sleep_until(double wallTime);
+
+/** Task function for the thread pool. Index is the task number. */
+typedef void (*fmu_check_task_ft)(void* data, size_t index);
+
+/** Opaque thread pool handle */
+typedef struct fmu_check_thread_pool_t fmu_check_thread_pool_t;
+
+/**
+	Create a thread pool with numThreads threads in total. The thread calling
+	fmu_check_thread_pool_run() counts as one of them, so numThreads - 1
+	worker threads are started. Zero means one thread per processor.
+*/
+fmu_check_thread_pool_t* fmu_check_thread_pool_create(jm_callbacks* cb, size_t numThreads);
+
+/** Number of threads in the pool (including the caller) */
+size_t fmu_check_thread_pool_size(fmu_check_thread_pool_t* pool);
+
+/** Run task(data, i) for i in [0, numTasks) and wait for all of them to finish */
+void fmu_check_thread_pool_run(fmu_check_thread_pool_t* pool, fmu_check_task_ft task, void* data, size_t numTasks);
+
+/** Stop the worker threads and release the pool */
+void fmu_check_thread_pool_free(fmu_check_thread_pool_t* pool);
+
+#endif
@@ -0,0 +1,53 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmu_check_unpack.h
+	On-demand extraction of the parts of an FMU needed for simulation.
+
+	Instead of unzipping the whole FMU up front, modelDescription.xml is
+	extracted first and the rest is extracted in a background thread while
+	the XML is parsed: the binaries for this platform (binaries/FMI_PLATFORM),
+	then the resources. The checker waits for the binaries before loading
+	the shared library and for the resources before instantiating the model.
+	Binaries for other platforms and the sources are not extracted unless the
+	whole FMU is unpacked (--extract-all).
+
+	Entries are extracted in parallel by a thread pool (-j), the largest
+	(compressed) entries first so that the threads finish at about the same
+	time. The time of each phase is logged.
+*/
+
+#ifndef FMU_CHECK_UNPACK_H_
+#define FMU_CHECK_UNPACK_H_
+
+/** Parts of the FMU extracted in the background */
+typedef enum fmu_check_unpack_part_enu_t {
+	/** binaries/FMI_PLATFORM */
+	fmu_check_unpack_binaries = 1,
+	/** resources */
+	fmu_check_unpack_resources = 2
+} fmu_check_unpack_part_enu_t;
+
+/** Opaque state of the background extraction */
+typedef struct fmu_check_unpack_t fmu_check_unpack_t;
+
+/** Start extracting the binaries and resources from cdata->fmuZip into cdata->tmpPath */
+jm_status_enu_t fmu_check_unpack_start(fmu_check_data_t* cdata);
+
+/** Extract all the entries of cdata->fmuZip into cdata->tmpPath and wait for them. Failures are logged. */
+jm_status_enu_t fmu_check_unpack_all(fmu_check_data_t* cdata);
+
+/**
+	Wait until the part has been extracted. Returns at once if nothing is
+	extracted in the background. Failures are logged.
+*/
+jm_status_enu_t fmu_check_unpack_wait(fmu_check_data_t* cdata, fmu_check_unpack_part_enu_t part);
+
+/** Stop the extraction (the rest is skipped) and release the state. Called before the unzip folder is removed. */
+void fmu_check_unpack_stop(fmu_check_data_t* cdata);
+
+#endif
@@ -0,0 +1,67 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmu_check_watchdog.h
+	Watchdog thread enforcing the run time limits (--timeout and --call-timeout options).
+
+	The simulation loops record each FMI call with fmu_check_watch() before
+	making it and clear it with fmu_check_watch_end() when it returns, so that
+	output writing and input reading between the calls do not count as call
+	time. The watchdog checks the recorded calls periodically. When the
+	current FMI call of any watched instance has run longer than the call
+	timeout, or the whole run longer than the total timeout, the watchdog logs
+	the FMI function and the simulation time, flushes the output written so
+	far, prints the summary and exits with FMUCHK_EXIT_TIMEOUT.
+*/
+
+#ifndef fmu_check_watchdog_h
+#define fmu_check_watchdog_h
+
+#include <fmilib.h>
+
+/** Exit code used when a timeout expires */
+#define FMUCHK_EXIT_TIMEOUT 2
+
+/** Default cap on the number of fmi2NewDiscreteStates calls in one event iteration */
+#define FMUCHK_DEFAULT_MAX_EVENT_ITERATIONS 1000
+#define FMUCHK_DEFAULT_MAX_EVENT_ITERATIONS_STR "1000"
+
+/** FMI call in progress for one FMU instance. Written by the simulating thread, read by the watchdog. */
+typedef struct fmu_check_watch_t {
+	/** Name of the FMI function in progress. NULL if none. */
+	const char* volatile callName;
+	/** Wall clock time when the call was started */
+	volatile double callStart;
+	/** Simulation time of the call */
+	volatile double simTime;
+} fmu_check_watch_t;
+
+/**
+	Start the watchdog thread if cdata->totalTimeout or cdata->callTimeout is set.
+	The total run time is measured from wallStart (see fmu_check_wall_clock()).
+*/
+jm_status_enu_t fmu_check_watchdog_start(fmu_check_data_t* cdata, double wallStart);
+
+/** Stop the watchdog thread (if started) */
+void fmu_check_watchdog_stop(void);
+
+/** Watch the FMI calls of an additional FMU instance (sweep and co-simulation children) */
+void fmu_check_watchdog_add(fmu_check_data_t* cdata);
+
+/** Stop watching an FMU instance added with fmu_check_watchdog_add() */
+void fmu_check_watchdog_remove(fmu_check_data_t* cdata);
+
+/**
+	Record that the FMI function callName is called at simulation time simTime.
+	NULL callName records that no FMI call is in progress.
+*/
+void fmu_check_watch(fmu_check_data_t* cdata, const char* callName, double simTime);
+
+/** Record that the FMI call recorded with fmu_check_watch() has returned */
+void fmu_check_watch_end(fmu_check_data_t* cdata);
+
+#endif
@@ -0,0 +1,71 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmu_check_zip.h
+	Reading single entries of an FMU archive.
+
+	The central directory of the zip file is read when the archive is opened,
+	so the entries can be listed without extracting anything. Entries are
+	read (stored or deflated, zip64 offsets supported) directly from the
+	archive. Each read opens the file itself, so entries may be read from
+	several threads.
+*/
+
+#ifndef FMU_CHECK_ZIP_H_
+#define FMU_CHECK_ZIP_H_
+
+#include <JM/jm_portability.h>
+
+/** Opaque archive handle */
+typedef struct fmu_check_zip_t fmu_check_zip_t;
+
+/**
+	Open a zip archive and read its central directory.
+	Returns NULL if the file is not a zip archive that can be read this way
+	(the reason is logged as verbose since the caller falls back to FMIL).
+*/
+fmu_check_zip_t* fmu_check_zip_open(jm_callbacks* cb, const char* fileName);
+
+/** Release the archive handle */
+void fmu_check_zip_close(fmu_check_zip_t* zip);
+
+/** Number of entries in the archive */
+size_t fmu_check_zip_num_entries(fmu_check_zip_t* zip);
+
+/** Name of an entry as stored in the archive ('/' separated, directories end with '/') */
+const char* fmu_check_zip_entry_name(fmu_check_zip_t* zip, size_t index);
+
+/** Uncompressed size of an entry */
+size_t fmu_check_zip_entry_size(fmu_check_zip_t* zip, size_t index);
+
+/** Compressed size of an entry, i.e., the amount of data read to extract it */
+size_t fmu_check_zip_entry_compressed_size(fmu_check_zip_t* zip, size_t index);
+
+/** Index of the entry with the given name or -1 if there is none */
+int fmu_check_zip_find(fmu_check_zip_t* zip, const char* name);
+
+/** Check if there are entries in the given folder, e.g., "binaries/" */
+int fmu_check_zip_has_folder(fmu_check_zip_t* zip, const char* folder);
+
+/**
+	Read an entry into memory. The data are zero terminated and must be released
+	with cb->free. The size (without the terminator) is returned in *size.
+	Returns NULL on failure. Nothing is logged so that entries can be read from
+	worker threads; the caller reports the failure.
+*/
+char* fmu_check_zip_read(fmu_check_zip_t* zip, size_t index, size_t* size);
+
+/**
+	Extract an entry below the given folder, creating the folders on the way.
+	The file is written through a buffer sized for the entry (up to 1 MB).
+	Folder entries (names ending with '/') only create the folder. Entries with
+	absolute names or ".." in them are refused. Returns 0 on failure; like
+	fmu_check_zip_read() nothing is logged.
+*/
+int fmu_check_zip_extract(fmu_check_zip_t* zip, size_t index, const char* dir);
+
+#endif
@@ -0,0 +1,395 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmuchk_bench.c
+	Micro-benchmarks for the input reader, the input interpolation, the
+	external event detection and the CSV output writer.
+
+	For each number of columns a model description with that many inputs and
+	outputs is written to a temporary directory together with the stub model
+	binary (fmuchk_bench_model). It is parsed and loaded with FMIL just like a
+	real FMU, so no FMU files are needed. For each number of rows a synthetic
+	input file is generated and the checker routines are timed on it.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <JM/jm_portability.h>
+#include <fmilib.h>
+#include <fmilib_config.h>
+#include <fmuChecker.h>
+
+#define BENCH_MODEL_IDENTIFIER "fmuchk_bench_model"
+#define BENCH_MAX_SIZES 16
+/* configurations with more values than this are skipped */
+#define BENCH_MAX_VALUES 20000000.0
+#define BENCH_NUM_VAR_NAMES 1000
+#define BENCH_VAR_NAME_ROUNDS 1000
+
+typedef struct bench_sizes_t {
+	size_t values[BENCH_MAX_SIZES];
+	size_t num;
+} bench_sizes_t;
+
+static void bench_usage(void) {
+	printf(
+		"Usage: fmuchk_bench [-r <rows>[,<rows>...]] [-c <cols>[,<cols>...]] [-t <tmp-dir>] <model-library>\n\n"
+		"-r <rows>        Numbers of rows in the input data. Default is 1000,10000,100000.\n"
+		"-c <cols>        Numbers of input and output columns. Default is 10,100,1000.\n"
+		"-t <tmp-dir>     Directory for the temporary files. Default is the system\n"
+		"                 temporary directory.\n"
+		"<model-library>  The fmuchk_bench_model shared library built with the benchmark.\n\n"
+		"Configurations with more than %g values in the input data are skipped.\n", BENCH_MAX_VALUES);
+}
+
+static int bench_parse_sizes(const char* arg, bench_sizes_t* sizes) {
+	const char* cur = arg;
+	sizes->num = 0;
+	while(*cur) {
+		char* end;
+		long val = strtol(cur, &end, 10);
+		if((end == cur) || (val <= 0) || (sizes->num >= BENCH_MAX_SIZES)) return 0;
+		sizes->values[sizes->num++] = (size_t)val;
+		cur = end;
+		if(*cur == ',') cur++;
+		else if(*cur) return 0;
+	}
+	return sizes->num > 0;
+}
+
+static void bench_report(const char* name, size_t rows, size_t cols, double time, double items, double bytes) {
+	if(time <= 0) time = 1e-9;
+	printf("%-24s %8u %6u %10.4f %12.4g %10.2f\n", name, (unsigned)rows, (unsigned)cols, time, items / time, bytes / time / 1e6);
+	fflush(stdout);
+}
+
+static long bench_file_size(const char* fileName) {
+	long size = -1;
+	FILE* f = fopen(fileName, "rb");
+	if(f) {
+		if(fseek(f, 0, SEEK_END) == 0) size = ftell(f);
+		fclose(f);
+	}
+	return size;
+}
+
+static int bench_copy_file(const char* from, const char* to) {
+	char buf[65536];
+	size_t n;
+	int ok = 1;
+	FILE* in = fopen(from, "rb");
+	FILE* out;
+	if(!in) return 0;
+	out = fopen(to, "wb");
+	if(!out) {
+		fclose(in);
+		return 0;
+	}
+	while((n = fread(buf, 1, sizeof(buf), in)) > 0) {
+		if(fwrite(buf, 1, n, out) != n) {
+			ok = 0;
+			break;
+		}
+	}
+	ok = !ferror(in) && ok;
+	fclose(in);
+	return (fclose(out) == 0) && ok;
+}
+
+/* Split the columns into reals, integers and booleans */
+static void bench_column_split(size_t cols, size_t* nReal, size_t* nInt, size_t* nBool) {
+	*nInt = cols / 10;
+	*nBool = cols / 10;
+	*nReal = cols - *nInt - *nBool;
+}
+
+/* Model description with cols inputs (u, k, b) followed by cols outputs (y, n, z) */
+static int bench_write_model_description(const char* fileName, size_t cols) {
+	size_t nReal, nInt, nBool, i, vr = 0;
+	FILE* f = fopen(fileName, "wb");
+	if(!f) return 0;
+	bench_column_split(cols, &nReal, &nInt, &nBool);
+
+	fprintf(f,
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<fmiModelDescription fmiVersion=\"2.0\" modelName=\"fmuchk_bench\" guid=\"{fmuchk-bench-%u}\" numberOfEventIndicators=\"0\">\n"
+		"<ModelExchange modelIdentifier=\"" BENCH_MODEL_IDENTIFIER "\"/>\n"
+		"<DefaultExperiment startTime=\"0\" stopTime=\"1\"/>\n"
+		"<ModelVariables>\n", (unsigned)cols);
+	for(i = 0; i < nReal; i++)
+		fprintf(f, "<ScalarVariable name=\"u[%u]\" valueReference=\"%u\" causality=\"input\"><Real start=\"0\"/></ScalarVariable>\n", (unsigned)(i + 1), (unsigned)vr++);
+	for(i = 0; i < nInt; i++)
+		fprintf(f, "<ScalarVariable name=\"k[%u]\" valueReference=\"%u\" causality=\"input\" variability=\"discrete\"><Integer start=\"0\"/></ScalarVariable>\n", (unsigned)(i + 1), (unsigned)vr++);
+	for(i = 0; i < nBool; i++)
+		fprintf(f, "<ScalarVariable name=\"b[%u]\" valueReference=\"%u\" causality=\"input\" variability=\"discrete\"><Boolean start=\"false\"/></ScalarVariable>\n", (unsigned)(i + 1), (unsigned)vr++);
+	for(i = 0; i < nReal; i++)
+		fprintf(f, "<ScalarVariable name=\"y[%u]\" valueReference=\"%u\" causality=\"output\"><Real/></ScalarVariable>\n", (unsigned)(i + 1), (unsigned)vr++);
+	for(i = 0; i < nInt; i++)
+		fprintf(f, "<ScalarVariable name=\"n[%u]\" valueReference=\"%u\" causality=\"output\" variability=\"discrete\"><Integer/></ScalarVariable>\n", (unsigned)(i + 1), (unsigned)vr++);
+	for(i = 0; i < nBool; i++)
+		fprintf(f, "<ScalarVariable name=\"z[%u]\" valueReference=\"%u\" causality=\"output\" variability=\"discrete\"><Boolean/></ScalarVariable>\n", (unsigned)(i + 1), (unsigned)vr++);
+	fprintf(f, "</ModelVariables>\n<ModelStructure>\n<Outputs>\n");
+	for(i = 0; i < cols; i++)
+		fprintf(f, "<Unknown index=\"%u\"/>\n", (unsigned)(cols + i + 1));
+	fprintf(f, "</Outputs>\n</ModelStructure>\n</fmiModelDescription>\n");
+	return fclose(f) == 0;
+}
+
+/* Input data with a time step of 1/rows. Integers change every 100 rows and booleans every 250 rows. */
+static int bench_write_input_file(const char* fileName, size_t rows, size_t cols) {
+	size_t nReal, nInt, nBool, i, j;
+	FILE* f = fopen(fileName, "wb");
+	if(!f) return 0;
+	bench_column_split(cols, &nReal, &nInt, &nBool);
+
+	fprintf(f, "time");
+	for(j = 0; j < nReal; j++) fprintf(f, ",u[%u]", (unsigned)(j + 1));
+	for(j = 0; j < nInt; j++) fprintf(f, ",k[%u]", (unsigned)(j + 1));
+	for(j = 0; j < nBool; j++) fprintf(f, ",b[%u]", (unsigned)(j + 1));
+	fprintf(f, "\n");
+	for(i = 0; i < rows; i++) {
+		fprintf(f, "%.16g", (double)i / rows);
+		for(j = 0; j < nReal; j++) fprintf(f, ",%.16g", 0.5 * i + j / 3.0);
+		for(j = 0; j < nInt; j++) fprintf(f, ",%d", (int)((i / 100 + j) % 7));
+		for(j = 0; j < nBool; j++) fprintf(f, ",%d", (int)((i / 250 + j) & 1));
+		fprintf(f, "\n");
+	}
+	return fclose(f) == 0;
+}
+
+/* Time the checker routines on one input file. Returns 0 on failure. */
+static int bench_run_rows(fmu_check_data_t* cdata, const char* tmpPath, size_t rows, size_t cols) {
+	fmi2_csv_input_t* indata = &cdata->fmu2_inputData;
+	char inputName[MAX_URL_LENGTH], outputName[MAX_URL_LENGTH];
+	fmu_check_arena_mark_t mark;
+	double start, time, tend = 1.0;
+	size_t i, nReal, nInt, nBool, numPoints;
+	long size;
+	int ok = 1;
+
+	bench_column_split(cols, &nReal, &nInt, &nBool);
+	jm_snprintf(inputName, sizeof(inputName), "%s" FMI_FILE_SEP "input.csv", tmpPath);
+	jm_snprintf(outputName, sizeof(outputName), "%s" FMI_FILE_SEP "output.csv", tmpPath);
+	if(!bench_write_input_file(inputName, rows, cols)) {
+		fprintf(stderr, "Could not write %s\n", inputName);
+		return 0;
+	}
+	size = bench_file_size(inputName);
+
+	/* the input rows are allocated in the arena */
+	fmu_check_arena_mark(&cdata->arena, &mark);
+	cdata->inputFileName = inputName;
+	start = fmu_check_wall_clock();
+	if((fmi2_init_input_data(indata, &cdata->callbacks, cdata->fmu2) != jm_status_success) ||
+		(fmi2_read_input_file(cdata) != jm_status_success)) {
+		fprintf(stderr, "Could not read %s\n", inputName);
+		ok = 0;
+	}
+	time = fmu_check_wall_clock() - start;
+	cdata->inputFileName = 0;
+	if(ok) bench_report("fmi2_read_input_file", rows, cols, time, (double)rows, (double)size);
+
+	if(ok) {
+		/* four interpolation points per input row */
+		numPoints = 4 * rows;
+		fmi2_rewind_input_data(indata);
+		start = fmu_check_wall_clock();
+		for(i = 0; i <= numPoints; i++) {
+			fmi2_update_input_interpolation(indata, tend * i / numPoints);
+		}
+		time = fmu_check_wall_clock() - start;
+		bench_report("fmi2_update_input_interp", rows, cols, time, (double)(numPoints + 1),
+			(double)(numPoints + 1) * nReal * sizeof(fmi2_real_t));
+	}
+
+	if(ok) {
+		/* two intervals per input row */
+		fmi2_event_info_t eventInfo;
+		double h = tend / (2 * rows);
+		numPoints = 2 * rows;
+		fmi2_rewind_input_data(indata);
+		start = fmu_check_wall_clock();
+		for(i = 0; i < numPoints; i++) {
+			double tcur = h * i;
+			eventInfo.nextEventTimeDefined = fmi2_false;
+			fmi2_check_external_events(tcur, tcur + h, &eventInfo, indata);
+		}
+		time = fmu_check_wall_clock() - start;
+		bench_report("fmi2_check_external_evts", rows, cols, time, (double)numPoints, 0);
+	}
+	fmi2_free_input_data(indata);
+	fmu_check_arena_release(&cdata->arena, &mark);
+
+	if(ok) {
+		cdata->out_file = fopen(outputName, "wb");
+		if(!cdata->out_file) {
+			fprintf(stderr, "Could not open %s for writing\n", outputName);
+			cdata->out_file = stdout;
+			return 0;
+		}
+		/* output at every call */
+		cdata->maxOutputPts = 0;
+		cdata->nextOutputTime = 0;
+		cdata->nextOutputStep = 0;
+		start = fmu_check_wall_clock();
+		ok = (fmi2_write_csv_header(cdata) == jm_status_success);
+		for(i = 0; ok && (i < rows); i++) {
+			ok = (fmi2_write_csv_data(cdata, tend * i / rows) == jm_status_success);
+		}
+		ok = (fclose(cdata->out_file) == 0) && ok;
+		time = fmu_check_wall_clock() - start;
+		cdata->out_file = stdout;
+		if(ok) bench_report("fmi2_write_csv_data", rows, cols, time, (double)rows, (double)bench_file_size(outputName));
+		else fprintf(stderr, "Could not write %s\n", outputName);
+	}
+	remove(inputName);
+	remove(outputName);
+	return ok;
+}
+
+/* Parse and load the model description for the given number of columns and run the row sizes */
+static int bench_run_cols(fmu_check_data_t* cdata, const char* tmpPath, const bench_sizes_t* rows, size_t cols) {
+	char xmlName[MAX_URL_LENGTH];
+	size_t i;
+	int ok = 1, instantiated = 0;
+
+	jm_snprintf(xmlName, sizeof(xmlName), "%s" FMI_FILE_SEP "modelDescription.xml", tmpPath);
+	if(!bench_write_model_description(xmlName, cols)) {
+		fprintf(stderr, "Could not write %s\n", xmlName);
+		return 0;
+	}
+	if((fmi2_check_parse_xml(cdata) != jm_status_success) ||
+		(fmi2_check_load_dll(cdata, fmi2_fmu_kind_me) != jm_status_success)) {
+		return 0;
+	}
+	cdata->instanceNameToCompare = "fmuchk_bench";
+	cdata->instanceNameSavedPtr = 0;
+	if(fmi2_import_instantiate(cdata->fmu2, cdata->instanceNameToCompare, fmi2_model_exchange, 0, fmi2_false) != jm_status_success) {
+		fprintf(stderr, "Could not instantiate the benchmark model\n");
+		ok = 0;
+	}
+	else instantiated = 1;
+	for(i = 0; ok && (i < rows->num); i++) {
+		if((double)rows->values[i] * cols > BENCH_MAX_VALUES) {
+			printf("%-24s %8u %6u %10s\n", "(skipped)", (unsigned)rows->values[i], (unsigned)cols, "-");
+			continue;
+		}
+		ok = bench_run_rows(cdata, tmpPath, rows->values[i], cols);
+	}
+	if(instantiated) fmi2_import_free_instance(cdata->fmu2);
+	fmi2_import_destroy_dllfmu(cdata->fmu2);
+	fmi2_import_free_variable_list(cdata->vl2);
+	cdata->vl2 = 0;
+	fmi2_import_free(cdata->fmu2);
+	cdata->fmu2 = 0;
+	return ok;
+}
+
+/* Header names, half of which need quoting */
+static int bench_var_names(fmu_check_data_t* cdata, const char* tmpPath) {
+	char outputName[MAX_URL_LENGTH];
+	char names[BENCH_NUM_VAR_NAMES][64];
+	double start, time, bytes = 0;
+	size_t i, round;
+	int mangle, ok = 1;
+
+	for(i = 0; i < BENCH_NUM_VAR_NAMES; i++) {
+		if(i & 1)
+			jm_snprintf(names[i], sizeof(names[i]), "\"sub system %u\".out, \"y\"", (unsigned)i);
+		else
+			jm_snprintf(names[i], sizeof(names[i]), "subSystem%u.der(x[%u])", (unsigned)i, (unsigned)(i % 17));
+		bytes += strlen(names[i]);
+	}
+	bytes *= BENCH_VAR_NAME_ROUNDS;
+
+	jm_snprintf(outputName, sizeof(outputName), "%s" FMI_FILE_SEP "names.csv", tmpPath);
+	for(mangle = 0; ok && (mangle < 2); mangle++) {
+		cdata->do_mangle_var_names = mangle;
+		cdata->out_file = fopen(outputName, "wb");
+		if(!cdata->out_file) {
+			fprintf(stderr, "Could not open %s for writing\n", outputName);
+			cdata->out_file = stdout;
+			return 0;
+		}
+		start = fmu_check_wall_clock();
+		for(round = 0; ok && (round < BENCH_VAR_NAME_ROUNDS); round++) {
+			for(i = 0; ok && (i < BENCH_NUM_VAR_NAMES); i++) {
+				ok = (check_fprintf_var_name(cdata, names[i]) == jm_status_success);
+			}
+		}
+		ok = (fclose(cdata->out_file) == 0) && ok;
+		time = fmu_check_wall_clock() - start;
+		cdata->out_file = stdout;
+		bench_report(mangle ? "check_fprintf_var_name -m" : "check_fprintf_var_name",
+			BENCH_NUM_VAR_NAMES * BENCH_VAR_NAME_ROUNDS, 1, time, (double)BENCH_NUM_VAR_NAMES * BENCH_VAR_NAME_ROUNDS, bytes);
+	}
+	cdata->do_mangle_var_names = 0;
+	remove(outputName);
+	return ok;
+}
+
+int main(int argc, char *argv[]) {
+	fmu_check_data_t cdata;
+	bench_sizes_t rows = {{1000, 10000, 100000}, 3};
+	bench_sizes_t cols = {{10, 100, 1000}, 3};
+	const char* tempDir = 0;
+	const char* modelLib;
+	char binDir[MAX_URL_LENGTH], libName[MAX_URL_LENGTH];
+	size_t i;
+	int argi, ok = 1;
+
+	for(argi = 1; argi < argc - 1; argi += 2) {
+		if(strcmp(argv[argi], "-r") == 0) ok = bench_parse_sizes(argv[argi + 1], &rows);
+		else if(strcmp(argv[argi], "-c") == 0) ok = bench_parse_sizes(argv[argi + 1], &cols);
+		else if(strcmp(argv[argi], "-t") == 0) tempDir = argv[argi + 1];
+		else ok = 0;
+		if(!ok) break;
+	}
+	if(!ok || (argi != argc - 1)) {
+		bench_usage();
+		return 1;
+	}
+	modelLib = argv[argc - 1];
+
+	init_fmu_check_data(&cdata);
+	/* only problems are reported; the timings are printed to stdout */
+	cdata.callbacks.log_level = jm_log_level_warning;
+	cdata.context = fmi_import_allocate_context(&cdata.callbacks);
+	if(!tempDir) tempDir = jm_get_system_temp_dir();
+	if(!tempDir) tempDir = "./";
+	cdata.tmpPath = fmi_import_mk_temp_dir(&cdata.callbacks, tempDir, "fmuchkbench");
+	if(!cdata.context || !cdata.tmpPath) {
+		clear_fmu_check_data(&cdata, 1);
+		return 1;
+	}
+
+	/* <tmp>/binaries/<platform>/<modelIdentifier><ext> as in an unpacked FMU */
+	jm_snprintf(binDir, sizeof(binDir), "%s" FMI_FILE_SEP "binaries", cdata.tmpPath);
+	ok = (jm_mkdir(&cdata.callbacks, binDir) == jm_status_success);
+	jm_snprintf(binDir, sizeof(binDir), "%s" FMI_FILE_SEP "binaries" FMI_FILE_SEP FMI_PLATFORM, cdata.tmpPath);
+	ok = ok && (jm_mkdir(&cdata.callbacks, binDir) == jm_status_success);
+	jm_snprintf(libName, sizeof(libName), "%s" FMI_FILE_SEP BENCH_MODEL_IDENTIFIER FMI_DLL_EXT, binDir);
+	if(!ok || !bench_copy_file(modelLib, libName)) {
+		fprintf(stderr, "Could not copy %s to %s\n", modelLib, libName);
+		clear_fmu_check_data(&cdata, 1);
+		return 1;
+	}
+
+	printf("%-24s %8s %6s %10s %12s %10s\n", "benchmark", "rows", "cols", "time [s]", "rows/s", "MB/s");
+	for(i = 0; ok && (i < cols.num); i++) {
+		ok = bench_run_cols(&cdata, cdata.tmpPath, &rows, cols.values[i]);
+	}
+	if(ok) {
+		ok = bench_var_names(&cdata, cdata.tmpPath);
+	}
+
+	clear_fmu_check_data(&cdata, 1);
+	fmu_check_log_filter_free(&cdata.fmu_log_filter);
+	return ok ? 0 : 1;
+}
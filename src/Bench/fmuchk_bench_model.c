@@ -0,0 +1,150 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmuchk_bench_model.c
+	Minimal FMI 2.0 model binary used by fmuchk_bench.
+
+	The model has no equations. Values are computed from the value reference
+	and the current time so that any modelDescription.xml written by the
+	benchmark can be served: reals are vr/1000 + time, integers are vr and
+	booleans alternate with vr. Set functions are accepted and ignored.
+*/
+
+#include "fmi2Functions.h"
+
+typedef struct bench_model_t {
+	fmi2CallbackFreeMemory freeMemory;
+	fmi2Real time;
+} bench_model_t;
+
+const char* fmi2GetTypesPlatform(void) { return fmi2TypesPlatform; }
+const char* fmi2GetVersion(void) { return fmi2Version; }
+
+fmi2Status fmi2SetDebugLogging(fmi2Component c, fmi2Boolean loggingOn, size_t nCategories, const fmi2String categories[]) {
+	return fmi2OK;
+}
+
+fmi2Component fmi2Instantiate(fmi2String instanceName, fmi2Type fmuType, fmi2String fmuGUID, fmi2String fmuResourceLocation,
+							  const fmi2CallbackFunctions* functions, fmi2Boolean visible, fmi2Boolean loggingOn) {
+	bench_model_t* m;
+	if(!functions || !functions->allocateMemory) return 0;
+	m = (bench_model_t*)functions->allocateMemory(1, sizeof(bench_model_t));
+	if(!m) return 0;
+	m->freeMemory = functions->freeMemory;
+	m->time = 0;
+	return m;
+}
+
+void fmi2FreeInstance(fmi2Component c) {
+	bench_model_t* m = (bench_model_t*)c;
+	if(m) m->freeMemory(m);
+}
+
+fmi2Status fmi2SetupExperiment(fmi2Component c, fmi2Boolean toleranceDefined, fmi2Real tolerance, fmi2Real startTime,
+							   fmi2Boolean stopTimeDefined, fmi2Real stopTime) {
+	((bench_model_t*)c)->time = startTime;
+	return fmi2OK;
+}
+
+fmi2Status fmi2EnterInitializationMode(fmi2Component c) { return fmi2OK; }
+fmi2Status fmi2ExitInitializationMode(fmi2Component c) { return fmi2OK; }
+fmi2Status fmi2Terminate(fmi2Component c) { return fmi2OK; }
+fmi2Status fmi2Reset(fmi2Component c) { ((bench_model_t*)c)->time = 0; return fmi2OK; }
+
+fmi2Status fmi2GetReal(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, fmi2Real value[]) {
+	fmi2Real time = c ? ((bench_model_t*)c)->time : 0;
+	size_t i;
+	for(i = 0; i < nvr; i++) value[i] = vr[i] * 1e-3 + time;
+	return fmi2OK;
+}
+
+fmi2Status fmi2GetInteger(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, fmi2Integer value[]) {
+	size_t i;
+	for(i = 0; i < nvr; i++) value[i] = (fmi2Integer)vr[i];
+	return fmi2OK;
+}
+
+fmi2Status fmi2GetBoolean(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, fmi2Boolean value[]) {
+	size_t i;
+	for(i = 0; i < nvr; i++) value[i] = (vr[i] & 1) ? fmi2True : fmi2False;
+	return fmi2OK;
+}
+
+fmi2Status fmi2GetString(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, fmi2String value[]) {
+	size_t i;
+	for(i = 0; i < nvr; i++) value[i] = "bench";
+	return fmi2OK;
+}
+
+fmi2Status fmi2SetReal(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, const fmi2Real value[]) { return fmi2OK; }
+fmi2Status fmi2SetInteger(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, const fmi2Integer value[]) { return fmi2OK; }
+fmi2Status fmi2SetBoolean(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, const fmi2Boolean value[]) { return fmi2OK; }
+fmi2Status fmi2SetString(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, const fmi2String value[]) { return fmi2OK; }
+
+/* The FMU state is not supported (canGetAndSetFMUstate is false in the model description) */
+fmi2Status fmi2GetFMUstate(fmi2Component c, fmi2FMUstate* FMUstate) { return fmi2Error; }
+fmi2Status fmi2SetFMUstate(fmi2Component c, fmi2FMUstate FMUstate) { return fmi2Error; }
+fmi2Status fmi2FreeFMUstate(fmi2Component c, fmi2FMUstate* FMUstate) { return fmi2Error; }
+fmi2Status fmi2SerializedFMUstateSize(fmi2Component c, fmi2FMUstate FMUstate, size_t* size) { return fmi2Error; }
+fmi2Status fmi2SerializeFMUstate(fmi2Component c, fmi2FMUstate FMUstate, fmi2Byte serializedState[], size_t size) { return fmi2Error; }
+fmi2Status fmi2DeSerializeFMUstate(fmi2Component c, const fmi2Byte serializedState[], size_t size, fmi2FMUstate* FMUstate) { return fmi2Error; }
+
+fmi2Status fmi2GetDirectionalDerivative(fmi2Component c, const fmi2ValueReference vUnknown_ref[], size_t nUnknown,
+										const fmi2ValueReference vKnown_ref[], size_t nKnown,
+										const fmi2Real dvKnown[], fmi2Real dvUnknown[]) {
+	return fmi2Error;
+}
+
+/* Model exchange */
+fmi2Status fmi2EnterEventMode(fmi2Component c) { return fmi2OK; }
+
+fmi2Status fmi2NewDiscreteStates(fmi2Component c, fmi2EventInfo* eventInfo) {
+	eventInfo->newDiscreteStatesNeeded = fmi2False;
+	eventInfo->terminateSimulation = fmi2False;
+	eventInfo->nominalsOfContinuousStatesChanged = fmi2False;
+	eventInfo->valuesOfContinuousStatesChanged = fmi2False;
+	eventInfo->nextEventTimeDefined = fmi2False;
+	eventInfo->nextEventTime = 0;
+	return fmi2OK;
+}
+
+fmi2Status fmi2EnterContinuousTimeMode(fmi2Component c) { return fmi2OK; }
+
+fmi2Status fmi2CompletedIntegratorStep(fmi2Component c, fmi2Boolean noSetFMUStatePriorToCurrentPoint,
+									   fmi2Boolean* enterEventMode, fmi2Boolean* terminateSimulation) {
+	*enterEventMode = fmi2False;
+	*terminateSimulation = fmi2False;
+	return fmi2OK;
+}
+
+fmi2Status fmi2SetTime(fmi2Component c, fmi2Real time) { ((bench_model_t*)c)->time = time; return fmi2OK; }
+fmi2Status fmi2SetContinuousStates(fmi2Component c, const fmi2Real x[], size_t nx) { return fmi2OK; }
+fmi2Status fmi2GetDerivatives(fmi2Component c, fmi2Real derivatives[], size_t nx) { return fmi2OK; }
+fmi2Status fmi2GetEventIndicators(fmi2Component c, fmi2Real eventIndicators[], size_t ni) { return fmi2OK; }
+fmi2Status fmi2GetContinuousStates(fmi2Component c, fmi2Real x[], size_t nx) { return fmi2OK; }
+fmi2Status fmi2GetNominalsOfContinuousStates(fmi2Component c, fmi2Real x_nominal[], size_t nx) { return fmi2OK; }
+
+/* Co-simulation */
+fmi2Status fmi2SetRealInputDerivatives(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, const fmi2Integer order[], const fmi2Real value[]) {
+	return fmi2Error;
+}
+
+fmi2Status fmi2GetRealOutputDerivatives(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, const fmi2Integer order[], fmi2Real value[]) {
+	return fmi2Error;
+}
+
+fmi2Status fmi2DoStep(fmi2Component c, fmi2Real currentCommunicationPoint, fmi2Real communicationStepSize, fmi2Boolean noSetFMUStatePriorToCurrentPoint) {
+	((bench_model_t*)c)->time = currentCommunicationPoint + communicationStepSize;
+	return fmi2OK;
+}
+
+fmi2Status fmi2CancelStep(fmi2Component c) { return fmi2Error; }
+fmi2Status fmi2GetStatus(fmi2Component c, const fmi2StatusKind s, fmi2Status* value) { return fmi2Discard; }
+fmi2Status fmi2GetRealStatus(fmi2Component c, const fmi2StatusKind s, fmi2Real* value) { return fmi2Discard; }
+fmi2Status fmi2GetIntegerStatus(fmi2Component c, const fmi2StatusKind s, fmi2Integer* value) { return fmi2Discard; }
+fmi2Status fmi2GetBooleanStatus(fmi2Component c, const fmi2StatusKind s, fmi2Boolean* value) { return fmi2Discard; }
+fmi2Status fmi2GetStringStatus(fmi2Component c, const fmi2StatusKind s, fmi2String* value) { return fmi2Discard; }
@@ -0,0 +1,191 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmuchk_gen_fmu.c
+	Generator for the synthetic FMI 2.0 test FMUs used in performance tests.
+
+	Writes modelDescription.xml and sources/<model-identifier>.c into the
+	output directory. The model source is the model template
+	(fmuchk_synthetic_model.c) preceded by the defines for the requested
+	sizes. The build compiles the source and packs the FMU.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void print_usage(void) {
+	printf("Usage: fmuchk_gen_fmu [options] <model-identifier> <model-template> <output-dir>\n"
+		"Options:\n"
+		"-x <n>\tNumber of continuous states (default 10).\n"
+		"-z <n>\tNumber of event indicators (default 1).\n"
+		"-u <n>\tNumber of real inputs (default 10).\n"
+		"-y <n>\tNumber of real outputs (default 10).\n"
+		"-s <n>\tNumber of string outputs (default 0).\n"
+		"-c <n>\tBusy-loop iterations per fmi2GetDerivatives and fmi2DoStep call (default 0).\n");
+}
+
+static int write_model_description(const char* path, const char* id, const char* guid,
+								   long nx, long nz, long nu, long ny, long ns) {
+	FILE* f = fopen(path, "w");
+	long i, index;
+	if(!f) {
+		fprintf(stderr, "Could not open %s for writing\n", path);
+		return 1;
+	}
+	fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<fmiModelDescription fmiVersion=\"2.0\" modelName=\"%s\" guid=\"%s\"\n"
+		"  description=\"Synthetic model: %ld states, %ld event indicators, %ld inputs, %ld outputs, %ld strings\"\n"
+		"  generationTool=\"fmuchk_gen_fmu\" variableNamingConvention=\"structured\" numberOfEventIndicators=\"%ld\">\n"
+		"<ModelExchange modelIdentifier=\"%s\" canGetAndSetFMUstate=\"true\" canSerializeFMUstate=\"true\">\n"
+		"  <SourceFiles><File name=\"%s.c\"/></SourceFiles>\n"
+		"</ModelExchange>\n"
+		"<CoSimulation modelIdentifier=\"%s\" canHandleVariableCommunicationStepSize=\"true\"\n"
+		"  canGetAndSetFMUstate=\"true\" canSerializeFMUstate=\"true\">\n"
+		"  <SourceFiles><File name=\"%s.c\"/></SourceFiles>\n"
+		"</CoSimulation>\n"
+		"<DefaultExperiment startTime=\"0\" stopTime=\"1\"/>\n"
+		"<ModelVariables>\n",
+		id, guid, nx, nz, nu, ny, ns, nz, id, id, id, id);
+
+	/* Real value references follow the variable order, see fmuchk_synthetic_model.c */
+	for(i = 0; i < nx; i++)
+		fprintf(f, "<ScalarVariable name=\"x[%ld]\" valueReference=\"%ld\" causality=\"local\" variability=\"continuous\" initial=\"exact\"><Real start=\"1\"/></ScalarVariable>\n",
+			i + 1, i);
+	for(i = 0; i < nx; i++)
+		fprintf(f, "<ScalarVariable name=\"der(x[%ld])\" valueReference=\"%ld\" causality=\"local\" variability=\"continuous\"><Real derivative=\"%ld\"/></ScalarVariable>\n",
+			i + 1, nx + i, i + 1);
+	for(i = 0; i < nu; i++)
+		fprintf(f, "<ScalarVariable name=\"u[%ld]\" valueReference=\"%ld\" causality=\"input\" variability=\"continuous\"><Real start=\"0\"/></ScalarVariable>\n",
+			i + 1, 2 * nx + i);
+	for(i = 0; i < ny; i++)
+		fprintf(f, "<ScalarVariable name=\"y[%ld]\" valueReference=\"%ld\" causality=\"output\" variability=\"continuous\"><Real/></ScalarVariable>\n",
+			i + 1, 2 * nx + nu + i);
+	for(i = 0; i < ns; i++)
+		fprintf(f, "<ScalarVariable name=\"s[%ld]\" valueReference=\"%ld\" causality=\"output\" variability=\"discrete\"><String/></ScalarVariable>\n",
+			i + 1, i);
+	fprintf(f, "</ModelVariables>\n<ModelStructure>\n");
+
+	/* Indices in ModelStructure are 1-based positions in ModelVariables */
+	index = 2 * nx + nu + 1;
+	if(ny + ns > 0) {
+		fprintf(f, "<Outputs>\n");
+		for(i = 0; i < ny + ns; i++) fprintf(f, "  <Unknown index=\"%ld\"/>\n", index + i);
+		fprintf(f, "</Outputs>\n");
+	}
+	if(nx > 0) {
+		fprintf(f, "<Derivatives>\n");
+		for(i = 0; i < nx; i++) fprintf(f, "  <Unknown index=\"%ld\"/>\n", nx + i + 1);
+		fprintf(f, "</Derivatives>\n");
+	}
+	if(ny + ns + nx > 0) {
+		fprintf(f, "<InitialUnknowns>\n");
+		for(i = 0; i < nx; i++) fprintf(f, "  <Unknown index=\"%ld\"/>\n", nx + i + 1);
+		for(i = 0; i < ny + ns; i++) fprintf(f, "  <Unknown index=\"%ld\"/>\n", index + i);
+		fprintf(f, "</InitialUnknowns>\n");
+	}
+	fprintf(f, "</ModelStructure>\n</fmiModelDescription>\n");
+
+	if(fclose(f) != 0) {
+		fprintf(stderr, "Error writing %s\n", path);
+		return 1;
+	}
+	return 0;
+}
+
+static int write_model_source(const char* path, const char* template_path, const char* guid,
+							  long nx, long nz, long nu, long ny, long ns, long cost) {
+	FILE* in = fopen(template_path, "rb");
+	FILE* out;
+	char buf[4096];
+	size_t n;
+	int err = 0;
+	if(!in) {
+		fprintf(stderr, "Could not open model template %s\n", template_path);
+		return 1;
+	}
+	out = fopen(path, "wb");
+	if(!out) {
+		fprintf(stderr, "Could not open %s for writing\n", path);
+		fclose(in);
+		return 1;
+	}
+	fprintf(out, "/* Generated by fmuchk_gen_fmu */\n"
+		"#define SYN_GUID \"%s\"\n"
+		"#define SYN_NX %ld\n#define SYN_NZ %ld\n#define SYN_NU %ld\n#define SYN_NY %ld\n#define SYN_NS %ld\n"
+		"#define SYN_COST %ldL\n\n",
+		guid, nx, nz, nu, ny, ns, cost);
+	while((n = fread(buf, 1, sizeof(buf), in)) > 0) {
+		if(fwrite(buf, 1, n, out) != n) {
+			err = 1;
+			break;
+		}
+	}
+	if(ferror(in)) err = 1;
+	fclose(in);
+	if(fclose(out) != 0) err = 1;
+	if(err) fprintf(stderr, "Error writing %s\n", path);
+	return err;
+}
+
+int main(int argc, char* argv[]) {
+	long nx = 10, nz = 1, nu = 10, ny = 10, ns = 0, cost = 0;
+	const char *id, *template_path, *outdir;
+	char guid[200];
+	char* path;
+	int i, err;
+
+	for(i = 1; i < argc && argv[i][0] == '-'; i++) {
+		long* val;
+		char* end;
+		switch(argv[i][1]) {
+		case 'x': val = &nx; break;
+		case 'z': val = &nz; break;
+		case 'u': val = &nu; break;
+		case 'y': val = &ny; break;
+		case 's': val = &ns; break;
+		case 'c': val = &cost; break;
+		default:
+			print_usage();
+			return 1;
+		}
+		if((argv[i][2] != 0) || (i + 1 >= argc)) {
+			print_usage();
+			return 1;
+		}
+		i++;
+		*val = strtol(argv[i], &end, 10);
+		if((*end != 0) || (*val < 0)) {
+			fprintf(stderr, "Expected a non-negative integer after %s, got %s\n", argv[i - 1], argv[i]);
+			return 1;
+		}
+	}
+	if(argc - i != 3) {
+		print_usage();
+		return 1;
+	}
+	id = argv[i];
+	template_path = argv[i + 1];
+	outdir = argv[i + 2];
+
+	/* The GUID identifies the sizes so that a stale binary is rejected by fmi2Instantiate */
+	sprintf(guid, "{fmuchk-synthetic-x%ld-z%ld-u%ld-y%ld-s%ld-c%ld}", nx, nz, nu, ny, ns, cost);
+
+	path = (char*)malloc(strlen(outdir) + strlen(id) + 40);
+	if(!path) {
+		fprintf(stderr, "Could not allocate memory\n");
+		return 1;
+	}
+	sprintf(path, "%s/modelDescription.xml", outdir);
+	err = write_model_description(path, id, guid, nx, nz, nu, ny, ns);
+	if(!err) {
+		sprintf(path, "%s/sources/%s.c", outdir, id);
+		err = write_model_source(path, template_path, guid, nx, nz, nu, ny, ns, cost);
+	}
+	free(path);
+	return err;
+}
@@ -0,0 +1,106 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmuchk_gunzip.c
+	Decompressor for the gzip output and log files written by the checker.
+
+	Used by the tests to compare the compressed output with the plain one
+	since "cmake -E tar" only extracts archives. Concatenated gzip members
+	are decompressed one after the other, as gunzip does.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <zlib.h>
+
+#define FMUCHK_GUNZIP_BUF_SIZE 65536
+
+static int gunzip_file(FILE* in, FILE* out) {
+	static unsigned char inBuf[FMUCHK_GUNZIP_BUF_SIZE];
+	static unsigned char outBuf[FMUCHK_GUNZIP_BUF_SIZE];
+	z_stream zs;
+	int ret = Z_OK, haveMember = 0;
+
+	memset(&zs, 0, sizeof(zs));
+	/* 16 selects the gzip wrapper */
+	if(inflateInit2(&zs, 15 + 16) != Z_OK) {
+		fprintf(stderr, "Could not initialize zlib\n");
+		return 1;
+	}
+	for(;;) {
+		if(!zs.avail_in) {
+			zs.avail_in = (uInt)fread(inBuf, 1, sizeof(inBuf), in);
+			zs.next_in = inBuf;
+			if(!zs.avail_in) break;
+		}
+		if(ret == Z_STREAM_END) {
+			/* the next member follows */
+			inflateReset(&zs);
+		}
+		haveMember = 1;
+		zs.avail_out = sizeof(outBuf);
+		zs.next_out = outBuf;
+		ret = inflate(&zs, Z_NO_FLUSH);
+		if((ret != Z_OK) && (ret != Z_STREAM_END)) {
+			fprintf(stderr, "Corrupt gzip data (%s)\n", zs.msg ? zs.msg : "unknown error");
+			inflateEnd(&zs);
+			return 1;
+		}
+		if(fwrite(outBuf, 1, sizeof(outBuf) - zs.avail_out, out) != sizeof(outBuf) - zs.avail_out) {
+			fprintf(stderr, "Could not write the decompressed data\n");
+			inflateEnd(&zs);
+			return 1;
+		}
+	}
+	/* write the output that did not fit the buffer in the last call */
+	while(haveMember && (ret == Z_OK)) {
+		zs.avail_out = sizeof(outBuf);
+		zs.next_out = outBuf;
+		ret = inflate(&zs, Z_FINISH);
+		if(fwrite(outBuf, 1, sizeof(outBuf) - zs.avail_out, out) != sizeof(outBuf) - zs.avail_out) {
+			fprintf(stderr, "Could not write the decompressed data\n");
+			inflateEnd(&zs);
+			return 1;
+		}
+	}
+	inflateEnd(&zs);
+	if(ferror(in) || !haveMember || (ret != Z_STREAM_END)) {
+		fprintf(stderr, "Truncated gzip data\n");
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char* argv[]) {
+	FILE* in;
+	FILE* out = stdout;
+	int ret;
+
+	if((argc != 2) && (argc != 3)) {
+		printf("Usage: fmuchk_gunzip <file.gz> [<output-file>]\n"
+			"Decompresses the file to the output file or to the standard output.\n");
+		return 1;
+	}
+	in = fopen(argv[1], "rb");
+	if(!in) {
+		fprintf(stderr, "Could not open %s\n", argv[1]);
+		return 1;
+	}
+	if(argc == 3) {
+		out = fopen(argv[2], "wb");
+		if(!out) {
+			fprintf(stderr, "Could not open %s for writing\n", argv[2]);
+			fclose(in);
+			return 1;
+		}
+	}
+	ret = gunzip_file(in, out);
+	fclose(in);
+	if((out != stdout) && (fclose(out) != 0)) ret = 1;
+	return ret;
+}
@@ -0,0 +1,456 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmuchk_synthetic_model.c
+	Model template for the synthetic test FMUs written by fmuchk_gen_fmu.
+
+	The generator copies this file into the sources directory of the FMU
+	after the defines for the model sizes (SYN_NX states, SYN_NZ event
+	indicators, SYN_NU inputs, SYN_NY real outputs, SYN_NS string outputs),
+	the GUID (SYN_GUID) and the simulated cost per call (SYN_COST).
+
+	Equations:
+	- der(x[i]) = -(1 + (i mod 10)/10) * x[i] + u[i mod nu], x[i](0) = 1
+	- y[k] = x[k mod nx] (time when there are no states)
+	- z[j] = time - (j + 1)/(nz + 1), i.e. each indicator crosses once in [0,1]
+	- s[k] is "even" or "odd" from the number of events plus k.
+
+	Real value references: states, derivatives, inputs and outputs in this
+	order. String value references start at 0. SYN_COST busy-loop iterations
+	are spent in each fmi2GetDerivatives and fmi2DoStep call.
+
+	The model counts the FMI calls made on each instance. If the environment
+	variable FMUCHK_SYNTHETIC_CALLS_FILE is set, fmi2FreeInstance appends the
+	count for the instance to that file (used by the performance tests).
+	If FMUCHK_SYNTHETIC_LOG_STEPS is set and logging is on, every completed
+	step is logged with status OK (used by the log filter tests).
+	FMUCHK_SYNTHETIC_STALL=<seconds> adds a busy wait of that length to each
+	fmi2GetDerivatives and fmi2DoStep call, and if FMUCHK_SYNTHETIC_EVENT_LOOP
+	is set fmi2NewDiscreteStates never clears newDiscreteStatesNeeded (used
+	by the watchdog tests). If FMUCHK_SYNTHETIC_NONDETERMINISTIC is set, the
+	number of fmi2SetupExperiment calls in the process so far is added to the
+	real outputs, so that repeated runs differ (used by the determinism tests).
+
+	The FMU state (time, states, inputs and event count) can be saved and
+	serialized. The serialized state is the syn_state_t structure as is.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "fmi2Functions.h"
+
+#if !defined(SYN_NX) || !defined(SYN_NZ) || !defined(SYN_NU) || !defined(SYN_NY) || !defined(SYN_NS) || !defined(SYN_COST) || !defined(SYN_GUID)
+#error "The model sizes are defined by fmuchk_gen_fmu"
+#endif
+
+#define SYN_VR_X 0
+#define SYN_VR_DX (SYN_VR_X + SYN_NX)
+#define SYN_VR_U (SYN_VR_DX + SYN_NX)
+#define SYN_VR_Y (SYN_VR_U + SYN_NU)
+#define SYN_VR_END (SYN_VR_Y + SYN_NY)
+
+/* Internal step of the co-simulation solver */
+#define SYN_CS_STEP 1e-3
+
+/* Number of fmi2SetupExperiment calls in the process (FMUCHK_SYNTHETIC_NONDETERMINISTIC) */
+static unsigned long synRuns = 0;
+
+typedef struct syn_model_t {
+	fmi2CallbackAllocateMemory allocateMemory;
+	fmi2CallbackFreeMemory freeMemory;
+	fmi2CallbackLogger logger;
+	fmi2ComponentEnvironment componentEnvironment;
+	fmi2Char* instanceName;
+	int logSteps;
+	int eventLoop;
+	double stall;
+	fmi2Real runOffset;
+	fmi2Real time;
+	fmi2Real* x;
+	fmi2Real* u;
+	unsigned long nEvents;
+	unsigned long numCalls;
+	double burnt;
+} syn_model_t;
+
+/* Saved FMU state. One extra element so that empty vectors are valid. */
+typedef struct syn_state_t {
+	fmi2Real time;
+	unsigned long nEvents;
+	double burnt;
+	fmi2Real x[SYN_NX + 1];
+	fmi2Real u[SYN_NU + 1];
+} syn_state_t;
+
+#define SYN_COUNT(c) (((syn_model_t*)(c))->numCalls++)
+
+static void syn_burn(syn_model_t* m) {
+	volatile double acc = m->burnt;
+	long i;
+	for(i = 0; i < SYN_COST; i++) acc = acc * 0.999999 + 1e-6;
+	m->burnt = acc;
+	if(m->stall > 0) {
+		clock_t end = clock() + (clock_t)(m->stall * CLOCKS_PER_SEC);
+		while(clock() < end);
+	}
+}
+
+static void syn_log_step(syn_model_t* m) {
+	if(m->logSteps && m->logger)
+		m->logger(m->componentEnvironment, m->instanceName, fmi2OK, "logStatusOK", "Step completed at time %g", m->time);
+}
+
+static fmi2Real syn_der(syn_model_t* m, size_t i) {
+	fmi2Real d = -(1.0 + (i % 10) * 0.1) * m->x[i];
+#if SYN_NU > 0
+	d += m->u[i % SYN_NU];
+#endif
+	return d;
+}
+
+static fmi2Real syn_output(syn_model_t* m, size_t k) {
+#if SYN_NX > 0
+	return m->x[k % SYN_NX] + m->runOffset;
+#else
+	return m->time + m->runOffset;
+#endif
+}
+
+const char* fmi2GetTypesPlatform(void) { return fmi2TypesPlatform; }
+const char* fmi2GetVersion(void) { return fmi2Version; }
+
+fmi2Status fmi2SetDebugLogging(fmi2Component c, fmi2Boolean loggingOn, size_t nCategories, const fmi2String categories[]) {
+	SYN_COUNT(c);
+	((syn_model_t*)c)->logSteps = loggingOn && getenv("FMUCHK_SYNTHETIC_LOG_STEPS");
+	return fmi2OK;
+}
+
+fmi2Component fmi2Instantiate(fmi2String instanceName, fmi2Type fmuType, fmi2String fmuGUID, fmi2String fmuResourceLocation,
+							  const fmi2CallbackFunctions* functions, fmi2Boolean visible, fmi2Boolean loggingOn) {
+	syn_model_t* m;
+	const char* stall = getenv("FMUCHK_SYNTHETIC_STALL");
+	if(!functions || !functions->allocateMemory || !functions->freeMemory) return 0;
+	if(!fmuGUID || strcmp(fmuGUID, SYN_GUID)) {
+		if(functions->logger)
+			functions->logger(functions->componentEnvironment, instanceName, fmi2Error, "error", "Wrong GUID %s, expected %s", fmuGUID, SYN_GUID);
+		return 0;
+	}
+	m = (syn_model_t*)functions->allocateMemory(1, sizeof(syn_model_t));
+	if(!m) return 0;
+	m->allocateMemory = functions->allocateMemory;
+	m->freeMemory = functions->freeMemory;
+	m->logger = functions->logger;
+	m->componentEnvironment = functions->componentEnvironment;
+	m->logSteps = loggingOn && getenv("FMUCHK_SYNTHETIC_LOG_STEPS");
+	m->eventLoop = getenv("FMUCHK_SYNTHETIC_EVENT_LOOP") != 0;
+	m->stall = stall ? atof(stall) : 0;
+	m->instanceName = (fmi2Char*)functions->allocateMemory(strlen(instanceName) + 1, sizeof(fmi2Char));
+	/* one extra element so that empty vectors are valid allocations */
+	m->x = (fmi2Real*)functions->allocateMemory(SYN_NX + 1, sizeof(fmi2Real));
+	m->u = (fmi2Real*)functions->allocateMemory(SYN_NU + 1, sizeof(fmi2Real));
+	if(!m->instanceName || !m->x || !m->u) {
+		m->freeMemory(m->instanceName);
+		m->freeMemory(m->x);
+		m->freeMemory(m->u);
+		m->freeMemory(m);
+		return 0;
+	}
+	strcpy(m->instanceName, instanceName);
+	fmi2Reset(m);
+	m->numCalls = 1;
+	return m;
+}
+
+void fmi2FreeInstance(fmi2Component c) {
+	syn_model_t* m = (syn_model_t*)c;
+	const char* callsFile = getenv("FMUCHK_SYNTHETIC_CALLS_FILE");
+	if(!m) return;
+	SYN_COUNT(c);
+	if(callsFile) {
+		FILE* f = fopen(callsFile, "a");
+		if(f) {
+			fprintf(f, "%lu\n", m->numCalls);
+			fclose(f);
+		}
+	}
+	m->freeMemory(m->instanceName);
+	m->freeMemory(m->x);
+	m->freeMemory(m->u);
+	m->freeMemory(m);
+}
+
+fmi2Status fmi2SetupExperiment(fmi2Component c, fmi2Boolean toleranceDefined, fmi2Real tolerance, fmi2Real startTime,
+							   fmi2Boolean stopTimeDefined, fmi2Real stopTime) {
+	syn_model_t* m = (syn_model_t*)c;
+	SYN_COUNT(c);
+	m->time = startTime;
+	m->runOffset = getenv("FMUCHK_SYNTHETIC_NONDETERMINISTIC") ? (fmi2Real)++synRuns : 0;
+	return fmi2OK;
+}
+
+fmi2Status fmi2EnterInitializationMode(fmi2Component c) { SYN_COUNT(c); return fmi2OK; }
+fmi2Status fmi2ExitInitializationMode(fmi2Component c) { SYN_COUNT(c); return fmi2OK; }
+fmi2Status fmi2Terminate(fmi2Component c) { SYN_COUNT(c); return fmi2OK; }
+
+fmi2Status fmi2Reset(fmi2Component c) {
+	syn_model_t* m = (syn_model_t*)c;
+	size_t i;
+	SYN_COUNT(c);
+	m->time = 0;
+	m->nEvents = 0;
+	m->burnt = 0;
+	for(i = 0; i < SYN_NX; i++) m->x[i] = 1.0;
+	for(i = 0; i < SYN_NU; i++) m->u[i] = 0.0;
+	return fmi2OK;
+}
+
+fmi2Status fmi2GetReal(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, fmi2Real value[]) {
+	syn_model_t* m = (syn_model_t*)c;
+	size_t i;
+	SYN_COUNT(c);
+	for(i = 0; i < nvr; i++) {
+		fmi2ValueReference r = vr[i];
+		if(r < SYN_VR_DX) value[i] = m->x[r - SYN_VR_X];
+		else if(r < SYN_VR_U) value[i] = syn_der(m, r - SYN_VR_DX);
+		else if(r < SYN_VR_Y) value[i] = m->u[r - SYN_VR_U];
+		else if(r < SYN_VR_END) value[i] = syn_output(m, r - SYN_VR_Y);
+		else return fmi2Error;
+	}
+	return fmi2OK;
+}
+
+fmi2Status fmi2GetInteger(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, fmi2Integer value[]) {
+	SYN_COUNT(c);
+	return nvr ? fmi2Error : fmi2OK;
+}
+
+fmi2Status fmi2GetBoolean(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, fmi2Boolean value[]) {
+	SYN_COUNT(c);
+	return nvr ? fmi2Error : fmi2OK;
+}
+
+fmi2Status fmi2GetString(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, fmi2String value[]) {
+	syn_model_t* m = (syn_model_t*)c;
+	size_t i;
+	SYN_COUNT(c);
+	for(i = 0; i < nvr; i++) {
+		if(vr[i] >= SYN_NS) return fmi2Error;
+		value[i] = ((m->nEvents + vr[i]) & 1) ? "odd" : "even";
+	}
+	return fmi2OK;
+}
+
+fmi2Status fmi2SetReal(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, const fmi2Real value[]) {
+	syn_model_t* m = (syn_model_t*)c;
+	size_t i;
+	SYN_COUNT(c);
+	for(i = 0; i < nvr; i++) {
+		fmi2ValueReference r = vr[i];
+		if(r < SYN_VR_DX) m->x[r - SYN_VR_X] = value[i];
+		else if((r >= SYN_VR_U) && (r < SYN_VR_Y)) m->u[r - SYN_VR_U] = value[i];
+		else return fmi2Error;
+	}
+	return fmi2OK;
+}
+
+fmi2Status fmi2SetInteger(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, const fmi2Integer value[]) {
+	SYN_COUNT(c);
+	return nvr ? fmi2Error : fmi2OK;
+}
+
+fmi2Status fmi2SetBoolean(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, const fmi2Boolean value[]) {
+	SYN_COUNT(c);
+	return nvr ? fmi2Error : fmi2OK;
+}
+
+fmi2Status fmi2SetString(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, const fmi2String value[]) {
+	SYN_COUNT(c);
+	return nvr ? fmi2Error : fmi2OK;
+}
+
+fmi2Status fmi2GetFMUstate(fmi2Component c, fmi2FMUstate* FMUstate) {
+	syn_model_t* m = (syn_model_t*)c;
+	syn_state_t* s = (syn_state_t*)*FMUstate;
+	SYN_COUNT(c);
+	if(!s) {
+		s = (syn_state_t*)m->allocateMemory(1, sizeof(syn_state_t));
+		if(!s) return fmi2Error;
+		*FMUstate = s;
+	}
+	s->time = m->time;
+	s->nEvents = m->nEvents;
+	s->burnt = m->burnt;
+	memcpy(s->x, m->x, sizeof(s->x));
+	memcpy(s->u, m->u, sizeof(s->u));
+	return fmi2OK;
+}
+
+fmi2Status fmi2SetFMUstate(fmi2Component c, fmi2FMUstate FMUstate) {
+	syn_model_t* m = (syn_model_t*)c;
+	const syn_state_t* s = (const syn_state_t*)FMUstate;
+	SYN_COUNT(c);
+	if(!s) return fmi2Error;
+	m->time = s->time;
+	m->nEvents = s->nEvents;
+	m->burnt = s->burnt;
+	memcpy(m->x, s->x, sizeof(s->x));
+	memcpy(m->u, s->u, sizeof(s->u));
+	return fmi2OK;
+}
+
+fmi2Status fmi2FreeFMUstate(fmi2Component c, fmi2FMUstate* FMUstate) {
+	SYN_COUNT(c);
+	((syn_model_t*)c)->freeMemory(*FMUstate);
+	*FMUstate = 0;
+	return fmi2OK;
+}
+
+fmi2Status fmi2SerializedFMUstateSize(fmi2Component c, fmi2FMUstate FMUstate, size_t* size) {
+	SYN_COUNT(c);
+	*size = sizeof(syn_state_t);
+	return fmi2OK;
+}
+
+fmi2Status fmi2SerializeFMUstate(fmi2Component c, fmi2FMUstate FMUstate, fmi2Byte serializedState[], size_t size) {
+	SYN_COUNT(c);
+	if(!FMUstate || (size < sizeof(syn_state_t))) return fmi2Error;
+	memcpy(serializedState, FMUstate, sizeof(syn_state_t));
+	return fmi2OK;
+}
+
+fmi2Status fmi2DeSerializeFMUstate(fmi2Component c, const fmi2Byte serializedState[], size_t size, fmi2FMUstate* FMUstate) {
+	syn_state_t* s;
+	SYN_COUNT(c);
+	if(size != sizeof(syn_state_t)) return fmi2Error;
+	s = (syn_state_t*)((syn_model_t*)c)->allocateMemory(1, sizeof(syn_state_t));
+	if(!s) return fmi2Error;
+	memcpy(s, serializedState, sizeof(syn_state_t));
+	*FMUstate = s;
+	return fmi2OK;
+}
+
+fmi2Status fmi2GetDirectionalDerivative(fmi2Component c, const fmi2ValueReference vUnknown_ref[], size_t nUnknown,
+										const fmi2ValueReference vKnown_ref[], size_t nKnown,
+										const fmi2Real dvKnown[], fmi2Real dvUnknown[]) {
+	SYN_COUNT(c);
+	return fmi2Error;
+}
+
+/* Model exchange */
+fmi2Status fmi2EnterEventMode(fmi2Component c) {
+	SYN_COUNT(c);
+	((syn_model_t*)c)->nEvents++;
+	return fmi2OK;
+}
+
+fmi2Status fmi2NewDiscreteStates(fmi2Component c, fmi2EventInfo* eventInfo) {
+	SYN_COUNT(c);
+	eventInfo->newDiscreteStatesNeeded = ((syn_model_t*)c)->eventLoop ? fmi2True : fmi2False;
+	eventInfo->terminateSimulation = fmi2False;
+	eventInfo->nominalsOfContinuousStatesChanged = fmi2False;
+	eventInfo->valuesOfContinuousStatesChanged = fmi2False;
+	eventInfo->nextEventTimeDefined = fmi2False;
+	eventInfo->nextEventTime = 0;
+	return fmi2OK;
+}
+
+fmi2Status fmi2EnterContinuousTimeMode(fmi2Component c) { SYN_COUNT(c); return fmi2OK; }
+
+fmi2Status fmi2CompletedIntegratorStep(fmi2Component c, fmi2Boolean noSetFMUStatePriorToCurrentPoint,
+									   fmi2Boolean* enterEventMode, fmi2Boolean* terminateSimulation) {
+	SYN_COUNT(c);
+	*enterEventMode = fmi2False;
+	*terminateSimulation = fmi2False;
+	syn_log_step((syn_model_t*)c);
+	return fmi2OK;
+}
+
+fmi2Status fmi2SetTime(fmi2Component c, fmi2Real time) { SYN_COUNT(c); ((syn_model_t*)c)->time = time; return fmi2OK; }
+
+fmi2Status fmi2SetContinuousStates(fmi2Component c, const fmi2Real x[], size_t nx) {
+	syn_model_t* m = (syn_model_t*)c;
+	SYN_COUNT(c);
+	if(nx != SYN_NX) return fmi2Error;
+	if(nx) memcpy(m->x, x, nx * sizeof(fmi2Real));
+	return fmi2OK;
+}
+
+fmi2Status fmi2GetDerivatives(fmi2Component c, fmi2Real derivatives[], size_t nx) {
+	syn_model_t* m = (syn_model_t*)c;
+	size_t i;
+	SYN_COUNT(c);
+	if(nx != SYN_NX) return fmi2Error;
+	syn_burn(m);
+	for(i = 0; i < nx; i++) derivatives[i] = syn_der(m, i);
+	return fmi2OK;
+}
+
+fmi2Status fmi2GetEventIndicators(fmi2Component c, fmi2Real eventIndicators[], size_t ni) {
+	syn_model_t* m = (syn_model_t*)c;
+	size_t j;
+	SYN_COUNT(c);
+	if(ni != SYN_NZ) return fmi2Error;
+	for(j = 0; j < ni; j++) eventIndicators[j] = m->time - (j + 1.0) / (SYN_NZ + 1.0);
+	return fmi2OK;
+}
+
+fmi2Status fmi2GetContinuousStates(fmi2Component c, fmi2Real x[], size_t nx) {
+	syn_model_t* m = (syn_model_t*)c;
+	SYN_COUNT(c);
+	if(nx != SYN_NX) return fmi2Error;
+	if(nx) memcpy(x, m->x, nx * sizeof(fmi2Real));
+	return fmi2OK;
+}
+
+fmi2Status fmi2GetNominalsOfContinuousStates(fmi2Component c, fmi2Real x_nominal[], size_t nx) {
+	size_t i;
+	SYN_COUNT(c);
+	for(i = 0; i < nx; i++) x_nominal[i] = 1.0;
+	return fmi2OK;
+}
+
+/* Co-simulation: explicit Euler with a fixed internal step */
+fmi2Status fmi2SetRealInputDerivatives(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, const fmi2Integer order[], const fmi2Real value[]) {
+	SYN_COUNT(c);
+	return fmi2Error;
+}
+
+fmi2Status fmi2GetRealOutputDerivatives(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, const fmi2Integer order[], fmi2Real value[]) {
+	SYN_COUNT(c);
+	return fmi2Error;
+}
+
+fmi2Status fmi2DoStep(fmi2Component c, fmi2Real currentCommunicationPoint, fmi2Real communicationStepSize, fmi2Boolean noSetFMUStatePriorToCurrentPoint) {
+	syn_model_t* m = (syn_model_t*)c;
+	long n = (long)ceil(communicationStepSize / SYN_CS_STEP);
+	fmi2Real h;
+	long k;
+	size_t i;
+	SYN_COUNT(c);
+	if(n < 1) n = 1;
+	h = communicationStepSize / n;
+	syn_burn(m);
+	m->time = currentCommunicationPoint;
+	for(k = 0; k < n; k++) {
+		for(i = 0; i < SYN_NX; i++) m->x[i] += h * syn_der(m, i);
+		m->time += h;
+	}
+	m->time = currentCommunicationPoint + communicationStepSize;
+	syn_log_step(m);
+	return fmi2OK;
+}
+
+fmi2Status fmi2CancelStep(fmi2Component c) { SYN_COUNT(c); return fmi2Error; }
+fmi2Status fmi2GetStatus(fmi2Component c, const fmi2StatusKind s, fmi2Status* value) { SYN_COUNT(c); return fmi2Discard; }
+fmi2Status fmi2GetRealStatus(fmi2Component c, const fmi2StatusKind s, fmi2Real* value) { SYN_COUNT(c); return fmi2Discard; }
+fmi2Status fmi2GetIntegerStatus(fmi2Component c, const fmi2StatusKind s, fmi2Integer* value) { SYN_COUNT(c); return fmi2Discard; }
+fmi2Status fmi2GetBooleanStatus(fmi2Component c, const fmi2StatusKind s, fmi2Boolean* value) { SYN_COUNT(c); return fmi2Discard; }
+fmi2Status fmi2GetStringStatus(fmi2Component c, const fmi2StatusKind s, fmi2String* value) { SYN_COUNT(c); return fmi2Discard; }
@@ -43,18 +43,23 @@ int allocated_mem_blocks = 0;
 
 void* check_calloc(size_t nobj, size_t size) {
 	void* ret = calloc(nobj, size);
+	/* FMUs may be running in several threads (--cosim) */
+	fmu_check_global_lock();
 	if(ret) allocated_mem_blocks++;
 	jm_log_verbose(&cdata_global_ptr->callbacks, fmu_checker_module,
 		"allocateMemory( %u, %u) called. Returning pointer: %p",nobj,size,ret);
+	fmu_check_global_unlock();
 	return ret;
 }
 
 void  check_free(void* obj) {
+	fmu_check_global_lock();
 	jm_log_verbose(&cdata_global_ptr->callbacks, fmu_checker_module, "freeMemory(%p) called", obj);
 	if(obj) {
 		free(obj);
 		allocated_mem_blocks--;
 	}
+	fmu_check_global_unlock();
 }
 
 void checker_logger(jm_callbacks* c, jm_string module, jm_log_level_enu_t log_level, jm_string message) {
@@ -68,15 +73,31 @@ void checker_logger(jm_callbacks* c, jm_string module, jm_log_level_enu_t log_le
 	else if(log_level == jm_log_level_fatal)
 		cdata->num_fatal++;
 
-	if(log_level)
-		ret = fprintf(cdata->log_file, "[%s][%s] %s\n", jm_log_level_to_string(log_level), module, message);
-	else
-		ret = fprintf(cdata->log_file, "%s\n", message);
+	if(cdata->log_stream) {
+		/* the compressed log is written in large blocks, no flushing */
+		if(log_level)
+			ret = fmu_check_stream_printf(cdata->log_stream, "[%s][%s] %s\n", jm_log_level_to_string(log_level), module, message);
+		else
+			ret = fmu_check_stream_printf(cdata->log_stream, "%s\n", message);
+	}
+	else {
+		if(log_level)
+			ret = fprintf(cdata->log_file, "[%s][%s] %s\n", jm_log_level_to_string(log_level), module, message);
+		else
+			ret = fprintf(cdata->log_file, "%s\n", message);
 
-	fflush(cdata->log_file);
+		fflush(cdata->log_file);
+	}
 
 	if(ret <= 0) {
-		fclose(cdata->log_file);
+		/* Only the checker data that opened the log file (log_file_name is set) closes it.
+		   Child data of other FMUs and instances share the file and just fall back to stderr. */
+		if(cdata->log_stream) {
+			if(cdata->log_file_name) fmu_check_stream_close(cdata->log_stream);
+			cdata->log_stream = 0;
+		}
+		else if(cdata->log_file_name && (cdata->log_file != stderr))
+			fclose(cdata->log_file);
 		cdata->log_file = stderr;
 		fprintf(stderr, "[%s][%s] %s\n", jm_log_level_to_string(log_level), module, message);
 		fprintf(stderr, "[%s][%s] %s\n", jm_log_level_to_string(jm_log_level_fatal), module, "Error writing to the log file");
@@ -95,13 +116,15 @@ void print_version() {
 
 void print_usage( ) {
     print_version();
-	printf(	"Usage: fmuCheck." FMI_PLATFORM " [options] <model.fmu>\n\n"
+	printf(	"Usage: fmuCheck." FMI_PLATFORM " [options] <model.fmu>\n"
+		"       fmuCheck." FMI_PLATFORM " [options] --cosim <connections.txt>\n\n"
 		"Options:\n\n"
 		"-c <separator>   Separator character to be used in CSV output. Default is ','.\n\n"
         "-d               Print also left limit values at event points to the output\n"
         "                 file to investigate event behaviour. Default is to only print\n"
         "                 values after event handling.\n\n"
-        "-e <filename>    Error log file name. Default is to use standard error.\n\n"
+        "-e <filename>    Error log file name. Default is to use standard error.\n"
+        "                 The log is compressed if the name ends with .gz or .zst.\n\n"
         "-f               Print all variables to the output file. Default is to only\n"
         "                 print outputs.\n\n"
         "-h <stepSize>    For ME simulation: Decides step size to use in forward Euler.\n"
@@ -113,6 +136,10 @@ void print_usage( ) {
         "                 points. See the -n option for how the number of outputs is\n"
         "                 set.\n\n"
         "-i <infile>      Name of the CSV file name with input data.\n\n"
+        "-j <numThreads>  Number of threads to use for stepping the FMUs in co-simulation\n"
+        "                 mode (--cosim), for the runs in a parameter sweep (--sweep)\n"
+        "                 for parsing large input files (-i) and for unpacking the\n"
+        "                 FMU. Default is 0, i.e., one thread per processor.\n\n"
         "-l <log level>   Log level: 0 - no logging, 1 - fatal errors only, 2 - errors, \n"
         "                 3 - warnings, 4 - info, 5 - verbose, 6 - debug.\n\n"
         "-m               Mangle variable names to avoid quoting (needed for some CSV\n"
@@ -121,16 +148,27 @@ void print_usage( ) {
         "-n <numSteps>    Maximum number of output points. \"-n 0\" means output at every\n"
         "                 step and the number of outputs are decided by the -h option.\n"
         "                 Observe that no interpolation is used, output points are taken\n"
-        "                 at the steps.\n"
+        "                 at the steps (see --resample).\n"
         "                 Default is " DEFAULT_MAX_OUTPUT_PTS_STR ".\n\n"
         "-o <filename>    Simulation result output CSV file name. Default is to use\n"
-        "                 standard output.\n\n"
+        "                 standard output. The file is written gzip compressed if the\n"
+        "                 name ends with .gz and zstd compressed if it ends with .zst\n"
+        "                 (if supported by the build). The compression runs in a\n"
+        "                 separate thread.\n\n"
+        "-r <maxRepeats>[:<interval>]\n"
+        "                 Print an FMU log message at most maxRepeats times. The key\n"
+        "                 for a message is its category, status and unformatted text.\n"
+        "                 Further repeats are suppressed and a line with the number of\n"
+        "                 suppressed repeats is printed every <interval> messages\n"
+        "                 (default " DEFAULT_LOG_REPEAT_REPORT_INTERVAL_STR ", 0 means only in the summary).\n"
+        "                 Default is 0, i.e., no messages are suppressed.\n\n"
         "-s <stopTime>    Simulation stop time, default is to use information from\n"
         "                 'DefaultExperiment' as specified in the model description XML.\n\n"
         "-t <tmp-dir>     Temporary dir to use for unpacking the FMU.\n"
         "                 Default is to use system-wide directory, e.g., C:\\Temp or /tmp.\n\n"
         "-v               Print the checker version information.\n\n"
-        "-k xml           Check XML only.\n"
+        "-k xml           Check XML only. Only modelDescription.xml is extracted\n"
+        "                 from the FMU.\n"
         "-k me            Check XML and ME simulation.\n"
         "-k cs            Check XML and CS simulation.\n"
         "                 Multiple -k options add up.\n"
@@ -140,6 +178,133 @@ void print_usage( ) {
         "-z <unzip-dir>   Do not create and remove a temp directory but instead use the\n"
         "                 specified one for unpacking the FMU. The option takes \n"
         "                 precendence over -t.\n\n"
+        "--cosim          Co-simulate several FMI 2.0 CS FMUs. The last argument is a\n"
+        "                 connection file instead of an FMU. Each line of the file is\n"
+        "                 either 'fmu <name> <path>' declaring an FMU, or\n"
+        "                 '<name>.<output> -> <name>.<input>' connecting an output of\n"
+        "                 one FMU to an input of another. Lines starting with '#' are\n"
+        "                 comments. Relative FMU paths are relative to the connection\n"
+        "                 file. The FMUs are stepped with a fixed communication step\n"
+        "                 size (-h). FMUs are stepped in dependency order and FMUs that\n"
+        "                 do not depend on each other are stepped in parallel (-j).\n"
+        "                 FMUs in a connection loop get the inputs from each other\n"
+        "                 from the previous communication step. The simulation covers\n"
+        "                 the time range common to the default experiments of the FMUs.\n"
+        "                 Outputs of all the FMUs are written to the output file.\n\n"
+        "--sweep <paramfile>\n"
+        "                 Simulate an FMI 2.0 FMU once for each parameter set in the\n"
+        "                 CSV file. The first line lists parameter or input names and\n"
+        "                 each following line gives the values for one run. The FMU\n"
+        "                 is unpacked and loaded once and the instance is reset with\n"
+        "                 fmi2Reset between the runs. Runs are done in parallel (-j)\n"
+        "                 if the FMU can be instantiated more than once per process.\n"
+        "                 ME is simulated unless -k cs is given or only CS is\n"
+        "                 supported. Requires -o: the output of run N is written to\n"
+        "                 <name>_N.<ext> for '-o <name>.<ext>'.\n\n"
+        "--state-cache <dir>\n"
+        "                 Save the state of an FMI 2.0 FMU after initialization in\n"
+        "                 the directory (the FMU must be able to serialize its state).\n"
+        "                 Later runs with the same GUID, start time, parameter values\n"
+        "                 and start inputs restore the saved state instead of\n"
+        "                 initializing the FMU. The time to restore and the time the\n"
+        "                 original initialization took are logged (-l 4).\n\n"
+        "--stats <file>   Write statistics of the run to the file in JSON format: the\n"
+        "                 exit code, wall clock and CPU time in seconds, peak\n"
+        "                 resident set size in kilobytes, the message counts and the\n"
+        "                 elapsed and CPU time of each phase of the check (unzip,\n"
+        "                 XML parsing, loading the binary, instantiation,\n"
+        "                 initialization, simulation, termination and cleanup). The\n"
+        "                 time of the phases is also printed in the summary.\n\n"
+        "--timeout <seconds>\n"
+        "                 Abort the run if it takes longer than the given wall clock\n"
+        "                 time.\n\n"
+        "--call-timeout <seconds>\n"
+        "                 Abort the run if a single FMI call takes longer than the\n"
+        "                 given wall clock time. On a timeout the FMI function and\n"
+        "                 the simulation time are logged, the output written so far\n"
+        "                 is kept, the summary is printed and the exit code is 2.\n\n"
+        "--max-event-iterations <n>\n"
+        "                 Maximum number of fmi2NewDiscreteStates calls in one event\n"
+        "                 iteration. Default is " FMUCHK_DEFAULT_MAX_EVENT_ITERATIONS_STR ".\n\n"
+        "--realtime <factor>\n"
+        "                 Pace the simulation to wall clock time: <factor> simulated\n"
+        "                 seconds per second (1 is real time). Each step is given an\n"
+        "                 absolute deadline. The step compute time (WCET estimate),\n"
+        "                 the slack, the missed deadlines and a histogram of the\n"
+        "                 release jitter are reported at the end (-l 4).\n\n"
+        "--resample       Write the output of FMI 2.0 FMUs at the exact output times\n"
+        "                 (-n) instead of at the first step after each of them. Real\n"
+        "                 values are linearly interpolated between the steps, discrete\n"
+        "                 values hold the value of the earlier step. The step size\n"
+        "                 (-h) can then be chosen independently of the output points.\n\n"
+        "--determinism    Check that an FMI 2.0 simulation is deterministic: simulate\n"
+        "                 again with a new instance and compare the output rows\n"
+        "                 bitwise with the first run (only the first run is written).\n"
+        "                 The first time and variable that differ are reported.\n\n"
+        "--determinism-reset\n"
+        "                 As --determinism and also simulate a third time after\n"
+        "                 resetting the instance with fmi2Reset.\n\n"
+        "--reference <file>\n"
+        "                 Compare the FMI 2.0 output with a reference result (CSV\n"
+        "                 with the time first and the variable names in the header)\n"
+        "                 while simulating and report which signals pass. Reference\n"
+        "                 signals are matched by name with the output columns (see\n"
+        "                 --vars and -f). Without -o the output is not written.\n\n"
+        "--ref-tol <relTol>[,<absTol>] | @<file>\n"
+        "                 Tolerance of the reference comparison: absTol + relTol\n"
+        "                 times the largest absolute reference value of the signal.\n"
+        "                 Default is 1e-3,0. Per-signal tolerances can be given in a\n"
+        "                 file with lines '<pattern> <relTol> [<absTol>]'; the first\n"
+        "                 matching pattern ('*' and '?' wildcards) is used.\n\n"
+        "--ref-tube <width>\n"
+        "                 Half width of the time tube around each output point as a\n"
+        "                 fraction of the reference time span. Values pass if they\n"
+        "                 are within the tolerance of the reference range in the\n"
+        "                 tube, so shifted discontinuities do not fail. Default is\n"
+        "                 1e-3.\n\n"
+        "--ref-max-violations <n>\n"
+        "                 Stop the simulation after n values outside of the\n"
+        "                 reference tolerance. Default is 0, i.e., no limit.\n\n"
+        "--compare-me-cs  For FMI 2.0 FMUs with both ME and CS: keep the ME output\n"
+        "                 in memory and compare the CS output with it while\n"
+        "                 simulating, as for --reference. The options --ref-tol,\n"
+        "                 --ref-tube and --ref-max-violations apply. The first\n"
+        "                 time and signal that differ are reported. CS is\n"
+        "                 simulated on a second thread at the same time as ME\n"
+        "                 unless -j 1, --determinism or --state-cache is given or\n"
+        "                 the FMU can only be instantiated once per process.\n\n"
+        "--instances <K>  For FMI 2.0 CS FMUs: after the simulation, load the FMU K\n"
+        "                 times and simulate 1, 2, 4, ... and K instances\n"
+        "                 concurrently, one thread per instance. The outputs of\n"
+        "                 each instance are compared with a single-instance run;\n"
+        "                 differences point to state shared between instances.\n"
+        "                 The throughput (steps/s) is reported for each number of\n"
+        "                 instances. Skipped if the FMU can only be instantiated\n"
+        "                 once per process. Inputs (-i) are not set.\n\n"
+        "--vars <patterns>\n"
+        "                 Write the FMI 2.0 variables whose names match one of the\n"
+        "                 comma separated patterns to the output file instead of the\n"
+        "                 outputs. '*' matches any sequence of characters and '?' any\n"
+        "                 single character, e.g., --vars \"h,der(*),x[1,?]\". With\n"
+        "                 '@<file>' the patterns are read from the file, one per line\n"
+        "                 ('#' starts a comment line). Overrides -f. Only the selected\n"
+        "                 variables are read from the FMU, without --vars all the\n"
+        "                 variables are read at each output point.\n\n"
+        "--stream-input   Read the FMI 2.0 input file (-i) during the simulation\n"
+        "                 instead of loading it before. A background thread reads\n"
+        "                 ahead into a window of rows and the rows before the current\n"
+        "                 time are dropped, so input files larger than the memory can\n"
+        "                 be used.\n\n"
+        "--input-cache    Save the parsed FMI 2.0 input data (-i) in a binary file\n"
+        "                 next to the input file (<infile>" FMI2_INPUT_CACHE_EXT "). Later runs with\n"
+        "                 --input-cache map the file into memory instead of parsing\n"
+        "                 the input file as long as the input file is unchanged.\n\n"
+        "--extract-all    Unpack the whole FMU before checking it. By default only\n"
+        "                 modelDescription.xml is extracted first. For simulation\n"
+        "                 the binaries for this platform and then the resources are\n"
+        "                 extracted in the background while the XML is parsed, and\n"
+        "                 binaries for other platforms and the sources are skipped.\n"
+        "                 Entries are extracted in parallel (-j).\n\n"
         "Command line examples:\n\n"
         "fmuCheck." FMI_PLATFORM " model.fmu\n"
         "       The checker will process 'model.fmu'  with default options.\n\n"
@@ -149,7 +314,13 @@ void print_usage( ) {
         "       result.csv and semicolon will be used for field separation in the CSV\n"
         "       file. The checker will simulate the FMU until 2 seconds with \n"
         "       time step 1e-3 seconds. Verbose messages will be generated.\n"
-        "       Temporary files will be created in the current directory.\n"
+        "       Temporary files will be created in the current directory.\n\n"
+        "fmuCheck." FMI_PLATFORM " -h 1e-3 -j 2 -o result.csv --cosim system.txt\n"
+        "       The checker will co-simulate the FMUs listed in 'system.txt' using\n"
+        "       two threads and the communication step size 1e-3 seconds.\n\n"
+        "fmuCheck." FMI_PLATFORM " -o result.csv --sweep params.csv model.fmu\n"
+        "       The checker will simulate 'model.fmu' once for each line in\n"
+        "       'params.csv' and write the results to result_1.csv, result_2.csv...\n"
         );
 }
 
@@ -168,6 +339,126 @@ void parse_options(int argc, char *argv[], fmu_check_data_t* cdata) {
 	i=1;
 	while(i < (size_t)(argc - 1)) {
 		const char* option = argv[i];
+		if((option[0] == '-') && (option[1] == '-')) {
+			if(strcmp(option, "--cosim") == 0) {
+				cdata->do_cosim = 1;
+			}
+			else if(strcmp(option, "--resample") == 0) {
+				cdata->resampleOutput = 1;
+			}
+			else if(strcmp(option, "--determinism") == 0) {
+				if(!cdata->determinism) cdata->determinism = 1;
+			}
+			else if(strcmp(option, "--determinism-reset") == 0) {
+				cdata->determinism = 2;
+			}
+			else if(strcmp(option, "--stream-input") == 0) {
+				cdata->streamInput = 1;
+			}
+			else if(strcmp(option, "--input-cache") == 0) {
+				cdata->inputCache = 1;
+			}
+			else if(strcmp(option, "--input-chunk-size") == 0) {
+				/* not in the usage text: lets the tests parse small input files in several chunks */
+				long n;
+				i++;
+				if((sscanf(argv[i], "%ld", &n) != 1) || (n < 1)) {
+					jm_log_fatal(&cdata->callbacks,fmu_checker_module,"Error parsing command line. Expected number of bytes after '--input-chunk-size'.\nRun without arguments to see help.");
+					do_exit(1);
+				}
+				cdata->inputChunkSize = (size_t)n;
+			}
+			else if(strcmp(option, "--extract-all") == 0) {
+				cdata->extractAll = 1;
+			}
+			else if(strcmp(option, "--vars") == 0) {
+				i++;
+				cdata->outputVarsSpec = argv[i];
+			}
+			else if(strcmp(option, "--reference") == 0) {
+				i++;
+				cdata->referenceFileName = argv[i];
+			}
+			else if(strcmp(option, "--instances") == 0) {
+				int n;
+				i++;
+				if((sscanf(argv[i], "%d", &n) != 1) || (n < 1) || (n > FMI2_MULTI_INSTANCE_MAX)) {
+					jm_log_fatal(&cdata->callbacks,fmu_checker_module,"Error parsing command line. Expected number of instances (1 to %d) after '--instances'.\nRun without arguments to see help.",
+						FMI2_MULTI_INSTANCE_MAX);
+					do_exit(1);
+				}
+				cdata->numInstances = (size_t)n;
+			}
+			else if(strcmp(option, "--compare-me-cs") == 0) {
+				cdata->compareMeCs = 1;
+			}
+			else if(strcmp(option, "--ref-tol") == 0) {
+				i++;
+				cdata->referenceTolSpec = argv[i];
+			}
+			else if(strcmp(option, "--ref-tube") == 0) {
+				i++;
+				if((sscanf(argv[i], "%lg", &cdata->referenceTube) != 1) || (cdata->referenceTube < 0)) {
+					jm_log_fatal(&cdata->callbacks,fmu_checker_module,"Error parsing command line. Expected non-negative tube width after '--ref-tube'.\nRun without arguments to see help.");
+					do_exit(1);
+				}
+			}
+			else if(strcmp(option, "--ref-max-violations") == 0) {
+				int n;
+				i++;
+				if((sscanf(argv[i], "%d", &n) != 1) || (n < 0)) {
+					jm_log_fatal(&cdata->callbacks,fmu_checker_module,"Error parsing command line. Expected number of violations after '--ref-max-violations'.\nRun without arguments to see help.");
+					do_exit(1);
+				}
+				cdata->referenceMaxViolations = (size_t)n;
+			}
+			else if(strcmp(option, "--sweep") == 0) {
+				i++;
+				cdata->sweepFileName = argv[i];
+			}
+			else if(strcmp(option, "--state-cache") == 0) {
+				i++;
+				cdata->stateCacheDir = argv[i];
+			}
+			else if(strcmp(option, "--stats") == 0) {
+				i++;
+				cdata->statsFileName = argv[i];
+			}
+			else if((strcmp(option, "--timeout") == 0) || (strcmp(option, "--call-timeout") == 0)) {
+				double t;
+				i++;
+				if((sscanf(argv[i], "%lg", &t) != 1) || (t <= 0)) {
+					jm_log_fatal(&cdata->callbacks,fmu_checker_module,"Error parsing command line. Expected positive number of seconds after '%s'.\nRun without arguments to see help.", option);
+					do_exit(1);
+				}
+				if(option[2] == 't')
+					cdata->totalTimeout = t;
+				else
+					cdata->callTimeout = t;
+			}
+			else if(strcmp(option, "--max-event-iterations") == 0) {
+				int n;
+				i++;
+				if((sscanf(argv[i], "%d", &n) != 1) || (n <= 0)) {
+					jm_log_fatal(&cdata->callbacks,fmu_checker_module,"Error parsing command line. Expected positive number after '--max-event-iterations'.\nRun without arguments to see help.");
+					do_exit(1);
+				}
+				cdata->maxEventIterations = (unsigned int)n;
+			}
+			else if(strcmp(option, "--realtime") == 0) {
+				i++;
+				if((sscanf(argv[i], "%lg", &cdata->realtimeFactor) != 1) || (cdata->realtimeFactor <= 0)) {
+					jm_log_fatal(&cdata->callbacks,fmu_checker_module,"Error parsing command line. Expected positive real-time factor after '--realtime'.\nRun without arguments to see help.");
+					do_exit(1);
+				}
+			}
+			else {
+				jm_log_fatal(&cdata->callbacks,fmu_checker_module,"Unsupported command line option %s.\nRun without arguments to see help.", option);
+				do_exit(1);
+			}
+			i++;
+			continue;
+		}
 		if((option[0] != '-') || (option[2] != 0)) {
 			jm_log_fatal(&cdata->callbacks,fmu_checker_module,"Error parsing command line. Expected a single character option but got %s.\nRun without arguments to see help.", option);
 			do_exit(1);
@@ -248,6 +539,33 @@ void parse_options(int argc, char *argv[], fmu_check_data_t* cdata) {
 			cdata->callbacks.log_level = (jm_log_level_enu_t)log_level;
 			break;
 		}
+		case 'r': {/*<maxRepeats>[:<interval>]\t Print FMU log message at most maxRepeats times.\n"*/
+			unsigned maxRepeats, interval;
+			int n;
+			i++;
+			option = argv[i];
+			n = sscanf(option, "%u:%u", &maxRepeats, &interval);
+			if((n < 1) || (option[0] == '-')) {
+				jm_log_fatal(&cdata->callbacks,fmu_checker_module,"Error parsing command line. Expected maximum number of repeats after '-r'.\nRun without arguments to see help.");
+				do_exit(1);
+			}
+			cdata->fmu_log_filter.maxRepeats = maxRepeats;
+			if(n == 2) {
+				cdata->fmu_log_filter.reportInterval = interval;
+			}
+			break;
+				  }
+		case 'j': {/*<numThreads>\t Number of threads to use in co-simulation mode. Zero means one per processor.\n"*/
+			int n;
+			i++;
+			option = argv[i];
+			if((sscanf(option, "%d", &n) != 1) || (n < 0)) {
+				jm_log_fatal(&cdata->callbacks,fmu_checker_module,"Error parsing command line. Expected number of threads after '-j'.\nRun without arguments to see help.");
+				do_exit(1);
+			}
+			cdata->num_threads = (size_t)n;
+			break;
+				  }
 		case 'c': {/*csvSeparator>\t Separator character to be used. Default is ','.\n"*/
 			i++;
 			option = argv[i];
@@ -319,12 +637,79 @@ void parse_options(int argc, char *argv[], fmu_check_data_t* cdata) {
 		do_exit(1);
 	}
 	cdata->FMUPath = argv[i];
+	if(cdata->do_cosim && (cdata->inputFileName || cdata->unzipPath)) {
+		jm_log_warning(&cdata->callbacks,fmu_checker_module,"Options -i and -z are ignored in co-simulation mode");
+		cdata->inputFileName = 0;
+		cdata->unzipPath = 0;
+	}
+	if(cdata->sweepFileName && cdata->do_cosim) {
+		jm_log_fatal(&cdata->callbacks,fmu_checker_module,"Options --sweep and --cosim cannot be combined");
+		do_exit(1);
+	}
+	if(cdata->stateCacheDir && cdata->do_cosim) {
+		jm_log_warning(&cdata->callbacks,fmu_checker_module,"Option --state-cache is ignored in co-simulation mode");
+		cdata->stateCacheDir = 0;
+	}
+	if(cdata->referenceFileName && cdata->do_cosim) {
+		jm_log_warning(&cdata->callbacks,fmu_checker_module,"Option --reference is ignored in co-simulation mode");
+		cdata->referenceFileName = 0;
+	}
+	if(cdata->referenceFileName && cdata->sweepFileName) {
+		jm_log_warning(&cdata->callbacks,fmu_checker_module,"Option --reference is ignored in a parameter sweep");
+		cdata->referenceFileName = 0;
+	}
+	if(cdata->numInstances && (cdata->do_cosim || cdata->sweepFileName)) {
+		jm_log_warning(&cdata->callbacks,fmu_checker_module,"Option --instances is ignored in %s", cdata->do_cosim ? "co-simulation mode" : "a parameter sweep");
+		cdata->numInstances = 0;
+	}
+	if(cdata->compareMeCs && (cdata->do_cosim || cdata->sweepFileName)) {
+		jm_log_warning(&cdata->callbacks,fmu_checker_module,"Option --compare-me-cs is ignored in %s", cdata->do_cosim ? "co-simulation mode" : "a parameter sweep");
+		cdata->compareMeCs = 0;
+	}
+	if(cdata->compareMeCs && cdata->referenceFileName) {
+		jm_log_warning(&cdata->callbacks,fmu_checker_module,"Option --compare-me-cs is ignored with --reference");
+		cdata->compareMeCs = 0;
+	}
+	if(cdata->determinism && cdata->do_cosim) {
+		jm_log_warning(&cdata->callbacks,fmu_checker_module,"Option --determinism is ignored in co-simulation mode");
+		cdata->determinism = 0;
+	}
+	if(cdata->determinism && cdata->sweepFileName) {
+		jm_log_warning(&cdata->callbacks,fmu_checker_module,"Option --determinism is ignored in a parameter sweep");
+		cdata->determinism = 0;
+	}
+	if(cdata->determinism && cdata->stateCacheDir) {
+		jm_log_warning(&cdata->callbacks,fmu_checker_module,"Option --state-cache is ignored with --determinism since the initialization is part of the check");
+		cdata->stateCacheDir = 0;
+	}
+	if(cdata->resampleOutput && cdata->do_cosim) {
+		jm_log_warning(&cdata->callbacks,fmu_checker_module,"Option --resample is ignored in co-simulation mode");
+		cdata->resampleOutput = 0;
+	}
+	if(cdata->outputVarsSpec && cdata->do_cosim) {
+		jm_log_warning(&cdata->callbacks,fmu_checker_module,"Option --vars is ignored in co-simulation mode");
+		cdata->outputVarsSpec = 0;
+	}
+	if(cdata->outputVarsSpec && cdata->do_output_all_vars) {
+		jm_log_warning(&cdata->callbacks,fmu_checker_module,"Option -f is ignored since the output variables are selected with --vars");
+	}
+	if(cdata->sweepFileName && !cdata->output_file_name) {
+		jm_log_fatal(&cdata->callbacks,fmu_checker_module,"Option --sweep requires an output file name (-o)");
+		do_exit(1);
+	}
 
     cdata->do_test_me = cdata->require_me || do_test_everything;
     cdata->do_test_cs = cdata->require_cs || do_test_everything;
     cdata->do_simulate_flg = cdata->do_test_me || cdata->do_test_cs;
 
-	if(cdata->log_file_name) {
+	if(cdata->log_file_name && (fmu_check_stream_kind(cdata->log_file_name) != fmu_check_stream_plain)) {
+		cdata->log_stream = fmu_check_stream_open(&cdata->callbacks, cdata->log_file_name, fmu_check_stream_kind(cdata->log_file_name));
+		if(!cdata->log_stream) {
+			clear_fmu_check_data(cdata, 1);
+			do_exit(1);
+		}
+	}
+	else if(cdata->log_file_name) {
 		cdata->log_file = fopen(cdata->log_file_name, "wb");
 		if(!cdata->log_file) {
 			cdata->log_file = stderr;
@@ -347,7 +732,7 @@ void parse_options(int argc, char *argv[], fmu_check_data_t* cdata) {
 	{
 		FILE* tryFMU = fopen(cdata->FMUPath, "r");
 		if(tryFMU == 0) {
-			jm_log_fatal(&cdata->callbacks,fmu_checker_module,"Cannot open FMU file (%s)", strerror(errno));
+			jm_log_fatal(&cdata->callbacks,fmu_checker_module,"Cannot open %s file (%s)", cdata->do_cosim ? "connection" : "FMU", strerror(errno));
 			clear_fmu_check_data(cdata, 1);
 			do_exit(1);
 		}
@@ -366,6 +751,17 @@ void parse_options(int argc, char *argv[], fmu_check_data_t* cdata) {
 		    	do_exit(1);
             }
         }
+        if(cdata->sweepFileName) {
+            FILE* paramfile = fopen(cdata->sweepFileName, "rb");
+            if(paramfile) {
+                fclose(paramfile);
+            }
+            else {
+    			jm_log_fatal(&cdata->callbacks,fmu_checker_module,"Cannot open parameter file (%s)", strerror(errno));
+	    		clear_fmu_check_data(cdata, 1);
+		    	do_exit(1);
+            }
+        }
     }
 
 	if(!cdata->temp_dir) {
@@ -381,10 +777,11 @@ void parse_options(int argc, char *argv[], fmu_check_data_t* cdata) {
 	if(!cdata->tmpPath) {
 		do_exit(1);
 	}
-	if(cdata->output_file_name) {
-		cdata->out_file = fopen(cdata->output_file_name, "wb");
-		if(!cdata->out_file) {
-			jm_log_fatal(&cdata->callbacks,fmu_checker_module,"Could not open %s for writing", cdata->output_file_name);
+	/* in a parameter sweep each run writes its own output file */
+	if(cdata->output_file_name && !cdata->sweepFileName) {
+		if(fmu_check_open_output(cdata, cdata->output_file_name) != jm_status_success) {
+			if(fmu_check_stream_kind(cdata->output_file_name) == fmu_check_stream_plain)
+				jm_log_fatal(&cdata->callbacks,fmu_checker_module,"Could not open %s for writing", cdata->output_file_name);
 			clear_fmu_check_data(cdata, 1);
 			do_exit(1);
 		}
@@ -419,8 +816,13 @@ jm_status_enu_t checked_print_quoted_str(fmu_check_data_t* cdata, const char* st
 jm_status_enu_t checked_fprintf(fmu_check_data_t* cdata, const char* fmt, ...) {
 	jm_status_enu_t status = jm_status_success;
 	va_list args;
+	int ret;
     va_start (args, fmt);
-	if(vfprintf(cdata->out_file, fmt, args) <= 0) {
+	if(cdata->out_stream)
+		ret = fmu_check_stream_vprintf(cdata->out_stream, fmt, args);
+	else
+		ret = vfprintf(cdata->out_file, fmt, args);
+	if(ret <= 0) {
 		jm_log_fatal(&cdata->callbacks, fmu_checker_module, "Error writing output file (%s)", strerror(errno));
 		status = jm_status_error;
 	}
@@ -428,10 +830,69 @@ jm_status_enu_t checked_fprintf(fmu_check_data_t* cdata, const char* fmt, ...) {
 	return status;
 }
 
-jm_status_enu_t check_fprintf_var_name(fmu_check_data_t* cdata, const char* vn) {
-    char buf[10000], *cursrc, *curdest;
+jm_status_enu_t checked_fwrite(fmu_check_data_t* cdata, const char* buf, size_t len) {
+	int ok;
+	if(cdata->out_stream)
+		ok = (fmu_check_stream_write(cdata->out_stream, buf, len) == 0);
+	else
+		ok = (fwrite(buf, 1, len, cdata->out_file) == len);
+	if(!ok) {
+		jm_log_fatal(&cdata->callbacks, fmu_checker_module, "Error writing output file (%s)", strerror(errno));
+		return jm_status_error;
+	}
+	return jm_status_success;
+}
+
+jm_status_enu_t fmu_check_open_output(fmu_check_data_t* cdata, const char* fileName) {
+	fmu_check_stream_kind_enu_t kind = fmu_check_stream_kind(fileName);
+	if(kind != fmu_check_stream_plain) {
+		cdata->out_stream = fmu_check_stream_open(&cdata->callbacks, fileName, kind);
+		return cdata->out_stream ? jm_status_success : jm_status_error;
+	}
+	cdata->out_file = fopen(fileName, "wb");
+	if(!cdata->out_file) {
+		cdata->out_file = stdout;
+		return jm_status_error;
+	}
+	return jm_status_success;
+}
+
+jm_status_enu_t fmu_check_close_output(fmu_check_data_t* cdata) {
+	int ret = 0;
+	if(cdata->out_stream) {
+		ret = fmu_check_stream_close(cdata->out_stream);
+		cdata->out_stream = 0;
+	}
+	else if(cdata->out_file && (cdata->out_file != stdout)) {
+		ret = fclose(cdata->out_file);
+	}
+	cdata->out_file = stdout;
+	if(ret != 0) {
+		jm_log_fatal(&cdata->callbacks, fmu_checker_module, "Error writing output file");
+		return jm_status_error;
+	}
+	return jm_status_success;
+}
+
+/* Close the log file and go back to standard error */
+static void fmu_check_close_log(fmu_check_data_t* cdata) {
+	if(cdata->log_stream) {
+		fmu_check_stream_t* s = cdata->log_stream;
+		/* messages about a failed write go to standard error */
+		cdata->log_stream = 0;
+		if(fmu_check_stream_close(s) != 0) {
+			jm_log_fatal(&cdata->callbacks, fmu_checker_module, "Error writing to the log file");
+		}
+	}
+	else if(cdata->log_file && (cdata->log_file != stderr)) {
+		fclose(cdata->log_file);
+	}
+	cdata->log_file = stderr;
+}
+
+void check_format_var_name(fmu_check_data_t* cdata, const char* vn, char* buf) {
+    char *cursrc, *curdest;
     int need_quoting = 1;
-    jm_status_enu_t status = jm_status_success;
    	char replace_sep = ':';
 
 	if(cdata->CSV_separator == ':') {
@@ -492,6 +953,13 @@ jm_status_enu_t check_fprintf_var_name(fmu_check_data_t* cdata, const char* vn)
             sprintf(buf, "%s", vn);
         }
     }
+}
+
+jm_status_enu_t check_fprintf_var_name(fmu_check_data_t* cdata, const char* vn) {
+    char buf[10000];
+    jm_status_enu_t status = jm_status_success;
+
+    check_format_var_name(cdata, vn, buf);
     status = checked_fprintf(cdata, "%c%s", cdata->CSV_separator, buf);
     if(status != jm_status_success) {
         return jm_status_error;
@@ -519,6 +987,9 @@ void init_fmu_check_data(fmu_check_data_t* cdata) {
 	cdata->callbacks.log_level = jm_log_level_info;
     cdata->callbacks.context = cdata;
 
+	fmu_check_log_filter_init(&cdata->fmu_log_filter, &cdata->callbacks);
+	fmu_check_arena_init(&cdata->arena, &cdata->callbacks);
+
 	cdata->context = 0;
 
 	cdata->modelIdentifierFMI1 = 0;
@@ -536,15 +1007,45 @@ void init_fmu_check_data(fmu_check_data_t* cdata) {
     cdata->maxOutputPtsSetByUser = 0;
     cdata->nextOutputTime = 0.0;
     cdata->nextOutputStep = 0;
+	cdata->resampleOutput = 0;
+	cdata->determinism = 0;
+	cdata->referenceFileName = 0;
+	cdata->referenceTolSpec = 0;
+	cdata->referenceTube = FMI2_REFERENCE_DEFAULT_TUBE;
+	cdata->referenceMaxViolations = 0;
+	cdata->compareMeCs = 0;
+	cdata->numInstances = 0;
+	cdata->outputVarsSpec = 0;
+	memset(&cdata->fmu2_resample, 0, sizeof(cdata->fmu2_resample));
+	memset(&cdata->fmu2_columns, 0, sizeof(cdata->fmu2_columns));
+	memset(&cdata->fmu2_row, 0, sizeof(cdata->fmu2_row));
+	memset(&cdata->fmu2_determinism, 0, sizeof(cdata->fmu2_determinism));
+	memset(&cdata->fmu2_reference, 0, sizeof(cdata->fmu2_reference));
 	cdata->CSV_separator = ',';
 #ifdef SUPPORT_out_enum_as_int_flag
 	cdata->out_enum_as_int_flag = 0;
 #endif
 	cdata->output_file_name = 0;
 	cdata->out_file = stdout;
+	cdata->out_stream = 0;
 	cdata->log_file_name = 0;
 	cdata->log_file = stderr;
+	cdata->log_stream = 0;
     cdata->inputFileName = 0;
+	cdata->streamInput = 0;
+	cdata->inputCache = 0;
+	cdata->inputChunkSize = FMU_CHECK_INPUT_MIN_CHUNK_SIZE;
+	cdata->extractAll = 0;
+	cdata->sweepFileName = 0;
+	cdata->stateCacheDir = 0;
+	cdata->statsFileName = 0;
+	memset(&cdata->phases, 0, sizeof(cdata->phases));
+	cdata->totalTimeout = 0;
+	cdata->callTimeout = 0;
+	cdata->maxEventIterations = FMUCHK_DEFAULT_MAX_EVENT_ITERATIONS;
+	memset(&cdata->watch, 0, sizeof(cdata->watch));
+	cdata->realtimeFactor = 0;
+	memset(&cdata->realtime, 0, sizeof(cdata->realtime));
 	cdata->do_simulate_flg = 1;
     cdata->do_test_me = 1;
     cdata->do_test_cs = 1;
@@ -553,8 +1054,14 @@ void init_fmu_check_data(fmu_check_data_t* cdata) {
     cdata->do_mangle_var_names = 0;
     cdata->do_output_all_vars = 0;
 	cdata->print_all_event_vars = 0;
+	cdata->do_cosim = 0;
+	cdata->num_threads = 0;
+	cdata->instance_data = 0;
+	cdata->num_instance_data = 0;
 
 	cdata->version = fmi_version_unknown_enu;
+	cdata->fmuZip = 0;
+	cdata->unpack = 0;
 
 	cdata->fmu1 = 0;
 	cdata->fmu1_kind = fmi1_fmu_kind_enu_unknown;
@@ -563,6 +1070,10 @@ void init_fmu_check_data(fmu_check_data_t* cdata) {
     cdata->fmu2 = 0;
 	cdata->fmu2_kind = fmi2_fmu_kind_unknown;
     cdata->vl2 = 0;
+	cdata->fmu2_params = 0;
+	cdata->fmu2_param_set = 0;
+	cdata->fmu2_reuse_instance = 0;
+	cdata->fmu2_instance_alive = 0;
 	assert(cdata_global_ptr == 0);
 	cdata_global_ptr = cdata;
 }
@@ -586,14 +1097,17 @@ void clear_fmu_check_data(fmu_check_data_t* cdata, int close_log) {
 		fmi_import_free_context(cdata->context);
 		cdata->context = 0;
 	}
+	fmu_check_unpack_stop(cdata);
+	if(cdata->fmuZip) {
+		fmu_check_zip_close(cdata->fmuZip);
+		cdata->fmuZip = 0;
+	}
     if(cdata->tmpPath && (cdata->tmpPath != cdata->unzipPath)) {
 		jm_rmdir(&cdata->callbacks,cdata->tmpPath);
 		cdata->callbacks.free(cdata->tmpPath);
 		cdata->tmpPath = 0;
 	}
-	if(cdata->out_file && (cdata->out_file != stdout)) {
-		fclose(cdata->out_file);
-	}
+	fmu_check_close_output(cdata);
 	if(cdata->vl) {
 		fmi1_import_free_variable_list(cdata->vl);
 		cdata->vl = 0;
@@ -602,13 +1116,147 @@ void clear_fmu_check_data(fmu_check_data_t* cdata, int close_log) {
 		fmi2_import_free_variable_list(cdata->vl2);
 		cdata->vl2 = 0;
 	}
-	if(close_log && cdata->log_file && (cdata->log_file != stderr)) {
-		fclose(cdata->log_file);
-		cdata->log_file = stderr;
+	fmi2_determinism_free(cdata);
+	fmi2_reference_free(cdata);
+	fmu_check_arena_free(&cdata->arena);
+	if(close_log) {
+		fmu_check_close_log(cdata);
 	}
 	cdata_global_ptr = 0;
 }
 
+void init_fmu_check_child_data(fmu_check_data_t* cdata, fmu_check_data_t* parent) {
+	/* options, log level and the output streams are shared with the parent */
+	*cdata = *parent;
+	cdata->FMUPath = 0;
+	cdata->tmpPath = 0;
+	cdata->unzipPath = 0;
+
+	cdata->num_errors = 0;
+	cdata->num_warnings = 0;
+	cdata->num_fatal = 0;
+	cdata->num_fmu_messages = 0;
+	cdata->printed_instance_name_error_flg = 0;
+
+	cdata->callbacks.context = cdata;
+	fmu_check_log_filter_init(&cdata->fmu_log_filter, &cdata->callbacks);
+	cdata->fmu_log_filter.maxRepeats = parent->fmu_log_filter.maxRepeats;
+	cdata->fmu_log_filter.reportInterval = parent->fmu_log_filter.reportInterval;
+	fmu_check_arena_init(&cdata->arena, &cdata->callbacks);
+
+	cdata->context = 0;
+
+	cdata->modelIdentifierFMI1 = 0;
+	cdata->modelIdentifierME = 0;
+	cdata->modelIdentifierCS = 0;
+	cdata->modelName = 0;
+	cdata->GUID = 0;
+	cdata->instanceNameSavedPtr = 0;
+	cdata->instanceNameToCompare = 0;
+
+    cdata->nextOutputTime = 0.0;
+    cdata->nextOutputStep = 0;
+	memset(&cdata->fmu2_resample, 0, sizeof(cdata->fmu2_resample));
+	memset(&cdata->fmu2_columns, 0, sizeof(cdata->fmu2_columns));
+	memset(&cdata->fmu2_row, 0, sizeof(cdata->fmu2_row));
+	memset(&cdata->fmu2_determinism, 0, sizeof(cdata->fmu2_determinism));
+	memset(&cdata->fmu2_reference, 0, sizeof(cdata->fmu2_reference));
+	cdata->output_file_name = 0;
+	cdata->log_file_name = 0;
+    cdata->inputFileName = 0;
+	cdata->sweepFileName = 0;
+	cdata->referenceFileName = 0;
+	cdata->statsFileName = 0;
+	memset(&cdata->phases, 0, sizeof(cdata->phases));
+	memset(&cdata->watch, 0, sizeof(cdata->watch));
+	cdata->instance_data = 0;
+	cdata->num_instance_data = 0;
+
+	cdata->version = fmi_version_unknown_enu;
+	cdata->fmuZip = 0;
+	cdata->unpack = 0;
+
+	cdata->fmu1 = 0;
+	cdata->fmu1_kind = fmi1_fmu_kind_enu_unknown;
+	memset(&cdata->fmu1_inputData, 0, sizeof(cdata->fmu1_inputData));
+	cdata->vl = 0;
+
+    cdata->fmu2 = 0;
+	cdata->fmu2_kind = fmi2_fmu_kind_unknown;
+	memset(&cdata->fmu2_inputData, 0, sizeof(cdata->fmu2_inputData));
+    cdata->vl2 = 0;
+	cdata->fmu2_params = 0;
+	cdata->fmu2_param_set = 0;
+	cdata->fmu2_reuse_instance = 0;
+	cdata->fmu2_instance_alive = 0;
+
+	fmu_check_watchdog_add(cdata);
+}
+
+void clear_fmu_check_child_data(fmu_check_data_t* cdata, fmu_check_data_t* parent) {
+	fmu_check_watchdog_remove(cdata);
+	if(cdata->vl) {
+		fmi1_import_free_variable_list(cdata->vl);
+		cdata->vl = 0;
+	}
+    if(cdata->vl2) {
+		fmi2_import_free_variable_list(cdata->vl2);
+		cdata->vl2 = 0;
+	}
+	if(cdata->fmu1) {
+		fmi1_free_input_data(&cdata->fmu1_inputData);
+		fmi1_import_free(cdata->fmu1);
+		cdata->fmu1 = 0;
+	}
+	if(cdata->fmu2) {
+		fmi2_free_input_data(&cdata->fmu2_inputData);
+		fmi2_import_free(cdata->fmu2);
+		cdata->fmu2 = 0;
+	}
+	if(cdata->context) {
+		fmi_import_free_context(cdata->context);
+		cdata->context = 0;
+	}
+    if(cdata->tmpPath) {
+		jm_rmdir(&cdata->callbacks,cdata->tmpPath);
+		cdata->callbacks.free(cdata->tmpPath);
+		cdata->tmpPath = 0;
+	}
+	fmu_check_arena_free(&cdata->arena);
+
+	parent->num_warnings += cdata->num_warnings;
+	parent->num_errors += cdata->num_errors;
+	parent->num_fatal += cdata->num_fatal;
+	parent->num_fmu_messages += cdata->num_fmu_messages;
+	cdata->num_warnings = cdata->num_errors = cdata->num_fatal = cdata->num_fmu_messages = 0;
+	fmu_check_log_filter_merge(&parent->fmu_log_filter, &cdata->fmu_log_filter);
+}
+
+fmu_check_data_t* fmu_check_get_instance_data(void* componentEnvironment) {
+	size_t i;
+	for(i = 0; i < cdata_global_ptr->num_instance_data; i++) {
+		if(cdata_global_ptr->instance_data[i] == componentEnvironment)
+			return cdata_global_ptr->instance_data[i];
+	}
+	return cdata_global_ptr;
+}
+
+int check_output_time(fmu_check_data_t* cdata, double time) {
+    if(cdata->maxOutputPts > 0) {
+        if(time < cdata->nextOutputTime) {
+            return 0;
+        }
+        else {
+            cdata->nextOutputStep++;
+            cdata->nextOutputTime = cdata->stopTime*cdata->nextOutputStep/cdata->maxOutputPts;
+            if(cdata->nextOutputTime > cdata->stopTime) {
+                cdata->nextOutputTime = cdata->stopTime;
+            }
+        }
+    }
+	return 1;
+}
+
 /* Prepare the time step, time end and number of steps info
     for the simulation.
     Input/output: information from default experiment
@@ -649,13 +1297,21 @@ static int check_dir_structure(fmu_check_data_t *cdata)
     char *bindir;
     char *srcdir;
     int is_valid = 0;
+    size_t pathlen;
+    size_t binlen;
+    size_t srclen;
+
+    if (cdata->fmuZip) {
+        /* answered from the central directory, the folders may not have been extracted */
+        return fmu_check_zip_has_folder(cdata->fmuZip, "binaries/") || fmu_check_zip_has_folder(cdata->fmuZip, "sources/");
+    }
 
-    size_t pathlen = strlen(cdata->tmpPath);
-    size_t binlen = pathlen + strlen(FMI_FILE_SEP) + 8; /*strlen("binaries") == 8*/
-    size_t srclen = pathlen + strlen(FMI_FILE_SEP) + 7; /*strlen("sources") == 7*/
+    pathlen = strlen(cdata->tmpPath);
+    binlen = pathlen + strlen(FMI_FILE_SEP) + 8; /*strlen("binaries") == 8*/
+    srclen = pathlen + strlen(FMI_FILE_SEP) + 7; /*strlen("sources") == 7*/
 
-    bindir = cdata->callbacks.calloc(binlen + 1, sizeof(char));
-    srcdir = cdata->callbacks.calloc(srclen + 1, sizeof(char));
+    bindir = fmu_check_arena_calloc(&cdata->arena, binlen + 1, sizeof(char));
+    srcdir = fmu_check_arena_calloc(&cdata->arena, srclen + 1, sizeof(char));
     if (bindir == NULL || srcdir == NULL) {
         jm_log_fatal(&cdata->callbacks,
                      fmu_checker_module,
@@ -669,12 +1325,156 @@ static int check_dir_structure(fmu_check_data_t *cdata)
 
     is_valid = direxists(bindir) || direxists(srcdir);
 
-    cdata->callbacks.free(bindir);
-    cdata->callbacks.free(srcdir);
-
     return is_valid;
 }
 
+/* The benchmark program (fmuchk_bench) links the checker sources with its own main() */
+#ifndef FMUCHK_NO_MAIN
+/*
+	Value of the fmiVersion attribute of the root fmiModelDescription element. Returns 0 if
+	the root element or the attribute is missing, otherwise *len is set to the length of the value.
+*/
+static const char* fmu_check_root_fmi_version(const char* xml, size_t* len) {
+	const char* p = xml;
+	const char* root = "fmiModelDescription";
+	size_t rootLen = strlen(root);
+
+	/* skip the XML declaration, processing instructions, comments and a DOCTYPE before the root */
+	for(;;) {
+		while((*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n')) p++;
+		if(strncmp(p, "<?", 2) == 0) {
+			p = strstr(p + 2, "?>");
+			if(!p) return 0;
+			p += 2;
+		}
+		else if(strncmp(p, "<!--", 4) == 0) {
+			p = strstr(p + 4, "-->");
+			if(!p) return 0;
+			p += 3;
+		}
+		else if(strncmp(p, "<!", 2) == 0) {
+			p = strchr(p + 2, '>');
+			if(!p) return 0;
+			p++;
+		}
+		else if(((unsigned char)p[0] == 0xEF) && ((unsigned char)p[1] == 0xBB) && ((unsigned char)p[2] == 0xBF)) {
+			/* UTF-8 byte order mark */
+			p += 3;
+		}
+		else break;
+	}
+	if((*p != '<') || (strncmp(p + 1, root, rootLen) != 0)) return 0;
+	p += 1 + rootLen;
+
+	/* attributes of the start tag */
+	for(;;) {
+		const char* name;
+		size_t nameLen;
+		char quote;
+		const char* value;
+
+		if((*p != ' ') && (*p != '\t') && (*p != '\r') && (*p != '\n')) return 0;
+		while((*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n')) p++;
+		name = p;
+		while(*p && (*p != '=') && (*p != '>') && (*p != '/') && (*p != ' ') && (*p != '\t') && (*p != '\r') && (*p != '\n')) p++;
+		nameLen = (size_t)(p - name);
+		if(!nameLen) return 0;
+		while((*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n')) p++;
+		if(*p++ != '=') return 0;
+		while((*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n')) p++;
+		if((*p != '"') && (*p != '\'')) return 0;
+		quote = *p++;
+		value = p;
+		while(*p && (*p != quote)) p++;
+		if(!*p) return 0;
+		if((nameLen == strlen("fmiVersion")) && (strncmp(name, "fmiVersion", nameLen) == 0)) {
+			*len = (size_t)(p - value);
+			return value;
+		}
+		p++;
+	}
+}
+
+/*
+	Extract modelDescription.xml from the FMU and detect the FMI version from it. Returns
+	fmi_version_unknown_enu on failure; the whole FMU is then unzipped by FMIL.
+*/
+static fmi_version_enu_t fmu_check_extract_model_description(fmu_check_data_t* cdata) {
+	jm_callbacks* cb = &cdata->callbacks;
+	fmi_version_enu_t version = fmi_version_unknown_enu;
+	int index = fmu_check_zip_find(cdata->fmuZip, "modelDescription.xml");
+	char* xml;
+	char* path;
+	size_t size, pathlen;
+	FILE* f;
+	const char* attr;
+	size_t attrLen = 0;
+	double start = fmu_check_wall_clock();
+
+	if(index < 0) return fmi_version_unknown_enu;
+	xml = fmu_check_zip_read(cdata->fmuZip, (size_t)index, &size);
+	if(!xml) {
+		jm_log_verbose(cb, fmu_checker_module, "Could not read modelDescription.xml directly from the FMU");
+		return fmi_version_unknown_enu;
+	}
+
+	/* fmiVersion attribute of the root element */
+	attr = fmu_check_root_fmi_version(xml, &attrLen);
+	if(attr) {
+		if((attrLen == 3) && (strncmp(attr, "1.0", 3) == 0)) version = fmi_version_1_enu;
+		else if((attrLen == 3) && (strncmp(attr, "2.0", 3) == 0)) version = fmi_version_2_0_enu;
+		else version = fmi_version_unsupported_enu;
+	}
+
+	/* the XML parser reads the file from the unzip directory */
+	pathlen = strlen(cdata->tmpPath) + strlen(FMI_FILE_SEP "modelDescription.xml") + 1;
+	path = (char*)cb->malloc(pathlen);
+	f = 0;
+	if(path) {
+		jm_snprintf(path, pathlen, "%s" FMI_FILE_SEP "modelDescription.xml", cdata->tmpPath);
+		f = fopen(path, "wb");
+	}
+	if(!f || (fwrite(xml, 1, size, f) != size)) {
+		version = fmi_version_unknown_enu;
+	}
+	if(f && fclose(f)) {
+		version = fmi_version_unknown_enu;
+	}
+	if(path) cb->free(path);
+	cb->free(xml);
+
+	if(version != fmi_version_unknown_enu) {
+		jm_log_info(cb, fmu_checker_module, "Extracted modelDescription.xml (%u bytes) from the FMU in %g s", (unsigned)size, fmu_check_wall_clock() - start);
+	}
+	return version;
+}
+
+void fmu_check_print_summary(fmu_check_data_t* cdata) {
+	jm_callbacks* callbacks = &cdata->callbacks;
+
+	jm_log(callbacks, fmu_checker_module, jm_log_level_nothing, "FMU check summary:");
+
+	jm_log(callbacks, fmu_checker_module, jm_log_level_nothing, "FMU reported:\n\t%u warning(s) and error(s)", cdata->num_fmu_messages);
+	fmu_check_log_filter_summary(&cdata->fmu_log_filter);
+	jm_log(callbacks, fmu_checker_module, jm_log_level_nothing, "Checker reported:");
+
+	if(callbacks->log_level < jm_log_level_error) {
+		jm_log(callbacks, fmu_checker_module, jm_log_level_nothing,
+			"\tWarnings and non-critical errors were ignored (log level: %s)", jm_log_level_to_string( callbacks->log_level ));
+	}
+	else {
+		if(callbacks->log_level < jm_log_level_warning) {
+			jm_log(callbacks, fmu_checker_module, jm_log_level_nothing,
+				"\tWarnings were ignored (log level: %s)", jm_log_level_to_string( callbacks->log_level ));
+		}
+		else
+		jm_log(callbacks, fmu_checker_module, jm_log_level_nothing, "\t%u Warning(s)", cdata->num_warnings);
+		if ((cdata->num_fatal > 0)) cdata->num_errors=cdata->num_errors+cdata->num_fatal;
+		jm_log(callbacks, fmu_checker_module, jm_log_level_nothing, "\t%u Error(s)", cdata->num_errors);
+	}
+	fmu_check_print_phase_times(cdata);
+}
+
 int main(int argc, char *argv[])
 {
 	fmu_check_data_t cdata;
@@ -684,10 +1484,15 @@ int main(int argc, char *argv[])
 	int i = 0;
     int cnt;
 	char clopts[JM_MAX_ERROR_MESSAGE_SIZE];
+	double wallStart = fmu_check_wall_clock();
 
 	init_fmu_check_data(&cdata);
 	callbacks = &cdata.callbacks;
 	parse_options(argc, argv, &cdata);
+	if(fmu_check_watchdog_start(&cdata, wallStart) != jm_status_success) {
+		clear_fmu_check_data(&cdata, 1);
+		do_exit(1);
+	}
 
 #ifdef FMILIB_GENERATE_BUILD_STAMP
 	jm_log_debug(callbacks,fmu_checker_module,"FMIL build stamp:\n%s\n", fmilib_get_build_stamp());
@@ -710,37 +1515,99 @@ int main(int argc, char *argv[])
 	jm_log_info(callbacks,fmu_checker_module,clopts);
 
 
-	jm_log_info(callbacks,fmu_checker_module,"Will process FMU %s",cdata.FMUPath);
-
-	cdata.context = fmi_import_allocate_context(callbacks);
-    fmi_import_set_configuration(cdata.context, FMI_IMPORT_NAME_CHECK);
-
-	cdata.version = fmi_import_get_fmi_version(cdata.context, cdata.FMUPath, cdata.tmpPath);
-	if(cdata.version == fmi_version_unknown_enu) {
-		jm_log_fatal(callbacks,fmu_checker_module,"Error in FMU version detection");
-		do_exit(1);
+	if(cdata.do_cosim) {
+		jm_log_info(callbacks,fmu_checker_module,"Will co-simulate FMUs listed in %s",cdata.FMUPath);
+		status = fmi2_cosim_check(&cdata);
 	}
+	else {
+		jm_log_info(callbacks,fmu_checker_module,"Will process FMU %s",cdata.FMUPath);
+
+		cdata.context = fmi_import_allocate_context(callbacks);
+		fmi_import_set_configuration(cdata.context, FMI_IMPORT_NAME_CHECK);
+
+		fmu_check_phase_begin(&cdata, fmu_check_phase_unzip);
+		cdata.fmuZip = fmu_check_zip_open(callbacks, cdata.FMUPath);
+		if(cdata.fmuZip) {
+			cdata.version = fmu_check_extract_model_description(&cdata);
+			if((cdata.version == fmi_version_1_enu) || (cdata.version == fmi_version_2_0_enu)) {
+				jm_status_enu_t unpackStatus = jm_status_success;
+				if(cdata.extractAll || cdata.sweepFileName) {
+					unpackStatus = fmu_check_unpack_all(&cdata);
+				}
+				else if(cdata.do_simulate_flg) {
+					unpackStatus = fmu_check_unpack_start(&cdata);
+				}
+				if(unpackStatus != jm_status_success) {
+					/* unzip everything below */
+					cdata.version = fmi_version_unknown_enu;
+				}
+			}
+		}
+		if(cdata.version == fmi_version_unknown_enu) {
+			cdata.version = fmi_import_get_fmi_version(cdata.context, cdata.FMUPath, cdata.tmpPath);
+		}
+		fmu_check_phase_end(&cdata);
+		if(cdata.version == fmi_version_unknown_enu) {
+			jm_log_fatal(callbacks,fmu_checker_module,"Error in FMU version detection");
+			do_exit(1);
+		}
 
-    if (!check_dir_structure(&cdata)) {
-        jm_log_error(&cdata.callbacks,
-                     fmu_checker_module,
-                     "FMU must contain either a \"sources\" or a \"binaries\" folder");
-    }
+		if (!check_dir_structure(&cdata)) {
+			jm_log_error(&cdata.callbacks,
+						 fmu_checker_module,
+						 "FMU must contain either a \"sources\" or a \"binaries\" folder");
+		}
 
-	switch(cdata.version) {
-	case  fmi_version_1_enu:
-		status = fmi1_check(&cdata);
-		break;
-	case  fmi_version_2_0_enu:
-		status = fmi2_check(&cdata);
-		break;
-	default:
-		clear_fmu_check_data(&cdata, 1);
-		jm_log_fatal(callbacks,fmu_checker_module,"Only FMI version 1.0 and 2.0 are supported so far");
-		do_exit(1);
+		switch(cdata.version) {
+		case  fmi_version_1_enu:
+			if(cdata.sweepFileName) {
+				jm_log_fatal(callbacks,fmu_checker_module,"Parameter sweep (--sweep) is only supported for FMI 2.0 FMUs");
+				status = jm_status_error;
+				break;
+			}
+			if(cdata.stateCacheDir) {
+				jm_log_warning(callbacks,fmu_checker_module,"The FMU state cache (--state-cache) is only supported for FMI 2.0 FMUs");
+			}
+			if(cdata.resampleOutput) {
+				jm_log_warning(callbacks,fmu_checker_module,"Output resampling (--resample) is only supported for FMI 2.0 FMUs");
+			}
+			if(cdata.determinism) {
+				jm_log_warning(callbacks,fmu_checker_module,"The determinism check (--determinism) is only supported for FMI 2.0 FMUs");
+			}
+			if(cdata.referenceFileName) {
+				jm_log_warning(callbacks,fmu_checker_module,"The reference comparison (--reference) is only supported for FMI 2.0 FMUs");
+			}
+			if(cdata.compareMeCs) {
+				jm_log_warning(callbacks,fmu_checker_module,"The ME/CS comparison (--compare-me-cs) is only supported for FMI 2.0 FMUs");
+			}
+			if(cdata.numInstances) {
+				jm_log_warning(callbacks,fmu_checker_module,"The multi-instance check (--instances) is only supported for FMI 2.0 FMUs");
+			}
+			if(cdata.outputVarsSpec) {
+				jm_log_warning(callbacks,fmu_checker_module,"Output variable selection (--vars) is only supported for FMI 2.0 FMUs");
+			}
+			if(cdata.streamInput) {
+				jm_log_warning(callbacks,fmu_checker_module,"Streaming input (--stream-input) is only supported for FMI 2.0 FMUs");
+			}
+			if(cdata.inputCache) {
+				jm_log_warning(callbacks,fmu_checker_module,"The input data cache (--input-cache) is only supported for FMI 2.0 FMUs");
+			}
+			status = fmi1_check(&cdata);
+			break;
+		case  fmi_version_2_0_enu:
+			status = fmi2_check(&cdata);
+			break;
+		default:
+			clear_fmu_check_data(&cdata, 1);
+			jm_log_fatal(callbacks,fmu_checker_module,"Only FMI version 1.0 and 2.0 are supported so far");
+			do_exit(1);
+		}
 	}
 
+	fmu_check_phase_begin(&cdata, fmu_check_phase_cleanup);
 	clear_fmu_check_data(&cdata, 0);
+	fmu_check_phase_end(&cdata);
+	fmu_check_watchdog_stop();
 
 	if(allocated_mem_blocks)  {
 		if(allocated_mem_blocks > 0) {
@@ -755,35 +1622,21 @@ int main(int argc, char *argv[])
 		}
 	}
 
-	jm_log(callbacks, fmu_checker_module, jm_log_level_nothing, "FMU check summary:");
-
-	jm_log(callbacks, fmu_checker_module, jm_log_level_nothing, "FMU reported:\n\t%u warning(s) and error(s)\nChecker reported:", cdata.num_fmu_messages);
-
-	if(callbacks->log_level < jm_log_level_error) {
-		jm_log(callbacks, fmu_checker_module, jm_log_level_nothing,
-			"\tWarnings and non-critical errors were ignored (log level: %s)", jm_log_level_to_string( callbacks->log_level ));
-	}
-	else {
-		if(callbacks->log_level < jm_log_level_warning) {
-			jm_log(callbacks, fmu_checker_module, jm_log_level_nothing,
-				"\tWarnings were ignored (log level: %s)", jm_log_level_to_string( callbacks->log_level ));
-		}
-		else
-		jm_log(callbacks, fmu_checker_module, jm_log_level_nothing, "\t%u Warning(s)", cdata.num_warnings);
-		if ((cdata.num_fatal > 0)) cdata.num_errors=cdata.num_errors+cdata.num_fatal;
-		jm_log(callbacks, fmu_checker_module, jm_log_level_nothing, "\t%u Error(s)", cdata.num_errors);
+	fmu_check_print_summary(&cdata);
+	fmu_check_log_filter_free(&cdata.fmu_log_filter);
+	if(cdata.statsFileName) {
+		fmu_check_write_stats(&cdata, ((status == jm_status_success) && (cdata.num_fatal == 0)) ? 0 : 1, wallStart);
 	}
 	if((status == jm_status_success) && (cdata.num_fatal == 0)) {
-		if(cdata.log_file && (cdata.log_file != stderr))
-			fclose(cdata.log_file);
+		fmu_check_close_log(&cdata);
 		do_exit(0);
 	}
 	else {
 		jm_log(callbacks, fmu_checker_module, jm_log_level_nothing,
 			"\t%u Fatal error(s) occurred during processing",cdata.num_fatal);
-		if(cdata.log_file && (cdata.log_file != stderr))
-			fclose(cdata.log_file);
+		fmu_check_close_log(&cdata);
 		do_exit(1);
 	}
 	return 0;
 }
+#endif
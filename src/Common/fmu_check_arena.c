@@ -0,0 +1,139 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmu_check_arena.c
+	Run-scoped bump allocator for memory owned by the checker.
+*/
+
+#include <stddef.h>
+#include <string.h>
+
+#include <fmu_check_arena.h>
+
+/* Type with the strictest alignment requirement we need to support */
+typedef union fmu_check_arena_align_t {
+	double d;
+	long l;
+	void* p;
+	long double ld;
+} fmu_check_arena_align_t;
+
+#define ARENA_ALIGNMENT (sizeof(fmu_check_arena_align_t))
+#define ARENA_ROUND_UP(size) (((size) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1))
+
+struct fmu_check_arena_block_t {
+	fmu_check_arena_block_t* next;
+	size_t size;
+	size_t used;
+	/** blocks are numbered in the order they are allocated */
+	size_t serial;
+	/* data follows the header */
+	fmu_check_arena_align_t data[1];
+};
+
+#define ARENA_BLOCK_HEADER_SIZE (offsetof(fmu_check_arena_block_t, data))
+
+void fmu_check_arena_init(fmu_check_arena_t* arena, jm_callbacks* cb) {
+	arena->cb = cb;
+	arena->head = 0;
+	arena->blockSize = FMU_CHECK_ARENA_BLOCK_SIZE;
+	arena->bytesUsed = 0;
+	arena->bytesReserved = 0;
+	arena->numBlocks = 0;
+}
+
+static fmu_check_arena_block_t* arena_new_block(fmu_check_arena_t* arena, size_t size) {
+	fmu_check_arena_block_t* block;
+	if(size < arena->blockSize) size = arena->blockSize;
+	block = (fmu_check_arena_block_t*)arena->cb->malloc(ARENA_BLOCK_HEADER_SIZE + size);
+	if(!block) return 0;
+	block->size = size;
+	block->used = 0;
+	block->serial = arena->numBlocks++;
+	arena->bytesReserved += size;
+	return block;
+}
+
+void* fmu_check_arena_alloc(fmu_check_arena_t* arena, size_t size) {
+	fmu_check_arena_block_t* block = arena->head;
+	char* ret;
+
+	size = ARENA_ROUND_UP(size ? size : 1);
+	if(!block || (block->size - block->used < size)) {
+		fmu_check_arena_block_t* newBlock = arena_new_block(arena, size);
+		if(!newBlock) return 0;
+		if(block && (size > arena->blockSize / 4)) {
+			/* Large requests get a block of their own that is put behind
+			   the head so that the free space in the head is not lost */
+			newBlock->next = block->next;
+			block->next = newBlock;
+		}
+		else {
+			newBlock->next = block;
+			arena->head = newBlock;
+		}
+		block = newBlock;
+	}
+	ret = (char*)block->data + block->used;
+	block->used += size;
+	arena->bytesUsed += size;
+	return ret;
+}
+
+void* fmu_check_arena_calloc(fmu_check_arena_t* arena, size_t nobj, size_t size) {
+	void* ret;
+	if(size && (nobj > ((size_t)-1) / size)) return 0;
+	ret = fmu_check_arena_alloc(arena, nobj * size);
+	if(ret) memset(ret, 0, nobj * size);
+	return ret;
+}
+
+char* fmu_check_arena_strdup(fmu_check_arena_t* arena, const char* str) {
+	size_t len = strlen(str) + 1;
+	char* ret = (char*)fmu_check_arena_alloc(arena, len);
+	if(ret) memcpy(ret, str, len);
+	return ret;
+}
+
+void fmu_check_arena_free(fmu_check_arena_t* arena) {
+	fmu_check_arena_block_t* block = arena->head;
+	while(block) {
+		fmu_check_arena_block_t* next = block->next;
+		arena->cb->free(block);
+		block = next;
+	}
+	arena->head = 0;
+	arena->bytesUsed = 0;
+	arena->bytesReserved = 0;
+}
+
+void fmu_check_arena_mark(fmu_check_arena_t* arena, fmu_check_arena_mark_t* mark) {
+	mark->head = arena->head;
+	mark->used = arena->head ? arena->head->used : 0;
+	mark->numBlocks = arena->numBlocks;
+	mark->bytesUsed = arena->bytesUsed;
+}
+
+void fmu_check_arena_release(fmu_check_arena_t* arena, const fmu_check_arena_mark_t* mark) {
+	fmu_check_arena_block_t** link = &arena->head;
+	/* Blocks allocated after the mark may be anywhere in the list since
+	   large blocks are put behind the head. Removing them all leaves the
+	   list as it was when the mark was set. */
+	while(*link) {
+		fmu_check_arena_block_t* block = *link;
+		if(block->serial >= mark->numBlocks) {
+			*link = block->next;
+			arena->bytesReserved -= block->size;
+			arena->cb->free(block);
+		}
+		else {
+			link = &block->next;
+		}
+	}
+	if(arena->head) arena->head->used = mark->used;
+	arena->bytesUsed = mark->bytesUsed;
+}
@@ -0,0 +1,331 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmu_check_input_chunks.c
+	Parallel parsing of the data lines of input files.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <JM/jm_vector.h>
+#include "fmuChecker.h"
+#include "fmu_check_input_chunks.h"
+
+/** Chunks per thread, more chunks than threads even out the differences in parsing speed */
+#define FMU_CHECK_INPUT_CHUNKS_PER_THREAD 4
+/** Initial number of rows in the buffers of a chunk */
+#define FMU_CHECK_INPUT_CHUNK_ROWS 1024
+
+typedef enum fmu_check_input_chunk_status_enu_t {
+	fmu_check_input_chunk_ok,
+	fmu_check_input_chunk_bad_value,
+	fmu_check_input_chunk_bad_line,
+	fmu_check_input_chunk_no_memory,
+	fmu_check_input_chunk_no_file
+} fmu_check_input_chunk_status_enu_t;
+
+typedef struct fmu_check_input_chunk_t {
+	/** File offsets: the chunk parses the lines starting in [start, end) */
+	long long start, end;
+	int isLast;
+
+	size_t numRows, capacity;
+	double* times;
+	char* parts[FMU_CHECK_INPUT_NUM_PARTS];
+
+	/** Number of lines attempted, including a failed one */
+	size_t lineCnt;
+	fmu_check_input_chunk_status_enu_t status;
+	double badTime;
+	size_t badVar;
+	/** Local line numbers of the lines with a missing separator */
+	size_t* sepErrors;
+	size_t numSepErrors, sepErrorsCapacity;
+} fmu_check_input_chunk_t;
+
+typedef struct fmu_check_input_job_t {
+	jm_callbacks* cb;
+	const char* fileName;
+	size_t partSize[FMU_CHECK_INPUT_NUM_PARTS];
+	fmu_check_input_row_parser_ft parser;
+	void* context;
+	fmu_check_input_chunk_t* chunks;
+} fmu_check_input_job_t;
+
+static int fmu_check_input_seek(FILE* f, long long pos) {
+#if defined(_WIN32) || defined(WIN32)
+	return _fseeki64(f, pos, SEEK_SET);
+#else
+	return fseeko(f, (off_t)pos, SEEK_SET);
+#endif
+}
+
+static long long fmu_check_input_tell(FILE* f) {
+#if defined(_WIN32) || defined(WIN32)
+	return _ftelli64(f);
+#else
+	return (long long)ftello(f);
+#endif
+}
+
+/* Make room for one more row. Returns 0 if out of memory. */
+static int fmu_check_input_chunk_grow(fmu_check_input_job_t* job, fmu_check_input_chunk_t* chunk) {
+	jm_callbacks* cb = job->cb;
+	size_t capacity = chunk->capacity ? 2 * chunk->capacity : FMU_CHECK_INPUT_CHUNK_ROWS;
+	double* times;
+	size_t p;
+
+	if(chunk->numRows < chunk->capacity) return 1;
+	times = (double*)cb->realloc(chunk->times, capacity * sizeof(double));
+	if(!times) return 0;
+	chunk->times = times;
+	for(p = 0; p < FMU_CHECK_INPUT_NUM_PARTS; p++) {
+		char* part = (char*)cb->realloc(chunk->parts[p], capacity * job->partSize[p] + 1);
+		if(!part) return 0;
+		chunk->parts[p] = part;
+	}
+	chunk->capacity = capacity;
+	return 1;
+}
+
+static void fmu_check_input_chunk_sep_error(fmu_check_input_job_t* job, fmu_check_input_chunk_t* chunk) {
+	if(chunk->numSepErrors == chunk->sepErrorsCapacity) {
+		size_t capacity = chunk->sepErrorsCapacity ? 2 * chunk->sepErrorsCapacity : 16;
+		size_t* sepErrors = (size_t*)job->cb->realloc(chunk->sepErrors, capacity * sizeof(size_t));
+		/* the message is lost if out of memory, the row is still used */
+		if(!sepErrors) return;
+		chunk->sepErrors = sepErrors;
+		chunk->sepErrorsCapacity = capacity;
+	}
+	chunk->sepErrors[chunk->numSepErrors++] = chunk->lineCnt;
+}
+
+/*
+	Skip the white space after a row. Returns the offset of the line the next row is on,
+	i.e., the offset after the last new line skipped (lineStart if there was none).
+	The offset is only needed, and only looked up, if the chunk has an end.
+*/
+static long long fmu_check_input_skip_blank(FILE* f, long long lineStart, int hasEnd) {
+	int c;
+	for(;;) {
+		c = fgetc(f);
+		if(c == '\n') {
+			if(hasEnd) lineStart = fmu_check_input_tell(f);
+		}
+		else if((c != ' ') && (c != '\t') && (c != '\r')) {
+			break;
+		}
+	}
+	if(c != EOF) ungetc(c, f);
+	return lineStart;
+}
+
+/*
+	Thread pool task: parse the rows on the lines starting within one chunk into its buffers.
+	A line belongs to the chunk where it starts, so the rows are parsed exactly once even if
+	a chunk boundary falls within a line or a run of blank lines.
+*/
+static void fmu_check_input_chunk_task(void* data, size_t index) {
+	fmu_check_input_job_t* job = (fmu_check_input_job_t*)data;
+	fmu_check_input_chunk_t* chunk = &job->chunks[index];
+	FILE* f = fopen(job->fileName, "rb");
+	long long lineStart = chunk->start;
+
+	if(!f) {
+		chunk->status = fmu_check_input_chunk_no_file;
+		return;
+	}
+	if(fmu_check_input_seek(f, (index > 0) ? chunk->start - 1 : chunk->start) != 0) {
+		chunk->status = fmu_check_input_chunk_no_file;
+		fclose(f);
+		return;
+	}
+	if(index > 0) {
+		/* the line that starts before the chunk belongs to the previous one */
+		int c;
+		do {
+			c = fgetc(f);
+		} while((c != '\n') && (c != EOF));
+		if(c == EOF) {
+			fclose(f);
+			return;
+		}
+		lineStart = fmu_check_input_tell(f);
+	}
+	lineStart = fmu_check_input_skip_blank(f, lineStart, !chunk->isLast);
+
+	while(!feof(f)) {
+		void* parts[FMU_CHECK_INPUT_NUM_PARTS];
+		double time = 0;
+		size_t p;
+		int ret;
+
+		if(!chunk->isLast && (lineStart >= chunk->end)) break;
+		chunk->lineCnt++;
+		if(!fmu_check_input_chunk_grow(job, chunk)) {
+			chunk->status = fmu_check_input_chunk_no_memory;
+			break;
+		}
+		for(p = 0; p < FMU_CHECK_INPUT_NUM_PARTS; p++) {
+			parts[p] = chunk->parts[p] + chunk->numRows * job->partSize[p];
+		}
+		ret = job->parser(job->context, f, &time, parts, &chunk->badVar);
+		if(ret == 0) {
+			if(!feof(f) || ferror(f)) chunk->status = fmu_check_input_chunk_bad_line;
+			break;
+		}
+		if(ret == -1) {
+			chunk->status = fmu_check_input_chunk_bad_value;
+			chunk->badTime = time;
+			break;
+		}
+		if(ret == -2) {
+			fmu_check_input_chunk_sep_error(job, chunk);
+		}
+		chunk->times[chunk->numRows++] = time;
+		lineStart = fmu_check_input_skip_blank(f, lineStart, !chunk->isLast);
+	}
+	fclose(f);
+}
+
+static void fmu_check_input_free_chunks(fmu_check_input_job_t* job, size_t numChunks) {
+	size_t i, p;
+	for(i = 0; i < numChunks; i++) {
+		fmu_check_input_chunk_t* chunk = &job->chunks[i];
+		job->cb->free(chunk->times);
+		for(p = 0; p < FMU_CHECK_INPUT_NUM_PARTS; p++) {
+			job->cb->free(chunk->parts[p]);
+		}
+		job->cb->free(chunk->sepErrors);
+	}
+	job->cb->free(job->chunks);
+}
+
+jm_status_enu_t fmu_check_parse_input_chunks(fmu_check_data_t* cdata, const char* fileName, long dataOffset, char sep,
+											 const size_t partSize[FMU_CHECK_INPUT_NUM_PARTS],
+											 fmu_check_input_row_parser_ft parser, void* context,
+											 jm_vector(double)* timeStamps, fmu_check_input_rows_t* rows) {
+	jm_callbacks* cb = &cdata->callbacks;
+	fmu_check_input_job_t job;
+	long long fileSize = -1, dataSize;
+	size_t numThreads = cdata->num_threads ? cdata->num_threads : fmu_check_get_num_cpus();
+	size_t numChunks, i, p, row, lineCnt;
+	double start = fmu_check_wall_clock();
+	jm_status_enu_t status = jm_status_success;
+
+	memset(rows, 0, sizeof(*rows));
+	{
+		FILE* f = fopen(fileName, "rb");
+		if(f) {
+			if(fseek(f, 0, SEEK_END) == 0) fileSize = fmu_check_input_tell(f);
+			fclose(f);
+		}
+	}
+	if(fileSize < dataOffset) {
+		jm_log_error(cb, fmu_checker_module, "Cannot open input file %s", fileName);
+		return jm_status_error;
+	}
+	dataSize = fileSize - dataOffset;
+	numChunks = (size_t)(dataSize / cdata->inputChunkSize);
+	if(numChunks > FMU_CHECK_INPUT_CHUNKS_PER_THREAD * numThreads) numChunks = FMU_CHECK_INPUT_CHUNKS_PER_THREAD * numThreads;
+	if((numThreads < 2) || (numChunks < 2)) numChunks = 1;
+
+	memset(&job, 0, sizeof(job));
+	job.cb = cb;
+	job.fileName = fileName;
+	job.parser = parser;
+	job.context = context;
+	for(p = 0; p < FMU_CHECK_INPUT_NUM_PARTS; p++) job.partSize[p] = partSize[p];
+	job.chunks = (fmu_check_input_chunk_t*)cb->calloc(numChunks, sizeof(fmu_check_input_chunk_t));
+	if(!job.chunks) {
+		jm_log_error(cb, fmu_checker_module, "Could not allocate memory");
+		return jm_status_error;
+	}
+	for(i = 0; i < numChunks; i++) {
+		job.chunks[i].start = dataOffset + (long long)(dataSize * i / numChunks);
+		job.chunks[i].end = dataOffset + (long long)(dataSize * (i + 1) / numChunks);
+		job.chunks[i].isLast = (i + 1 == numChunks);
+	}
+
+	if(numChunks == 1) {
+		fmu_check_input_chunk_task(&job, 0);
+	}
+	else {
+		fmu_check_thread_pool_t* pool = fmu_check_thread_pool_create(cb, numThreads);
+		if(!pool) {
+			jm_log_error(cb, fmu_checker_module, "Could not start threads for reading the input file");
+			fmu_check_input_free_chunks(&job, numChunks);
+			return jm_status_error;
+		}
+		fmu_check_thread_pool_run(pool, fmu_check_input_chunk_task, &job, numChunks);
+		fmu_check_thread_pool_free(pool);
+	}
+
+	/* report in line order and stop at the first chunk that failed */
+	for(i = 0, lineCnt = 0; i < numChunks; i++) {
+		fmu_check_input_chunk_t* chunk = &job.chunks[i];
+		size_t k;
+		for(k = 0; k < chunk->numSepErrors; k++) {
+			jm_log_error(cb, fmu_checker_module, "Expected separator character, got '%c'[%x] instead. Parsing line %i", sep, sep, (int)(lineCnt + chunk->sepErrors[k]));
+		}
+		switch(chunk->status) {
+		case fmu_check_input_chunk_bad_value:
+			rows->badLine = lineCnt + chunk->lineCnt + 1;
+			rows->badTime = chunk->badTime;
+			rows->badVar = chunk->badVar;
+			status = jm_status_error;
+			break;
+		case fmu_check_input_chunk_bad_line:
+			jm_log_error(cb, fmu_checker_module, "Could not process input file past line %d.", (int)(lineCnt + chunk->lineCnt + 1));
+			status = jm_status_error;
+			break;
+		case fmu_check_input_chunk_no_memory:
+			jm_log_error(cb, fmu_checker_module, "Out of memory while reading input file line %d", (int)(lineCnt + chunk->lineCnt));
+			status = jm_status_error;
+			break;
+		case fmu_check_input_chunk_no_file:
+			jm_log_error(cb, fmu_checker_module, "Cannot open input file %s", fileName);
+			status = jm_status_error;
+			break;
+		default:
+			break;
+		}
+		if(status != jm_status_success) break;
+		lineCnt += chunk->numRows;
+		rows->numRows += chunk->numRows;
+	}
+
+	/* copy the rows of the chunks into contiguous storage */
+	if(status == jm_status_success) {
+		for(p = 0; p < FMU_CHECK_INPUT_NUM_PARTS; p++) {
+			rows->parts[p] = (char*)fmu_check_arena_alloc(&cdata->arena, rows->numRows * partSize[p]);
+			if(!rows->parts[p]) status = jm_status_error;
+		}
+		if((status != jm_status_success) || (jm_vector_resize(double)(timeStamps, rows->numRows) != rows->numRows)) {
+			jm_log_error(cb, fmu_checker_module, "Out of memory while reading input file %s", fileName);
+			status = jm_status_error;
+		}
+	}
+	for(i = 0, row = 0; (status == jm_status_success) && (i < numChunks); i++) {
+		fmu_check_input_chunk_t* chunk = &job.chunks[i];
+		if(!chunk->numRows) continue;
+		memcpy(jm_vector_get_itemp(double)(timeStamps, row), chunk->times, chunk->numRows * sizeof(double));
+		for(p = 0; p < FMU_CHECK_INPUT_NUM_PARTS; p++) {
+			memcpy(rows->parts[p] + row * partSize[p], chunk->parts[p], chunk->numRows * partSize[p]);
+		}
+		row += chunk->numRows;
+	}
+	fmu_check_input_free_chunks(&job, numChunks);
+
+	if(status == jm_status_success) {
+		jm_log_verbose(cb, fmu_checker_module, "Parsed %u input rows in %u chunk(s) in %g s",
+			(unsigned)rows->numRows, (unsigned)numChunks, fmu_check_wall_clock() - start);
+	}
+	return status;
+}
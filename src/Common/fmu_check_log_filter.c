@@ -0,0 +1,216 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmu_check_log_filter.c
+	Suppression of repeated FMU log messages.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <fmuChecker.h>
+#include <fmu_check_log_filter.h>
+
+#define LOG_FILTER_INITIAL_CAPACITY 64
+
+void fmu_check_log_filter_init(fmu_check_log_filter_t* filter, jm_callbacks* cb) {
+	filter->cb = cb;
+	filter->maxRepeats = 0;
+	filter->reportInterval = DEFAULT_LOG_REPEAT_REPORT_INTERVAL;
+	filter->keys = 0;
+	filter->capacity = 0;
+	filter->size = 0;
+	filter->outOfMemory = 0;
+}
+
+void fmu_check_log_filter_free(fmu_check_log_filter_t* filter) {
+	size_t i;
+	if(!filter->keys) return;
+	for(i = 0; i < filter->capacity; i++) {
+		filter->cb->free(filter->keys[i].category);
+		filter->cb->free(filter->keys[i].format);
+	}
+	filter->cb->free(filter->keys);
+	filter->keys = 0;
+	filter->capacity = 0;
+	filter->size = 0;
+}
+
+/* FNV-1a over the key strings */
+static unsigned long log_filter_hash(const char* category, int status, const char* format) {
+	unsigned long h = 2166136261UL;
+	const char* ch;
+	for(ch = category; ch && *ch; ch++) {
+		h = (h ^ (unsigned char)*ch) * 16777619UL;
+	}
+	h = (h ^ 0xFFUL) * 16777619UL;
+	for(ch = format; ch && *ch; ch++) {
+		h = (h ^ (unsigned char)*ch) * 16777619UL;
+	}
+	h = (h ^ (unsigned long)status) * 16777619UL;
+	return h;
+}
+
+static int log_filter_str_eq(const char* s1, const char* s2) {
+	if(!s1 || !s2) return (s1 == s2);
+	return strcmp(s1, s2) == 0;
+}
+
+static char* log_filter_strdup(jm_callbacks* cb, const char* str) {
+	char* copy;
+	size_t len;
+	if(!str) return 0;
+	len = strlen(str);
+	copy = (char*)cb->malloc(len + 1);
+	if(copy) memcpy(copy, str, len + 1);
+	return copy;
+}
+
+/* Find the slot for the key. Returns an empty slot if the key is not in the table. */
+static fmu_check_log_key_t* log_filter_find(fmu_check_log_key_t* keys, size_t capacity,
+	unsigned long hash, const char* category, int status, const char* format) {
+	size_t i = hash & (capacity - 1);
+	while(keys[i].count) {
+		fmu_check_log_key_t* k = &keys[i];
+		if((k->hash == hash) && (k->status == status)
+			&& log_filter_str_eq(k->format, format)
+			&& log_filter_str_eq(k->category, category)) {
+			return k;
+		}
+		i = (i + 1) & (capacity - 1);
+	}
+	return &keys[i];
+}
+
+static int log_filter_grow(fmu_check_log_filter_t* filter) {
+	size_t i, capacity = filter->capacity ? 2 * filter->capacity : LOG_FILTER_INITIAL_CAPACITY;
+	fmu_check_log_key_t* keys = (fmu_check_log_key_t*)filter->cb->calloc(capacity, sizeof(fmu_check_log_key_t));
+	if(!keys) return 0;
+	for(i = 0; i < filter->capacity; i++) {
+		fmu_check_log_key_t* k = &filter->keys[i];
+		if(k->count) {
+			*log_filter_find(keys, capacity, k->hash, k->category, k->status, k->format) = *k;
+		}
+	}
+	filter->cb->free(filter->keys);
+	filter->keys = keys;
+	filter->capacity = capacity;
+	return 1;
+}
+
+fmu_check_log_filter_enu_t fmu_check_log_filter_pass(fmu_check_log_filter_t* filter,
+	const char* category, int status, const char* statusStr, const char* format, fmu_check_log_key_t** key) {
+	unsigned long hash;
+	fmu_check_log_key_t* k;
+
+	*key = 0;
+	if(!filter->maxRepeats || filter->outOfMemory) return fmu_check_log_print;
+
+	/* keep load factor below 1/2 */
+	if((2 * (filter->size + 1) > filter->capacity) && !log_filter_grow(filter)) {
+		filter->outOfMemory = 1;
+		return fmu_check_log_print;
+	}
+
+	hash = log_filter_hash(category, status, format);
+	k = log_filter_find(filter->keys, filter->capacity, hash, category, status, format);
+	if(!k->count) {
+		k->hash = hash;
+		k->status = status;
+		k->statusStr = statusStr;
+		k->category = log_filter_strdup(filter->cb, category);
+		k->format = log_filter_strdup(filter->cb, format);
+		if((category && !k->category) || (format && !k->format)) {
+			filter->cb->free(k->category);
+			filter->cb->free(k->format);
+			k->category = k->format = 0;
+			filter->outOfMemory = 1;
+			return fmu_check_log_print;
+		}
+		filter->size++;
+	}
+	k->count++;
+	*key = k;
+
+	if(k->count < filter->maxRepeats) return fmu_check_log_print;
+	if(k->count == filter->maxRepeats) return fmu_check_log_print_last;
+
+	k->suppressed++;
+	k->unreported++;
+	if(filter->reportInterval && (k->unreported >= filter->reportInterval)) {
+		return fmu_check_log_report;
+	}
+	return fmu_check_log_suppress;
+}
+
+void fmu_check_log_filter_report(fmu_check_log_filter_t* filter, fmu_check_log_key_t* k) {
+	const char* category = (k->category && *k->category) ? k->category : 0;
+	if(k->unreported) {
+		jm_log(filter->cb, fmu_checker_module, jm_log_level_nothing,
+			"\t[FMU]%s%s%s[FMU status:%s] suppressed %u repeat(s) of: %s",
+			category ? "[" : "", category ? category : "", category ? "]" : "",
+			k->statusStr, (unsigned)k->unreported, k->format ? k->format : "");
+		k->unreported = 0;
+	}
+	else {
+		jm_log(filter->cb, fmu_checker_module, jm_log_level_nothing,
+			"\t[FMU]%s%s%s[FMU status:%s] message logged %u time(s), further repeats will be suppressed",
+			category ? "[" : "", category ? category : "", category ? "]" : "",
+			k->statusStr, (unsigned)k->count);
+	}
+}
+
+void fmu_check_log_filter_merge(fmu_check_log_filter_t* filter, fmu_check_log_filter_t* other) {
+	size_t i;
+	for(i = 0; i < other->capacity; i++) {
+		fmu_check_log_key_t* src = &other->keys[i];
+		fmu_check_log_key_t* k;
+		if(!src->count) continue;
+		if(filter->outOfMemory
+			|| ((2 * (filter->size + 1) > filter->capacity) && !log_filter_grow(filter))) {
+			filter->outOfMemory = 1;
+			break;
+		}
+		k = log_filter_find(filter->keys, filter->capacity, src->hash, src->category, src->status, src->format);
+		if(!k->count) {
+			/* the strings are moved over */
+			*k = *src;
+			src->category = src->format = 0;
+			filter->size++;
+		}
+		else {
+			k->count += src->count;
+			k->suppressed += src->suppressed;
+			k->unreported += src->unreported;
+		}
+	}
+	fmu_check_log_filter_free(other);
+}
+
+void fmu_check_log_filter_summary(fmu_check_log_filter_t* filter) {
+	size_t i, num_keys = 0, num_suppressed = 0;
+	if(!filter->keys) return;
+
+	for(i = 0; i < filter->capacity; i++) {
+		if(filter->keys[i].suppressed) {
+			num_keys++;
+			num_suppressed += filter->keys[i].suppressed;
+		}
+	}
+	if(!num_keys) return;
+
+	jm_log(filter->cb, fmu_checker_module, jm_log_level_nothing,
+		"\t%u repeated message(s) suppressed for %u message kind(s) (limit: %u per kind):",
+		(unsigned)num_suppressed, (unsigned)num_keys, (unsigned)filter->maxRepeats);
+	for(i = 0; i < filter->capacity; i++) {
+		fmu_check_log_key_t* k = &filter->keys[i];
+		if(!k->suppressed) continue;
+		jm_log(filter->cb, fmu_checker_module, jm_log_level_nothing,
+			"\t\t%u time(s) [%s][FMU status:%s] %s",
+			(unsigned)k->count, (k->category && *k->category) ? k->category : "", k->statusStr, k->format ? k->format : "");
+	}
+}
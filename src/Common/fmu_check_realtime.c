@@ -0,0 +1,92 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmu_check_realtime.c
+	Real-time pacing of the simulation loops (--realtime option).
+*/
+
+#include <string.h>
+
+#include <fmuChecker.h>
+#include <fmu_check_realtime.h>
+
+/* Upper limits of the jitter histogram bins in seconds. The last bin is open. */
+static const double fmu_check_jitter_limits[FMUCHK_REALTIME_JITTER_BINS - 1] = { 1e-4, 5e-4, 1e-3, 5e-3, 1e-2 };
+static const char* fmu_check_jitter_labels[FMUCHK_REALTIME_JITTER_BINS] = {
+	"< 0.1 ms", "0.1-0.5 ms", "0.5-1 ms", "1-5 ms", "5-10 ms", ">= 10 ms"
+};
+
+void fmu_check_realtime_start(fmu_check_data_t* cdata, double simTime) {
+	fmu_check_realtime_t* rt = &cdata->realtime;
+	if(cdata->realtimeFactor <= 0) return;
+
+	memset(rt, 0, sizeof(*rt));
+	rt->simStart = simTime;
+	rt->wallStart = rt->stepStart = fmu_check_wall_clock();
+}
+
+void fmu_check_realtime_step(fmu_check_data_t* cdata, double simTime) {
+	fmu_check_realtime_t* rt = &cdata->realtime;
+	double deadline, now, compute, slack, jitter;
+	size_t bin;
+	if(cdata->realtimeFactor <= 0) return;
+
+	/* deadlines are absolute so that a late step does not shift the following ones */
+	deadline = rt->wallStart + (simTime - rt->simStart) / cdata->realtimeFactor;
+	now = fmu_check_wall_clock();
+	compute = now - rt->stepStart;
+	slack = deadline - now;
+
+	if((rt->numSteps == 0) || (slack < rt->minSlack)) rt->minSlack = slack;
+	if(compute > rt->maxCompute) rt->maxCompute = compute;
+	rt->sumCompute += compute;
+	rt->numSteps++;
+
+	if(slack < 0) {
+		rt->numMisses++;
+		jm_log_verbose(&cdata->callbacks, fmu_checker_module, "Missed the real-time deadline at simulation time %g by %g ms",
+			simTime, -slack * 1000.0);
+	}
+	else {
+		/* sleeping is not an FMI call */
+		fmu_check_watch(cdata, 0, simTime);
+		fmu_check_sleep_until(deadline);
+		now = fmu_check_wall_clock();
+	}
+
+	/* the next step is released late by the sleep overshoot or by the missed deadline */
+	jitter = now - deadline;
+	for(bin = 0; bin < FMUCHK_REALTIME_JITTER_BINS - 1; bin++) {
+		if(jitter < fmu_check_jitter_limits[bin]) break;
+	}
+	rt->jitter[bin]++;
+	rt->stepStart = now;
+}
+
+void fmu_check_realtime_report(fmu_check_data_t* cdata) {
+	fmu_check_realtime_t* rt = &cdata->realtime;
+	jm_callbacks* cb = &cdata->callbacks;
+	char histogram[400];
+	size_t bin, len = 0;
+	if((cdata->realtimeFactor <= 0) || (rt->numSteps == 0)) return;
+
+	jm_log_info(cb, fmu_checker_module, "Real-time pacing (factor %g): %u step(s), %u missed deadline(s)",
+		cdata->realtimeFactor, (unsigned)rt->numSteps, (unsigned)rt->numMisses);
+	jm_log_info(cb, fmu_checker_module, "Step compute time: %g ms on average, %g ms max (WCET estimate). Minimum slack: %g ms",
+		rt->sumCompute / rt->numSteps * 1000.0, rt->maxCompute * 1000.0, rt->minSlack * 1000.0);
+	histogram[0] = 0;
+	for(bin = 0; bin < FMUCHK_REALTIME_JITTER_BINS; bin++) {
+		len += jm_snprintf(histogram + len, sizeof(histogram) - len, "%s%s: %u",
+			bin ? ", " : "", fmu_check_jitter_labels[bin], (unsigned)rt->jitter[bin]);
+		if(len >= sizeof(histogram)) break;
+	}
+	jm_log_info(cb, fmu_checker_module, "Release jitter histogram: %s", histogram);
+	if(rt->numMisses > 0) {
+		jm_log_warning(cb, fmu_checker_module, "The FMU could not keep up with real time (factor %g) in %u of %u step(s)",
+			cdata->realtimeFactor, (unsigned)rt->numMisses, (unsigned)rt->numSteps);
+	}
+}
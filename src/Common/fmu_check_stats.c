@@ -0,0 +1,158 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmu_check_stats.c
+	Resource usage of the checker process and the run statistics file (--stats option).
+*/
+
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+
+#include <fmuChecker.h>
+#include <fmu_check_stats.h>
+
+#if defined(_WIN32) || defined(WIN32)
+#include <windows.h>
+#include <psapi.h>
+
+double fmu_check_cpu_time(void) {
+	FILETIME creation, exit, kernel, user;
+	ULARGE_INTEGER k, u;
+	if(!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) return 0;
+	k.LowPart = kernel.dwLowDateTime;
+	k.HighPart = kernel.dwHighDateTime;
+	u.LowPart = user.dwLowDateTime;
+	u.HighPart = user.dwHighDateTime;
+	/* 100 ns units */
+	return (double)(k.QuadPart + u.QuadPart) * 1e-7;
+}
+
+size_t fmu_check_peak_rss_kb(void) {
+	PROCESS_MEMORY_COUNTERS pmc;
+	if(!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+	return (size_t)(pmc.PeakWorkingSetSize / 1024);
+}
+
+#else
+#include <sys/time.h>
+#include <sys/resource.h>
+
+double fmu_check_cpu_time(void) {
+	struct rusage ru;
+	if(getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+	return (double)ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1e-6
+		+ (double)ru.ru_stime.tv_sec + ru.ru_stime.tv_usec * 1e-6;
+}
+
+size_t fmu_check_peak_rss_kb(void) {
+	struct rusage ru;
+	if(getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+#ifdef __APPLE__
+	/* bytes on Mac OS X */
+	return (size_t)(ru.ru_maxrss / 1024);
+#else
+	return (size_t)ru.ru_maxrss;
+#endif
+}
+#endif
+
+/* Print a string value with the JSON escapes */
+static void fmu_check_print_json_str(FILE* f, const char* str) {
+	const unsigned char* c;
+	fputc('"', f);
+	for(c = (const unsigned char*)str; *c; c++) {
+		if((*c == '"') || (*c == '\\')) fprintf(f, "\\%c", *c);
+		else if(*c < 0x20) fprintf(f, "\\u%04x", *c);
+		else fputc(*c, f);
+	}
+	fputc('"', f);
+}
+
+static const char* fmu_check_phase_names[fmu_check_num_phases] = {
+	"unzip",
+	"xml",
+	"load",
+	"instantiate",
+	"initialize",
+	"simulate",
+	"terminate",
+	"cleanup"
+};
+
+const char* fmu_check_phase_name(fmu_check_phase_enu_t phase) {
+	return fmu_check_phase_names[phase];
+}
+
+void fmu_check_phase_begin(fmu_check_data_t* cdata, fmu_check_phase_enu_t phase) {
+	fmu_check_phase_times_t* t = &cdata->phases;
+	fmu_check_phase_end(cdata);
+	t->current = phase;
+	t->running = 1;
+	t->wallStart = fmu_check_wall_clock();
+	t->cpuStart = fmu_check_cpu_time();
+}
+
+void fmu_check_phase_end(fmu_check_data_t* cdata) {
+	fmu_check_phase_times_t* t = &cdata->phases;
+	if(!t->running) return;
+	t->wall[t->current] += fmu_check_wall_clock() - t->wallStart;
+	t->cpu[t->current] += fmu_check_cpu_time() - t->cpuStart;
+	t->count[t->current]++;
+	t->running = 0;
+}
+
+void fmu_check_print_phase_times(fmu_check_data_t* cdata) {
+	jm_callbacks* cb = &cdata->callbacks;
+	fmu_check_phase_times_t* t = &cdata->phases;
+	int k, any = 0;
+
+	fmu_check_phase_end(cdata);
+	for(k = 0; k < fmu_check_num_phases; k++) {
+		if(!t->count[k]) continue;
+		if(!any) {
+			jm_log(cb, fmu_checker_module, jm_log_level_nothing, "Time spent (elapsed/CPU seconds):");
+			any = 1;
+		}
+		jm_log(cb, fmu_checker_module, jm_log_level_nothing, "\t%-12s %9.3f %9.3f", fmu_check_phase_names[k], t->wall[k], t->cpu[k]);
+	}
+}
+
+jm_status_enu_t fmu_check_write_stats(fmu_check_data_t* cdata, int exitCode, double wallStart) {
+	double wallTime = fmu_check_wall_clock() - wallStart;
+	FILE* f = fopen(cdata->statsFileName, "w");
+	int err, k, first;
+	if(!f) {
+		jm_log_error(&cdata->callbacks, fmu_checker_module, "Could not open %s for writing (%s)", cdata->statsFileName, strerror(errno));
+		return jm_status_error;
+	}
+	fprintf(f, "{\n\t\"fmu\": ");
+	fmu_check_print_json_str(f, cdata->FMUPath);
+	fprintf(f, ",\n\t\"exit_code\": %d,\n", exitCode);
+	fprintf(f, "\t\"wall_time\": %.6f,\n", wallTime);
+	fprintf(f, "\t\"cpu_time\": %.6f,\n", fmu_check_cpu_time());
+	fprintf(f, "\t\"peak_rss_kb\": %lu,\n", (unsigned long)fmu_check_peak_rss_kb());
+	fprintf(f, "\t\"fmu_messages\": %u,\n", cdata->num_fmu_messages);
+	fprintf(f, "\t\"warnings\": %u,\n", cdata->num_warnings);
+	fprintf(f, "\t\"errors\": %u,\n", cdata->num_errors);
+	fprintf(f, "\t\"fatal\": %u,\n", cdata->num_fatal);
+	fprintf(f, "\t\"phases\": {");
+	fmu_check_phase_end(cdata);
+	for(k = 0, first = 1; k < fmu_check_num_phases; k++) {
+		if(!cdata->phases.count[k]) continue;
+		fprintf(f, "%s\n\t\t\"%s\": {\"wall_time\": %.6f, \"cpu_time\": %.6f, \"count\": %u}",
+			first ? "" : ",", fmu_check_phase_names[k], cdata->phases.wall[k], cdata->phases.cpu[k], cdata->phases.count[k]);
+		first = 0;
+	}
+	fprintf(f, "%s}\n}\n", first ? "" : "\n\t");
+	err = ferror(f);
+	if((fclose(f) != 0) || err) {
+		jm_log_error(&cdata->callbacks, fmu_checker_module, "Error writing %s", cdata->statsFileName);
+		return jm_status_error;
+	}
+	return jm_status_success;
+}
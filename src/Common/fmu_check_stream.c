@@ -0,0 +1,322 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmu_check_stream.c
+	Compressed output and log files.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <zlib.h>
+#ifdef FMUCHK_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#include "fmuChecker.h"
+#include "fmu_check_stream.h"
+
+/** Size of the compressed data chunks written to the file */
+#define FMU_CHECK_STREAM_CHUNK_SIZE (64*1024)
+
+struct fmu_check_stream_t {
+	jm_callbacks* cb;
+	fmu_check_stream_kind_enu_t kind;
+	FILE* file;
+
+	/** Serializes the writers so that the data of one write call stay together
+		while the writer waits for a free buffer */
+	fmu_check_mutex_t writeMutex;
+	/** Protects the buffer state below */
+	fmu_check_mutex_t mutex;
+	/** Signaled when a buffer is queued, a buffer is released or the stream is closing */
+	fmu_check_cond_t cond;
+	fmu_check_thread_t* thread;
+
+	char* buffers[FMU_CHECK_STREAM_NUM_BUFFERS];
+	size_t lengths[FMU_CHECK_STREAM_NUM_BUFFERS];
+	/** Buffer filled by the writers */
+	size_t fill;
+	/** Number of buffers before fill that wait for or are in compression */
+	size_t numQueued;
+	/** Set when no more buffers are queued */
+	int closing;
+	/** Set when the stream is finished */
+	int finished;
+	/** Set when compressing or writing failed (in the compression thread) */
+	int error;
+
+	/** Compressor state, only used by the compression thread */
+	z_stream zs;
+#ifdef FMUCHK_WITH_ZSTD
+	ZSTD_CCtx* zstd;
+#endif
+	char* chunk;
+};
+
+fmu_check_stream_kind_enu_t fmu_check_stream_kind(const char* fileName) {
+	size_t len = fileName ? strlen(fileName) : 0;
+	if((len > 3) && (strcmp(fileName + len - 3, ".gz") == 0)) return fmu_check_stream_gzip;
+	if((len > 4) && (strcmp(fileName + len - 4, ".zst") == 0)) return fmu_check_stream_zstd;
+	return fmu_check_stream_plain;
+}
+
+static int fmu_check_stream_write_chunk(fmu_check_stream_t* s, size_t len) {
+	if(len && (fwrite(s->chunk, 1, len, s->file) != len)) return -1;
+	return 0;
+}
+
+/* Compress len bytes of data and write the compressed chunks. Ends the compressed stream if finish is set. */
+static int fmu_check_stream_compress(fmu_check_stream_t* s, const char* data, size_t len, int finish) {
+#ifdef FMUCHK_WITH_ZSTD
+	if(s->kind == fmu_check_stream_zstd) {
+		ZSTD_inBuffer in;
+		ZSTD_EndDirective mode = finish ? ZSTD_e_end : ZSTD_e_continue;
+		size_t remaining;
+		in.src = data;
+		in.size = len;
+		in.pos = 0;
+		do {
+			ZSTD_outBuffer out;
+			out.dst = s->chunk;
+			out.size = FMU_CHECK_STREAM_CHUNK_SIZE;
+			out.pos = 0;
+			remaining = ZSTD_compressStream2(s->zstd, &out, &in, mode);
+			if(ZSTD_isError(remaining) || fmu_check_stream_write_chunk(s, out.pos)) return -1;
+		} while(finish ? (remaining != 0) : (in.pos < in.size));
+		return 0;
+	}
+#endif
+	{
+		int ret;
+		s->zs.next_in = (Bytef*)data;
+		s->zs.avail_in = (uInt)len;
+		do {
+			s->zs.next_out = (Bytef*)s->chunk;
+			s->zs.avail_out = FMU_CHECK_STREAM_CHUNK_SIZE;
+			ret = deflate(&s->zs, finish ? Z_FINISH : Z_NO_FLUSH);
+			if((ret == Z_STREAM_ERROR)
+				|| fmu_check_stream_write_chunk(s, FMU_CHECK_STREAM_CHUNK_SIZE - s->zs.avail_out)) return -1;
+		} while(finish ? (ret != Z_STREAM_END) : (s->zs.avail_out == 0));
+		return 0;
+	}
+}
+
+/* Compression thread: compress the queued buffers in order, end the stream when closing */
+static void fmu_check_stream_main(void* data) {
+	fmu_check_stream_t* s = (fmu_check_stream_t*)data;
+	int error = 0;
+
+	fmu_check_mutex_lock(&s->mutex);
+	for(;;) {
+		size_t idx;
+		while(!s->numQueued && !s->closing) {
+			fmu_check_cond_wait(&s->cond, &s->mutex);
+		}
+		if(!s->numQueued) break;
+		idx = (s->fill + FMU_CHECK_STREAM_NUM_BUFFERS - s->numQueued) % FMU_CHECK_STREAM_NUM_BUFFERS;
+		fmu_check_mutex_unlock(&s->mutex);
+
+		/* after an error the data are dropped but the buffers are still released */
+		if(!error) error = fmu_check_stream_compress(s, s->buffers[idx], s->lengths[idx], 0);
+
+		fmu_check_mutex_lock(&s->mutex);
+		s->lengths[idx] = 0;
+		s->numQueued--;
+		if(error) s->error = 1;
+		fmu_check_cond_broadcast(&s->cond);
+	}
+	fmu_check_mutex_unlock(&s->mutex);
+
+	if(!error) error = fmu_check_stream_compress(s, 0, 0, 1);
+	if(fclose(s->file) != 0) error = 1;
+	s->file = 0;
+	if(error) {
+		fmu_check_mutex_lock(&s->mutex);
+		s->error = 1;
+		fmu_check_mutex_unlock(&s->mutex);
+	}
+}
+
+static void fmu_check_stream_free(fmu_check_stream_t* s) {
+	jm_callbacks* cb = s->cb;
+	size_t i;
+
+	if(s->kind == fmu_check_stream_gzip) deflateEnd(&s->zs);
+#ifdef FMUCHK_WITH_ZSTD
+	if(s->zstd) ZSTD_freeCCtx(s->zstd);
+#endif
+	for(i = 0; i < FMU_CHECK_STREAM_NUM_BUFFERS; i++) {
+		cb->free(s->buffers[i]);
+	}
+	cb->free(s->chunk);
+	if(s->file) fclose(s->file);
+	fmu_check_cond_destroy(&s->cond);
+	fmu_check_mutex_destroy(&s->mutex);
+	fmu_check_mutex_destroy(&s->writeMutex);
+	cb->free(s);
+}
+
+fmu_check_stream_t* fmu_check_stream_open(jm_callbacks* cb, const char* fileName, fmu_check_stream_kind_enu_t kind) {
+	fmu_check_stream_t* s;
+	size_t i;
+	int ok;
+
+#ifndef FMUCHK_WITH_ZSTD
+	if(kind == fmu_check_stream_zstd) {
+		jm_log_fatal(cb, fmu_checker_module, "Cannot write %s: the checker is built without zstd support", fileName);
+		return 0;
+	}
+#endif
+	s = (fmu_check_stream_t*)cb->calloc(1, sizeof(fmu_check_stream_t));
+	if(!s) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not allocate memory");
+		return 0;
+	}
+	s->cb = cb;
+	s->kind = kind;
+	fmu_check_mutex_init(&s->writeMutex);
+	fmu_check_mutex_init(&s->mutex);
+	fmu_check_cond_init(&s->cond);
+
+	ok = ((s->chunk = (char*)cb->malloc(FMU_CHECK_STREAM_CHUNK_SIZE)) != 0);
+	for(i = 0; ok && (i < FMU_CHECK_STREAM_NUM_BUFFERS); i++) {
+		ok = ((s->buffers[i] = (char*)cb->malloc(FMU_CHECK_STREAM_BUFFER_SIZE)) != 0);
+	}
+	if(!ok) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not allocate memory");
+		fmu_check_stream_free(s);
+		return 0;
+	}
+
+	if(kind == fmu_check_stream_gzip) {
+		/* window bits + 16 selects the gzip format */
+		if(deflateInit2(&s->zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+			jm_log_fatal(cb, fmu_checker_module, "Could not initialize gzip compression for %s", fileName);
+			s->kind = fmu_check_stream_plain;
+			fmu_check_stream_free(s);
+			return 0;
+		}
+	}
+#ifdef FMUCHK_WITH_ZSTD
+	else if(kind == fmu_check_stream_zstd) {
+		s->zstd = ZSTD_createCCtx();
+		if(!s->zstd) {
+			jm_log_fatal(cb, fmu_checker_module, "Could not initialize zstd compression for %s", fileName);
+			fmu_check_stream_free(s);
+			return 0;
+		}
+	}
+#endif
+
+	s->file = fopen(fileName, "wb");
+	if(!s->file) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not open %s for writing (%s)", fileName, strerror(errno));
+		fmu_check_stream_free(s);
+		return 0;
+	}
+	s->thread = fmu_check_thread_start(cb, fmu_check_stream_main, s);
+	if(!s->thread) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not start the compression thread for %s", fileName);
+		fmu_check_stream_free(s);
+		return 0;
+	}
+	return s;
+}
+
+/* Queue the buffer being filled and wait for a free one. Called with the mutex locked. */
+static void fmu_check_stream_queue(fmu_check_stream_t* s) {
+	while(s->numQueued >= FMU_CHECK_STREAM_NUM_BUFFERS - 1) {
+		fmu_check_cond_wait(&s->cond, &s->mutex);
+	}
+	s->numQueued++;
+	s->fill = (s->fill + 1) % FMU_CHECK_STREAM_NUM_BUFFERS;
+	fmu_check_cond_broadcast(&s->cond);
+}
+
+int fmu_check_stream_write(fmu_check_stream_t* s, const char* buf, size_t len) {
+	int ret = 0;
+
+	fmu_check_mutex_lock(&s->writeMutex);
+	fmu_check_mutex_lock(&s->mutex);
+	while(len) {
+		size_t n = FMU_CHECK_STREAM_BUFFER_SIZE - s->lengths[s->fill];
+		/* checked in the loop since the watchdog may finish the stream while a writer waits for a buffer */
+		if(s->finished || s->error) {
+			ret = -1;
+			break;
+		}
+		if(n > len) n = len;
+		memcpy(s->buffers[s->fill] + s->lengths[s->fill], buf, n);
+		s->lengths[s->fill] += n;
+		buf += n;
+		len -= n;
+		if(s->lengths[s->fill] == FMU_CHECK_STREAM_BUFFER_SIZE) {
+			fmu_check_stream_queue(s);
+		}
+	}
+	fmu_check_mutex_unlock(&s->mutex);
+	fmu_check_mutex_unlock(&s->writeMutex);
+	return ret;
+}
+
+int fmu_check_stream_vprintf(fmu_check_stream_t* s, const char* fmt, va_list args) {
+	char buf[1000];
+	char* text = buf;
+	va_list args2;
+	int len;
+
+	va_copy(args2, args);
+	len = jm_vsnprintf(buf, sizeof(buf), fmt, args);
+	if((len >= 0) && ((size_t)len >= sizeof(buf))) {
+		/* long messages are formatted into a temporary buffer */
+		text = (char*)s->cb->malloc((size_t)len + 1);
+		if(text) jm_vsnprintf(text, (size_t)len + 1, fmt, args2);
+		else len = -1;
+	}
+	va_end(args2);
+	if((len > 0) && (fmu_check_stream_write(s, text, (size_t)len) != 0)) len = -1;
+	if(text != buf) s->cb->free(text);
+	return len;
+}
+
+int fmu_check_stream_printf(fmu_check_stream_t* s, const char* fmt, ...) {
+	va_list args;
+	int len;
+	va_start(args, fmt);
+	len = fmu_check_stream_vprintf(s, fmt, args);
+	va_end(args);
+	return len;
+}
+
+int fmu_check_stream_finish(fmu_check_stream_t* s) {
+	fmu_check_thread_t* thread;
+
+	fmu_check_mutex_lock(&s->mutex);
+	thread = s->thread;
+	s->thread = 0;
+	if(!s->finished) {
+		s->finished = 1;
+		if(s->lengths[s->fill]) fmu_check_stream_queue(s);
+		s->closing = 1;
+		fmu_check_cond_broadcast(&s->cond);
+	}
+	fmu_check_mutex_unlock(&s->mutex);
+
+	/* only the first caller joins the thread */
+	if(thread) fmu_check_thread_join(thread);
+	return s->error ? -1 : 0;
+}
+
+int fmu_check_stream_close(fmu_check_stream_t* s) {
+	int ret;
+	if(!s) return 0;
+	ret = fmu_check_stream_finish(s);
+	fmu_check_stream_free(s);
+	return ret;
+}
@@ -0,0 +1,318 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmu_check_thread.c
+	Portable threads, locks, thread pool and wall clock used by the checker.
+*/
+
+#include <stdlib.h>
+
+#include <fmuChecker.h>
+#include <fmu_check_thread.h>
+
+#if defined(_WIN32) || defined(WIN32)
+
+struct fmu_check_thread_t {
+	jm_callbacks* cb;
+	HANDLE handle;
+	fmu_check_thread_ft func;
+	void* data;
+};
+
+static DWORD WINAPI fmu_check_thread_main(LPVOID arg) {
+	fmu_check_thread_t* thread = (fmu_check_thread_t*)arg;
+	thread->func(thread->data);
+	return 0;
+}
+
+fmu_check_thread_t* fmu_check_thread_start(jm_callbacks* cb, fmu_check_thread_ft func, void* data) {
+	fmu_check_thread_t* thread = (fmu_check_thread_t*)cb->calloc(1, sizeof(fmu_check_thread_t));
+	if(!thread) return 0;
+	thread->cb = cb;
+	thread->func = func;
+	thread->data = data;
+	thread->handle = CreateThread(NULL, 0, fmu_check_thread_main, thread, 0, NULL);
+	if(!thread->handle) {
+		cb->free(thread);
+		return 0;
+	}
+	return thread;
+}
+
+void fmu_check_thread_join(fmu_check_thread_t* thread) {
+	if(!thread) return;
+	WaitForSingleObject(thread->handle, INFINITE);
+	CloseHandle(thread->handle);
+	thread->cb->free(thread);
+}
+
+void fmu_check_mutex_init(fmu_check_mutex_t* mutex) { InitializeSRWLock(mutex); }
+void fmu_check_mutex_destroy(fmu_check_mutex_t* mutex) { (void)mutex; }
+void fmu_check_mutex_lock(fmu_check_mutex_t* mutex) { AcquireSRWLockExclusive(mutex); }
+void fmu_check_mutex_unlock(fmu_check_mutex_t* mutex) { ReleaseSRWLockExclusive(mutex); }
+
+void fmu_check_cond_init(fmu_check_cond_t* cond) { InitializeConditionVariable(cond); }
+void fmu_check_cond_destroy(fmu_check_cond_t* cond) { (void)cond; }
+void fmu_check_cond_wait(fmu_check_cond_t* cond, fmu_check_mutex_t* mutex) {
+	SleepConditionVariableSRW(cond, mutex, INFINITE, 0);
+}
+int fmu_check_cond_timed_wait(fmu_check_cond_t* cond, fmu_check_mutex_t* mutex, double seconds) {
+	DWORD ms = (seconds <= 0) ? 0 : (DWORD)(seconds * 1000.0 + 0.5);
+	return SleepConditionVariableSRW(cond, mutex, ms, 0) ? 1 : 0;
+}
+void fmu_check_cond_signal(fmu_check_cond_t* cond) { WakeConditionVariable(cond); }
+void fmu_check_cond_broadcast(fmu_check_cond_t* cond) { WakeAllConditionVariable(cond); }
+
+static SRWLOCK fmu_check_global_mutex = SRWLOCK_INIT;
+void fmu_check_global_lock(void) { AcquireSRWLockExclusive(&fmu_check_global_mutex); }
+void fmu_check_global_unlock(void) { ReleaseSRWLockExclusive(&fmu_check_global_mutex); }
+
+size_t fmu_check_get_num_cpus(void) {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (info.dwNumberOfProcessors > 0) ? (size_t)info.dwNumberOfProcessors : 1;
+}
+
+double fmu_check_wall_clock(void) {
+	LARGE_INTEGER freq, count;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+	return (double)count.QuadPart / (double)freq.QuadPart;
+}
+
+void fmu_check_sleep_until(double wallTime) {
+	double now;
+	/* Sleep() has a resolution of a scheduler tick; the last millisecond is spent yielding */
+	while((now = fmu_check_wall_clock()) < wallTime) {
+		DWORD ms = (DWORD)((wallTime - now) * 1000.0);
+		Sleep((ms > 1) ? ms - 1 : 0);
+	}
+}
+
+#else
+
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+struct fmu_check_thread_t {
+	jm_callbacks* cb;
+	pthread_t handle;
+	fmu_check_thread_ft func;
+	void* data;
+};
+
+static void* fmu_check_thread_main(void* arg) {
+	fmu_check_thread_t* thread = (fmu_check_thread_t*)arg;
+	thread->func(thread->data);
+	return 0;
+}
+
+fmu_check_thread_t* fmu_check_thread_start(jm_callbacks* cb, fmu_check_thread_ft func, void* data) {
+	fmu_check_thread_t* thread = (fmu_check_thread_t*)cb->calloc(1, sizeof(fmu_check_thread_t));
+	if(!thread) return 0;
+	thread->cb = cb;
+	thread->func = func;
+	thread->data = data;
+	if(pthread_create(&thread->handle, NULL, fmu_check_thread_main, thread) != 0) {
+		cb->free(thread);
+		return 0;
+	}
+	return thread;
+}
+
+void fmu_check_thread_join(fmu_check_thread_t* thread) {
+	if(!thread) return;
+	pthread_join(thread->handle, NULL);
+	thread->cb->free(thread);
+}
+
+void fmu_check_mutex_init(fmu_check_mutex_t* mutex) { pthread_mutex_init(mutex, NULL); }
+void fmu_check_mutex_destroy(fmu_check_mutex_t* mutex) { pthread_mutex_destroy(mutex); }
+void fmu_check_mutex_lock(fmu_check_mutex_t* mutex) { pthread_mutex_lock(mutex); }
+void fmu_check_mutex_unlock(fmu_check_mutex_t* mutex) { pthread_mutex_unlock(mutex); }
+
+void fmu_check_cond_init(fmu_check_cond_t* cond) { pthread_cond_init(cond, NULL); }
+void fmu_check_cond_destroy(fmu_check_cond_t* cond) { pthread_cond_destroy(cond); }
+void fmu_check_cond_wait(fmu_check_cond_t* cond, fmu_check_mutex_t* mutex) {
+	pthread_cond_wait(cond, mutex);
+}
+int fmu_check_cond_timed_wait(fmu_check_cond_t* cond, fmu_check_mutex_t* mutex, double seconds) {
+	/* condition variables use the realtime clock by default */
+	struct timeval now;
+	struct timespec deadline;
+	double sec;
+	gettimeofday(&now, NULL);
+	if(seconds < 0) seconds = 0;
+	sec = (double)now.tv_sec + now.tv_usec * 1e-6 + seconds;
+	deadline.tv_sec = (time_t)sec;
+	deadline.tv_nsec = (long)((sec - (double)deadline.tv_sec) * 1e9);
+	if(deadline.tv_nsec >= 1000000000L) deadline.tv_nsec = 999999999L;
+	return (pthread_cond_timedwait(cond, mutex, &deadline) == ETIMEDOUT) ? 0 : 1;
+}
+void fmu_check_cond_signal(fmu_check_cond_t* cond) { pthread_cond_signal(cond); }
+void fmu_check_cond_broadcast(fmu_check_cond_t* cond) { pthread_cond_broadcast(cond); }
+
+static pthread_mutex_t fmu_check_global_mutex = PTHREAD_MUTEX_INITIALIZER;
+void fmu_check_global_lock(void) { pthread_mutex_lock(&fmu_check_global_mutex); }
+void fmu_check_global_unlock(void) { pthread_mutex_unlock(&fmu_check_global_mutex); }
+
+size_t fmu_check_get_num_cpus(void) {
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return (n > 0) ? (size_t)n : 1;
+}
+
+double fmu_check_wall_clock(void) {
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+	if(clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+		return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+	}
+#endif
+	{
+		struct timeval tv;
+		gettimeofday(&tv, NULL);
+		return (double)tv.tv_sec + tv.tv_usec * 1e-6;
+	}
+}
+
+void fmu_check_sleep_until(double wallTime) {
+	struct timespec ts;
+	double now = fmu_check_wall_clock();
+	if(now >= wallTime) return;
+#if defined(CLOCK_MONOTONIC) && defined(TIMER_ABSTIME) && !defined(__APPLE__)
+	/* absolute deadline on the clock used by fmu_check_wall_clock() so that the sleeps do not drift */
+	ts.tv_sec = (time_t)wallTime;
+	ts.tv_nsec = (long)((wallTime - (double)ts.tv_sec) * 1e9);
+	if(ts.tv_nsec >= 1000000000L) ts.tv_nsec = 999999999L;
+	while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+#else
+	while(now < wallTime) {
+		double remaining = wallTime - now;
+		ts.tv_sec = (time_t)remaining;
+		ts.tv_nsec = (long)((remaining - (double)ts.tv_sec) * 1e9);
+		nanosleep(&ts, NULL);
+		now = fmu_check_wall_clock();
+	}
+#endif
+}
+
+#endif
+
+struct fmu_check_thread_pool_t {
+	jm_callbacks* cb;
+	size_t numThreads;
+	/** numThreads - 1 worker threads */
+	fmu_check_thread_t** workers;
+	fmu_check_mutex_t lock;
+	/** signalled when a new batch is posted or on shutdown */
+	fmu_check_cond_t workReady;
+	/** signalled when the last task of a batch finishes */
+	fmu_check_cond_t workDone;
+	fmu_check_task_ft task;
+	void* data;
+	size_t numTasks;
+	size_t nextTask;
+	size_t tasksDone;
+	int shutdown;
+};
+
+/* Take and run tasks of the current batch until none are left. Called with the lock held. */
+static void thread_pool_work(fmu_check_thread_pool_t* pool) {
+	while(pool->nextTask < pool->numTasks) {
+		size_t index = pool->nextTask++;
+		fmu_check_mutex_unlock(&pool->lock);
+		pool->task(pool->data, index);
+		fmu_check_mutex_lock(&pool->lock);
+		pool->tasksDone++;
+		if(pool->tasksDone == pool->numTasks) {
+			fmu_check_cond_broadcast(&pool->workDone);
+		}
+	}
+}
+
+static void thread_pool_worker(void* data) {
+	fmu_check_thread_pool_t* pool = (fmu_check_thread_pool_t*)data;
+	fmu_check_mutex_lock(&pool->lock);
+	while(!pool->shutdown) {
+		thread_pool_work(pool);
+		if(pool->shutdown) break;
+		fmu_check_cond_wait(&pool->workReady, &pool->lock);
+	}
+	fmu_check_mutex_unlock(&pool->lock);
+}
+
+fmu_check_thread_pool_t* fmu_check_thread_pool_create(jm_callbacks* cb, size_t numThreads) {
+	fmu_check_thread_pool_t* pool = (fmu_check_thread_pool_t*)cb->calloc(1, sizeof(fmu_check_thread_pool_t));
+	size_t i;
+	if(!pool) return 0;
+	if(numThreads == 0) numThreads = fmu_check_get_num_cpus();
+	pool->cb = cb;
+	pool->numThreads = 1;
+	fmu_check_mutex_init(&pool->lock);
+	fmu_check_cond_init(&pool->workReady);
+	fmu_check_cond_init(&pool->workDone);
+	if(numThreads > 1) {
+		pool->workers = (fmu_check_thread_t**)cb->calloc(numThreads - 1, sizeof(fmu_check_thread_t*));
+	}
+	for(i = 0; pool->workers && (i < numThreads - 1); i++) {
+		pool->workers[i] = fmu_check_thread_start(cb, thread_pool_worker, pool);
+		if(!pool->workers[i]) {
+			/* continue with the threads started so far */
+			jm_log_warning(cb, fmu_checker_module, "Could only start %u thread(s) out of %u", (unsigned)(i + 1), (unsigned)numThreads);
+			break;
+		}
+		pool->numThreads++;
+	}
+	return pool;
+}
+
+size_t fmu_check_thread_pool_size(fmu_check_thread_pool_t* pool) {
+	return pool->numThreads;
+}
+
+void fmu_check_thread_pool_run(fmu_check_thread_pool_t* pool, fmu_check_task_ft task, void* data, size_t numTasks) {
+	size_t i;
+	if((pool->numThreads == 1) || (numTasks == 1)) {
+		for(i = 0; i < numTasks; i++) {
+			task(data, i);
+		}
+		return;
+	}
+	fmu_check_mutex_lock(&pool->lock);
+	pool->task = task;
+	pool->data = data;
+	pool->numTasks = numTasks;
+	pool->nextTask = 0;
+	pool->tasksDone = 0;
+	fmu_check_cond_broadcast(&pool->workReady);
+	thread_pool_work(pool);
+	while(pool->tasksDone < pool->numTasks) {
+		fmu_check_cond_wait(&pool->workDone, &pool->lock);
+	}
+	pool->numTasks = 0;
+	pool->nextTask = 0;
+	fmu_check_mutex_unlock(&pool->lock);
+}
+
+void fmu_check_thread_pool_free(fmu_check_thread_pool_t* pool) {
+	size_t i;
+	if(!pool) return;
+	fmu_check_mutex_lock(&pool->lock);
+	pool->shutdown = 1;
+	fmu_check_cond_broadcast(&pool->workReady);
+	fmu_check_mutex_unlock(&pool->lock);
+	for(i = 0; i + 1 < pool->numThreads; i++) {
+		fmu_check_thread_join(pool->workers[i]);
+	}
+	pool->cb->free(pool->workers);
+	fmu_check_cond_destroy(&pool->workReady);
+	fmu_check_cond_destroy(&pool->workDone);
+	fmu_check_mutex_destroy(&pool->lock);
+	pool->cb->free(pool);
+}
@@ -0,0 +1,278 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmu_check_unpack.c
+	On-demand extraction of the parts of an FMU needed for simulation.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fmuChecker.h"
+#include "fmu_check_unpack.h"
+
+/** Number of parts extracted in the background */
+#define FMU_CHECK_UNPACK_NUM_PARTS 2
+
+/** Folder in the archive and the part for each extraction step, in order */
+static const char* fmu_check_unpack_folders[FMU_CHECK_UNPACK_NUM_PARTS] = {
+	"binaries/" FMI_PLATFORM "/",
+	"resources/"
+};
+static const fmu_check_unpack_part_enu_t fmu_check_unpack_parts[FMU_CHECK_UNPACK_NUM_PARTS] = {
+	fmu_check_unpack_binaries,
+	fmu_check_unpack_resources
+};
+
+/** Result of extracting the entries of a folder */
+typedef struct fmu_check_unpack_result_t {
+	size_t numFiles;
+	double bytes;
+	double seconds;
+	int failed;
+	/** First entry (in archive order) that could not be extracted */
+	size_t failedEntry;
+} fmu_check_unpack_result_t;
+
+struct fmu_check_unpack_t {
+	jm_callbacks* cb;
+	fmu_check_zip_t* zip;
+	const char* dir;
+	fmu_check_thread_t* thread;
+	/** Created by the checker thread and run by the background thread */
+	fmu_check_thread_pool_t* pool;
+
+	fmu_check_mutex_t lock;
+	fmu_check_cond_t partDone;
+	/** Parts that are done (bit mask of fmu_check_unpack_part_enu_t) */
+	int done;
+	/** Parts reported by fmu_check_unpack_wait() */
+	int reported;
+	/** Set to skip the rest */
+	int cancel;
+
+	fmu_check_unpack_result_t results[FMU_CHECK_UNPACK_NUM_PARTS];
+};
+
+/** Entry and its compressed size for ordering the work */
+typedef struct fmu_check_unpack_item_t {
+	size_t entry;
+	size_t compSize;
+} fmu_check_unpack_item_t;
+
+/** Work shared by the extraction tasks */
+typedef struct fmu_check_unpack_job_t {
+	fmu_check_zip_t* zip;
+	const char* dir;
+	/** Background extraction to check for cancellation (NULL if none) */
+	fmu_check_unpack_t* unpack;
+	fmu_check_unpack_item_t* items;
+	/** Per item: 1 if extracted, 0 if failed or skipped */
+	char* extracted;
+} fmu_check_unpack_job_t;
+
+static int fmu_check_unpack_part_index(fmu_check_unpack_part_enu_t part) {
+	int k;
+	for(k = 0; k < FMU_CHECK_UNPACK_NUM_PARTS; k++) {
+		if(fmu_check_unpack_parts[k] == part) return k;
+	}
+	return 0;
+}
+
+/* Largest compressed size first, then archive order */
+static int fmu_check_unpack_compare_items(const void* a, const void* b) {
+	const fmu_check_unpack_item_t* x = (const fmu_check_unpack_item_t*)a;
+	const fmu_check_unpack_item_t* y = (const fmu_check_unpack_item_t*)b;
+	if(x->compSize != y->compSize) return (x->compSize > y->compSize) ? -1 : 1;
+	return (x->entry < y->entry) ? -1 : (x->entry > y->entry);
+}
+
+/* Thread pool task: extract one entry */
+static void fmu_check_unpack_task(void* data, size_t index) {
+	fmu_check_unpack_job_t* job = (fmu_check_unpack_job_t*)data;
+	if(job->unpack) {
+		int cancel;
+		fmu_check_mutex_lock(&job->unpack->lock);
+		cancel = job->unpack->cancel;
+		fmu_check_mutex_unlock(&job->unpack->lock);
+		if(cancel) return;
+	}
+	job->extracted[index] = (char)fmu_check_zip_extract(job->zip, job->items[index].entry, job->dir);
+}
+
+/*
+	Extract the entries in the folder ("" for all) with the thread pool (on the calling thread if pool is NULL).
+	Returns 0 if out of memory. Nothing is logged so that this can run in the background thread.
+*/
+static int fmu_check_unpack_folder(jm_callbacks* cb, fmu_check_zip_t* zip, const char* dir, const char* folder,
+								   fmu_check_thread_pool_t* pool, fmu_check_unpack_t* unpack, fmu_check_unpack_result_t* result) {
+	size_t numEntries = fmu_check_zip_num_entries(zip), len = strlen(folder), n = 0, i;
+	double start = fmu_check_wall_clock();
+	fmu_check_unpack_job_t job;
+
+	memset(result, 0, sizeof(*result));
+	job.zip = zip;
+	job.dir = dir;
+	job.unpack = unpack;
+	job.items = (fmu_check_unpack_item_t*)cb->malloc((numEntries + 1) * sizeof(fmu_check_unpack_item_t));
+	job.extracted = (char*)cb->calloc(numEntries + 1, 1);
+	if(!job.items || !job.extracted) {
+		if(job.items) cb->free(job.items);
+		if(job.extracted) cb->free(job.extracted);
+		return 0;
+	}
+	for(i = 0; i < numEntries; i++) {
+		if(strncmp(fmu_check_zip_entry_name(zip, i), folder, len) != 0) continue;
+		job.items[n].entry = i;
+		job.items[n].compSize = fmu_check_zip_entry_compressed_size(zip, i);
+		n++;
+	}
+	qsort(job.items, n, sizeof(fmu_check_unpack_item_t), fmu_check_unpack_compare_items);
+
+	if(pool && (n > 1)) {
+		fmu_check_thread_pool_run(pool, fmu_check_unpack_task, &job, n);
+	}
+	else {
+		for(i = 0; i < n; i++) fmu_check_unpack_task(&job, i);
+	}
+
+	for(i = 0; i < n; i++) {
+		size_t entry = job.items[i].entry;
+		const char* name = fmu_check_zip_entry_name(zip, entry);
+		if(job.extracted[i]) {
+			/* folder entries are not counted */
+			if(*name && (name[strlen(name) - 1] != '/')) result->numFiles++;
+			result->bytes += (double)fmu_check_zip_entry_size(zip, entry);
+		}
+		else if(!result->failed || (entry < result->failedEntry)) {
+			result->failed = 1;
+			result->failedEntry = entry;
+		}
+	}
+	result->seconds = fmu_check_wall_clock() - start;
+	cb->free(job.items);
+	cb->free(job.extracted);
+	return 1;
+}
+
+/* Log the outcome of extracting a folder. Returns jm_status_error if an entry failed. */
+static jm_status_enu_t fmu_check_unpack_report(jm_callbacks* cb, fmu_check_zip_t* zip, const char* folder,
+											   fmu_check_thread_pool_t* pool, const fmu_check_unpack_result_t* result) {
+	if(result->failed) {
+		jm_log_error(cb, fmu_checker_module, "Could not extract %s from the FMU", fmu_check_zip_entry_name(zip, result->failedEntry));
+		return jm_status_error;
+	}
+	jm_log_verbose(cb, fmu_checker_module, "Extracted %u file(s) (%g MB) from %s with %u thread(s) in %g s",
+		(unsigned)result->numFiles, result->bytes / (1024.0 * 1024.0), *folder ? folder : "the FMU",
+		(unsigned)(pool ? fmu_check_thread_pool_size(pool) : 1), result->seconds);
+	return jm_status_success;
+}
+
+/* Background thread: extract the parts in order. Nothing is logged here since the logger is not thread safe. */
+static void fmu_check_unpack_thread(void* data) {
+	fmu_check_unpack_t* u = (fmu_check_unpack_t*)data;
+	int k;
+
+	for(k = 0; k < FMU_CHECK_UNPACK_NUM_PARTS; k++) {
+		fmu_check_unpack_result_t* result = &u->results[k];
+		if(!fmu_check_unpack_folder(u->cb, u->zip, u->dir, fmu_check_unpack_folders[k], u->pool, u, result)) {
+			/* out of memory, reported as a failure of the first entry */
+			result->failed = 1;
+			result->failedEntry = 0;
+		}
+		fmu_check_mutex_lock(&u->lock);
+		u->done |= fmu_check_unpack_parts[k];
+		fmu_check_cond_broadcast(&u->partDone);
+		fmu_check_mutex_unlock(&u->lock);
+	}
+}
+
+jm_status_enu_t fmu_check_unpack_start(fmu_check_data_t* cdata) {
+	jm_callbacks* cb = &cdata->callbacks;
+	fmu_check_unpack_t* u = (fmu_check_unpack_t*)cb->calloc(1, sizeof(fmu_check_unpack_t));
+
+	if(!u) {
+		jm_log_error(cb, fmu_checker_module, "Could not allocate memory");
+		return jm_status_error;
+	}
+	u->cb = cb;
+	u->zip = cdata->fmuZip;
+	u->dir = cdata->tmpPath;
+	/* the pool is created here since creating it may log */
+	u->pool = fmu_check_thread_pool_create(cb, cdata->num_threads);
+	fmu_check_mutex_init(&u->lock);
+	fmu_check_cond_init(&u->partDone);
+	u->thread = fmu_check_thread_start(cb, fmu_check_unpack_thread, u);
+	if(!u->thread) {
+		jm_log_error(cb, fmu_checker_module, "Could not start a thread for extracting the FMU");
+		fmu_check_thread_pool_free(u->pool);
+		fmu_check_cond_destroy(&u->partDone);
+		fmu_check_mutex_destroy(&u->lock);
+		cb->free(u);
+		return jm_status_error;
+	}
+	cdata->unpack = u;
+	jm_log_verbose(cb, fmu_checker_module, "Extracting %s and %s from the FMU in the background",
+		fmu_check_unpack_folders[0], fmu_check_unpack_folders[1]);
+	return jm_status_success;
+}
+
+jm_status_enu_t fmu_check_unpack_all(fmu_check_data_t* cdata) {
+	jm_callbacks* cb = &cdata->callbacks;
+	fmu_check_thread_pool_t* pool = fmu_check_thread_pool_create(cb, cdata->num_threads);
+	fmu_check_unpack_result_t result;
+	jm_status_enu_t status;
+
+	if(!fmu_check_unpack_folder(cb, cdata->fmuZip, cdata->tmpPath, "", pool, 0, &result)) {
+		jm_log_error(cb, fmu_checker_module, "Could not allocate memory");
+		status = jm_status_error;
+	}
+	else {
+		status = fmu_check_unpack_report(cb, cdata->fmuZip, "", pool, &result);
+	}
+	if(pool) fmu_check_thread_pool_free(pool);
+	return status;
+}
+
+jm_status_enu_t fmu_check_unpack_wait(fmu_check_data_t* cdata, fmu_check_unpack_part_enu_t part) {
+	fmu_check_unpack_t* u = cdata->unpack;
+	jm_callbacks* cb = &cdata->callbacks;
+	double start;
+	int k, report;
+
+	if(!u) return jm_status_success;
+	k = fmu_check_unpack_part_index(part);
+	start = fmu_check_wall_clock();
+	fmu_check_mutex_lock(&u->lock);
+	while(!(u->done & part)) {
+		fmu_check_cond_wait(&u->partDone, &u->lock);
+	}
+	report = !(u->reported & part);
+	u->reported |= part;
+	fmu_check_mutex_unlock(&u->lock);
+
+	if(report) {
+		jm_log_verbose(cb, fmu_checker_module, "Waited %g s for %s", fmu_check_wall_clock() - start, fmu_check_unpack_folders[k]);
+		return fmu_check_unpack_report(cb, u->zip, fmu_check_unpack_folders[k], u->pool, &u->results[k]);
+	}
+	return u->results[k].failed ? jm_status_error : jm_status_success;
+}
+
+void fmu_check_unpack_stop(fmu_check_data_t* cdata) {
+	fmu_check_unpack_t* u = cdata->unpack;
+	if(!u) return;
+	fmu_check_mutex_lock(&u->lock);
+	u->cancel = 1;
+	fmu_check_mutex_unlock(&u->lock);
+	fmu_check_thread_join(u->thread);
+	if(u->pool) fmu_check_thread_pool_free(u->pool);
+	fmu_check_cond_destroy(&u->partDone);
+	fmu_check_mutex_destroy(&u->lock);
+	cdata->callbacks.free(u);
+	cdata->unpack = 0;
+}
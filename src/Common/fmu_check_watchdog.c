@@ -0,0 +1,218 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmu_check_watchdog.c
+	Watchdog thread enforcing the run time limits (--timeout and --call-timeout options).
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <fmuChecker.h>
+#include <fmu_check_watchdog.h>
+
+typedef struct fmu_check_watchdog_t {
+	/** Checker data of the run (first watched instance) */
+	fmu_check_data_t* cdata;
+	double wallStart;
+	/** Polling interval in seconds */
+	double interval;
+	fmu_check_thread_t* thread;
+	fmu_check_mutex_t mutex;
+	fmu_check_cond_t cond;
+	int stop;
+	/** Watched instances, protected by the mutex */
+	fmu_check_data_t** watched;
+	size_t numWatched;
+	size_t capWatched;
+} fmu_check_watchdog_t;
+
+/* There is one watchdog per process */
+static fmu_check_watchdog_t* fmu_check_watchdog = 0;
+
+void fmu_check_watch(fmu_check_data_t* cdata, const char* callName, double simTime) {
+	fmu_check_watch_t* w = &cdata->watch;
+	if(!fmu_check_watchdog) return;
+	/* the name is written last so that the watchdog does not see it with an old start time */
+	w->callName = 0;
+	w->simTime = simTime;
+	w->callStart = fmu_check_wall_clock();
+	w->callName = callName;
+}
+
+void fmu_check_watch_end(fmu_check_data_t* cdata) {
+	if(fmu_check_watchdog) cdata->watch.callName = 0;
+}
+
+/* Log the expiry, save what can be saved and exit. Called with the mutex locked. */
+static void fmu_check_watchdog_expire(fmu_check_watchdog_t* wd, fmu_check_data_t* stuck, const char* callName, double simTime, double callTime) {
+	fmu_check_data_t* cdata = wd->cdata;
+	jm_callbacks* cb = &cdata->callbacks;
+	size_t i;
+
+	if(stuck) {
+		jm_log_fatal(cb, fmu_checker_module, "Watchdog: %s%s%s did not return within %g s (running for %g s at simulation time %g)",
+			callName, stuck->modelName ? " in model " : "", stuck->modelName ? stuck->modelName : "",
+			cdata->callTimeout, callTime, simTime);
+	}
+	else if(callName) {
+		jm_log_fatal(cb, fmu_checker_module, "Watchdog: run time limit of %g s exceeded while in %s at simulation time %g",
+			cdata->totalTimeout, callName, simTime);
+	}
+	else {
+		jm_log_fatal(cb, fmu_checker_module, "Watchdog: run time limit of %g s exceeded", cdata->totalTimeout);
+	}
+
+	/* keep the results written so far */
+	for(i = 0; i < wd->numWatched; i++) {
+		if(wd->watched[i]->out_stream) fmu_check_stream_finish(wd->watched[i]->out_stream);
+		else if(wd->watched[i]->out_file) fflush(wd->watched[i]->out_file);
+	}
+	fmu_check_print_summary(cdata);
+	jm_log(cb, fmu_checker_module, jm_log_level_nothing, "\tRun aborted by the watchdog (exit code %d)", FMUCHK_EXIT_TIMEOUT);
+	if(cdata->statsFileName) {
+		fmu_check_write_stats(cdata, FMUCHK_EXIT_TIMEOUT, wd->wallStart);
+	}
+	if(cdata->log_stream) fmu_check_stream_finish(cdata->log_stream);
+	else if(cdata->log_file) fflush(cdata->log_file);
+	do_exit(FMUCHK_EXIT_TIMEOUT);
+}
+
+static void fmu_check_watchdog_main(void* data) {
+	fmu_check_watchdog_t* wd = (fmu_check_watchdog_t*)data;
+	fmu_check_data_t* cdata = wd->cdata;
+
+	fmu_check_mutex_lock(&wd->mutex);
+	while(!wd->stop) {
+		double now = fmu_check_wall_clock();
+		size_t i;
+
+		if(cdata->callTimeout > 0) {
+			for(i = 0; i < wd->numWatched; i++) {
+				fmu_check_watch_t* w = &wd->watched[i]->watch;
+				const char* callName = w->callName;
+				double callTime = now - w->callStart;
+				if(callName && (callTime > cdata->callTimeout)) {
+					fmu_check_watchdog_expire(wd, wd->watched[i], callName, w->simTime, callTime);
+				}
+			}
+		}
+		if((cdata->totalTimeout > 0) && (now - wd->wallStart > cdata->totalTimeout)) {
+			/* report the first instance that is in an FMI call */
+			for(i = 0; i < wd->numWatched; i++) {
+				if(wd->watched[i]->watch.callName) break;
+			}
+			if(i == wd->numWatched) i = 0;
+			fmu_check_watchdog_expire(wd, 0, wd->watched[i]->watch.callName, wd->watched[i]->watch.simTime, 0);
+		}
+		fmu_check_cond_timed_wait(&wd->cond, &wd->mutex, wd->interval);
+	}
+	fmu_check_mutex_unlock(&wd->mutex);
+}
+
+jm_status_enu_t fmu_check_watchdog_start(fmu_check_data_t* cdata, double wallStart) {
+	jm_callbacks* cb = &cdata->callbacks;
+	fmu_check_watchdog_t* wd;
+	double shortest;
+
+	if((cdata->totalTimeout <= 0) && (cdata->callTimeout <= 0)) return jm_status_success;
+	assert(!fmu_check_watchdog);
+
+	wd = (fmu_check_watchdog_t*)cb->calloc(1, sizeof(fmu_check_watchdog_t));
+	if(wd) wd->watched = (fmu_check_data_t**)cb->calloc(8, sizeof(fmu_check_data_t*));
+	if(!wd || !wd->watched) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not allocate memory");
+		if(wd) cb->free(wd);
+		return jm_status_error;
+	}
+	wd->cdata = cdata;
+	wd->wallStart = wallStart;
+	wd->capWatched = 8;
+	wd->watched[0] = cdata;
+	wd->numWatched = 1;
+
+	/* check ten times per the shortest timeout, but not more often than every 10 ms and at least every 0.5 s */
+	if(cdata->callTimeout <= 0) shortest = cdata->totalTimeout;
+	else if(cdata->totalTimeout <= 0) shortest = cdata->callTimeout;
+	else shortest = (cdata->callTimeout < cdata->totalTimeout) ? cdata->callTimeout : cdata->totalTimeout;
+	wd->interval = shortest / 10;
+	if(wd->interval < 0.01) wd->interval = 0.01;
+	if(wd->interval > 0.5) wd->interval = 0.5;
+
+	fmu_check_mutex_init(&wd->mutex);
+	fmu_check_cond_init(&wd->cond);
+	fmu_check_watchdog = wd;
+	wd->thread = fmu_check_thread_start(cb, fmu_check_watchdog_main, wd);
+	if(!wd->thread) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not start the watchdog thread");
+		fmu_check_watchdog = 0;
+		fmu_check_cond_destroy(&wd->cond);
+		fmu_check_mutex_destroy(&wd->mutex);
+		cb->free(wd->watched);
+		cb->free(wd);
+		return jm_status_error;
+	}
+	jm_log_verbose(cb, fmu_checker_module, "Started the watchdog (total timeout %g s, call timeout %g s)",
+		cdata->totalTimeout, cdata->callTimeout);
+	return jm_status_success;
+}
+
+void fmu_check_watchdog_stop(void) {
+	fmu_check_watchdog_t* wd = fmu_check_watchdog;
+	jm_callbacks* cb;
+	if(!wd) return;
+	cb = &wd->cdata->callbacks;
+
+	fmu_check_mutex_lock(&wd->mutex);
+	wd->stop = 1;
+	fmu_check_cond_signal(&wd->cond);
+	fmu_check_mutex_unlock(&wd->mutex);
+	fmu_check_thread_join(wd->thread);
+
+	fmu_check_watchdog = 0;
+	fmu_check_cond_destroy(&wd->cond);
+	fmu_check_mutex_destroy(&wd->mutex);
+	cb->free(wd->watched);
+	cb->free(wd);
+}
+
+void fmu_check_watchdog_add(fmu_check_data_t* cdata) {
+	fmu_check_watchdog_t* wd = fmu_check_watchdog;
+	if(!wd) return;
+	fmu_check_mutex_lock(&wd->mutex);
+	if(wd->numWatched == wd->capWatched) {
+		jm_callbacks* cb = &wd->cdata->callbacks;
+		fmu_check_data_t** watched = (fmu_check_data_t**)cb->calloc(2 * wd->capWatched, sizeof(fmu_check_data_t*));
+		if(!watched) {
+			/* the instance is not watched but the run can go on */
+			fmu_check_mutex_unlock(&wd->mutex);
+			jm_log_warning(cb, fmu_checker_module, "Could not allocate memory for the watchdog");
+			return;
+		}
+		memcpy(watched, wd->watched, wd->numWatched * sizeof(fmu_check_data_t*));
+		cb->free(wd->watched);
+		wd->watched = watched;
+		wd->capWatched *= 2;
+	}
+	wd->watched[wd->numWatched++] = cdata;
+	fmu_check_mutex_unlock(&wd->mutex);
+}
+
+void fmu_check_watchdog_remove(fmu_check_data_t* cdata) {
+	fmu_check_watchdog_t* wd = fmu_check_watchdog;
+	size_t i;
+	if(!wd) return;
+	fmu_check_mutex_lock(&wd->mutex);
+	for(i = 1; i < wd->numWatched; i++) {
+		if(wd->watched[i] == cdata) {
+			wd->watched[i] = wd->watched[--wd->numWatched];
+			break;
+		}
+	}
+	fmu_check_mutex_unlock(&wd->mutex);
+}
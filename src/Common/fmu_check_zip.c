@@ -0,0 +1,452 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmu_check_zip.c
+	Reading single entries of an FMU archive.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/stat.h>
+#if defined(_WIN32) || defined(WIN32)
+#include <direct.h>
+#endif
+
+#include <zlib.h>
+
+#include "fmuChecker.h"
+#include "fmu_check_zip.h"
+
+/* Record signatures and fixed sizes (APPNOTE.TXT) */
+#define ZIP_LOCAL_SIG 0x04034b50UL
+#define ZIP_LOCAL_SIZE 30
+#define ZIP_CENTRAL_SIG 0x02014b50UL
+#define ZIP_CENTRAL_SIZE 46
+#define ZIP_EOCD_SIG 0x06054b50UL
+#define ZIP_EOCD_SIZE 22
+#define ZIP64_LOCATOR_SIG 0x07064b50UL
+#define ZIP64_LOCATOR_SIZE 20
+#define ZIP64_EOCD_SIG 0x06064b50UL
+#define ZIP64_EOCD_SIZE 56
+#define ZIP64_EXTRA_ID 0x0001
+#define ZIP_MAX_COMMENT 0xFFFF
+
+/* Compression methods */
+#define ZIP_STORED 0
+#define ZIP_DEFLATED 8
+
+/** Size of the blocks of compressed data read from the archive */
+#define ZIP_READ_BLOCK (64*1024)
+/** Largest buffer used when writing an extracted file */
+#define ZIP_MAX_WRITE_BUFFER (1024*1024)
+
+typedef struct fmu_check_zip_entry_t {
+	const char* name;
+	int method;
+	int encrypted;
+	unsigned long crc;
+	unsigned long long compSize;
+	unsigned long long size;
+	/** Offset of the local header */
+	unsigned long long offset;
+} fmu_check_zip_entry_t;
+
+struct fmu_check_zip_t {
+	jm_callbacks* cb;
+	char* fileName;
+	size_t numEntries;
+	fmu_check_zip_entry_t* entries;
+	/** Zero terminated entry names */
+	char* names;
+};
+
+static unsigned get16(const unsigned char* p) {
+	return (unsigned)p[0] | ((unsigned)p[1] << 8);
+}
+
+static unsigned long get32(const unsigned char* p) {
+	return (unsigned long)get16(p) | ((unsigned long)get16(p + 2) << 16);
+}
+
+static unsigned long long get64(const unsigned char* p) {
+	return (unsigned long long)get32(p) | ((unsigned long long)get32(p + 4) << 32);
+}
+
+static int zip_seek(FILE* f, unsigned long long pos) {
+#if defined(_WIN32) || defined(WIN32)
+	return _fseeki64(f, (long long)pos, SEEK_SET);
+#else
+	return fseeko(f, (off_t)pos, SEEK_SET);
+#endif
+}
+
+static long long zip_file_size(FILE* f) {
+#if defined(_WIN32) || defined(WIN32)
+	if(_fseeki64(f, 0, SEEK_END) != 0) return -1;
+	return _ftelli64(f);
+#else
+	if(fseeko(f, 0, SEEK_END) != 0) return -1;
+	return (long long)ftello(f);
+#endif
+}
+
+static int zip_read_at(FILE* f, unsigned long long pos, void* buf, size_t size) {
+	return (zip_seek(f, pos) == 0) && (fread(buf, 1, size, f) == size);
+}
+
+/*
+	Find the central directory from the end of central directory record
+	(and the zip64 records if needed). Returns 0 if the archive cannot be read.
+*/
+static int zip_find_central_dir(jm_callbacks* cb, FILE* f, unsigned long long* numEntries, unsigned long long* cdOffset, unsigned long long* cdSize) {
+	long long fileSize = zip_file_size(f);
+	size_t tailSize, i;
+	unsigned char* tail;
+	unsigned long long eocdPos = 0;
+	int found = 0;
+
+	if(fileSize < ZIP_EOCD_SIZE) return 0;
+	tailSize = (fileSize < ZIP_EOCD_SIZE + ZIP_MAX_COMMENT) ? (size_t)fileSize : ZIP_EOCD_SIZE + ZIP_MAX_COMMENT;
+	tail = (unsigned char*)cb->malloc(tailSize);
+	if(!tail) return 0;
+	if(zip_read_at(f, (unsigned long long)fileSize - tailSize, tail, tailSize)) {
+		/* the record is followed by a comment of at most 64k, search backwards */
+		for(i = tailSize - ZIP_EOCD_SIZE + 1; i-- > 0; ) {
+			if(get32(tail + i) == ZIP_EOCD_SIG) {
+				eocdPos = (unsigned long long)fileSize - tailSize + i;
+				*numEntries = get16(tail + i + 10);
+				*cdSize = get32(tail + i + 12);
+				*cdOffset = get32(tail + i + 16);
+				found = 1;
+				break;
+			}
+		}
+	}
+	cb->free(tail);
+	if(!found) return 0;
+
+	if((*numEntries == 0xFFFF) || (*cdSize == 0xFFFFFFFFUL) || (*cdOffset == 0xFFFFFFFFUL)) {
+		unsigned char locator[ZIP64_LOCATOR_SIZE], eocd64[ZIP64_EOCD_SIZE];
+		if(    (eocdPos < ZIP64_LOCATOR_SIZE)
+			|| !zip_read_at(f, eocdPos - ZIP64_LOCATOR_SIZE, locator, ZIP64_LOCATOR_SIZE)
+			|| (get32(locator) != ZIP64_LOCATOR_SIG)
+			|| !zip_read_at(f, get64(locator + 8), eocd64, ZIP64_EOCD_SIZE)
+			|| (get32(eocd64) != ZIP64_EOCD_SIG)) {
+				return 0;
+		}
+		*numEntries = get64(eocd64 + 32);
+		*cdSize = get64(eocd64 + 40);
+		*cdOffset = get64(eocd64 + 48);
+	}
+	return (*cdOffset <= (unsigned long long)fileSize) && (*cdSize <= (unsigned long long)fileSize - *cdOffset);
+}
+
+/* Take the 64 bit sizes and offset from the zip64 extra field where the 32 bit ones overflowed */
+static int zip_read_zip64_extra(fmu_check_zip_entry_t* e, const unsigned char* extra, size_t extraLen) {
+	while(extraLen >= 4) {
+		unsigned id = get16(extra), len = get16(extra + 2);
+		if(len > extraLen - 4) return 0;
+		if(id == ZIP64_EXTRA_ID) {
+			const unsigned char* p = extra + 4;
+			const unsigned char* end = p + len;
+			if(e->size == 0xFFFFFFFFUL) {
+				if(p + 8 > end) return 0;
+				e->size = get64(p);
+				p += 8;
+			}
+			if(e->compSize == 0xFFFFFFFFUL) {
+				if(p + 8 > end) return 0;
+				e->compSize = get64(p);
+				p += 8;
+			}
+			if(e->offset == 0xFFFFFFFFUL) {
+				if(p + 8 > end) return 0;
+				e->offset = get64(p);
+			}
+			return 1;
+		}
+		extra += 4 + len;
+		extraLen -= 4 + len;
+	}
+	return 1;
+}
+
+fmu_check_zip_t* fmu_check_zip_open(jm_callbacks* cb, const char* fileName) {
+	FILE* f = fopen(fileName, "rb");
+	double start = fmu_check_wall_clock();
+	unsigned long long numEntries, cdOffset, cdSize;
+	unsigned char* cd = 0;
+	fmu_check_zip_t* zip = 0;
+	const unsigned char* p;
+	size_t i, namesUsed = 0;
+	int ok;
+
+	if(!f) {
+		jm_log_verbose(cb, fmu_checker_module, "Could not open %s", fileName);
+		return 0;
+	}
+	ok = zip_find_central_dir(cb, f, &numEntries, &cdOffset, &cdSize)
+		&& (cdSize < (size_t)-1 - 1) && (numEntries <= cdSize / ZIP_CENTRAL_SIZE);
+	if(ok) {
+		cd = (unsigned char*)cb->malloc((size_t)cdSize + 1);
+		zip = (fmu_check_zip_t*)cb->calloc(1, sizeof(fmu_check_zip_t));
+		if(zip) zip->cb = cb;
+		ok = cd && zip;
+	}
+	if(ok) {
+		zip->numEntries = (size_t)numEntries;
+		zip->fileName = (char*)cb->malloc(strlen(fileName) + 1);
+		zip->entries = (fmu_check_zip_entry_t*)cb->calloc(zip->numEntries + 1, sizeof(fmu_check_zip_entry_t));
+		/* the names take less space than the central directory records they are in */
+		zip->names = (char*)cb->malloc((size_t)cdSize + 1);
+		ok = zip->fileName && zip->entries && zip->names && zip_read_at(f, cdOffset, cd, (size_t)cdSize);
+	}
+	fclose(f);
+
+	for(i = 0, p = cd; ok && (i < zip->numEntries); i++) {
+		fmu_check_zip_entry_t* e = &zip->entries[i];
+		size_t nameLen, extraLen, commentLen;
+		if(    (p + ZIP_CENTRAL_SIZE > cd + cdSize)
+			|| (get32(p) != ZIP_CENTRAL_SIG)) {
+			ok = 0;
+			break;
+		}
+		nameLen = get16(p + 28);
+		extraLen = get16(p + 30);
+		commentLen = get16(p + 32);
+		if(p + ZIP_CENTRAL_SIZE + nameLen + extraLen + commentLen > cd + cdSize) {
+			ok = 0;
+			break;
+		}
+		e->encrypted = (get16(p + 8) & 1);
+		e->method = (int)get16(p + 10);
+		e->crc = get32(p + 16);
+		e->compSize = get32(p + 20);
+		e->size = get32(p + 24);
+		e->offset = get32(p + 42);
+		ok = zip_read_zip64_extra(e, p + ZIP_CENTRAL_SIZE + nameLen, extraLen);
+		memcpy(zip->names + namesUsed, p + ZIP_CENTRAL_SIZE, nameLen);
+		zip->names[namesUsed + nameLen] = 0;
+		e->name = zip->names + namesUsed;
+		namesUsed += nameLen + 1;
+		p += ZIP_CENTRAL_SIZE + nameLen + extraLen + commentLen;
+	}
+	if(cd) cb->free(cd);
+	if(!ok) {
+		jm_log_verbose(cb, fmu_checker_module, "Could not read the zip central directory of %s", fileName);
+		fmu_check_zip_close(zip);
+		return 0;
+	}
+	strcpy(zip->fileName, fileName);
+	jm_log_verbose(cb, fmu_checker_module, "Read the zip central directory of %s: %u entries in %g s",
+		fileName, (unsigned)zip->numEntries, fmu_check_wall_clock() - start);
+	return zip;
+}
+
+void fmu_check_zip_close(fmu_check_zip_t* zip) {
+	jm_callbacks* cb;
+	if(!zip) return;
+	cb = zip->cb;
+	if(zip->fileName) cb->free(zip->fileName);
+	if(zip->entries) cb->free(zip->entries);
+	if(zip->names) cb->free(zip->names);
+	cb->free(zip);
+}
+
+size_t fmu_check_zip_num_entries(fmu_check_zip_t* zip) {
+	return zip->numEntries;
+}
+
+const char* fmu_check_zip_entry_name(fmu_check_zip_t* zip, size_t index) {
+	return zip->entries[index].name;
+}
+
+size_t fmu_check_zip_entry_size(fmu_check_zip_t* zip, size_t index) {
+	return (size_t)zip->entries[index].size;
+}
+
+size_t fmu_check_zip_entry_compressed_size(fmu_check_zip_t* zip, size_t index) {
+	return (size_t)zip->entries[index].compSize;
+}
+
+int fmu_check_zip_find(fmu_check_zip_t* zip, const char* name) {
+	size_t i;
+	for(i = 0; i < zip->numEntries; i++) {
+		if(strcmp(zip->entries[i].name, name) == 0) return (int)i;
+	}
+	return -1;
+}
+
+int fmu_check_zip_has_folder(fmu_check_zip_t* zip, const char* folder) {
+	size_t i, len = strlen(folder);
+	for(i = 0; i < zip->numEntries; i++) {
+		if(strncmp(zip->entries[i].name, folder, len) == 0) return 1;
+	}
+	return 0;
+}
+
+/* Consumer of the uncompressed data of an entry. Returns 0 on failure. */
+typedef int (*zip_sink_ft)(void* context, const char* data, size_t len);
+
+typedef struct zip_memory_sink_t {
+	char* data;
+	size_t used, size;
+} zip_memory_sink_t;
+
+static int zip_memory_sink(void* context, const char* data, size_t len) {
+	zip_memory_sink_t* m = (zip_memory_sink_t*)context;
+	if(len > m->size - m->used) return 0;
+	memcpy(m->data + m->used, data, len);
+	m->used += len;
+	return 1;
+}
+
+static int zip_file_sink(void* context, const char* data, size_t len) {
+	return fwrite(data, 1, len, (FILE*)context) == len;
+}
+
+/*
+	Pass the uncompressed data of an entry to the sink in blocks and check the size and crc.
+	Returns 0 on failure.
+*/
+static int zip_copy_entry(fmu_check_zip_t* zip, fmu_check_zip_entry_t* e, zip_sink_ft sink, void* context) {
+	unsigned char local[ZIP_LOCAL_SIZE];
+	unsigned char in[ZIP_READ_BLOCK];
+	char out[ZIP_READ_BLOCK];
+	unsigned long long compLeft = e->compSize, done = 0;
+	unsigned long crc = crc32(0L, Z_NULL, 0);
+	z_stream zs;
+	int ok, inflating = 0, ret = Z_OK;
+	FILE* f;
+
+	if(e->encrypted || ((e->method != ZIP_STORED) && (e->method != ZIP_DEFLATED))) return 0;
+	if((e->method == ZIP_STORED) && (e->compSize != e->size)) return 0;
+	f = fopen(zip->fileName, "rb");
+	if(!f) return 0;
+	ok = zip_read_at(f, e->offset, local, ZIP_LOCAL_SIZE) && (get32(local) == ZIP_LOCAL_SIG)
+		&& (zip_seek(f, e->offset + ZIP_LOCAL_SIZE + get16(local + 26) + get16(local + 28)) == 0);
+	memset(&zs, 0, sizeof(zs));
+	if(ok && (e->method == ZIP_DEFLATED)) {
+		ok = inflating = (inflateInit2(&zs, -MAX_WBITS) == Z_OK);
+	}
+	while(ok && (ret != Z_STREAM_END)) {
+		size_t len;
+		if(e->method == ZIP_STORED) {
+			if(!compLeft) break;
+			len = (compLeft < ZIP_READ_BLOCK) ? (size_t)compLeft : ZIP_READ_BLOCK;
+			ok = (fread(out, 1, len, f) == len);
+			compLeft -= len;
+		}
+		else {
+			if((zs.avail_in == 0) && (compLeft > 0)) {
+				size_t inLen = (compLeft < ZIP_READ_BLOCK) ? (size_t)compLeft : ZIP_READ_BLOCK;
+				if(fread(in, 1, inLen, f) != inLen) {
+					ok = 0;
+					break;
+				}
+				compLeft -= inLen;
+				zs.next_in = in;
+				zs.avail_in = (uInt)inLen;
+			}
+			zs.next_out = (Bytef*)out;
+			zs.avail_out = ZIP_READ_BLOCK;
+			ret = inflate(&zs, Z_NO_FLUSH);
+			len = ZIP_READ_BLOCK - zs.avail_out;
+			/* no progress is only fine if more input is coming */
+			if((ret != Z_OK) && (ret != Z_STREAM_END) && !((ret == Z_BUF_ERROR) && (zs.avail_in == 0) && (compLeft > 0))) ok = 0;
+		}
+		if(ok && len) {
+			crc = crc32(crc, (const Bytef*)out, (uInt)len);
+			done += len;
+			ok = (done <= e->size) && sink(context, out, len);
+		}
+	}
+	if(inflating) inflateEnd(&zs);
+	fclose(f);
+	return ok && (done == e->size) && (crc == e->crc);
+}
+
+char* fmu_check_zip_read(fmu_check_zip_t* zip, size_t index, size_t* size) {
+	fmu_check_zip_entry_t* e = &zip->entries[index];
+	zip_memory_sink_t m;
+
+	if(e->size >= (size_t)-1) return 0;
+	m.size = (size_t)e->size;
+	m.used = 0;
+	m.data = (char*)zip->cb->malloc(m.size + 1);
+	if(!m.data) return 0;
+	if(!zip_copy_entry(zip, e, zip_memory_sink, &m)) {
+		zip->cb->free(m.data);
+		return 0;
+	}
+	m.data[m.size] = 0;
+	*size = m.size;
+	return m.data;
+}
+
+static void zip_mkdir(const char* path) {
+	/* failures (including existing folders) show up when the file is created */
+#if defined(_WIN32) || defined(WIN32)
+	_mkdir(path);
+#else
+	mkdir(path, 0777);
+#endif
+}
+
+/* Entry names must stay within the target folder */
+static int zip_safe_name(const char* name) {
+	const char* p = name;
+	if((*name == '/') || (*name == '\\') || strchr(name, ':')) return 0;
+	while(*p) {
+		if((p[0] == '.') && (p[1] == '.') && ((p[2] == '/') || (p[2] == '\\') || (p[2] == 0))) return 0;
+		while(*p && (*p != '/') && (*p != '\\')) p++;
+		while((*p == '/') || (*p == '\\')) p++;
+	}
+	return 1;
+}
+
+int fmu_check_zip_extract(fmu_check_zip_t* zip, size_t index, const char* dir) {
+	fmu_check_zip_entry_t* e = &zip->entries[index];
+	size_t dirLen = strlen(dir), nameLen = strlen(e->name), i;
+	char* path;
+	FILE* f;
+	int ok;
+
+	if(!zip_safe_name(e->name)) return 0;
+	path = (char*)zip->cb->malloc(dirLen + nameLen + 2);
+	if(!path) return 0;
+	memcpy(path, dir, dirLen);
+	path[dirLen] = FMI_FILE_SEP[0];
+	memcpy(path + dirLen + 1, e->name, nameLen + 1);
+
+	/* create the folders on the way */
+	for(i = dirLen + 1; path[i]; i++) {
+		if((path[i] == '/') || (path[i] == '\\')) {
+			path[i] = 0;
+			zip_mkdir(path);
+			path[i] = FMI_FILE_SEP[0];
+		}
+	}
+	if(nameLen && ((e->name[nameLen - 1] == '/') || (e->name[nameLen - 1] == '\\'))) {
+		/* folder entry */
+		zip->cb->free(path);
+		return 1;
+	}
+	f = fopen(path, "wb");
+	if(f) {
+		/* one buffer for the whole file up to a limit, small files are written at once */
+		size_t bufSize = (e->size < ZIP_MAX_WRITE_BUFFER) ? (size_t)e->size + 1 : ZIP_MAX_WRITE_BUFFER;
+		setvbuf(f, 0, _IOFBF, (bufSize < BUFSIZ) ? BUFSIZ : bufSize);
+	}
+	ok = (f != 0) && zip_copy_entry(zip, e, zip_file_sink, f);
+	if(f && fclose(f)) ok = 0;
+	if(f && !ok) remove(path);
+	zip->cb->free(path);
+	return ok;
+}
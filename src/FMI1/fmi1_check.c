@@ -23,6 +23,8 @@ void  fmi1_checker_logger(fmi1_component_t c, fmi1_string_t instanceName, fmi1_s
 	jm_log_level_enu_t logLevel;
 	char buf[100000], *curp = buf;
 	const char* statusStr;
+	fmu_check_log_filter_enu_t filterStatus;
+	fmu_check_log_key_t* filterKey;
 	va_list args;
 
 	assert(cdata);
@@ -61,6 +63,15 @@ void  fmi1_checker_logger(fmi1_component_t c, fmi1_string_t instanceName, fmi1_s
 	if(logLevel < jm_log_level_info)
 		cdata->num_fmu_messages++;
 
+	/* repeated messages are dropped before any formatting is done */
+	statusStr = fmi1_status_to_string(status);
+	filterStatus = fmu_check_log_filter_pass(&cdata->fmu_log_filter, category, (int)status, statusStr, message, &filterKey);
+	if(filterStatus >= fmu_check_log_suppress) {
+		if(filterStatus == fmu_check_log_report)
+			fmu_check_log_filter_report(&cdata->fmu_log_filter, filterKey);
+		return;
+	}
+
 	if(category && *category) {
 		sprintf(curp, "\t[FMU][%s]", category);
 	}
@@ -68,7 +79,6 @@ void  fmi1_checker_logger(fmi1_component_t c, fmi1_string_t instanceName, fmi1_s
 		sprintf(curp, "\t[FMU]");
 	}
 	curp += strlen(curp);
-	statusStr = fmi1_status_to_string(status);
 	sprintf(curp, "[FMU status:%s] ", statusStr);
 	curp += strlen(statusStr) + strlen("[FMU status:] ");
 	va_start (args, message);
@@ -76,6 +86,8 @@ void  fmi1_checker_logger(fmi1_component_t c, fmi1_string_t instanceName, fmi1_s
 	fmi1_import_expand_variable_references(fmu, buf, cb->errMessageBuffer,JM_MAX_ERROR_MESSAGE_SIZE);
 	va_end (args);
 	checker_logger(cb, fmu_checker_module, jm_log_level_nothing, cb->errMessageBuffer);
+	if(filterStatus == fmu_check_log_print_last)
+		fmu_check_log_filter_report(&cdata->fmu_log_filter, filterKey);
 }
 
 int fmi1_filter_outputs(fmi1_import_variable_t*vl, void * data) {
@@ -87,7 +99,9 @@ jm_status_enu_t fmi1_check(fmu_check_data_t* cdata) {
 	jm_callbacks* cb = &cdata->callbacks;
 	jm_status_enu_t status = jm_status_success;
 
+	fmu_check_phase_begin(cdata, fmu_check_phase_xml);
 	cdata->fmu1 = fmi1_import_parse_xml(cdata->context, cdata->tmpPath);
+	fmu_check_phase_end(cdata);
 
 	if(!cdata->fmu1) {
 		jm_log_fatal(cb,fmu_checker_module,"Error parsing XML, exiting");
@@ -180,7 +194,12 @@ jm_status_enu_t fmi1_check(fmu_check_data_t* cdata) {
 	}
 	if( (cdata->fmu1_kind == fmi1_fmu_kind_enu_me) && (cdata->do_test_me) ) {
 
-		status = fmi1_import_create_dllfmu(cdata->fmu1, callBackFunctions, 0);
+		fmu_check_phase_begin(cdata, fmu_check_phase_load);
+		status = fmu_check_unpack_wait(cdata, fmu_check_unpack_binaries);
+		if (status != jm_status_error) {
+			status = fmi1_import_create_dllfmu(cdata->fmu1, callBackFunctions, 0);
+		}
+		fmu_check_phase_end(cdata);
 
 		if (status == jm_status_error) {
 			jm_log_fatal(cb,fmu_checker_module,"Could not create the DLL loading mechanism(C-API).");
@@ -211,7 +230,12 @@ jm_status_enu_t fmi1_check(fmu_check_data_t* cdata) {
 		&& cdata->do_test_cs) {
 			jm_status_enu_t savedStatus = status;
 
-			status = fmi1_import_create_dllfmu(cdata->fmu1, callBackFunctions, 0);
+			fmu_check_phase_begin(cdata, fmu_check_phase_load);
+			status = fmu_check_unpack_wait(cdata, fmu_check_unpack_binaries);
+			if (status != jm_status_error) {
+				status = fmi1_import_create_dllfmu(cdata->fmu1, callBackFunctions, 0);
+			}
+			fmu_check_phase_end(cdata);
 
 			if (status == jm_status_error) {
 				jm_log_fatal(cb,fmu_checker_module,"Could not create the DLL loading mechanism(C-API) for CoSimulation.");
@@ -324,17 +348,8 @@ jm_status_enu_t fmi1_write_csv_data(fmu_check_data_t* cdata, double time) {
 	char fmt_true[20];
 	char fmt_false[20];
 
-	if(cdata->maxOutputPts > 0) {
-		if(time < cdata->nextOutputTime) {
-			return jm_status_success;
-		}
-		else {
-			cdata->nextOutputStep++;
-			cdata->nextOutputTime = cdata->stopTime*cdata->nextOutputStep/cdata->maxOutputPts;
-			if(cdata->nextOutputTime > cdata->stopTime) {
-				cdata->nextOutputTime = cdata->stopTime;
-			}
-		}
+	if(!check_output_time(cdata, time)) {
+		return jm_status_success;
 	}
 
 	fmt_sep[0] = cdata->CSV_separator; fmt_sep[1] = 0;
@@ -359,11 +374,13 @@ jm_status_enu_t fmi1_write_csv_data(fmu_check_data_t* cdata, double time) {
 	for(i = 0; i < n; i++) {
 		fmi1_import_variable_t* v = fmi1_import_get_variable(vl, i);
 		fmi1_value_reference_t vr = fmi1_import_get_variable_vr(v); 
+		fmu_check_watch(cdata, "fmiGetXXX (output)", time);
 		switch(fmi1_import_get_variable_base_type(v)) {
 		case fmi1_base_type_real:
 			{
 				double val;
 				fmistatus = fmi1_import_get_real(fmu,&vr, 1, &val);
+				fmu_check_watch_end(cdata);
 				if (cdata->do_output_all_vars || (fmi1_import_get_causality(v) == fmi1_causality_enu_output)){
 					if(fmi1_import_get_variable_alias_kind(v) == fmi1_variable_is_negated_alias)
 						val = -val;
@@ -375,6 +392,7 @@ jm_status_enu_t fmi1_write_csv_data(fmu_check_data_t* cdata, double time) {
 			{
 				int val;
 				fmistatus = fmi1_import_get_integer(fmu,&vr, 1, &val);
+				fmu_check_watch_end(cdata);
 				if (cdata->do_output_all_vars || (fmi1_import_get_causality(v) == fmi1_causality_enu_output)){
 					if(fmi1_import_get_variable_alias_kind(v) == fmi1_variable_is_negated_alias)
 						val = -val;
@@ -387,6 +405,7 @@ jm_status_enu_t fmi1_write_csv_data(fmu_check_data_t* cdata, double time) {
 				fmi1_boolean_t val;
 				char* fmt;
 				fmistatus = fmi1_import_get_boolean(fmu,&vr, 1, &val);
+				fmu_check_watch_end(cdata);
 				if (cdata->do_output_all_vars || (fmi1_import_get_causality(v) == fmi1_causality_enu_output)){
 					if(fmi1_import_get_variable_alias_kind(v) == fmi1_variable_is_negated_alias)
 						fmt = (val == fmi1_false) ? fmt_true:fmt_false;
@@ -402,6 +421,7 @@ jm_status_enu_t fmi1_write_csv_data(fmu_check_data_t* cdata, double time) {
 				fmi1_string_t val = "test ##";
 
 				fmistatus = fmi1_import_get_string(fmu,&vr, 1, &val);
+				fmu_check_watch_end(cdata);
 				if (cdata->do_output_all_vars || (fmi1_import_get_causality(v) == fmi1_causality_enu_output)){
 					checked_fprintf(cdata, fmt_sep);
 					outstatus = checked_print_quoted_str(cdata, val);
@@ -418,6 +438,7 @@ jm_status_enu_t fmi1_write_csv_data(fmu_check_data_t* cdata, double time) {
 				if(t) et = fmi1_import_get_type_as_enum(t);
 
 				fmistatus = fmi1_import_get_integer(fmu,&vr, 1, &val);
+				fmu_check_watch_end(cdata);
 				if(et) itname = fmi1_import_get_enum_type_item_name(et, val);
 				if(!itname) {
 					jm_log_error(cb, fmu_checker_module, "Could not get item name for enum variable %s", fmi1_import_get_variable_name(v));
@@ -47,19 +47,28 @@ jm_status_enu_t fmi1_cs_simulate(fmu_check_data_t* cdata)
 
     prepare_time_step_info(cdata, &tend, &hstep);
 
+	fmu_check_phase_begin(cdata, fmu_check_phase_instantiate);
+	if(fmu_check_unpack_wait(cdata, fmu_check_unpack_resources) != jm_status_success) {
+		return jm_status_error;
+	}
 	cdata->instanceNameToCompare = "Test FMI 1.0 CS";
 	cdata->instanceNameSavedPtr = 0;
+	fmu_check_watch(cdata, "fmiInstantiateSlave", tstart);
 	jmstatus = fmi1_import_instantiate_slave(fmu, cdata->instanceNameToCompare, 0, mimeType, timeout, visible, interactive);
+	fmu_check_watch_end(cdata);
 	cdata->instanceNameSavedPtr = cdata->instanceNameToCompare;
 	if (jmstatus == jm_status_error) {
 		jm_log_fatal(cb, fmu_checker_module, "Could not instantiate the model");
 		return jm_status_error;
 	}
 
+    fmu_check_phase_begin(cdata, fmu_check_phase_initialize);
+    fmu_check_watch(cdata, "fmiInitializeSlave", tstart);
     if (fmi1_status_ok_or_warning(fmistatus = check_fmi1_set_with_zero_len_array(fmu, cb)) &&
         fmi1_status_ok_or_warning(fmistatus = fmi1_set_inputs(cdata, tstart)) &&
         fmi1_status_ok_or_warning(fmistatus = fmi1_import_initialize_slave(fmu, tstart, StopTimeDefined, tend)))
     {
+        fmu_check_watch_end(cdata);
         jm_log_info(cb, fmu_checker_module, "Initialized FMU for simulation starting at time %g", tstart);
         if (fmi1_status_ok_or_warning(fmistatus = check_fmi1_get_with_zero_len_array(fmu, cb))) {
             fmistatus = fmi1_status_ok;
@@ -68,10 +77,12 @@ jm_status_enu_t fmi1_cs_simulate(fmu_check_data_t* cdata)
         }
     }
     else {
+        fmu_check_watch_end(cdata);
         jm_log_fatal(cb, fmu_checker_module, "Failed to initialize FMU for simulation (FMU status: %s)", fmi1_status_to_string(fmistatus));
         jmstatus = jm_status_error;
     }
 
+	fmu_check_phase_begin(cdata, fmu_check_phase_simulate);
 	if(jmstatus != jm_status_error) {
 		jm_log_verbose(cb, fmu_checker_module, "Writing simulation output for start time");
 		if(fmi1_write_csv_data(cdata, tstart) != jm_status_success){
@@ -87,11 +98,14 @@ jm_status_enu_t fmi1_cs_simulate(fmu_check_data_t* cdata)
 		}
 
 		jm_log_verbose(cb, fmu_checker_module, "Simulation step from time: %g until: %g", tcur, tnext);
+        fmu_check_watch(cdata, "fmiSetReal (inputs)", tcur);
         if(!fmi1_status_ok_or_warning(fmistatus = fmi1_set_inputs(cdata, tcur))) {
             jmstatus = jm_status_error;
             break;
         }
+		fmu_check_watch(cdata, "fmiDoStep", tcur);
 		fmistatus = fmi1_import_do_step(fmu, tcur, hstep, newStep);
+		fmu_check_watch_end(cdata);
 
 		tcur = tnext;
 
@@ -114,13 +128,17 @@ jm_status_enu_t fmi1_cs_simulate(fmu_check_data_t* cdata)
  		 jm_log_info(cb, fmu_checker_module, "Simulation finished successfully at time %g", tcur);
 	}
 
+	fmu_check_phase_begin(cdata, fmu_check_phase_terminate);
+	fmu_check_watch(cdata, "fmiTerminateSlave", tcur);
 	fmistatus = fmi1_import_terminate_slave(fmu);
+	fmu_check_watch_end(cdata);
 
 	if(  fmistatus != fmi1_status_ok) {
 		 jm_log_error(cb, fmu_checker_module, "fmiTerminateSlave returned status: %s", fmi1_status_to_string(fmistatus));
 	}
 
 	fmi1_import_free_slave_instance(fmu);
+	fmu_check_phase_end(cdata);
 
 	return jmstatus;
 }
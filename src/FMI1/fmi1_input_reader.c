@@ -58,40 +58,24 @@ jm_status_enu_t fmi1_init_input_data(fmi1_csv_input_t* indata, jm_callbacks* cb,
 }
 
 void fmi1_free_input_data(fmi1_csv_input_t* indata) {
-    size_t i;
     if(!indata || !indata->fmu) return;
     jm_vector_free_data(double)(&indata->timeStamps);
 
     fmi1_import_free_variable_list(indata->allInputs);
     indata->allInputs = 0;
     if(indata->boolInputData) {
-        for(i=0; i < jm_vector_get_size(jm_voidp)(indata->boolInputData); i++) {
-            void** data = jm_vector_get_itemp(jm_voidp)(indata->boolInputData, i);
-            free(*data);
-            *data = 0;
-        }
         jm_vector_free(jm_voidp)(indata->boolInputData);
         indata->boolInputData = 0;
     }
     fmi1_import_free_variable_list(indata->boolInputs);
     indata->boolInputs = 0;
     if(indata->intInputData) {
-        for(i=0; i < jm_vector_get_size(jm_voidp)(indata->intInputData); i++) {
-            void** data = jm_vector_get_itemp(jm_voidp)(indata->intInputData, i);
-            free(*data);
-            *data = 0;
-        }
         jm_vector_free(jm_voidp)(indata->intInputData);
         indata->intInputData = 0;
     }
     fmi1_import_free_variable_list(indata->intInputs);
     indata->intInputs = 0;
     if(indata->realInputData) {
-        for(i=0; i < jm_vector_get_size(jm_voidp)(indata->realInputData); i++) {
-            void** data = jm_vector_get_itemp(jm_voidp)(indata->realInputData, i);
-            free(*data);
-            *data = 0;
-        }
         jm_vector_free(jm_voidp)(indata->realInputData);
         indata->realInputData = 0;
     }
@@ -99,9 +83,8 @@ void fmi1_free_input_data(fmi1_csv_input_t* indata) {
     indata->realInputs = 0;
     fmi1_import_free_variable_list(indata->continuousInputs);
     indata->continuousInputs = 0;
-    free(indata->interpData);
+    /* data rows and interpolation buffers are owned by the checker arena */
     indata->interpData = 0;
-    free(indata->interpContinuousData);
     indata->interpContinuousData = 0;
 }
 
@@ -218,6 +201,84 @@ fmi1_status_t fmi1_set_inputs(fmu_check_data_t* cdata, double time) {
     return fmiStatus;
 }
 
+/* Context of fmi1_parse_input_chunk_row() */
+typedef struct fmi1_input_row_context_t {
+    char sep;
+    fmi1_import_variable_list_t* allInputs;
+} fmi1_input_row_context_t;
+
+/* Row parser for fmu_check_parse_input_chunks(), negated aliases get the negated values */
+static int fmi1_parse_input_chunk_row(void* context, FILE* infile, double* time, void* parts[FMU_CHECK_INPUT_NUM_PARTS], size_t* badVar) {
+    fmi1_input_row_context_t* ctx = (fmi1_input_row_context_t*)context;
+    fmi1_real_t* realData = (fmi1_real_t*)parts[0];
+    fmi1_integer_t* intData = (fmi1_integer_t*)parts[1];
+    fmi1_boolean_t* boolData = (fmi1_boolean_t*)parts[2];
+    size_t varCnt, realVarCnt, intVarCnt, boolVarCnt;
+    int ret = 1;
+    int buf;
+
+    /* first column is time */
+    if(fscanf(infile,"%lg",time) != 1) return 0;
+
+    for(varCnt = realVarCnt = intVarCnt = boolVarCnt = 0;
+        varCnt < fmi1_import_get_variable_list_size(ctx->allInputs);
+        varCnt++) {
+        fmi1_import_variable_t* v = fmi1_import_get_variable(ctx->allInputs, varCnt);
+        fmi1_base_type_enu_t type = fmi1_import_get_variable_base_type(v);
+        int negated = (fmi1_import_get_variable_alias_kind(v) == fmi1_variable_is_negated_alias);
+        int err = 0;
+        if(fgetc(infile) != ctx->sep) {
+            *badVar = varCnt;
+            ret = -2;
+            break;
+        }
+        switch(type) {
+        case fmi1_base_type_real:
+            {
+                double dbl;
+                err = (fscanf(infile,"%lg",&dbl) != 1);
+                if(negated) dbl = -dbl;
+                realData[realVarCnt++] = dbl;
+                break;
+            }
+
+        case fmi1_base_type_int:
+        case fmi1_base_type_enum:
+            {
+                int intbuf;
+                err = (fscanf(infile,"%d",&intbuf) != 1);
+                if(negated) intbuf = -intbuf;
+                intData[intVarCnt++] = intbuf;
+                break;
+            }
+        case fmi1_base_type_bool:
+            {
+                int intbuf;
+                err = (fscanf(infile,"%d",&intbuf) != 1) || (intbuf != 0) && (intbuf != 1);
+                if(negated) intbuf = intbuf ^ 1;
+                boolData[boolVarCnt++] = intbuf;
+                break;
+            }
+        default:
+            err = 1;
+            break;
+        }
+        if(err) {
+            *badVar = varCnt;
+            return -1;
+        }
+    }
+    /* skip the end of line, the new line itself is left for the chunk parser to see where the next line starts */
+    buf = fgetc(infile);
+    if(buf == '\r') {
+        buf = fgetc(infile);
+    }
+    if(buf == '\n') {
+        ungetc(buf, infile);
+    }
+    return ret;
+}
+
 jm_status_enu_t fmi1_read_input_file(fmu_check_data_t* cdata) {
     FILE* infile;
     fmi1_csv_input_t* indata = &cdata->fmu1_inputData;
@@ -228,7 +289,6 @@ jm_status_enu_t fmi1_read_input_file(fmu_check_data_t* cdata) {
     char namebuffer[NAMEBUFSIZE+1];
     size_t namelen = 0;
     int quotedFlg = 0;
-    size_t lineCnt = 0, varCnt = 0;
     const char* fname = cdata->inputFileName;
 
     if(!fname) return jm_status_success;
@@ -365,8 +425,8 @@ jm_status_enu_t fmi1_read_input_file(fmu_check_data_t* cdata) {
         if(buf != '\n') buf = fgetc(infile);
     }
     if(
-        !(indata->interpData = (fmi1_real_t*)malloc(sizeof(fmi1_real_t) * fmi1_import_get_variable_list_size(indata->realInputs))) ||
-        !(indata->interpContinuousData = (fmi1_real_t*)malloc(sizeof(fmi1_real_t) * fmi1_import_get_variable_list_size(indata->continuousInputs))) ||
+        !(indata->interpData = (fmi1_real_t*)fmu_check_arena_alloc(&cdata->arena, sizeof(fmi1_real_t) * fmi1_import_get_variable_list_size(indata->realInputs))) ||
+        !(indata->interpContinuousData = (fmi1_real_t*)fmu_check_arena_alloc(&cdata->arena, sizeof(fmi1_real_t) * fmi1_import_get_variable_list_size(indata->continuousInputs))) ||
         (fmi1_import_get_variable_list_size(indata->allInputs) !=
         fmi1_import_get_variable_list_size(indata->realInputs)+
         fmi1_import_get_variable_list_size(indata->intInputs)+
@@ -377,100 +437,39 @@ jm_status_enu_t fmi1_read_input_file(fmu_check_data_t* cdata) {
     }
 
     /* read input data */
-    lineCnt = 0, varCnt = 0;
-    while(!feof(infile)) {
-        size_t realVarCnt, intVarCnt, boolVarCnt;
-        int memErr = 0;
-        fmi1_real_t* realData = 0;
-        fmi1_integer_t* intData = 0;
-        fmi1_boolean_t* boolData = 0;
-        double time;
-        lineCnt++;
-        /* first column is time */
-        if(fscanf(infile,"%lg",&time) != 1) break;
-        /* allocate memory for the data and store pointers */
-        memErr |= (jm_vector_push_back(double)(&indata->timeStamps, time) == 0);
-        memErr |= (jm_vector_push_back(jm_voidp)(indata->realInputData,realData) == 0);
-        memErr |= (jm_vector_push_back(jm_voidp)(indata->intInputData,intData) == 0);
-        memErr |= (jm_vector_push_back(jm_voidp)(indata->boolInputData,boolData) == 0);
-        if(!memErr) {
-            realData = (fmi1_real_t*)malloc(sizeof(fmi1_real_t) * fmi1_import_get_variable_list_size(indata->realInputs));
-            intData = (fmi1_integer_t*)malloc(sizeof(fmi1_integer_t) * fmi1_import_get_variable_list_size(indata->intInputs));
-            boolData = (fmi1_boolean_t*)malloc(sizeof(fmi1_boolean_t) * fmi1_import_get_variable_list_size(indata->boolInputs));
-        }
-        if(    (realData == 0)
-            || (intData == 0)
-            || (boolData == 0)
-            || memErr) {
-            free(realData);
-            free(intData);
-            free(boolData);
-            fclose(infile);
-            jm_log_error(&cdata->callbacks, fmu_checker_module, "Out of memory while reading input file line %d", lineCnt);
-            return jm_status_error;
-        }
-        *(fmi1_real_t**)jm_vector_get_lastp(jm_voidp)(indata->realInputData) = realData;
-        *(fmi1_integer_t**)jm_vector_get_lastp(jm_voidp)(indata->intInputData) = intData;
-        *(fmi1_boolean_t**)jm_vector_get_lastp(jm_voidp)(indata->boolInputData) = boolData;
-
-        for(varCnt = realVarCnt = intVarCnt = boolVarCnt = 0;
-            varCnt < fmi1_import_get_variable_list_size(indata->allInputs);
-            varCnt++) {
-            fmi1_import_variable_t* v = fmi1_import_get_variable(indata->allInputs, varCnt);
-            fmi1_base_type_enu_t type = fmi1_import_get_variable_base_type(v);
-            int negated = (fmi1_import_get_variable_alias_kind(v) == fmi1_variable_is_negated_alias);
-            int err = 0;
-            if(fgetc(infile) != sep) {
-                jm_log_error(&cdata->callbacks, fmu_checker_module, "Expected separator character, got '%c'[%x] instead. Parsing line %i", sep,sep,lineCnt);
-                break;
-            }
-            switch(type) {
-            case fmi1_base_type_real:
-                {
-                    double dbl;
-                    err = (fscanf(infile,"%lg",&dbl) != 1);
-                    if(negated) dbl = -dbl;
-                    realData[realVarCnt++] = dbl;
-                    break;
-                }
+    {
+        long dataOffset = ftell(infile);
+        size_t partSize[FMU_CHECK_INPUT_NUM_PARTS];
+        fmu_check_input_rows_t rows;
+        fmi1_input_row_context_t context;
+        size_t i;
 
-            case fmi1_base_type_int:
-            case fmi1_base_type_enum:
-                {
-                    int intbuf;
-                    err = (fscanf(infile,"%d",&intbuf) != 1);
-                    if(negated) intbuf = -intbuf;
-                    intData[intVarCnt++] = intbuf;
-                    break;
-                }
-            case fmi1_base_type_bool:
-                {
-                    int intbuf;
-                    err = (fscanf(infile,"%d",&intbuf) != 1) || (intbuf != 0) && (intbuf != 1);
-                    if(negated) intbuf = intbuf ^ 1;
-                    boolData[boolVarCnt++] = intbuf;
-                    break;
-                }
-            default:
-                err = 1;
-                break;
-            }
-            if(err) {
-                fclose(infile);
+        fclose(infile);
+        partSize[0] = sizeof(fmi1_real_t) * fmi1_import_get_variable_list_size(indata->realInputs);
+        partSize[1] = sizeof(fmi1_integer_t) * fmi1_import_get_variable_list_size(indata->intInputs);
+        partSize[2] = sizeof(fmi1_boolean_t) * fmi1_import_get_variable_list_size(indata->boolInputs);
+        context.sep = sep;
+        context.allInputs = indata->allInputs;
+        if(fmu_check_parse_input_chunks(cdata, fname, dataOffset, sep, partSize, fmi1_parse_input_chunk_row, &context,
+                                        &indata->timeStamps, &rows) != jm_status_success) {
+            if(rows.badLine) {
                 jm_log_error(indata->cb, fmu_checker_module, "Error parsing input file data [line %d, time '%g', variable '%s']",
-                    lineCnt+1, time, fmi1_import_get_variable_name(v));
-                return jm_status_error;
+                    (int)rows.badLine, rows.badTime, fmi1_import_get_variable_name(fmi1_import_get_variable(indata->allInputs, rows.badVar)));
             }
+            return jm_status_error;
         }
-        buf = fgetc(infile);
-        if(buf == '\r') {
-            buf = fgetc(infile);
+        /* store the data pointers */
+        if(    (jm_vector_resize(jm_voidp)(indata->realInputData, rows.numRows) != rows.numRows)
+            || (jm_vector_resize(jm_voidp)(indata->intInputData, rows.numRows) != rows.numRows)
+            || (jm_vector_resize(jm_voidp)(indata->boolInputData, rows.numRows) != rows.numRows)) {
+            jm_log_error(&cdata->callbacks, fmu_checker_module, "Out of memory while reading input file %s", fname);
+            return jm_status_error;
+        }
+        for(i = 0; i < rows.numRows; i++) {
+            *jm_vector_get_itemp(jm_voidp)(indata->realInputData, i) = rows.parts[0] + i * partSize[0];
+            *jm_vector_get_itemp(jm_voidp)(indata->intInputData, i) = rows.parts[1] + i * partSize[1];
+            *jm_vector_get_itemp(jm_voidp)(indata->boolInputData, i) = rows.parts[2] + i * partSize[2];
         }
-    }
-    if(!feof(infile) || ferror(infile)) {
-        fclose(infile);
-        jm_log_error(&cdata->callbacks, fmu_checker_module, "Could not process input file past line %d.", lineCnt+1);
-        return jm_status_error;
     }
     if(jm_vector_get_size(double)(&indata->timeStamps)) {
         fmi1_update_input_interpolation(indata, jm_vector_get_item(double)(&indata->timeStamps,0)-1);
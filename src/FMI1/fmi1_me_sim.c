@@ -40,43 +40,33 @@ jm_status_enu_t fmi1_me_simulate(fmu_check_data_t* cdata)
     n_states = fmi1_import_get_number_of_continuous_states(fmu);
 	n_event_indicators = fmi1_import_get_number_of_event_indicators(fmu);
 
-	if(n_states) {
-		states = cb->calloc(n_states, sizeof(double));
-		states_der = cb->calloc(n_states, sizeof(double));
-		if(!states || !states_der) {
-			cb->free(states);
-			cb->free(states_der);
-			jm_log_fatal(cb, fmu_checker_module, "Could not allocated memory");
-			return jm_status_error;
-		}
+	/* the buffers are owned by the arena and released with the checker data */
+	states = fmu_check_arena_calloc(&cdata->arena, n_states, sizeof(double));
+	states_der = fmu_check_arena_calloc(&cdata->arena, n_states, sizeof(double));
+	event_indicators = fmu_check_arena_calloc(&cdata->arena, n_event_indicators, sizeof(double));
+	event_indicators_prev = fmu_check_arena_calloc(&cdata->arena, n_event_indicators, sizeof(double));
+	if(!states || !states_der || !event_indicators || !event_indicators_prev) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not allocated memory");
+		return jm_status_error;
 	}
-	if(n_event_indicators) {
-		event_indicators = cb->calloc(n_event_indicators, sizeof(double));
-		event_indicators_prev = cb->calloc(n_event_indicators, sizeof(double));
 
-		if( !event_indicators || !event_indicators_prev) {
-			cb->free(states);
-			cb->free(states_der);
-			cb->free(event_indicators);
-			cb->free(event_indicators_prev);
-			jm_log_fatal(cb, fmu_checker_module, "Could not allocated memory");
-			return jm_status_error;
-		}
+	fmu_check_phase_begin(cdata, fmu_check_phase_instantiate);
+	if(fmu_check_unpack_wait(cdata, fmu_check_unpack_resources) != jm_status_success) {
+		return jm_status_error;
 	}
-
 	cdata->instanceNameToCompare = "Test FMI 1.0 ME";
 	cdata->instanceNameSavedPtr = 0;
+	fmu_check_watch(cdata, "fmiInstantiateModel", tstart);
 	jmstatus = fmi1_import_instantiate_model(fmu, cdata->instanceNameToCompare);
+	fmu_check_watch_end(cdata);
 	cdata->instanceNameSavedPtr = cdata->instanceNameToCompare;
 	if (jmstatus == jm_status_error) {
 		jm_log_fatal(cb, fmu_checker_module, "Could not instantiate the model");
-		cb->free(states);
-		cb->free(states_der);
-		cb->free(event_indicators);
-		cb->free(event_indicators_prev);
 		return jm_status_error;
 	}
 
+    fmu_check_phase_begin(cdata, fmu_check_phase_initialize);
+    fmu_check_watch(cdata, "fmiInitialize", tstart);
     if (fmi1_status_ok_or_warning(fmistatus = check_fmi1_set_with_zero_len_array(fmu, cb)) &&
         fmi1_status_ok_or_warning(fmistatus = fmi1_import_set_time(fmu, tstart)) &&
         fmi1_status_ok_or_warning(fmistatus = fmi1_set_inputs(cdata, tstart)) &&
@@ -84,6 +74,7 @@ jm_status_enu_t fmi1_me_simulate(fmu_check_data_t* cdata)
         fmi1_status_ok_or_warning(fmistatus = fmi1_import_get_continuous_states(fmu, states, n_states)) &&
         fmi1_status_ok_or_warning(fmistatus = fmi1_import_get_event_indicators(fmu, event_indicators_prev, n_event_indicators)))
     {
+        fmu_check_watch_end(cdata);
         jm_log_info(cb, fmu_checker_module, "Initialized FMU for simulation starting at time %g", tstart);
         if (fmi1_status_ok_or_warning(fmistatus = check_fmi1_get_with_zero_len_array(fmu, cb))) {
             fmistatus = fmi1_status_ok;
@@ -92,10 +83,12 @@ jm_status_enu_t fmi1_me_simulate(fmu_check_data_t* cdata)
         }
     }
 	else {
+        fmu_check_watch_end(cdata);
         jm_log_fatal(cb, fmu_checker_module, "Failed to initialize FMU for simulation (FMU status: %s)", fmi1_status_to_string(fmistatus));
         jmstatus = jm_status_error;
     }
 
+	fmu_check_phase_begin(cdata, fmu_check_phase_simulate);
 	tcur = tstart;
 	if((jmstatus != jm_status_error) && (fmi1_write_csv_data(cdata, tstart) != jm_status_success)) {
 		jmstatus = jm_status_error;
@@ -107,10 +100,12 @@ jm_status_enu_t fmi1_me_simulate(fmu_check_data_t* cdata)
 		int external_time_event = 0;
 
 		/* Get derivatives */
+		fmu_check_watch(cdata, "fmiGetDerivatives", tcur);
 		if(!fmi1_status_ok_or_warning(fmistatus = fmi1_import_get_derivatives(fmu, states_der, n_states))) {
 			jm_log_fatal(cb, fmu_checker_module, "Could not retrieve time derivatives");
 			break;
 		}
+		fmu_check_watch_end(cdata);
 
 		tnext = tcur + hdef;
 		/* adjust next time step to be within simulation time */
@@ -146,14 +141,18 @@ jm_status_enu_t fmi1_me_simulate(fmu_check_data_t* cdata)
 		tcur = tnext;
 
 		jm_log_verbose(cb, fmu_checker_module, "Simulation time: %g", tcur);
+		fmu_check_watch(cdata, "fmiSetTime", tcur);
 		if(    !fmi1_status_ok_or_warning(fmistatus = fmi1_import_set_time(fmu, tcur))) {
 			jm_log_fatal(cb, fmu_checker_module, "Could not set simulation time to %g", tcur);
 			break;
 		}
+		fmu_check_watch_end(cdata);
+		fmu_check_watch(cdata, "fmiSetReal (inputs)", tcur);
 		if (!fmi1_status_ok_or_warning(fmistatus = fmi1_set_continuous_inputs(cdata, tcur))) {
 			jm_log_fatal(cb, fmu_checker_module, "Could not set inputs");
 			break;
 		}
+		fmu_check_watch_end(cdata);
 
 		/* integrate */
 		for (k = 0; k < n_states; k++) {
@@ -161,25 +160,31 @@ jm_status_enu_t fmi1_me_simulate(fmu_check_data_t* cdata)
 		}
 
         /* Set states */
+        fmu_check_watch(cdata, "fmiSetContinuousStates", tcur);
         if (!fmi1_status_ok_or_warning(fmistatus = fmi1_import_set_continuous_states(fmu, states, n_states))) {
             jm_log_fatal(cb, fmu_checker_module, "Could not set continuous states");
             break;
         }
+        fmu_check_watch_end(cdata);
 
 		callEventUpdate = fmi1_false;
 		/* Step is completed */
+		fmu_check_watch(cdata, "fmiCompletedIntegratorStep", tcur);
 		if (!fmi1_status_ok_or_warning(fmistatus = fmi1_import_completed_integrator_step(fmu, &callEventUpdate))){
 			jm_log_fatal(cb, fmu_checker_module, "Could not complete integrator step");
 			break;
 		}
+		fmu_check_watch_end(cdata);
 
         /* Check if an event indicator has triggered */
+        fmu_check_watch(cdata, "fmiGetEventIndicators", tcur);
         if (!fmi1_status_ok_or_warning(fmistatus = 
                 fmi1_import_get_event_indicators(fmu, event_indicators, n_event_indicators)))
         {
             jm_log_fatal(cb, fmu_checker_module, "Could not get event indicators");
             break;
         }
+        fmu_check_watch_end(cdata);
 
 		for (k = 0; k < n_event_indicators; k++) {
 			if (event_indicators[k]*event_indicators_prev[k] < 0) {
@@ -208,16 +213,20 @@ jm_status_enu_t fmi1_me_simulate(fmu_check_data_t* cdata)
 			if (external_time_event) {
 				/* Update the discrete inputs to their new values. The rest of
 				 * the inputs are also updated. */
+				fmu_check_watch(cdata, "fmiSetReal (inputs)", tcur);
 				if (!fmi1_status_ok_or_warning(fmistatus = fmi1_set_inputs(cdata, tcur))) {
 					jm_log_fatal(cb, fmu_checker_module, "Could not set inputs");
 					break;
 				}
+				fmu_check_watch_end(cdata);
 			}
 			eventInfo.iterationConverged = fmi1_false;
+			fmu_check_watch(cdata, "fmiEventUpdate", tcur);
 			if (!fmi1_status_ok_or_warning(fmistatus = fmi1_import_eventUpdate(fmu, intermediateResults, &eventInfo))) {
 				jm_log_fatal(cb, fmu_checker_module, "Event update call failed");
 				break;
 			}
+			fmu_check_watch_end(cdata);
 
 			/* Entering the eventPending state.
 			 * Since intermediateResults is set to fmi1_false we do not need to
@@ -230,13 +239,17 @@ jm_status_enu_t fmi1_me_simulate(fmu_check_data_t* cdata)
 				break;
 			}
 			/* Update continuous states */
+			fmu_check_watch(cdata, "fmiGetContinuousStates", tcur);
 			fmistatus = fmi1_import_get_continuous_states(fmu, states, n_states);
+			fmu_check_watch_end(cdata);
 			if (eventInfo.stateValuesChanged && !fmi1_status_ok_or_warning(fmistatus)) {
 				jm_log_fatal(cb, fmu_checker_module, "Could not get continuous states");
 				break;
 			}
 			/* Get event indicators */
+			fmu_check_watch(cdata, "fmiGetEventIndicators", tcur);
 			fmistatus = fmi1_import_get_event_indicators(fmu, event_indicators_prev, n_event_indicators);
+			fmu_check_watch_end(cdata);
 			if (!fmi1_status_ok_or_warning(fmistatus)) {
 				jm_log_fatal(cb, fmu_checker_module, "Could not get event indicators");
 				break;
@@ -253,6 +266,7 @@ jm_status_enu_t fmi1_me_simulate(fmu_check_data_t* cdata)
 			break;
 		}
 	} /* while */
+	fmu_check_watch_end(cdata);
 
 	if(!fmi1_status_ok_or_warning(fmistatus)) {
 		jm_log_fatal(cb, fmu_checker_module, "Simulation loop terminated at time %g since FMU returned status: %s", tcur, fmi1_status_to_string(fmistatus));
@@ -262,16 +276,16 @@ jm_status_enu_t fmi1_me_simulate(fmu_check_data_t* cdata)
 		jm_log_info(cb, fmu_checker_module, "Simulation finished successfully at time %g", tcur);
 	}
 
-	if(  (fmistatus = fmi1_import_terminate(fmu)) != fmi1_status_ok) {
+	fmu_check_phase_begin(cdata, fmu_check_phase_terminate);
+	fmu_check_watch(cdata, "fmiTerminate", tcur);
+	fmistatus = fmi1_import_terminate(fmu);
+	fmu_check_watch_end(cdata);
+	if(fmistatus != fmi1_status_ok) {
 		 jm_log_error(cb, fmu_checker_module, "fmiTerminate returned status: %s", fmi1_status_to_string(fmistatus));
 	}
 
 	fmi1_import_free_model_instance(fmu);
-
-	cb->free(states);
-	cb->free(states_der);
-	cb->free(event_indicators);
-	cb->free(event_indicators_prev);
+	fmu_check_phase_end(cdata);
 
 	return 	jmstatus;
 }
@@ -17,12 +17,14 @@
 
 void  fmi2_checker_logger(fmi2_component_environment_t c, fmi2_string_t instanceName, fmi2_status_t status, fmi2_string_t category, fmi2_string_t message, ...){
 
-	fmu_check_data_t* cdata = cdata_global_ptr;
+	fmu_check_data_t* cdata = fmu_check_get_instance_data(c);
 	fmi2_import_t* fmu = cdata->fmu2;
 	jm_callbacks* cb = &cdata->callbacks;
 	jm_log_level_enu_t logLevel;
 	char buf[10000], *curp = buf;
 	const char* statusStr;
+	fmu_check_log_filter_enu_t filterStatus;
+	fmu_check_log_key_t* filterKey;
     va_list args;
 
 	assert(cdata);
@@ -65,6 +67,15 @@ void  fmi2_checker_logger(fmi2_component_environment_t c, fmi2_string_t instance
 	if(logLevel < jm_log_level_info)
 		cdata->num_fmu_messages++;
 
+	/* repeated messages are dropped before any formatting is done */
+	statusStr = fmi2_status_to_string(status);
+	filterStatus = fmu_check_log_filter_pass(&cdata->fmu_log_filter, category, (int)status, statusStr, message, &filterKey);
+	if(filterStatus >= fmu_check_log_suppress) {
+		if(filterStatus == fmu_check_log_report)
+			fmu_check_log_filter_report(&cdata->fmu_log_filter, filterKey);
+		return;
+	}
+
 	if(category && *category) {
         sprintf(curp, "\t[FMU][%s]", category);
     }
@@ -72,7 +83,6 @@ void  fmi2_checker_logger(fmi2_component_environment_t c, fmi2_string_t instance
         sprintf(curp, "\t[FMU]");
 	}
     curp += strlen(curp);
-	statusStr = fmi2_status_to_string(status);
     sprintf(curp, "[FMU status:%s] ", statusStr);
     curp += strlen(statusStr) + strlen("[FMU status:] ");
     va_start (args, message);
@@ -80,6 +90,8 @@ void  fmi2_checker_logger(fmi2_component_environment_t c, fmi2_string_t instance
 	fmi2_import_expand_variable_references(fmu, buf, cb->errMessageBuffer,JM_MAX_ERROR_MESSAGE_SIZE);
     va_end (args);
 	checker_logger(cb, fmu_checker_module, jm_log_level_nothing, cb->errMessageBuffer);
+	if(filterStatus == fmu_check_log_print_last)
+		fmu_check_log_filter_report(&cdata->fmu_log_filter, filterKey);
 }
 
 int annotation_start_handle(void *context, const char *parentName, void *parent, const char *elm, const char **attr) {
@@ -107,12 +119,12 @@ int fmi2_filter_outputs(fmi2_import_variable_t*vl, void * data) {
 }
 
 
-jm_status_enu_t fmi2_check(fmu_check_data_t* cdata) {
-	fmi2_callback_functions_t callBackFunctions;
+jm_status_enu_t fmi2_check_parse_xml(fmu_check_data_t* cdata) {
 	jm_callbacks* cb = &cdata->callbacks;
-	jm_status_enu_t status = jm_status_success;
 
+	fmu_check_phase_begin(cdata, fmu_check_phase_xml);
 	cdata->fmu2 = fmi2_import_parse_xml(cdata->context, cdata->tmpPath, 0);
+	fmu_check_phase_end(cdata);
 
 	if(!cdata->fmu2) {
 		jm_log_fatal(cb,fmu_checker_module,"Error parsing XML, exiting");
@@ -136,6 +148,9 @@ jm_status_enu_t fmi2_check(fmu_check_data_t* cdata) {
 		jm_log_fatal(cb, fmu_checker_module,"Could not construct model variables list");
 		return jm_status_error;
 	}
+	if(fmi2_build_column_plan(cdata) != jm_status_success) {
+		return jm_status_error;
+	}
 
 	if(cb->log_level >= jm_log_level_info) {
 		fmi2_import_model_counts_t counts;
@@ -179,11 +194,235 @@ jm_status_enu_t fmi2_check(fmu_check_data_t* cdata) {
 		}
 
 	}
+	return jm_status_success;
+}
+
+jm_status_enu_t fmi2_check_load_dll(fmu_check_data_t* cdata, fmi2_fmu_kind_enu_t kind) {
+	fmi2_callback_functions_t callBackFunctions;
+	jm_callbacks* cb = &cdata->callbacks;
+	const char* kindStr = (kind == fmi2_fmu_kind_me) ? "ME" : "CS";
+	const char* platform;
+
+	callBackFunctions.allocateMemory = check_calloc;
+	callBackFunctions.freeMemory = check_free;
+	callBackFunctions.logger = fmi2_checker_logger;
+	callBackFunctions.stepFinished = 0;
+	callBackFunctions.componentEnvironment = cdata;
+
+	if(kind == fmi2_fmu_kind_me) {
+		cdata->modelIdentifierME = fmi2_import_get_model_identifier_ME(cdata->fmu2);
+		jm_log_info(cb, fmu_checker_module,"Model identifier for ModelExchange: %s", cdata->modelIdentifierME);
+	}
+	else {
+		cdata->modelIdentifierCS = fmi2_import_get_model_identifier_CS(cdata->fmu2);
+		jm_log_info(cb, fmu_checker_module,"Model identifier for CoSimulation: %s", cdata->modelIdentifierCS);
+	}
+
+	fmu_check_phase_begin(cdata, fmu_check_phase_load);
+	if (   (fmu_check_unpack_wait(cdata, fmu_check_unpack_binaries) != jm_status_success)
+		|| (fmi2_import_create_dllfmu(cdata->fmu2, kind, &callBackFunctions) == jm_status_error)) {
+		fmu_check_phase_end(cdata);
+		jm_log_fatal(cb,fmu_checker_module,"Could not create the DLL loading mechanism(C-API) for %s.",
+			(kind == fmi2_fmu_kind_me) ? "ME" : "CoSimulation");
+		return jm_status_error;
+	}
+	fmu_check_phase_end(cdata);
+	if(cdata->tmpPath == cdata->unzipPath) {
+		fmi2_import_set_debug_mode(cdata->fmu2, 1);
+	}
+	jm_log_info(cb,fmu_checker_module,"Version returned from %s FMU: '%s'\n", kindStr, fmi2_import_get_version(cdata->fmu2));
+
+	platform = fmi2_import_get_types_platform(cdata->fmu2);
+	if(strcmp(platform, fmi2_get_types_platform())) 
+		jm_log_error(cb,fmu_checker_module,"Platform type returned from %s FMU '%s' does not match the checker '%s'", kindStr, platform, fmi2_get_types_platform() );
+
+	return jm_status_success;
+}
+
+/* The CS run of --compare-me-cs on the second thread */
+typedef struct fmi2_check_cs_run_t {
+	fmu_check_data_t* cdata;
+	jm_status_enu_t status;
+} fmi2_check_cs_run_t;
+
+static void fmi2_check_cs_thread(void* data) {
+	fmi2_check_cs_run_t* run = (fmi2_check_cs_run_t*)data;
+	run->status = fmi2_cs_simulate(run->cdata);
+}
+
+/* ME and CS can run at the same time unless an instance must be alone in the process or runs are repeated */
+static int fmi2_check_me_cs_concurrent(fmu_check_data_t* cdata) {
+	return (cdata->num_threads != 1) && !cdata->determinism && !cdata->stateCacheDir
+		&& !fmi2_import_get_capability(cdata->fmu2, fmi2_me_canBeInstantiatedOnlyOncePerProcess)
+		&& !fmi2_import_get_capability(cdata->fmu2, fmi2_cs_canBeInstantiatedOnlyOncePerProcess);
+}
+
+/* Set up the check data of the CS run with its own import of the FMU unpacked by cdata. The rows go to a temporary file. */
+static jm_status_enu_t fmi2_check_load_cs_run(fmu_check_data_t* cdata, fmu_check_data_t* w, const char* outName) {
+	jm_callbacks* cb = &w->callbacks;
+
+	w->FMUPath = cdata->FMUPath;
+	/* shared with the main checker data, reset before the CS run data is cleared */
+	w->tmpPath = cdata->tmpPath;
+	w->unzipPath = cdata->unzipPath;
+	w->inputFileName = cdata->inputFileName;
+	w->version = cdata->version;
+
+	w->context = fmi_import_allocate_context(cb);
+	if(!w->context) return jm_status_error;
+	fmi_import_set_configuration(w->context, FMI_IMPORT_NAME_CHECK);
+
+	w->fmu2 = fmi2_import_parse_xml(w->context, w->tmpPath, 0);
+	if(!w->fmu2) {
+		jm_log_fatal(cb, fmu_checker_module, "Error parsing XML, exiting");
+		return jm_status_error;
+	}
+	w->modelName = fmi2_import_get_model_name(w->fmu2);
+	w->GUID = fmi2_import_get_GUID(w->fmu2);
+	w->fmu2_kind = fmi2_import_get_fmu_kind(w->fmu2);
+	w->vl2 = fmi2_import_get_variable_list(w->fmu2, 0);
+	if(!w->vl2) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not construct model variables list");
+		return jm_status_error;
+	}
+	/* the value references are the same. The plan stays valid since cdata is cleared later. */
+	w->fmu2_columns = cdata->fmu2_columns;
+	if((fmi2_init_input_data(&w->fmu2_inputData, cb, w->fmu2) != jm_status_success)
+		|| (fmi2_read_input_file(w) != jm_status_success)) {
+		return jm_status_error;
+	}
+	if(fmu_check_open_output(w, outName) != jm_status_success) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not open %s for writing", outName);
+		return jm_status_error;
+	}
+	return fmi2_check_load_dll(w, fmi2_fmu_kind_cs);
+}
+
+/* Append the rows of the CS run after the ME rows in the output file */
+static jm_status_enu_t fmi2_check_append_cs_output(fmu_check_data_t* cdata, const char* outName) {
+	char buf[65536];
+	size_t n;
+	jm_status_enu_t status = jm_status_success;
+	FILE* f = fopen(outName, "rb");
+
+	if(!f) {
+		jm_log_fatal(&cdata->callbacks, fmu_checker_module, "Could not read the CS output from %s", outName);
+		return jm_status_error;
+	}
+	while((status == jm_status_success) && ((n = fread(buf, 1, sizeof(buf), f)) > 0)) {
+		status = checked_fwrite(cdata, buf, n);
+	}
+	fclose(f);
+	return status;
+}
 
-	jm_log_info(cb, fmu_checker_module,"Printing output file header");
-	if(fmi2_write_csv_header(cdata) != jm_status_success) {
+/*
+	Simulate CS on a second thread while ME is simulated on this one. The CS rows
+	are compared with the ME output kept so far and written to a temporary file,
+	which is appended to the output file afterwards as in a sequential check.
+	*ran is cleared without simulating if the CS run could not be set up.
+*/
+static jm_status_enu_t fmi2_check_me_cs_concurrently(fmu_check_data_t* cdata, int* ran) {
+	jm_callbacks* cb = &cdata->callbacks;
+	fmi2_check_cs_run_t run;
+	fmu_check_thread_t* thread = 0;
+	fmu_check_data_t* w;
+	char outName[MAX_URL_LENGTH];
+	jm_status_enu_t status, meStatus = jm_status_error;
+
+	/* the CS run has no handle of the background extraction, so both parts must be there before it is set up */
+	if((fmu_check_unpack_wait(cdata, fmu_check_unpack_binaries) != jm_status_success)
+		|| (fmu_check_unpack_wait(cdata, fmu_check_unpack_resources) != jm_status_success)) {
+		*ran = 0;
 		return jm_status_error;
 	}
+	w = (fmu_check_data_t*)fmu_check_arena_calloc(&cdata->arena, 1, sizeof(fmu_check_data_t));
+	cdata->instance_data = (fmu_check_data_t**)fmu_check_arena_calloc(&cdata->arena, 1, sizeof(fmu_check_data_t*));
+	if(!w || !cdata->instance_data) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not allocate memory");
+		cdata->instance_data = 0;
+		*ran = 0;
+		return jm_status_error;
+	}
+	jm_snprintf(outName, sizeof(outName), "%s" FMI_FILE_SEP "cs_output.csv", cdata->tmpPath);
+	init_fmu_check_child_data(w, cdata);
+	w->out_file = stdout;
+	w->out_stream = 0;
+	/* lets the FMU logger find the checker data of the CS instance from the component environment */
+	cdata->instance_data[0] = w;
+	cdata->num_instance_data = 1;
+	status = fmi2_check_load_cs_run(cdata, w, outName);
+	if(status == jm_status_success) status = fmi2_reference_share(cdata, w);
+	if(status != jm_status_success) {
+		jm_log_info(cb, fmu_checker_module, "Could not set up the CS run on a second thread, ME and CS are simulated one after the other");
+		fmu_check_close_output(w);
+		/* the sequential runs report the problems that remain */
+		w->num_warnings = w->num_errors = w->num_fatal = 0;
+		*ran = 0;
+	}
+	else {
+		*ran = 1;
+		run.cdata = w;
+		run.status = jm_status_error;
+		jm_log_info(cb, fmu_checker_module, "Simulating the ME and CS FMUs concurrently for the ME/CS comparison");
+		if(fmi2_check_load_dll(cdata, fmi2_fmu_kind_me) != jm_status_error) {
+			fmi2_reference_start(cdata);
+			thread = fmu_check_thread_start(cb, fmi2_check_cs_thread, &run);
+			if(!thread) jm_log_warning(cb, fmu_checker_module, "Could not start a thread for the CS run, CS is simulated after ME");
+			meStatus = fmi2_me_simulate(cdata);
+		}
+		/* the CS rows still waiting are compared with the ME rows there are */
+		fmi2_reference_share_end(cdata);
+		if(thread) fmu_check_thread_join(thread);
+		else fmi2_check_cs_thread(&run);
+
+		if(fmi2_reference_record_end(cdata, "ME") != jm_status_success) {
+			jm_log_error(cb, fmu_checker_module, "The ME/CS comparison is skipped");
+			meStatus = jm_status_error;
+		}
+		else if(fmi2_reference_report(w, "ME/CS comparison") != jm_status_success) {
+			run.status = jm_status_error;
+		}
+		if((fmu_check_close_output(w) != jm_status_success) || (fmi2_check_append_cs_output(cdata, outName) != jm_status_success)) {
+			run.status = jm_status_error;
+		}
+		status = run.status;
+		if(status == jm_status_success) status = meStatus;
+		else if((status == jm_status_warning) && (meStatus == jm_status_error)) status = jm_status_error;
+		fmi2_reference_unshare(cdata, w);
+	}
+	remove(outName);
+
+	if(w->fmu2_instance_alive) {
+		fmi2_import_free_instance(w->fmu2);
+		w->fmu2_instance_alive = 0;
+	}
+	w->tmpPath = 0;
+	clear_fmu_check_child_data(w, cdata);
+	cdata->instance_data = 0;
+	cdata->num_instance_data = 0;
+	return status;
+}
+
+jm_status_enu_t fmi2_check(fmu_check_data_t* cdata) {
+	jm_callbacks* cb = &cdata->callbacks;
+	jm_status_enu_t status = jm_status_success;
+	int compareMeCs = 0, concurrent = 0;
+
+	if(fmi2_check_parse_xml(cdata) != jm_status_success) {
+		return jm_status_error;
+	}
+
+	if(cdata->sweepFileName) {
+		return fmi2_sweep_check(cdata);
+	}
+
+	if(!fmi2_reference_only(cdata)) {
+		jm_log_info(cb, fmu_checker_module,"Printing output file header");
+		if(fmi2_write_csv_header(cdata) != jm_status_success) {
+			return jm_status_error;
+		}
+	}
 
 	if(!cdata->do_simulate_flg) {
 		jm_log_verbose(cb, fmu_checker_module,"Simulation was not requested");
@@ -193,90 +432,73 @@ jm_status_enu_t fmi2_check(fmu_check_data_t* cdata) {
         || (fmi2_read_input_file(cdata) != jm_status_success)) {
 		return jm_status_error;
     }
-
-	callBackFunctions.allocateMemory = check_calloc;
-	callBackFunctions.freeMemory = check_free;
-	callBackFunctions.logger = fmi2_checker_logger;
-	callBackFunctions.stepFinished = 0;
-	callBackFunctions.componentEnvironment = cdata;
+	if(cdata->referenceFileName && (fmi2_reference_load(cdata) != jm_status_success)) {
+		return jm_status_error;
+	}
+	if(cdata->compareMeCs) {
+		if((cdata->fmu2_kind != fmi2_fmu_kind_me_and_cs) || !cdata->do_test_me || !cdata->do_test_cs) {
+			jm_log_warning(cb, fmu_checker_module, "The ME/CS comparison (--compare-me-cs) is skipped since ME and CS are not both tested");
+		}
+		else if(fmi2_reference_record_start(cdata) != jm_status_success) {
+			return jm_status_error;
+		}
+		else {
+			compareMeCs = 1;
+		}
+	}
+	if(compareMeCs && fmi2_check_me_cs_concurrent(cdata)) {
+		status = fmi2_check_me_cs_concurrently(cdata, &concurrent);
+		if(!concurrent) status = jm_status_success;
+	}
 
     if ((cdata->fmu2_kind & fmi2_fmu_kind_me) == 0 && cdata->require_me) {
         jm_log_error(cb, fmu_checker_module, "Testing of ME requested but not an ME FMU!");
     }
 	if( ((cdata->fmu2_kind == fmi2_fmu_kind_me) || (cdata->fmu2_kind == fmi2_fmu_kind_me_and_cs))
-      && (cdata->do_test_me)) {
-		cdata->modelIdentifierME = fmi2_import_get_model_identifier_ME(cdata->fmu2);
-	    jm_log_info(cb, fmu_checker_module,"Model identifier for ModelExchange: %s", cdata->modelIdentifierME);
-
-		status = fmi2_import_create_dllfmu(cdata->fmu2, fmi2_fmu_kind_me, &callBackFunctions);
-
-		if (status == jm_status_error) {
-			jm_log_fatal(cb,fmu_checker_module,"Could not create the DLL loading mechanism(C-API) for ME.");
-		}
-		else {
-			if(cdata->tmpPath == cdata->unzipPath) {
-				fmi2_import_set_debug_mode(cdata->fmu2, 1);
-			}
-			jm_log_info(cb,fmu_checker_module,"Version returned from ME FMU: '%s'\n", fmi2_import_get_version(cdata->fmu2));
-
-			{
-				const char* platform;
-
-				platform= fmi2_import_get_types_platform(cdata->fmu2);
-
-				if(strcmp(platform, fmi2_get_types_platform())) 
-					jm_log_error(cb,fmu_checker_module,"Platform type returned from ME FMU '%s' does not match the checker '%s'",platform, fmi2_get_types_platform() );
-			}
-
-			status = fmi2_me_simulate(cdata);
+      && cdata->do_test_me && !concurrent) {
+		status = fmi2_check_load_dll(cdata, fmi2_fmu_kind_me);
+		if (status != jm_status_error) {
+			fmi2_reference_start(cdata);
+			status = cdata->determinism ? fmi2_determinism_check(cdata, fmi2_fmu_kind_me) : fmi2_me_simulate(cdata);
+			if(cdata->referenceFileName && (fmi2_reference_report(cdata, "ME reference comparison") != jm_status_success)) status = jm_status_error;
 		}
 	}
+	if(compareMeCs && !concurrent && (fmi2_reference_record_end(cdata, "ME") != jm_status_success)) {
+		jm_log_error(cb, fmu_checker_module, "The ME/CS comparison is skipped");
+		compareMeCs = 0;
+		status = jm_status_error;
+	}
     if ((cdata->fmu2_kind & fmi2_fmu_kind_cs) == 0 && cdata->require_cs) {
         jm_log_error(cb, fmu_checker_module, "Testing of CS requested but not a CS FMU!");
     }
 	if( ((cdata->fmu2_kind == fmi2_fmu_kind_cs) || (cdata->fmu2_kind == fmi2_fmu_kind_me_and_cs))
-      && cdata->do_test_cs) {
+      && cdata->do_test_cs && !concurrent) {
 		jm_status_enu_t savedStatus = status;
-		cdata->modelIdentifierCS = fmi2_import_get_model_identifier_CS(cdata->fmu2);
-	    jm_log_info(cb, fmu_checker_module,"Model identifier for CoSimulation: %s", cdata->modelIdentifierCS);
-		status = fmi2_import_create_dllfmu(cdata->fmu2, fmi2_fmu_kind_cs, &callBackFunctions);
-
-		if (status == jm_status_error) {
-			jm_log_fatal(cb,fmu_checker_module,"Could not create the DLL loading mechanism(C-API) for CoSimulation.");
-		}
-		else {
-			if(cdata->tmpPath == cdata->unzipPath) {
-				fmi2_import_set_debug_mode(cdata->fmu2, 1);
-			}
-			jm_log_info(cb,fmu_checker_module,"Version returned from CS FMU:   %s", fmi2_import_get_version(cdata->fmu2));
-
-			{
-				const char* platform;
-
-				platform= fmi2_import_get_types_platform(cdata->fmu2);
-
-				if(strcmp(platform, fmi2_get_types_platform())) 
-					jm_log_error(cb,fmu_checker_module,"Platform type returned from CS FMU '%s' does not match the checker '%s'",platform, fmi2_get_types_platform() );
-			}
-
-			status = fmi2_cs_simulate(cdata);
+		status = fmi2_check_load_dll(cdata, fmi2_fmu_kind_cs);
+		if (status != jm_status_error) {
+			fmi2_reference_start(cdata);
+			status = cdata->determinism ? fmi2_determinism_check(cdata, fmi2_fmu_kind_cs) : fmi2_cs_simulate(cdata);
+			if(cdata->referenceFileName && (fmi2_reference_report(cdata, "CS reference comparison") != jm_status_success)) status = jm_status_error;
+			if(compareMeCs && (fmi2_reference_report(cdata, "ME/CS comparison") != jm_status_success)) status = jm_status_error;
 		}
 		if(status == jm_status_success) status = savedStatus;
 		else if((status == jm_status_warning) && (savedStatus == jm_status_error)) status = jm_status_error;
 	}
+	if(cdata->numInstances) {
+		if(status == jm_status_error) {
+			jm_log_info(cb, fmu_checker_module, "The multi-instance check is skipped since the simulation failed");
+		}
+		else if(fmi2_multi_instance_check(cdata) == jm_status_error) {
+			status = jm_status_error;
+		}
+	}
 	return status;
 }
 
 
 jm_status_enu_t fmi2_write_csv_header(fmu_check_data_t* cdata) {
-	fmi2_import_variable_list_t * vl = cdata->vl2;
-	unsigned i, n = (unsigned)fmi2_import_get_variable_list_size(vl);
-
-	char replace_sep = ':';
-	
-	if(cdata->CSV_separator == ':') {
-		replace_sep = '|';
-	}
+	fmi2_column_plan_t* plan = &cdata->fmu2_columns;
+	size_t i;
 
 	if (cdata->do_mangle_var_names){
 		if(checked_fprintf(cdata,"time") != jm_status_success) {
@@ -289,29 +511,8 @@ jm_status_enu_t fmi2_write_csv_header(fmu_check_data_t* cdata) {
 		}
 	}
 
-    for(i = 0; i < n; i++) {
-/*        char buf[10000], *cursrc, *curdest;
-        int need_quoting = 0; */
-        fmi2_import_variable_t * v = fmi2_import_get_variable(vl, i);
-        const char* vn = fmi2_import_get_variable_name(v);
-        fmi2_import_variable_t * vb = fmi2_import_get_variable_alias_base(cdata->fmu2, v);
-        jm_status_enu_t status = jm_status_success;
-#if 0
-        switch(fmi2_import_get_variable_alias_kind(v)) {
-        case fmi2_variable_is_not_alias:
-            sprintf(buf, "%s", vn);
-            break;
-        case fmi2_variable_is_alias:
-            sprintf(buf, "%s=%s", vn, fmi2_import_get_variable_name(vb));
-            break;
-        default:
-            assert(0);
-        }
-#endif
-      if (cdata->do_output_all_vars || (fmi2_import_get_causality(v) == fmi2_causality_enu_output)){
-		  status = check_fprintf_var_name(cdata, vn);
-	  }
-		if(status != jm_status_success) {
+	for(i = 0; i < plan->numCols; i++) {
+		if(checked_fprintf(cdata, "%c%s", cdata->CSV_separator, plan->cols[i].header) != jm_status_success) {
 			return jm_status_error;
 		}
 	}
@@ -323,135 +524,23 @@ jm_status_enu_t fmi2_write_csv_header(fmu_check_data_t* cdata) {
 }
 
 jm_status_enu_t fmi2_write_csv_data(fmu_check_data_t* cdata, double time) {
-	fmi2_import_t* fmu = cdata->fmu2;
-	fmi2_import_variable_list_t * vl = cdata->vl2;
-	jm_callbacks* cb = &cdata->callbacks;
-	fmi2_status_t fmistatus = fmi2_status_ok;
-	jm_status_enu_t outstatus = jm_status_success;
-	unsigned i, n = (unsigned)fmi2_import_get_variable_list_size(vl);
-
-	char fmt_sep[2];
-	char fmt_r[20];
-	char fmt_i[20];
-	char fmt_true[20];
-	char fmt_false[20];
-
-    if(cdata->maxOutputPts > 0) {
-        if(time < cdata->nextOutputTime) {
-            return jm_status_success;
-        }
-        else {
-            cdata->nextOutputStep++;
-            cdata->nextOutputTime = cdata->stopTime*cdata->nextOutputStep/cdata->maxOutputPts;
-            if(cdata->nextOutputTime > cdata->stopTime) {
-                cdata->nextOutputTime = cdata->stopTime;
-            }
-        }
-    }
+	fmi2_row_writer_t* row = &cdata->fmu2_row;
 
-	fmt_sep[0] = cdata->CSV_separator; fmt_sep[1] = 0;
-	sprintf(fmt_r, "%c%s", cdata->CSV_separator, "%.16E");
-	sprintf(fmt_i, "%c%s", cdata->CSV_separator, "%d");
-#ifdef SUPPORT_out_enum_as_int_flag
-	if(!cdata->out_enum_as_int_flag) {
-		sprintf(fmt_true, "%ctrue", cdata->CSV_separator);
-		sprintf(fmt_false, "%cfalse", cdata->CSV_separator);
-	}
-	else
-#endif
-	{
-		sprintf(fmt_true, "%c1", cdata->CSV_separator);
-		sprintf(fmt_false, "%c0", cdata->CSV_separator);
+	if(fmi2_resample_enabled(cdata)) {
+		return fmi2_resample_write(cdata, time);
 	}
-
-	if(checked_fprintf(cdata, "%.16E", time) != jm_status_success) {
-		return jm_status_error;
-	}
-
-	for(i = 0; i < n; i++) {
-		fmi2_import_variable_t* v = fmi2_import_get_variable(vl, i);
-		fmi2_value_reference_t vr = fmi2_import_get_variable_vr(v); 
-		switch(fmi2_import_get_variable_base_type(v)) {
-		case fmi2_base_type_real:
-			{
-				double val;
-				fmistatus = fmi2_import_get_real(fmu,&vr, 1, &val);
-				if (cdata->do_output_all_vars || (fmi2_import_get_causality(v) == fmi2_causality_enu_output)){
-					outstatus = checked_fprintf(cdata, fmt_r, val);
-				}
-				break;
-			}
-		case fmi2_base_type_int:
-			{
-				int val;
-				fmistatus = fmi2_import_get_integer(fmu,&vr, 1, &val);
-				if (cdata->do_output_all_vars || (fmi2_import_get_causality(v) == fmi2_causality_enu_output)){
-					outstatus = checked_fprintf(cdata, fmt_i, val);
-				}
-				break;
-			}
-		case fmi2_base_type_bool:
-			{
-				fmi2_boolean_t val;
-				char* fmt;
-				fmistatus = fmi2_import_get_boolean(fmu,&vr, 1, &val);
-				if (cdata->do_output_all_vars || (fmi2_import_get_causality(v) == fmi2_causality_enu_output)){
-					fmt = (val == fmi2_true) ? fmt_true:fmt_false;
-					outstatus = checked_fprintf(cdata, fmt);
-				}
-				break;
-			}
-		case fmi2_base_type_str:
-			{
-				fmi2_string_t val;
-				
-				fmistatus = fmi2_import_get_string(fmu,&vr, 1, &val);
-				if (cdata->do_output_all_vars || (fmi2_import_get_causality(v) == fmi2_causality_enu_output)){
-					checked_fprintf(cdata, fmt_sep);
-					outstatus = checked_print_quoted_str(cdata, val);
-				}
-				break;
-			}
-		case fmi2_base_type_enum:
-			{
-				int val;
-				fmi2_import_variable_typedef_t* t = fmi2_import_get_variable_declared_type(v);
-				fmi2_import_enumeration_typedef_t* et = 0;
-				unsigned int item = 0;
-				const char* itname = 0;
-				if(t) et = fmi2_import_get_type_as_enum(t);
-
-				fmistatus = fmi2_import_get_integer(fmu,&vr, 1, &val);
-				if(et) itname = fmi2_import_get_enum_type_value_name(et, val);
-				if(!itname) {
-					jm_log_error(cb, fmu_checker_module, "Could not get item name for enum variable %s", fmi2_import_get_variable_name(v));
-				}
-#ifdef SUPPORT_out_enum_as_int_flag
-                if(!cdata->out_enum_as_int_flag && itname) {
-					checked_fprintf(cdata, fmt_sep);
-					outstatus = checked_print_quoted_str(cdata, itname);
-				}
-				else 
-#endif
-                {
-					if (cdata->do_output_all_vars || (fmi2_import_get_causality(v) == fmi2_causality_enu_output)){
-						outstatus = checked_fprintf(cdata, fmt_i, val);
-					}
-				}
-				break;
-			}
-		}
-		if(  fmistatus != fmi2_status_ok) {
-			jm_log_warning(cb, fmu_checker_module, "fmiGetXXX returned status: %s for variable %s", 
-				fmi2_status_to_string(fmistatus), fmi2_import_get_variable_name(v));
-		}
-
-		if(outstatus != jm_status_success) {
+    if(!check_output_time(cdata, time)) {
+        return jm_status_success;
+    }
+	if(!row->setUp) {
+		if(fmi2_alloc_column_values(cdata, &row->values) != jm_status_success) {
 			return jm_status_error;
 		}
+		row->setUp = 1;
 	}
-	if(checked_fprintf(cdata, "\r\n")!= jm_status_success) {
-		return jm_status_error;
-	}
-	return jm_status_success;
+
+	fmu_check_watch(cdata, "fmi2GetXXX (output)", time);
+	fmi2_read_column_values(cdata, &row->values);
+	fmu_check_watch_end(cdata);
+	return fmi2_write_csv_row(cdata, time, &row->values);
 }
\ No newline at end of file
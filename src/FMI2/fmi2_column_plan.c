@@ -0,0 +1,444 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmi2_column_plan.c
+	Selection of the FMI 2.0 variables written to the output file (--vars option).
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <fmuChecker.h>
+#include <fmilib.h>
+
+/* Variable name patterns given with the --vars option */
+typedef struct fmi2_column_patterns_t {
+	size_t num;
+	char** patterns;
+	/* number of variables matched by each pattern */
+	size_t* matches;
+} fmi2_column_patterns_t;
+
+int fmi2_column_pattern_match(const char* pattern, const char* name) {
+	const char* star = 0;
+	const char* resume = 0;
+
+	while(*name) {
+		if(*pattern == '*') {
+			/* remember the position and let the star match the empty string first */
+			star = pattern++;
+			resume = name;
+		}
+		else if((*pattern == '?') || (*pattern == *name)) {
+			pattern++;
+			name++;
+		}
+		else if(star) {
+			/* let the last star match one more character */
+			pattern = star + 1;
+			name = ++resume;
+		}
+		else {
+			return 0;
+		}
+	}
+	while(*pattern == '*') pattern++;
+	return *pattern == 0;
+}
+
+static int fmi2_column_is_space(char ch) {
+	return (ch == ' ') || (ch == '\t') || (ch == '\r') || (ch == '\n');
+}
+
+/* Add the pattern str[0..len) with surrounding white space removed. Empty patterns are skipped. */
+static jm_status_enu_t fmi2_column_add_pattern(fmu_check_data_t* cdata, fmi2_column_patterns_t* p, size_t maxNum,
+											   const char* str, size_t len) {
+	char* pattern;
+	while(len && fmi2_column_is_space(*str)) {
+		str++;
+		len--;
+	}
+	while(len && fmi2_column_is_space(str[len - 1])) len--;
+	if(!len) return jm_status_success;
+	if(p->num >= maxNum) return jm_status_error;
+
+	pattern = (char*)fmu_check_arena_alloc(&cdata->arena, len + 1);
+	if(!pattern) {
+		jm_log_fatal(&cdata->callbacks, fmu_checker_module, "Could not allocate memory");
+		return jm_status_error;
+	}
+	memcpy(pattern, str, len);
+	pattern[len] = 0;
+	p->patterns[p->num++] = pattern;
+	return jm_status_success;
+}
+
+/* Read the whole pattern file into the arena */
+static char* fmi2_column_read_file(fmu_check_data_t* cdata, const char* fileName) {
+	jm_callbacks* cb = &cdata->callbacks;
+	FILE* f = fopen(fileName, "rb");
+	char* text = 0;
+	long size;
+
+	if(!f) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not open variable pattern file %s (%s)", fileName, strerror(errno));
+		return 0;
+	}
+	if((fseek(f, 0, SEEK_END) == 0) && ((size = ftell(f)) >= 0) && (fseek(f, 0, SEEK_SET) == 0)) {
+		text = (char*)fmu_check_arena_alloc(&cdata->arena, (size_t)size + 1);
+		if(text && (fread(text, 1, (size_t)size, f) == (size_t)size)) {
+			text[size] = 0;
+		}
+		else {
+			text = 0;
+		}
+	}
+	if(!text) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not read variable pattern file %s", fileName);
+	}
+	fclose(f);
+	return text;
+}
+
+/*
+	Parse the --vars specification: a comma separated list of patterns (commas inside
+	brackets belong to the pattern, e.g., "x[1,2]") or '@' followed by a file name with
+	one pattern per line. Lines starting with '#' in the file are comments.
+*/
+static jm_status_enu_t fmi2_column_parse_patterns(fmu_check_data_t* cdata, fmi2_column_patterns_t* p) {
+	const char* spec = cdata->outputVarsSpec;
+	const char* start;
+	const char* cur;
+	size_t maxNum = 1;
+	int fromFile = (spec[0] == '@');
+	int depth = 0;
+
+	if(fromFile) {
+		spec = fmi2_column_read_file(cdata, spec + 1);
+		if(!spec) return jm_status_error;
+	}
+	for(cur = spec; *cur; cur++) {
+		if((*cur == ',') || (*cur == '\n')) maxNum++;
+	}
+	p->num = 0;
+	p->patterns = (char**)fmu_check_arena_calloc(&cdata->arena, maxNum, sizeof(char*));
+	p->matches = (size_t*)fmu_check_arena_calloc(&cdata->arena, maxNum, sizeof(size_t));
+	if(!p->patterns || !p->matches) {
+		jm_log_fatal(&cdata->callbacks, fmu_checker_module, "Could not allocate memory");
+		return jm_status_error;
+	}
+
+	start = spec;
+	for(cur = spec; ; cur++) {
+		int endOfPattern;
+		if(fromFile) {
+			endOfPattern = (*cur == '\n') || (*cur == 0);
+		}
+		else {
+			if(*cur == '[') depth++;
+			else if((*cur == ']') && depth) depth--;
+			endOfPattern = ((*cur == ',') && !depth) || (*cur == 0);
+		}
+		if(endOfPattern) {
+			const char* first = start;
+			while((first < cur) && fmi2_column_is_space(*first)) first++;
+			if(!fromFile || (first == cur) || (*first != '#')) {
+				if(fmi2_column_add_pattern(cdata, p, maxNum, start, cur - start) != jm_status_success) {
+					return jm_status_error;
+				}
+			}
+			if(*cur == 0) break;
+			start = cur + 1;
+		}
+	}
+	if(!p->num) {
+		jm_log_warning(&cdata->callbacks, fmu_checker_module, "No variable name patterns given with --vars, no variables will be written to the output file");
+	}
+	return jm_status_success;
+}
+
+/* Check if the variable goes to the output file and count the pattern matches */
+static int fmi2_column_is_selected(fmu_check_data_t* cdata, fmi2_column_patterns_t* p, fmi2_import_variable_t* v) {
+	const char* name;
+	size_t k;
+	int selected = 0;
+
+	if(!cdata->outputVarsSpec) {
+		return cdata->do_output_all_vars || (fmi2_import_get_causality(v) == fmi2_causality_enu_output);
+	}
+	name = fmi2_import_get_variable_name(v);
+	for(k = 0; k < p->num; k++) {
+		if(fmi2_column_pattern_match(p->patterns[k], name)) {
+			p->matches[k]++;
+			selected = 1;
+		}
+	}
+	return selected;
+}
+
+/* Add the variable as the next column of the plan. The header is only set up for written columns. */
+static jm_status_enu_t fmi2_column_add(fmu_check_data_t* cdata, fmi2_column_plan_t* plan, fmi2_import_variable_t* v, int written) {
+	fmi2_column_t* col = &plan->cols[plan->numReadCols];
+	const char* vn;
+	char* header;
+
+	memset(col, 0, sizeof(*col));
+	col->var = v;
+	col->type = fmi2_import_get_variable_base_type(v);
+	col->vr = fmi2_import_get_variable_vr(v);
+	switch(col->type) {
+	case fmi2_base_type_real:
+		col->index = plan->numReals;
+		plan->vrReals[plan->numReals++] = col->vr;
+		break;
+	case fmi2_base_type_enum:
+		{
+			fmi2_import_variable_typedef_t* t = fmi2_import_get_variable_declared_type(v);
+			if(t) col->enumType = fmi2_import_get_type_as_enum(t);
+		}
+		/* enumeration values are read as integers */
+	case fmi2_base_type_int:
+		col->index = plan->numInts;
+		plan->vrInts[plan->numInts++] = col->vr;
+		break;
+	case fmi2_base_type_bool:
+		col->index = plan->numBools;
+		plan->vrBools[plan->numBools++] = col->vr;
+		break;
+	case fmi2_base_type_str:
+		col->index = plan->numStrs;
+		plan->vrStrs[plan->numStrs++] = col->vr;
+		break;
+	default:
+		return jm_status_success;
+	}
+	plan->numReadCols++;
+	if(!written) return jm_status_success;
+
+	/* quoting doubles the '"' characters and adds two quotes */
+	vn = fmi2_import_get_variable_name(v);
+	header = (char*)fmu_check_arena_alloc(&cdata->arena, 2 * strlen(vn) + 3);
+	if(!header) {
+		jm_log_fatal(&cdata->callbacks, fmu_checker_module, "Could not allocate memory");
+		return jm_status_error;
+	}
+	check_format_var_name(cdata, vn, header);
+	col->header = header;
+	plan->numCols++;
+	return jm_status_success;
+}
+
+jm_status_enu_t fmi2_build_column_plan(fmu_check_data_t* cdata) {
+	fmi2_column_plan_t* plan = &cdata->fmu2_columns;
+	fmu_check_arena_t* arena = &cdata->arena;
+	fmi2_import_variable_list_t* vl = cdata->vl2;
+	size_t i, k, n = fmi2_import_get_variable_list_size(vl);
+	fmi2_column_patterns_t patterns;
+	char* selected;
+
+	memset(plan, 0, sizeof(*plan));
+	memset(&patterns, 0, sizeof(patterns));
+	/* the output buffers are sized for the plan */
+	memset(&cdata->fmu2_row, 0, sizeof(cdata->fmu2_row));
+	memset(&cdata->fmu2_resample, 0, sizeof(cdata->fmu2_resample));
+	if(cdata->outputVarsSpec && (fmi2_column_parse_patterns(cdata, &patterns) != jm_status_success)) {
+		return jm_status_error;
+	}
+
+	plan->cols = (fmi2_column_t*)fmu_check_arena_calloc(arena, n + 1, sizeof(fmi2_column_t));
+	plan->vrReals = (fmi2_value_reference_t*)fmu_check_arena_calloc(arena, n + 1, sizeof(fmi2_value_reference_t));
+	plan->vrInts = (fmi2_value_reference_t*)fmu_check_arena_calloc(arena, n + 1, sizeof(fmi2_value_reference_t));
+	plan->vrBools = (fmi2_value_reference_t*)fmu_check_arena_calloc(arena, n + 1, sizeof(fmi2_value_reference_t));
+	plan->vrStrs = (fmi2_value_reference_t*)fmu_check_arena_calloc(arena, n + 1, sizeof(fmi2_value_reference_t));
+	selected = (char*)fmu_check_arena_calloc(arena, n + 1, 1);
+	if(!plan->cols || !plan->vrReals || !plan->vrInts || !plan->vrBools || !plan->vrStrs || !selected) {
+		jm_log_fatal(&cdata->callbacks, fmu_checker_module, "Could not allocate memory");
+		return jm_status_error;
+	}
+
+	/* the written columns come first */
+	for(i = 0; i < n; i++) {
+		fmi2_import_variable_t* v = fmi2_import_get_variable(vl, i);
+		selected[i] = (char)fmi2_column_is_selected(cdata, &patterns, v);
+		if(selected[i] && (fmi2_column_add(cdata, plan, v, 1) != jm_status_success)) {
+			return jm_status_error;
+		}
+	}
+	/* without --vars the remaining variables are read but not written */
+	for(i = 0; (i < n) && !cdata->outputVarsSpec; i++) {
+		if(!selected[i] && (fmi2_column_add(cdata, plan, fmi2_import_get_variable(vl, i), 0) != jm_status_success)) {
+			return jm_status_error;
+		}
+	}
+
+	for(k = 0; k < patterns.num; k++) {
+		if(!patterns.matches[k]) {
+			jm_log_warning(&cdata->callbacks, fmu_checker_module, "Variable name pattern '%s' (--vars) does not match any variable", patterns.patterns[k]);
+		}
+	}
+	if(cdata->outputVarsSpec) {
+		jm_log_info(&cdata->callbacks, fmu_checker_module, "%u variable(s) selected for the output file", (unsigned)plan->numCols);
+	}
+	return jm_status_success;
+}
+
+jm_status_enu_t fmi2_alloc_column_values(fmu_check_data_t* cdata, fmi2_column_values_t* values) {
+	fmu_check_arena_t* arena = &cdata->arena;
+	fmi2_column_plan_t* plan = &cdata->fmu2_columns;
+	values->reals = (fmi2_real_t*)fmu_check_arena_calloc(arena, plan->numReals + 1, sizeof(fmi2_real_t));
+	values->ints = (fmi2_integer_t*)fmu_check_arena_calloc(arena, plan->numInts + 1, sizeof(fmi2_integer_t));
+	values->bools = (fmi2_boolean_t*)fmu_check_arena_calloc(arena, plan->numBools + 1, sizeof(fmi2_boolean_t));
+	values->strs = (fmi2_string_t*)fmu_check_arena_calloc(arena, plan->numStrs + 1, sizeof(fmi2_string_t));
+	if(!values->reals || !values->ints || !values->bools || !values->strs) {
+		jm_log_fatal(&cdata->callbacks, fmu_checker_module, "Could not allocate memory");
+		return jm_status_error;
+	}
+	return jm_status_success;
+}
+
+/* Read the values of one type one by one after a failed get call and report the variables */
+static void fmi2_read_column_values_one_by_one(fmu_check_data_t* cdata, fmi2_column_values_t* values,
+											   fmi2_base_type_enu_t type, fmi2_base_type_enu_t type2) {
+	fmi2_import_t* fmu = cdata->fmu2;
+	fmi2_column_plan_t* plan = &cdata->fmu2_columns;
+	size_t i;
+
+	for(i = 0; i < plan->numReadCols; i++) {
+		fmi2_column_t* col = &plan->cols[i];
+		fmi2_status_t fmistatus;
+		if((col->type != type) && (col->type != type2)) continue;
+		switch(col->type) {
+		case fmi2_base_type_real:
+			fmistatus = fmi2_import_get_real(fmu, &col->vr, 1, &values->reals[col->index]);
+			break;
+		case fmi2_base_type_bool:
+			fmistatus = fmi2_import_get_boolean(fmu, &col->vr, 1, &values->bools[col->index]);
+			break;
+		case fmi2_base_type_str:
+			fmistatus = fmi2_import_get_string(fmu, &col->vr, 1, &values->strs[col->index]);
+			break;
+		default:
+			fmistatus = fmi2_import_get_integer(fmu, &col->vr, 1, &values->ints[col->index]);
+			break;
+		}
+		if(fmistatus != fmi2_status_ok) {
+			jm_log_warning(&cdata->callbacks, fmu_checker_module, "fmiGetXXX returned status: %s for variable %s", 
+				fmi2_status_to_string(fmistatus), fmi2_import_get_variable_name(col->var));
+		}
+	}
+}
+
+void fmi2_read_column_values(fmu_check_data_t* cdata, fmi2_column_values_t* values) {
+	fmi2_import_t* fmu = cdata->fmu2;
+	fmi2_column_plan_t* plan = &cdata->fmu2_columns;
+
+	if(plan->numReals && (fmi2_import_get_real(fmu, plan->vrReals, plan->numReals, values->reals) != fmi2_status_ok)) {
+		fmi2_read_column_values_one_by_one(cdata, values, fmi2_base_type_real, fmi2_base_type_real);
+	}
+	if(plan->numInts && (fmi2_import_get_integer(fmu, plan->vrInts, plan->numInts, values->ints) != fmi2_status_ok)) {
+		fmi2_read_column_values_one_by_one(cdata, values, fmi2_base_type_int, fmi2_base_type_enum);
+	}
+	if(plan->numBools && (fmi2_import_get_boolean(fmu, plan->vrBools, plan->numBools, values->bools) != fmi2_status_ok)) {
+		fmi2_read_column_values_one_by_one(cdata, values, fmi2_base_type_bool, fmi2_base_type_bool);
+	}
+	if(plan->numStrs) {
+		memset(values->strs, 0, plan->numStrs * sizeof(fmi2_string_t));
+		if(fmi2_import_get_string(fmu, plan->vrStrs, plan->numStrs, values->strs) != fmi2_status_ok) {
+			fmi2_read_column_values_one_by_one(cdata, values, fmi2_base_type_str, fmi2_base_type_str);
+		}
+	}
+}
+
+/* Longest formatted number: "%.16E" of a negative double with a three digit exponent */
+#define FMI2_ROW_NUMBER_SIZE 32
+
+/* Append the string in double quotes replacing '"' with '\'' (see checked_print_quoted_str()) */
+static char* fmi2_row_append_quoted(char* cur, const char* str) {
+	*cur++ = '"';
+	while(*str) {
+		*cur++ = (*str == '"') ? '\'' : *str;
+		str++;
+	}
+	*cur++ = '"';
+	return cur;
+}
+
+jm_status_enu_t fmi2_write_csv_row(fmu_check_data_t* cdata, double time, const fmi2_column_values_t* values) {
+	fmi2_column_plan_t* plan = &cdata->fmu2_columns;
+	fmi2_row_writer_t* row = &cdata->fmu2_row;
+	char sep = cdata->CSV_separator;
+	size_t i, size;
+	char* cur;
+
+	if(cdata->fmu2_determinism.mode != fmi2_determinism_off) {
+		fmi2_determinism_row(cdata, time, values);
+		/* only the first run is written */
+		if(cdata->fmu2_determinism.mode == fmi2_determinism_compare) return jm_status_success;
+	}
+	if(cdata->fmu2_reference.mode != fmi2_reference_off) {
+		if(fmi2_reference_row(cdata, time, values) != jm_status_success) return jm_status_error;
+		if(fmi2_reference_only(cdata)) return jm_status_success;
+	}
+	/* separator and number for each column, quotes for the strings, time and line end */
+	size = (plan->numCols + 1) * (FMI2_ROW_NUMBER_SIZE + 1) + 3;
+	for(i = 0; i < plan->numStrs; i++) {
+		if(values->strs[i]) size += strlen(values->strs[i]) + 2;
+	}
+	if(size > row->lineSize) {
+		/* the old buffer stays in the arena; doubling keeps the waste bounded */
+		row->line = (char*)fmu_check_arena_alloc(&cdata->arena, 2 * size);
+		row->lineSize = row->line ? 2 * size : 0;
+		if(!row->line) {
+			jm_log_fatal(&cdata->callbacks, fmu_checker_module, "Could not allocate memory");
+			return jm_status_error;
+		}
+	}
+
+	cur = row->line;
+	cur += sprintf(cur, "%.16E", time);
+	for(i = 0; i < plan->numCols; i++) {
+		const fmi2_column_t* col = &plan->cols[i];
+		*cur++ = sep;
+		switch(col->type) {
+		case fmi2_base_type_real:
+			cur += sprintf(cur, "%.16E", values->reals[col->index]);
+			break;
+		case fmi2_base_type_int:
+			cur += sprintf(cur, "%d", values->ints[col->index]);
+			break;
+		case fmi2_base_type_bool:
+#ifdef SUPPORT_out_enum_as_int_flag
+			if(!cdata->out_enum_as_int_flag) {
+				cur += sprintf(cur, "%s", (values->bools[col->index] == fmi2_true) ? "true" : "false");
+			}
+			else
+#endif
+			*cur++ = (values->bools[col->index] == fmi2_true) ? '1' : '0';
+			break;
+		case fmi2_base_type_str:
+			if(values->strs[col->index]) cur = fmi2_row_append_quoted(cur, values->strs[col->index]);
+			break;
+		case fmi2_base_type_enum:
+			{
+				int val = values->ints[col->index];
+				const char* itname = 0;
+				if(col->enumType) itname = fmi2_import_get_enum_type_value_name(col->enumType, val);
+				if(!itname) {
+					jm_log_error(&cdata->callbacks, fmu_checker_module, "Could not get item name for enum variable %s", fmi2_import_get_variable_name(col->var));
+				}
+				cur += sprintf(cur, "%d", val);
+				break;
+			}
+		default:
+			break;
+		}
+	}
+	*cur++ = '\r';
+	*cur++ = '\n';
+	return checked_fwrite(cdata, row->line, cur - row->line);
+}
@@ -0,0 +1,918 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmi2_cosim.c
+	Co-simulation master for several FMI 2.0 CS FMUs (--cosim option).
+
+	The FMUs and the connections between them are read from a connection file.
+	The FMUs are sorted into levels so that an FMU only depends on FMUs on
+	lower levels within a communication step. The FMUs in a connection loop
+	(a strongly connected component of the connection graph) share a level
+	and get the inputs from each other from the previous communication step.
+	FMUs on the same level are stepped in parallel. Variables are exchanged with one get/set call per FMU
+	and type using value reference arrays prepared before the simulation.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <JM/jm_vector.h>
+#include <fmuChecker.h>
+#include <fmilib.h>
+
+#define COSIM_LINE_LENGTH 10000
+
+/** Value types exchanged between the FMUs. Enumerations are exchanged as integers. */
+typedef enum fmi2_cosim_type_enu_t {
+	fmi2_cosim_real = 0,
+	fmi2_cosim_integer,
+	fmi2_cosim_boolean,
+	fmi2_cosim_num_types
+} fmi2_cosim_type_enu_t;
+
+typedef struct fmi2_cosim_member_t fmi2_cosim_member_t;
+
+/** Source of the value for a connected input */
+typedef struct fmi2_cosim_link_t {
+	fmi2_cosim_member_t* source;
+	/** index into the outputs of the source */
+	size_t index;
+} fmi2_cosim_link_t;
+
+/** Variables of one type together with the buffers for batched get/set calls */
+typedef struct fmi2_cosim_ports_t {
+	size_t size;
+	fmi2_import_variable_t** vars;
+	fmi2_value_reference_t* vr;
+	/** fmi2_real_t, fmi2_integer_t or fmi2_boolean_t array */
+	void* values;
+	/** sources of the connected inputs (NULL for outputs) */
+	fmi2_cosim_link_t* links;
+} fmi2_cosim_ports_t;
+
+/** An FMU in the co-simulation */
+struct fmi2_cosim_member_t {
+	fmu_check_data_t cdata;
+	/** Name used in the connection file. Also used as instance name. */
+	char* name;
+	size_t index;
+	/** Position in the dependency ordering */
+	size_t level;
+	int instantiated;
+	fmi2_cosim_ports_t outputs[fmi2_cosim_num_types];
+	fmi2_cosim_ports_t inputs[fmi2_cosim_num_types];
+	/** Status of the last step and the FMI function that returned it */
+	fmi2_status_t stepStatus;
+	const char* stepFunction;
+	/** Wall clock time spent in the step task */
+	double stepTime;
+	double maxStepTime;
+};
+
+/** A connection as read from the connection file */
+typedef struct fmi2_cosim_connection_t {
+	char* from;
+	char* to;
+	unsigned line;
+	fmi2_cosim_member_t* source;
+	size_t sourceIndex;
+	fmi2_cosim_member_t* target;
+	fmi2_import_variable_t* targetVar;
+	fmi2_cosim_type_enu_t type;
+} fmi2_cosim_connection_t;
+
+typedef struct fmi2_cosim_t {
+	fmu_check_data_t* cdata;
+	jm_callbacks* cb;
+	/** fmi2_cosim_member_t* in the order of declaration */
+	jm_vector(jm_voidp) members;
+	/** fmi2_cosim_connection_t* */
+	jm_vector(jm_voidp) connections;
+	/** Members sorted by level. Level l is order[levelStart[l]] to order[levelStart[l+1]-1]. */
+	fmi2_cosim_member_t** order;
+	size_t* levelStart;
+	size_t numLevels;
+	fmu_check_thread_pool_t* pool;
+	/** Level stepped by the thread pool */
+	size_t level;
+	fmi2_real_t tcur;
+	fmi2_real_t hstep;
+} fmi2_cosim_t;
+
+#define COSIM_MEMBER(sim, i) ((fmi2_cosim_member_t*)jm_vector_get_item(jm_voidp)(&(sim)->members, (i)))
+#define COSIM_CONNECTION(sim, i) ((fmi2_cosim_connection_t*)jm_vector_get_item(jm_voidp)(&(sim)->connections, (i)))
+
+static const size_t fmi2_cosim_type_size[fmi2_cosim_num_types] = {
+	sizeof(fmi2_real_t), sizeof(fmi2_integer_t), sizeof(fmi2_boolean_t)
+};
+
+static int fmi2_cosim_get_type(fmi2_import_variable_t* v) {
+	switch(fmi2_import_get_variable_base_type(v)) {
+	case fmi2_base_type_real: return fmi2_cosim_real;
+	case fmi2_base_type_int:
+	case fmi2_base_type_enum: return fmi2_cosim_integer;
+	case fmi2_base_type_bool: return fmi2_cosim_boolean;
+	default: return -1;
+	}
+}
+
+static char* fmi2_cosim_trim(char* s) {
+	char* end;
+	while(isspace((unsigned char)*s)) s++;
+	end = s + strlen(s);
+	while((end > s) && isspace((unsigned char)end[-1])) *--end = 0;
+	return s;
+}
+
+static fmi2_cosim_member_t* fmi2_cosim_find_member(fmi2_cosim_t* sim, const char* name, size_t len) {
+	size_t i, n = jm_vector_get_size(jm_voidp)(&sim->members);
+	for(i = 0; i < n; i++) {
+		fmi2_cosim_member_t* m = COSIM_MEMBER(sim, i);
+		if((strlen(m->name) == len) && (strncmp(m->name, name, len) == 0)) return m;
+	}
+	return 0;
+}
+
+/* FMU paths are relative to the directory of the connection file */
+static char* fmi2_cosim_resolve_path(fmi2_cosim_t* sim, const char* path) {
+	const char* file = sim->cdata->FMUPath;
+	size_t dirLen = strlen(file);
+	char* fullPath;
+
+	if((path[0] == '/') || (path[0] == '\\') || (path[0] && (path[1] == ':'))) {
+		return fmu_check_arena_strdup(&sim->cdata->arena, path);
+	}
+	while((dirLen > 0) && (file[dirLen - 1] != '/') && (file[dirLen - 1] != '\\')) dirLen--;
+	fullPath = (char*)fmu_check_arena_alloc(&sim->cdata->arena, dirLen + strlen(path) + 1);
+	if(!fullPath) return 0;
+	memcpy(fullPath, file, dirLen);
+	strcpy(fullPath + dirLen, path);
+	return fullPath;
+}
+
+static jm_status_enu_t fmi2_cosim_read_connections(fmi2_cosim_t* sim) {
+	fmu_check_data_t* cdata = sim->cdata;
+	jm_callbacks* cb = sim->cb;
+	char line[COSIM_LINE_LENGTH];
+	unsigned lineNo = 0;
+	jm_status_enu_t status = jm_status_success;
+	FILE* file = fopen(cdata->FMUPath, "r");
+
+	if(!file) {
+		jm_log_fatal(cb, fmu_checker_module, "Cannot open connection file %s", cdata->FMUPath);
+		return jm_status_error;
+	}
+	while(fgets(line, sizeof(line), file)) {
+		char* s = fmi2_cosim_trim(line);
+		char* arrow;
+		lineNo++;
+		if(!*s || (*s == '#')) continue;
+
+		if((strncmp(s, "fmu", 3) == 0) && isspace((unsigned char)s[3])) {
+			char* name = fmi2_cosim_trim(s + 3);
+			char* path = name;
+			fmi2_cosim_member_t* m;
+
+			while(*path && !isspace((unsigned char)*path)) path++;
+			if(*path) *path++ = 0;
+			path = fmi2_cosim_trim(path);
+			if(!*path || strchr(name, '.')) {
+				jm_log_fatal(cb, fmu_checker_module, "%s:%u: expected 'fmu <name> <path>' with a name without dots", cdata->FMUPath, lineNo);
+				status = jm_status_error;
+				break;
+			}
+			if(fmi2_cosim_find_member(sim, name, strlen(name))) {
+				jm_log_fatal(cb, fmu_checker_module, "%s:%u: FMU name '%s' is used more than once", cdata->FMUPath, lineNo, name);
+				status = jm_status_error;
+				break;
+			}
+			m = (fmi2_cosim_member_t*)fmu_check_arena_calloc(&cdata->arena, 1, sizeof(fmi2_cosim_member_t));
+			if(!m || !jm_vector_push_back(jm_voidp)(&sim->members, m)) {
+				jm_log_fatal(cb, fmu_checker_module, "Could not allocate memory");
+				status = jm_status_error;
+				break;
+			}
+			init_fmu_check_child_data(&m->cdata, cdata);
+			m->name = fmu_check_arena_strdup(&cdata->arena, name);
+			m->index = jm_vector_get_size(jm_voidp)(&sim->members) - 1;
+			m->cdata.FMUPath = fmi2_cosim_resolve_path(sim, path);
+			m->stepStatus = fmi2_status_ok;
+			if(!m->name || !m->cdata.FMUPath) {
+				jm_log_fatal(cb, fmu_checker_module, "Could not allocate memory");
+				status = jm_status_error;
+				break;
+			}
+		}
+		else if((arrow = strstr(s, "->")) != 0) {
+			fmi2_cosim_connection_t* c = (fmi2_cosim_connection_t*)fmu_check_arena_calloc(&cdata->arena, 1, sizeof(fmi2_cosim_connection_t));
+			*arrow = 0;
+			if(!c || !jm_vector_push_back(jm_voidp)(&sim->connections, c)
+				|| !(c->from = fmu_check_arena_strdup(&cdata->arena, fmi2_cosim_trim(s)))
+				|| !(c->to = fmu_check_arena_strdup(&cdata->arena, fmi2_cosim_trim(arrow + 2)))) {
+				jm_log_fatal(cb, fmu_checker_module, "Could not allocate memory");
+				status = jm_status_error;
+				break;
+			}
+			c->line = lineNo;
+		}
+		else {
+			jm_log_fatal(cb, fmu_checker_module, "%s:%u: expected 'fmu <name> <path>' or '<name>.<output> -> <name>.<input>'", cdata->FMUPath, lineNo);
+			status = jm_status_error;
+			break;
+		}
+	}
+	fclose(file);
+
+	if((status == jm_status_success) && !jm_vector_get_size(jm_voidp)(&sim->members)) {
+		jm_log_fatal(cb, fmu_checker_module, "No FMUs are declared in %s", cdata->FMUPath);
+		status = jm_status_error;
+	}
+	return status;
+}
+
+/* Unpack the FMU, parse the XML and load the CS binary */
+static jm_status_enu_t fmi2_cosim_load_member(fmi2_cosim_t* sim, fmi2_cosim_member_t* m) {
+	fmu_check_data_t* cdata = &m->cdata;
+	jm_callbacks* cb = &cdata->callbacks;
+
+	jm_log_info(cb, fmu_checker_module, "Loading FMU %s from %s", m->name, cdata->FMUPath);
+	cdata->tmpPath = fmi_import_mk_temp_dir(cb, cdata->temp_dir, "fmucktmp");
+	if(!cdata->tmpPath) return jm_status_error;
+
+	cdata->context = fmi_import_allocate_context(cb);
+	if(!cdata->context) return jm_status_error;
+	fmi_import_set_configuration(cdata->context, FMI_IMPORT_NAME_CHECK);
+
+	cdata->version = fmi_import_get_fmi_version(cdata->context, cdata->FMUPath, cdata->tmpPath);
+	if(cdata->version != fmi_version_2_0_enu) {
+		jm_log_fatal(cb, fmu_checker_module, "FMU %s: only FMI 2.0 FMUs are supported in co-simulation mode", m->name);
+		return jm_status_error;
+	}
+	if(fmi2_check_parse_xml(cdata) != jm_status_success) {
+		return jm_status_error;
+	}
+	if((cdata->fmu2_kind & fmi2_fmu_kind_cs) == 0) {
+		jm_log_fatal(cb, fmu_checker_module, "FMU %s does not support co-simulation", m->name);
+		return jm_status_error;
+	}
+	return fmi2_check_load_dll(cdata, fmi2_fmu_kind_cs);
+}
+
+static int fmi2_cosim_alloc_ports(fmi2_cosim_t* sim, fmi2_cosim_ports_t* p, int type, size_t size, int withLinks) {
+	fmu_check_arena_t* arena = &sim->cdata->arena;
+	p->size = 0;
+	if(!size) return 1;
+	p->vars = (fmi2_import_variable_t**)fmu_check_arena_calloc(arena, size, sizeof(fmi2_import_variable_t*));
+	p->vr = (fmi2_value_reference_t*)fmu_check_arena_calloc(arena, size, sizeof(fmi2_value_reference_t));
+	p->values = fmu_check_arena_calloc(arena, size, fmi2_cosim_type_size[type]);
+	if(withLinks) {
+		p->links = (fmi2_cosim_link_t*)fmu_check_arena_calloc(arena, size, sizeof(fmi2_cosim_link_t));
+	}
+	return p->vars && p->vr && p->values && (!withLinks || p->links);
+}
+
+/* All outputs are read after each step. They are used both for the connections and the result file. */
+static jm_status_enu_t fmi2_cosim_setup_outputs(fmi2_cosim_t* sim, fmi2_cosim_member_t* m) {
+	fmi2_import_variable_list_t* vl = m->cdata.vl2;
+	size_t i, n = fmi2_import_get_variable_list_size(vl);
+	size_t count[fmi2_cosim_num_types];
+	int t;
+
+	for(t = 0; t < fmi2_cosim_num_types; t++) count[t] = 0;
+	for(i = 0; i < n; i++) {
+		fmi2_import_variable_t* v = fmi2_import_get_variable(vl, i);
+		if(fmi2_import_get_causality(v) != fmi2_causality_enu_output) continue;
+		t = fmi2_cosim_get_type(v);
+		if(t < 0) {
+			jm_log_warning(sim->cb, fmu_checker_module, "FMU %s: string output %s is not exchanged or saved in co-simulation mode",
+				m->name, fmi2_import_get_variable_name(v));
+			continue;
+		}
+		count[t]++;
+	}
+	for(t = 0; t < fmi2_cosim_num_types; t++) {
+		if(!fmi2_cosim_alloc_ports(sim, &m->outputs[t], t, count[t], 0)) {
+			jm_log_fatal(sim->cb, fmu_checker_module, "Could not allocate memory");
+			return jm_status_error;
+		}
+	}
+	for(i = 0; i < n; i++) {
+		fmi2_import_variable_t* v = fmi2_import_get_variable(vl, i);
+		fmi2_cosim_ports_t* p;
+		if(fmi2_import_get_causality(v) != fmi2_causality_enu_output) continue;
+		t = fmi2_cosim_get_type(v);
+		if(t < 0) continue;
+		p = &m->outputs[t];
+		p->vars[p->size] = v;
+		p->vr[p->size] = fmi2_import_get_variable_vr(v);
+		p->size++;
+	}
+	return jm_status_success;
+}
+
+/* Find the FMU and the variable for a '<name>.<variable>' reference */
+static fmi2_import_variable_t* fmi2_cosim_find_variable(fmi2_cosim_t* sim, fmi2_cosim_connection_t* c, const char* ref, fmi2_cosim_member_t** m) {
+	const char* dot = strchr(ref, '.');
+	fmi2_import_variable_t* v;
+
+	*m = dot ? fmi2_cosim_find_member(sim, ref, dot - ref) : 0;
+	if(!*m) {
+		jm_log_fatal(sim->cb, fmu_checker_module, "%s:%u: '%s' does not refer to a declared FMU (expected <name>.<variable>)",
+			sim->cdata->FMUPath, c->line, ref);
+		return 0;
+	}
+	v = fmi2_import_get_variable_by_name((*m)->cdata.fmu2, dot + 1);
+	if(!v) {
+		jm_log_fatal(sim->cb, fmu_checker_module, "%s:%u: FMU %s has no variable named '%s'",
+			sim->cdata->FMUPath, c->line, (*m)->name, dot + 1);
+	}
+	return v;
+}
+
+static jm_status_enu_t fmi2_cosim_setup_connections(fmi2_cosim_t* sim) {
+	size_t i, j, n = jm_vector_get_size(jm_voidp)(&sim->connections);
+	size_t numMembers = jm_vector_get_size(jm_voidp)(&sim->members);
+	int t;
+
+	for(i = 0; i < n; i++) {
+		fmi2_cosim_connection_t* c = COSIM_CONNECTION(sim, i);
+		fmi2_import_variable_t* from = fmi2_cosim_find_variable(sim, c, c->from, &c->source);
+		fmi2_import_variable_t* to = from ? fmi2_cosim_find_variable(sim, c, c->to, &c->target) : 0;
+		fmi2_cosim_ports_t* p;
+
+		if(!from || !to) return jm_status_error;
+		if(fmi2_import_get_causality(from) != fmi2_causality_enu_output) {
+			jm_log_fatal(sim->cb, fmu_checker_module, "%s:%u: %s is not an output", sim->cdata->FMUPath, c->line, c->from);
+			return jm_status_error;
+		}
+		if(fmi2_import_get_causality(to) != fmi2_causality_enu_input) {
+			jm_log_fatal(sim->cb, fmu_checker_module, "%s:%u: %s is not an input", sim->cdata->FMUPath, c->line, c->to);
+			return jm_status_error;
+		}
+		t = fmi2_cosim_get_type(from);
+		if((t < 0) || (t != fmi2_cosim_get_type(to))) {
+			jm_log_fatal(sim->cb, fmu_checker_module, "%s:%u: cannot connect %s to %s, the types do not match or are not supported",
+				sim->cdata->FMUPath, c->line, c->from, c->to);
+			return jm_status_error;
+		}
+		for(j = 0; j < i; j++) {
+			fmi2_cosim_connection_t* other = COSIM_CONNECTION(sim, j);
+			if((other->target == c->target) && (other->targetVar == to)) {
+				jm_log_fatal(sim->cb, fmu_checker_module, "%s:%u: input %s is already connected on line %u",
+					sim->cdata->FMUPath, c->line, c->to, other->line);
+				return jm_status_error;
+			}
+		}
+		p = &c->source->outputs[t];
+		for(j = 0; p->vars[j] != from; j++);
+		c->sourceIndex = j;
+		c->targetVar = to;
+		c->type = (fmi2_cosim_type_enu_t)t;
+		/* count the inputs, the arrays are allocated below */
+		c->target->inputs[t].size++;
+	}
+
+	for(i = 0; i < numMembers; i++) {
+		fmi2_cosim_member_t* m = COSIM_MEMBER(sim, i);
+		for(t = 0; t < fmi2_cosim_num_types; t++) {
+			if(!fmi2_cosim_alloc_ports(sim, &m->inputs[t], t, m->inputs[t].size, 1)) {
+				jm_log_fatal(sim->cb, fmu_checker_module, "Could not allocate memory");
+				return jm_status_error;
+			}
+		}
+	}
+	for(i = 0; i < n; i++) {
+		fmi2_cosim_connection_t* c = COSIM_CONNECTION(sim, i);
+		fmi2_cosim_ports_t* p = &c->target->inputs[c->type];
+		p->vars[p->size] = c->targetVar;
+		p->vr[p->size] = fmi2_import_get_variable_vr(c->targetVar);
+		p->links[p->size].source = c->source;
+		p->links[p->size].index = c->sourceIndex;
+		p->size++;
+	}
+	return jm_status_success;
+}
+
+/** State of Tarjan's algorithm on the connection graph. Members are identified by their index. */
+typedef struct fmi2_cosim_tarjan_t {
+	/** Targets of the connections from member i are edges[edgeStart[i]] to edges[edgeStart[i+1]-1] */
+	size_t* edgeStart;
+	size_t* edges;
+	/** Visiting order starting from 1 (0 if not visited yet) and the lowest one reachable */
+	size_t* index;
+	size_t* lowLink;
+	size_t* stack;
+	size_t stackSize;
+	int* onStack;
+	size_t nextIndex;
+	/** Component of each member. Components are numbered in reverse topological order. */
+	size_t* component;
+	size_t numComponents;
+} fmi2_cosim_tarjan_t;
+
+static void fmi2_cosim_strong_connect(fmi2_cosim_tarjan_t* t, size_t v) {
+	size_t e, w;
+
+	t->index[v] = t->lowLink[v] = ++t->nextIndex;
+	t->stack[t->stackSize++] = v;
+	t->onStack[v] = 1;
+	for(e = t->edgeStart[v]; e < t->edgeStart[v + 1]; e++) {
+		w = t->edges[e];
+		if(!t->index[w]) {
+			fmi2_cosim_strong_connect(t, w);
+			if(t->lowLink[w] < t->lowLink[v]) t->lowLink[v] = t->lowLink[w];
+		}
+		else if(t->onStack[w] && (t->index[w] < t->lowLink[v])) {
+			t->lowLink[v] = t->index[w];
+		}
+	}
+	if(t->lowLink[v] == t->index[v]) {
+		do {
+			w = t->stack[--t->stackSize];
+			t->onStack[w] = 0;
+			t->component[w] = t->numComponents;
+		} while(w != v);
+		t->numComponents++;
+	}
+}
+
+/* Sort the FMUs into levels. The strongly connected components of the connection graph
+   (Tarjan's algorithm) are placed on the level after the highest level of the components
+   they depend on. FMUs in a connection loop thereby share a level and get their inputs
+   from each other from the previous communication step. */
+static jm_status_enu_t fmi2_cosim_setup_levels(fmi2_cosim_t* sim) {
+	fmu_check_arena_t* arena = &sim->cdata->arena;
+	size_t numMembers = jm_vector_get_size(jm_voidp)(&sim->members);
+	size_t numConnections = jm_vector_get_size(jm_voidp)(&sim->connections);
+	fmi2_cosim_tarjan_t t;
+	size_t *componentLevel, *componentSize;
+	size_t i, c, e, k;
+
+	memset(&t, 0, sizeof(t));
+	t.edgeStart = (size_t*)fmu_check_arena_calloc(arena, numMembers + 1, sizeof(size_t));
+	t.edges = (size_t*)fmu_check_arena_calloc(arena, numConnections + 1, sizeof(size_t));
+	t.index = (size_t*)fmu_check_arena_calloc(arena, numMembers, sizeof(size_t));
+	t.lowLink = (size_t*)fmu_check_arena_calloc(arena, numMembers, sizeof(size_t));
+	t.stack = (size_t*)fmu_check_arena_calloc(arena, numMembers, sizeof(size_t));
+	t.onStack = (int*)fmu_check_arena_calloc(arena, numMembers, sizeof(int));
+	t.component = (size_t*)fmu_check_arena_calloc(arena, numMembers, sizeof(size_t));
+	componentLevel = (size_t*)fmu_check_arena_calloc(arena, numMembers, sizeof(size_t));
+	componentSize = (size_t*)fmu_check_arena_calloc(arena, numMembers, sizeof(size_t));
+	sim->order = (fmi2_cosim_member_t**)fmu_check_arena_calloc(arena, numMembers, sizeof(fmi2_cosim_member_t*));
+	sim->levelStart = (size_t*)fmu_check_arena_calloc(arena, numMembers + 1, sizeof(size_t));
+	if(!t.edgeStart || !t.edges || !t.index || !t.lowLink || !t.stack || !t.onStack || !t.component
+		|| !componentLevel || !componentSize || !sim->order || !sim->levelStart) {
+		jm_log_fatal(sim->cb, fmu_checker_module, "Could not allocate memory");
+		return jm_status_error;
+	}
+
+	/* connections grouped by the source. An FMU connected to itself does not depend on another FMU. */
+	for(i = 0; i < numConnections; i++) {
+		fmi2_cosim_connection_t* conn = COSIM_CONNECTION(sim, i);
+		if(conn->source != conn->target) t.edgeStart[conn->source->index + 1]++;
+	}
+	for(i = 0; i < numMembers; i++) t.edgeStart[i + 1] += t.edgeStart[i];
+	for(i = 0; i < numConnections; i++) {
+		fmi2_cosim_connection_t* conn = COSIM_CONNECTION(sim, i);
+		if(conn->source != conn->target) t.edges[t.edgeStart[conn->source->index]++] = conn->target->index;
+	}
+	for(i = numMembers; i > 0; i--) t.edgeStart[i] = t.edgeStart[i - 1];
+	t.edgeStart[0] = 0;
+
+	for(i = 0; i < numMembers; i++) {
+		if(!t.index[i]) fmi2_cosim_strong_connect(&t, i);
+	}
+
+	/* visit the components in topological order and push the levels downstream */
+	sim->numLevels = 0;
+	for(c = t.numComponents; c > 0; c--) {
+		for(i = 0; i < numMembers; i++) {
+			if(t.component[i] != c - 1) continue;
+			componentSize[c - 1]++;
+			for(e = t.edgeStart[i]; e < t.edgeStart[i + 1]; e++) {
+				size_t target = t.component[t.edges[e]];
+				if((target != c - 1) && (componentLevel[target] < componentLevel[c - 1] + 1)) {
+					componentLevel[target] = componentLevel[c - 1] + 1;
+				}
+			}
+		}
+		if(componentLevel[c - 1] + 1 > sim->numLevels) sim->numLevels = componentLevel[c - 1] + 1;
+		if(componentSize[c - 1] > 1) {
+			jm_log_verbose(sim->cb, fmu_checker_module,
+				"Connection loop: %u FMU(s) on level %u are stepped together with inputs from the previous communication step",
+				(unsigned)componentSize[c - 1], (unsigned)componentLevel[c - 1]);
+		}
+	}
+
+	/* members sorted by level, in the order of declaration within a level */
+	for(i = 0; i < numMembers; i++) {
+		fmi2_cosim_member_t* m = COSIM_MEMBER(sim, i);
+		m->level = componentLevel[t.component[i]];
+		sim->levelStart[m->level + 1]++;
+	}
+	for(k = 0; k < sim->numLevels; k++) sim->levelStart[k + 1] += sim->levelStart[k];
+	for(i = 0; i < numMembers; i++) {
+		fmi2_cosim_member_t* m = COSIM_MEMBER(sim, i);
+		sim->order[sim->levelStart[m->level]++] = m;
+	}
+	for(k = sim->numLevels; k > 0; k--) sim->levelStart[k] = sim->levelStart[k - 1];
+	sim->levelStart[0] = 0;
+
+	for(k = 0; k < numMembers; k++) {
+		jm_log_verbose(sim->cb, fmu_checker_module, "FMU %s is stepped on level %u",
+			sim->order[k]->name, (unsigned)sim->order[k]->level);
+	}
+	return jm_status_success;
+}
+
+static fmi2_status_t fmi2_cosim_get_outputs(fmi2_cosim_member_t* m) {
+	fmi2_import_t* fmu = m->cdata.fmu2;
+	fmi2_cosim_ports_t* p = m->outputs;
+	fmi2_status_t status = fmi2_status_ok, s;
+
+	if(p[fmi2_cosim_real].size) {
+		s = fmi2_import_get_real(fmu, p[fmi2_cosim_real].vr, p[fmi2_cosim_real].size, (fmi2_real_t*)p[fmi2_cosim_real].values);
+		if(s > status) status = s;
+	}
+	if(p[fmi2_cosim_integer].size) {
+		s = fmi2_import_get_integer(fmu, p[fmi2_cosim_integer].vr, p[fmi2_cosim_integer].size, (fmi2_integer_t*)p[fmi2_cosim_integer].values);
+		if(s > status) status = s;
+	}
+	if(p[fmi2_cosim_boolean].size) {
+		s = fmi2_import_get_boolean(fmu, p[fmi2_cosim_boolean].vr, p[fmi2_cosim_boolean].size, (fmi2_boolean_t*)p[fmi2_cosim_boolean].values);
+		if(s > status) status = s;
+	}
+	return status;
+}
+
+static fmi2_status_t fmi2_cosim_set_inputs(fmi2_cosim_member_t* m) {
+	fmi2_import_t* fmu = m->cdata.fmu2;
+	fmi2_cosim_ports_t* p = m->inputs;
+	fmi2_status_t status = fmi2_status_ok, s;
+
+	if(p[fmi2_cosim_real].size) {
+		s = fmi2_import_set_real(fmu, p[fmi2_cosim_real].vr, p[fmi2_cosim_real].size, (fmi2_real_t*)p[fmi2_cosim_real].values);
+		if(s > status) status = s;
+	}
+	if(p[fmi2_cosim_integer].size) {
+		s = fmi2_import_set_integer(fmu, p[fmi2_cosim_integer].vr, p[fmi2_cosim_integer].size, (fmi2_integer_t*)p[fmi2_cosim_integer].values);
+		if(s > status) status = s;
+	}
+	if(p[fmi2_cosim_boolean].size) {
+		s = fmi2_import_set_boolean(fmu, p[fmi2_cosim_boolean].vr, p[fmi2_cosim_boolean].size, (fmi2_boolean_t*)p[fmi2_cosim_boolean].values);
+		if(s > status) status = s;
+	}
+	return status;
+}
+
+/* Copy the current output values of the sources into the input buffers */
+static void fmi2_cosim_gather_inputs(fmi2_cosim_member_t* m) {
+	fmi2_cosim_ports_t* p = &m->inputs[fmi2_cosim_real];
+	size_t k;
+	for(k = 0; k < p->size; k++) {
+		((fmi2_real_t*)p->values)[k] = ((fmi2_real_t*)p->links[k].source->outputs[fmi2_cosim_real].values)[p->links[k].index];
+	}
+	p = &m->inputs[fmi2_cosim_integer];
+	for(k = 0; k < p->size; k++) {
+		((fmi2_integer_t*)p->values)[k] = ((fmi2_integer_t*)p->links[k].source->outputs[fmi2_cosim_integer].values)[p->links[k].index];
+	}
+	p = &m->inputs[fmi2_cosim_boolean];
+	for(k = 0; k < p->size; k++) {
+		((fmi2_boolean_t*)p->values)[k] = ((fmi2_boolean_t*)p->links[k].source->outputs[fmi2_cosim_boolean].values)[p->links[k].index];
+	}
+}
+
+/* Thread pool task: set inputs, step and get outputs of one FMU on the current level */
+static void fmi2_cosim_step_task(void* data, size_t index) {
+	fmi2_cosim_t* sim = (fmi2_cosim_t*)data;
+	fmi2_cosim_member_t* m = sim->order[sim->levelStart[sim->level] + index];
+	double start = fmu_check_wall_clock(), elapsed;
+	fmi2_status_t status;
+
+	m->stepFunction = "fmi2SetXXX";
+	fmu_check_watch(&m->cdata, m->stepFunction, sim->tcur);
+	status = fmi2_cosim_set_inputs(m);
+	if(fmi2_status_ok_or_warning(status)) {
+		m->stepFunction = "fmi2DoStep";
+		fmu_check_watch(&m->cdata, m->stepFunction, sim->tcur);
+		status = fmi2_import_do_step(m->cdata.fmu2, sim->tcur, sim->hstep, fmi2_true);
+	}
+	if(fmi2_status_ok_or_warning(status)) {
+		m->stepFunction = "fmi2GetXXX";
+		fmu_check_watch(&m->cdata, m->stepFunction, sim->tcur);
+		status = fmi2_cosim_get_outputs(m);
+	}
+	fmu_check_watch_end(&m->cdata);
+	m->stepStatus = status;
+
+	elapsed = fmu_check_wall_clock() - start;
+	m->stepTime += elapsed;
+	if(elapsed > m->maxStepTime) m->maxStepTime = elapsed;
+}
+
+static jm_status_enu_t fmi2_cosim_write_header(fmi2_cosim_t* sim) {
+	fmu_check_data_t* cdata = sim->cdata;
+	size_t i, k, n = jm_vector_get_size(jm_voidp)(&sim->members);
+	char buf[COSIM_LINE_LENGTH];
+	int t;
+
+	if(checked_fprintf(cdata, cdata->do_mangle_var_names ? "time" : "\"time\"") != jm_status_success) {
+		return jm_status_error;
+	}
+	for(i = 0; i < n; i++) {
+		fmi2_cosim_member_t* m = COSIM_MEMBER(sim, i);
+		for(t = 0; t < fmi2_cosim_num_types; t++) {
+			for(k = 0; k < m->outputs[t].size; k++) {
+				jm_snprintf(buf, sizeof(buf), "%s.%s", m->name, fmi2_import_get_variable_name(m->outputs[t].vars[k]));
+				if(check_fprintf_var_name(cdata, buf) != jm_status_success) {
+					return jm_status_error;
+				}
+			}
+		}
+	}
+	return checked_fprintf(cdata, "\r\n");
+}
+
+static jm_status_enu_t fmi2_cosim_write_data(fmi2_cosim_t* sim, double time) {
+	fmu_check_data_t* cdata = sim->cdata;
+	size_t i, k, n = jm_vector_get_size(jm_voidp)(&sim->members);
+	char sep = cdata->CSV_separator;
+
+	if(!check_output_time(cdata, time)) {
+		return jm_status_success;
+	}
+	if(checked_fprintf(cdata, "%.16E", time) != jm_status_success) {
+		return jm_status_error;
+	}
+	for(i = 0; i < n; i++) {
+		fmi2_cosim_member_t* m = COSIM_MEMBER(sim, i);
+		fmi2_cosim_ports_t* p = &m->outputs[fmi2_cosim_real];
+		for(k = 0; k < p->size; k++) {
+			if(checked_fprintf(cdata, "%c%.16E", sep, ((fmi2_real_t*)p->values)[k]) != jm_status_success) return jm_status_error;
+		}
+		p = &m->outputs[fmi2_cosim_integer];
+		for(k = 0; k < p->size; k++) {
+			if(checked_fprintf(cdata, "%c%d", sep, ((fmi2_integer_t*)p->values)[k]) != jm_status_success) return jm_status_error;
+		}
+		p = &m->outputs[fmi2_cosim_boolean];
+		for(k = 0; k < p->size; k++) {
+			if(checked_fprintf(cdata, "%c%d", sep, ((fmi2_boolean_t*)p->values)[k] ? 1 : 0) != jm_status_success) return jm_status_error;
+		}
+	}
+	return checked_fprintf(cdata, "\r\n");
+}
+
+/* Instantiate and initialize all FMUs. Start values of the outputs are propagated to the connected inputs. */
+static jm_status_enu_t fmi2_cosim_initialize(fmi2_cosim_t* sim, fmi2_real_t tstart) {
+	size_t i, n = jm_vector_get_size(jm_voidp)(&sim->members);
+	fmi2_status_t fmistatus;
+
+	for(i = 0; i < n; i++) {
+		fmi2_cosim_member_t* m = COSIM_MEMBER(sim, i);
+		fmi2_import_t* fmu = m->cdata.fmu2;
+
+		m->cdata.instanceNameToCompare = m->name;
+		m->cdata.instanceNameSavedPtr = 0;
+		fmu_check_watch(&m->cdata, "fmi2Instantiate", tstart);
+		if(fmi2_import_instantiate(fmu, m->name, fmi2_cosimulation, 0, fmi2_false) == jm_status_error) {
+			fmu_check_watch_end(&m->cdata);
+			jm_log_fatal(sim->cb, fmu_checker_module, "Could not instantiate FMU %s", m->name);
+			return jm_status_error;
+		}
+		m->cdata.instanceNameSavedPtr = m->name;
+		m->instantiated = 1;
+		fmu_check_watch_end(&m->cdata);
+
+		fmu_check_watch(&m->cdata, "fmi2SetupExperiment/fmi2EnterInitializationMode", tstart);
+		if(!fmi2_status_ok_or_warning(fmistatus = fmi2_import_setup_experiment(fmu, fmi2_false,
+				fmi2_import_get_default_experiment_tolerance(fmu), tstart, fmi2_false, 0.0)) ||
+			!fmi2_status_ok_or_warning(fmistatus = fmi2_import_enter_initialization_mode(fmu))) {
+			fmu_check_watch_end(&m->cdata);
+			jm_log_fatal(sim->cb, fmu_checker_module, "Failed to initialize FMU %s (FMU status: %s)", m->name, fmi2_status_to_string(fmistatus));
+			m->stepStatus = fmistatus;
+			return jm_status_error;
+		}
+		fmu_check_watch_end(&m->cdata);
+	}
+	for(i = 0; i < n; i++) {
+		fmi2_cosim_member_t* m = COSIM_MEMBER(sim, i);
+		if(!fmi2_status_ok_or_warning(fmistatus = fmi2_cosim_get_outputs(m))) {
+			jm_log_fatal(sim->cb, fmu_checker_module, "Could not get start values of the outputs of FMU %s (FMU status: %s)", m->name, fmi2_status_to_string(fmistatus));
+			return jm_status_error;
+		}
+	}
+	for(i = 0; i < n; i++) {
+		fmi2_cosim_member_t* m = COSIM_MEMBER(sim, i);
+		fmi2_cosim_gather_inputs(m);
+		fmu_check_watch(&m->cdata, "fmi2ExitInitializationMode", tstart);
+		if(!fmi2_status_ok_or_warning(fmistatus = fmi2_cosim_set_inputs(m)) ||
+			!fmi2_status_ok_or_warning(fmistatus = fmi2_import_exit_initialization_mode(m->cdata.fmu2)) ||
+			!fmi2_status_ok_or_warning(fmistatus = fmi2_cosim_get_outputs(m))) {
+			fmu_check_watch_end(&m->cdata);
+			jm_log_fatal(sim->cb, fmu_checker_module, "Failed to initialize FMU %s (FMU status: %s)", m->name, fmi2_status_to_string(fmistatus));
+			m->stepStatus = fmistatus;
+			return jm_status_error;
+		}
+		fmu_check_watch_end(&m->cdata);
+	}
+	return jm_status_success;
+}
+
+static jm_status_enu_t fmi2_cosim_simulate(fmi2_cosim_t* sim) {
+	fmu_check_data_t* cdata = sim->cdata;
+	jm_callbacks* cb = sim->cb;
+	size_t i, l, n = jm_vector_get_size(jm_voidp)(&sim->members);
+	fmi2_import_t* fmu0 = COSIM_MEMBER(sim, 0)->cdata.fmu2;
+	fmi2_real_t tstart = fmi2_import_get_default_experiment_start(fmu0);
+	fmi2_real_t tend = fmi2_import_get_default_experiment_stop(fmu0);
+	fmi2_boolean_t canHandleVarStepSize = fmi2_true;
+	jm_status_enu_t jmstatus;
+	size_t numThreads = cdata->num_threads ? cdata->num_threads : fmu_check_get_num_cpus();
+	size_t maxLevelSize = 0, numSteps = 0;
+	int terminated = 0, sameExperiment = 1;
+	double wallStart, wallTime;
+
+	/* the FMUs are simulated where all their default experiments are defined */
+	for(i = 1; i < n; i++) {
+		fmi2_import_t* fmu = COSIM_MEMBER(sim, i)->cdata.fmu2;
+		fmi2_real_t start = fmi2_import_get_default_experiment_start(fmu);
+		fmi2_real_t stop = fmi2_import_get_default_experiment_stop(fmu);
+		if((start != tstart) || (stop != tend)) sameExperiment = 0;
+		if(start > tstart) tstart = start;
+		if(stop < tend) tend = stop;
+	}
+	if(!sameExperiment) {
+		jm_log_warning(cb, fmu_checker_module, "The default experiments of the FMUs differ. Using the common time range from %g to %g.", tstart, tend);
+	}
+	prepare_time_step_info(cdata, &tend, &sim->hstep);
+	if(tend <= tstart) {
+		jm_log_fatal(cb, fmu_checker_module, "Co-simulation stop time %g is not after the start time %g", tend, tstart);
+		return jm_status_error;
+	}
+	sim->tcur = tstart;
+
+	for(i = 0; i < n; i++) {
+		if(!fmi2_import_get_capability(COSIM_MEMBER(sim, i)->cdata.fmu2, fmi2_cs_canHandleVariableCommunicationStepSize))
+			canHandleVarStepSize = fmi2_false;
+	}
+	for(l = 0; l < sim->numLevels; l++) {
+		size_t size = sim->levelStart[l + 1] - sim->levelStart[l];
+		if(size > maxLevelSize) maxLevelSize = size;
+	}
+	if(numThreads > maxLevelSize) numThreads = maxLevelSize;
+
+	jmstatus = fmi2_cosim_initialize(sim, tstart);
+	if(jmstatus != jm_status_error) {
+		jm_log_info(cb, fmu_checker_module, "Initialized %u FMU(s) for co-simulation starting at time %g", (unsigned)n, tstart);
+		if((fmi2_cosim_write_header(sim) != jm_status_success) || (fmi2_cosim_write_data(sim, tstart) != jm_status_success)) {
+			jmstatus = jm_status_error;
+		}
+	}
+	if(jmstatus != jm_status_error) {
+		sim->pool = fmu_check_thread_pool_create(cb, numThreads);
+		if(!sim->pool) {
+			jm_log_fatal(cb, fmu_checker_module, "Could not create the thread pool");
+			jmstatus = jm_status_error;
+		}
+	}
+
+	wallStart = fmu_check_wall_clock();
+	while((sim->tcur < tend) && (jmstatus != jm_status_error) && !terminated) {
+		fmi2_real_t tnext = sim->tcur + sim->hstep;
+		if(tnext > tend - 1e-3*sim->hstep) { /* last step should be on tend */
+			if (canHandleVarStepSize) {
+				sim->hstep = tend - sim->tcur;
+				tnext = tend;
+			}
+			else {
+				jm_log_warning(cb,fmu_checker_module, "Not all FMUs support variable communication stepsize. Stepsize may not be altered to reach stopTime exactly.");
+			}
+		}
+		jm_log_verbose(cb, fmu_checker_module, "Co-simulation step from time: %g until: %g", sim->tcur, tnext);
+
+		for(l = 0; (l < sim->numLevels) && (jmstatus != jm_status_error); l++) {
+			size_t first = sim->levelStart[l], size = sim->levelStart[l + 1] - first;
+			for(i = 0; i < size; i++) {
+				fmi2_cosim_gather_inputs(sim->order[first + i]);
+			}
+			sim->level = l;
+			fmu_check_thread_pool_run(sim->pool, fmi2_cosim_step_task, sim, size);
+
+			for(i = 0; i < size; i++) {
+				fmi2_cosim_member_t* m = sim->order[first + i];
+				fmi2_boolean_t bstatus = fmi2_false;
+				if(fmi2_status_ok_or_warning(m->stepStatus)) continue;
+				if((m->stepStatus == fmi2_status_discard)
+					&& fmi2_status_ok_or_warning(fmi2_import_get_boolean_status(m->cdata.fmu2, fmi2_terminated, &bstatus))
+					&& bstatus) {
+					jm_log_info(cb, fmu_checker_module, "FMU %s requests to terminate simulation at time %g", m->name, tnext);
+					m->stepStatus = fmi2_status_ok;
+					terminated = 1;
+				}
+				else {
+					jm_log_fatal(cb, fmu_checker_module, "Co-simulation terminated at time %g since %s returned status %s for FMU %s",
+						sim->tcur, m->stepFunction, fmi2_status_to_string(m->stepStatus), m->name);
+					jmstatus = jm_status_error;
+				}
+			}
+		}
+		if(jmstatus == jm_status_error) break;
+		numSteps++;
+		sim->tcur = tnext;
+		if(fmi2_cosim_write_data(sim, sim->tcur) != jm_status_success) {
+			jmstatus = jm_status_error;
+		}
+	}
+	wallTime = fmu_check_wall_clock() - wallStart;
+
+	if(jmstatus != jm_status_error) {
+		jm_log_info(cb, fmu_checker_module, "Co-simulation finished successfully at time %g", sim->tcur);
+	}
+	if(sim->pool) {
+		jm_log_info(cb, fmu_checker_module, "%u communication step(s) with %u FMU(s) on %u level(s) using %u thread(s) took %g s",
+			(unsigned)numSteps, (unsigned)n, (unsigned)sim->numLevels, (unsigned)fmu_check_thread_pool_size(sim->pool), wallTime);
+		for(i = 0; i < n; i++) {
+			fmi2_cosim_member_t* m = COSIM_MEMBER(sim, i);
+			jm_log_info(cb, fmu_checker_module, "FMU %s: %g s stepping (%g s per step on average, %g s max)",
+				m->name, m->stepTime, numSteps ? m->stepTime / numSteps : 0.0, m->maxStepTime);
+		}
+		fmu_check_thread_pool_free(sim->pool);
+		sim->pool = 0;
+	}
+
+	for(i = 0; i < n; i++) {
+		fmi2_cosim_member_t* m = COSIM_MEMBER(sim, i);
+		fmi2_status_t fmistatus;
+		if(!m->instantiated || (m->stepStatus == fmi2_status_fatal)) continue;
+		fmu_check_watch(&m->cdata, "fmi2Terminate", sim->tcur);
+		fmistatus = fmi2_import_terminate(m->cdata.fmu2);
+		fmu_check_watch_end(&m->cdata);
+		if(!fmi2_status_ok_or_warning(fmistatus)) {
+			jm_log_error(cb, fmu_checker_module, "fmi2Terminate returned status: %s for FMU %s", fmi2_status_to_string(fmistatus), m->name);
+		}
+		if(fmistatus != fmi2_status_fatal) {
+			fmi2_import_free_instance(m->cdata.fmu2);
+		}
+		m->instantiated = 0;
+	}
+	return jmstatus;
+}
+
+jm_status_enu_t fmi2_cosim_check(fmu_check_data_t* cdata) {
+	fmi2_cosim_t sim;
+	jm_callbacks* cb = &cdata->callbacks;
+	jm_status_enu_t status;
+	size_t i, n;
+
+	memset(&sim, 0, sizeof(sim));
+	sim.cdata = cdata;
+	sim.cb = cb;
+	jm_vector_init(jm_voidp)(&sim.members, 0, cb);
+	jm_vector_init(jm_voidp)(&sim.connections, 0, cb);
+
+	status = fmi2_cosim_read_connections(&sim);
+	n = jm_vector_get_size(jm_voidp)(&sim.members);
+
+	if(status == jm_status_success) {
+		/* lets the FMU logger find the checker data from the component environment */
+		cdata->instance_data = (fmu_check_data_t**)fmu_check_arena_calloc(&cdata->arena, n, sizeof(fmu_check_data_t*));
+		if(!cdata->instance_data) {
+			jm_log_fatal(cb, fmu_checker_module, "Could not allocate memory");
+			status = jm_status_error;
+		}
+		for(i = 0; (i < n) && (status == jm_status_success); i++) {
+			fmi2_cosim_member_t* m = COSIM_MEMBER(&sim, i);
+			cdata->instance_data[i] = &m->cdata;
+			cdata->num_instance_data = i + 1;
+			status = fmi2_cosim_load_member(&sim, m);
+			if(status == jm_status_success) {
+				status = fmi2_cosim_setup_outputs(&sim, m);
+			}
+		}
+	}
+	if(status == jm_status_success) {
+		jm_log_info(cb, fmu_checker_module, "Connecting %u FMU(s) with %u connection(s)",
+			(unsigned)n, (unsigned)jm_vector_get_size(jm_voidp)(&sim.connections));
+		status = fmi2_cosim_setup_connections(&sim);
+	}
+	if(status == jm_status_success) {
+		status = fmi2_cosim_setup_levels(&sim);
+	}
+	if(status == jm_status_success && cdata->do_simulate_flg) {
+		status = fmi2_cosim_simulate(&sim);
+	}
+
+	for(i = 0; i < n; i++) {
+		clear_fmu_check_child_data(&COSIM_MEMBER(&sim, i)->cdata, cdata);
+	}
+	cdata->instance_data = 0;
+	cdata->num_instance_data = 0;
+	jm_vector_free_data(jm_voidp)(&sim.members);
+	jm_vector_free_data(jm_voidp)(&sim.connections);
+	return status;
+}
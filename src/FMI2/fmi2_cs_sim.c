@@ -34,22 +34,17 @@ jm_status_enu_t fmi2_cs_simulate(fmu_check_data_t* cdata)
 
     prepare_time_step_info(cdata, &tend, &hstep);
 
-	cdata->instanceNameToCompare = "Test FMI 2.0 CS";
-	cdata->instanceNameSavedPtr = 0;
-	jmstatus = fmi2_import_instantiate(fmu, cdata->instanceNameToCompare, fmi2_cosimulation, 0, visible);
-
-	cdata->instanceNameSavedPtr = cdata->instanceNameToCompare;
+	fmu_check_phase_begin(cdata, fmu_check_phase_instantiate);
+	jmstatus = fmi2_instantiate_or_reset(cdata, "Test FMI 2.0 CS", fmi2_cosimulation, visible);
 
 	if (jmstatus == jm_status_error) {
 		jm_log_fatal(cb, fmu_checker_module, "Could not instantiate the model");
 		return jm_status_error;
 	}
 	
+	fmu_check_phase_begin(cdata, fmu_check_phase_initialize);
 	//fmistatus = fmi2_import_initialize(fmu, 0 /* relTolerance */, tstart, StopTimeDefined, tend);
-	if( fmi2_status_ok_or_warning(fmistatus = fmi2_set_inputs(cdata, tstart)) &&
-		fmi2_status_ok_or_warning(fmistatus =  fmi2_import_setup_experiment(fmu, toleranceControlled,relativeTolerance, tstart, fmi2_false, 0.0)) && 
-		fmi2_status_ok_or_warning(fmistatus = fmi2_import_enter_initialization_mode(fmu)) &&
-		fmi2_status_ok_or_warning(fmi2_import_exit_initialization_mode(fmu))){
+	if(fmi2_status_ok_or_warning(fmistatus = fmi2_initialize_fmu(cdata, fmi2_cosimulation, toleranceControlled, relativeTolerance, tstart))) {
 			jm_log_info(cb, fmu_checker_module, "Initialized FMU for simulation starting at time %g", tstart);
 			fmistatus = fmi2_status_ok;
 	}
@@ -58,12 +53,15 @@ jm_status_enu_t fmi2_cs_simulate(fmu_check_data_t* cdata)
 			jmstatus = jm_status_error;
 	}
 
+	fmu_check_phase_begin(cdata, fmu_check_phase_simulate);
+	fmi2_resample_start(cdata);
 	if(jmstatus != jm_status_error) {
 		jm_log_verbose(cb, fmu_checker_module, "Writing simulation output for start time");
 		if(fmi2_write_csv_data(cdata, tstart) != jm_status_success){
 			jmstatus = jm_status_error;
 		}
 	}
+	fmu_check_realtime_start(cdata, tstart);
 	while ((tcur < tend) && (jmstatus != jm_status_error)) {
 		fmi2_boolean_t newStep = fmi2_true;
 		fmi2_real_t tnext = tcur + hstep;
@@ -85,7 +83,9 @@ jm_status_enu_t fmi2_cs_simulate(fmu_check_data_t* cdata)
             jmstatus = jm_status_error;
             break;
         }
+		fmu_check_watch(cdata, "fmi2DoStep", tcur);
 		fmistatus = fmi2_import_do_step(fmu, tcur, hstep, newStep);
+		fmu_check_watch_end(cdata);
 
 		tcur = tnext;
 
@@ -99,14 +99,18 @@ jm_status_enu_t fmi2_cs_simulate(fmu_check_data_t* cdata)
 		else if(fmistatus == fmi2_status_discard) {
 			fmi2_boolean_t bstatus = fmi2_false;
 			fmi2_real_t lastTime;
+			fmu_check_watch(cdata, "fmi2GetRealStatus", tcur);
 			fmistatus = fmi2_import_get_real_status(fmu, fmi2_last_successful_time, &lastTime);
+			fmu_check_watch_end(cdata);
 			if((fmistatus != fmi2_status_ok) && (fmistatus != fmi2_status_warning)) {
 				jm_log_error(cb, fmu_checker_module, "Could not retrive fmiLastSuccessfulTime status since FMU returned: %s",fmi2_status_to_string(fmistatus));
 			}
 			else 
 				tcur = lastTime;
 
+			fmu_check_watch(cdata, "fmi2GetBooleanStatus", tcur);
 			fmistatus = fmi2_import_get_boolean_status(fmu, fmi2_terminated, &bstatus);
+			fmu_check_watch_end(cdata);
 			if((fmistatus != fmi2_status_ok) && (fmistatus != fmi2_status_warning)) 
 			{
 				jm_log_error(cb, fmu_checker_module, "Could not retrive fmiTerminated status since FMU returned: %s",fmi2_status_to_string(fmistatus));
@@ -124,7 +128,10 @@ jm_status_enu_t fmi2_cs_simulate(fmu_check_data_t* cdata)
 		}
 		else
 			jmstatus = jm_status_error;
+
+		fmu_check_realtime_step(cdata, tcur);
 	}
+	fmu_check_realtime_report(cdata);
 
 	if((fmistatus != fmi2_status_ok) && (fmistatus != fmi2_status_warning)) {
 		jm_log_fatal(cb, fmu_checker_module, "Simulation loop terminated at time %g since FMU returned status: %s", tcur, fmi2_status_to_string(fmistatus));
@@ -134,17 +141,25 @@ jm_status_enu_t fmi2_cs_simulate(fmu_check_data_t* cdata)
  		 jm_log_info(cb, fmu_checker_module, "Simulation finished successfully at time %g", tcur);
 	}
 
+	fmu_check_phase_begin(cdata, fmu_check_phase_terminate);
 	if(fmistatus != fmi2_status_fatal) {
+		fmu_check_watch(cdata, "fmi2Terminate", tcur);
 		fmistatus = fmi2_import_terminate(fmu);
+		fmu_check_watch_end(cdata);
 	}
 
 	if(  (fmistatus != fmi2_status_ok) && (fmistatus != fmi2_status_warning)) {
 		 jm_log_error(cb, fmu_checker_module, "fmiTerminateSlave returned status: %s", fmi2_status_to_string(fmistatus));
 	}
 
-	if(fmistatus != fmi2_status_fatal) {
+	if(cdata->fmu2_reuse_instance && (jmstatus != jm_status_error) && fmi2_status_ok_or_warning(fmistatus)) {
+		/* the instance is reset for the next run */
+		cdata->fmu2_instance_alive = 1;
+	}
+	else if(fmistatus != fmi2_status_fatal) {
 		fmi2_import_free_instance(fmu);
 	}
+	fmu_check_phase_end(cdata);
 
 	return jmstatus;
 }
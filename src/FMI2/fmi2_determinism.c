@@ -0,0 +1,201 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmi2_determinism.c
+	Determinism check of FMI 2.0 simulations (--determinism option).
+*/
+
+#include <string.h>
+
+#include <fmuChecker.h>
+#include <fmilib.h>
+
+#define FMI2_DETERMINISM_HASH_START 14695981039346656037ULL
+
+/* 64-bit FNV-1a */
+static void fmi2_determinism_hash(unsigned long long* h, const void* data, size_t size) {
+	const unsigned char* p = (const unsigned char*)data;
+	size_t i;
+	for(i = 0; i < size; i++) {
+		*h ^= p[i];
+		*h *= 1099511628211ULL;
+	}
+}
+
+/* The bits of a numeric value as they are, a hash of a string */
+static unsigned long long fmi2_determinism_cell(const fmi2_column_t* col, const fmi2_column_values_t* values) {
+	unsigned long long cell = 0;
+	switch(col->type) {
+	case fmi2_base_type_real:
+		memcpy(&cell, &values->reals[col->index], sizeof(fmi2_real_t));
+		break;
+	case fmi2_base_type_int:
+	case fmi2_base_type_enum:
+		memcpy(&cell, &values->ints[col->index], sizeof(fmi2_integer_t));
+		break;
+	case fmi2_base_type_bool:
+		memcpy(&cell, &values->bools[col->index], sizeof(fmi2_boolean_t));
+		break;
+	case fmi2_base_type_str:
+		cell = FMI2_DETERMINISM_HASH_START;
+		/* the terminator is included so that NULL and "" differ */
+		if(values->strs[col->index]) fmi2_determinism_hash(&cell, values->strs[col->index], strlen(values->strs[col->index]) + 1);
+		break;
+	default:
+		break;
+	}
+	return cell;
+}
+
+static int fmi2_determinism_grow(fmu_check_data_t* cdata, fmi2_determinism_t* d) {
+	jm_callbacks* cb = &cdata->callbacks;
+	size_t capacity = d->capacity ? 2 * d->capacity : 512;
+	double* times = (double*)cb->realloc(d->times, capacity * sizeof(double));
+	unsigned long long* cells;
+
+	if(!times) return 0;
+	d->times = times;
+	cells = (unsigned long long*)cb->realloc(d->cells, (capacity * d->numCols + 1) * sizeof(unsigned long long));
+	if(!cells) return 0;
+	d->cells = cells;
+	d->capacity = capacity;
+	return 1;
+}
+
+void fmi2_determinism_row(fmu_check_data_t* cdata, double time, const fmi2_column_values_t* values) {
+	fmi2_determinism_t* d = &cdata->fmu2_determinism;
+	fmi2_column_plan_t* plan = &cdata->fmu2_columns;
+	unsigned long long* kept;
+	size_t i;
+
+	if(d->mode == fmi2_determinism_record) {
+		if(d->outOfMemory) return;
+		if((d->numRows == d->capacity) && !fmi2_determinism_grow(cdata, d)) {
+			d->outOfMemory = 1;
+			return;
+		}
+		kept = d->cells + d->numRows * d->numCols;
+		for(i = 0; i < plan->numCols; i++) {
+			kept[i] = fmi2_determinism_cell(&plan->cols[i], values);
+		}
+		d->times[d->numRows] = time;
+		d->numRows++;
+		return;
+	}
+
+	/* compare: rows after the first difference or beyond the first run are only counted */
+	if(d->diverged || (d->row >= d->numRows)) {
+		d->row++;
+		return;
+	}
+	kept = d->cells + d->row * d->numCols;
+	if(memcmp(&time, &d->times[d->row], sizeof(time)) != 0) {
+		d->diverged = 1;
+		d->divergedCol = -1;
+	}
+	for(i = 0; !d->diverged && (i < plan->numCols); i++) {
+		if(fmi2_determinism_cell(&plan->cols[i], values) != kept[i]) {
+			d->diverged = 1;
+			d->divergedCol = (long)i;
+		}
+	}
+	if(d->diverged) d->divergedTime = time;
+	d->row++;
+}
+
+/* Simulate once more with the state of the outputs and inputs rewound as for a sweep run */
+static jm_status_enu_t fmi2_determinism_run(fmu_check_data_t* cdata, fmi2_fmu_kind_enu_t kind) {
+	fmu_check_arena_mark_t mark;
+	jm_status_enu_t status;
+
+	cdata->nextOutputTime = 0.0;
+	cdata->nextOutputStep = 0;
+	fmi2_rewind_input_data(&cdata->fmu2_inputData);
+
+	/* buffers allocated by the simulation are released after each run */
+	fmu_check_arena_mark(&cdata->arena, &mark);
+	status = (kind == fmi2_fmu_kind_me) ? fmi2_me_simulate(cdata) : fmi2_cs_simulate(cdata);
+	fmu_check_arena_release(&cdata->arena, &mark);
+	memset(&cdata->fmu2_row, 0, sizeof(cdata->fmu2_row));
+	memset(&cdata->fmu2_resample, 0, sizeof(cdata->fmu2_resample));
+	return status;
+}
+
+/* Log the result of comparing a later run with the first one */
+static void fmi2_determinism_report(fmu_check_data_t* cdata, const char* kindStr, const char* runStr) {
+	jm_callbacks* cb = &cdata->callbacks;
+	fmi2_determinism_t* d = &cdata->fmu2_determinism;
+
+	if(d->diverged) {
+		const char* name = (d->divergedCol < 0) ? "time" : fmi2_import_get_variable_name(cdata->fmu2_columns.cols[d->divergedCol].var);
+		jm_log_error(cb, fmu_checker_module, "%s simulation is not deterministic: the output of the run %s differs from the first run at time %.16g in %s",
+			kindStr, runStr, d->divergedTime, name);
+	}
+	else if(d->row != d->numRows) {
+		jm_log_error(cb, fmu_checker_module, "%s simulation is not deterministic: the run %s produced %u output rows and the first run %u",
+			kindStr, runStr, (unsigned)d->row, (unsigned)d->numRows);
+	}
+	else {
+		jm_log_info(cb, fmu_checker_module, "%s simulation is deterministic: the %u output rows of the run %s are bitwise equal to the first run",
+			kindStr, (unsigned)d->numRows, runStr);
+	}
+}
+
+jm_status_enu_t fmi2_determinism_check(fmu_check_data_t* cdata, fmi2_fmu_kind_enu_t kind) {
+	jm_callbacks* cb = &cdata->callbacks;
+	fmi2_determinism_t* d = &cdata->fmu2_determinism;
+	const char* kindStr = (kind == fmi2_fmu_kind_me) ? "ME" : "CS";
+	int reuseInstance = cdata->fmu2_reuse_instance;
+	jm_status_enu_t status;
+
+	fmi2_determinism_free(cdata);
+	d->numCols = cdata->fmu2_columns.numCols;
+	d->mode = fmi2_determinism_record;
+	status = fmi2_determinism_run(cdata, kind);
+	if(d->outOfMemory) {
+		jm_log_error(cb, fmu_checker_module, "Could not allocate memory for the determinism check");
+		d->mode = fmi2_determinism_off;
+		return jm_status_error;
+	}
+	if(status == jm_status_error) {
+		jm_log_error(cb, fmu_checker_module, "%s simulation failed, the determinism check is skipped", kindStr);
+		d->mode = fmi2_determinism_off;
+		return status;
+	}
+
+	/* the instance of the second run is kept for the run after fmi2Reset */
+	d->mode = fmi2_determinism_compare;
+	d->row = 0;
+	d->diverged = 0;
+	cdata->fmu2_reuse_instance = (cdata->determinism > 1);
+	jm_log_verbose(cb, fmu_checker_module, "Simulating the %s FMU again with a new instance", kindStr);
+	if(fmi2_determinism_run(cdata, kind) == jm_status_error) status = jm_status_error;
+	fmi2_determinism_report(cdata, kindStr, "with a new instance");
+
+	if((cdata->determinism > 1) && cdata->fmu2_instance_alive) {
+		d->row = 0;
+		d->diverged = 0;
+		cdata->fmu2_reuse_instance = reuseInstance;
+		jm_log_verbose(cb, fmu_checker_module, "Simulating the %s FMU again after fmi2Reset", kindStr);
+		if(fmi2_determinism_run(cdata, kind) == jm_status_error) status = jm_status_error;
+		fmi2_determinism_report(cdata, kindStr, "after fmi2Reset");
+	}
+	else if(cdata->determinism > 1) {
+		jm_log_error(cb, fmu_checker_module, "The %s simulation after fmi2Reset is skipped since the previous run failed", kindStr);
+	}
+	cdata->fmu2_reuse_instance = reuseInstance;
+	d->mode = fmi2_determinism_off;
+	return status;
+}
+
+void fmi2_determinism_free(fmu_check_data_t* cdata) {
+	fmi2_determinism_t* d = &cdata->fmu2_determinism;
+	jm_callbacks* cb = &cdata->callbacks;
+	if(d->times) cb->free(d->times);
+	if(d->cells) cb->free(d->cells);
+	memset(d, 0, sizeof(*d));
+}
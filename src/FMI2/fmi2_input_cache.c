@@ -0,0 +1,422 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmi2_input_cache.c
+	Binary cache of parsed FMI 2.0 input files.
+
+	The cache file is only meant for the machine that wrote it: the header
+	and the values are stored in the native byte order and sizes, which are
+	checked when the file is loaded. Files are written under a temporary name
+	and renamed so that parallel runs never map a partial file.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if defined(_WIN32) || defined(WIN32)
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+#endif
+
+#include <JM/jm_vector.h>
+#include <fmuChecker.h>
+#include <fmilib.h>
+
+#define FMI2_INPUT_CACHE_MAGIC "FMUCHKI1"
+#define FMI2_INPUT_CACHE_MAGIC_LEN 8
+#define FMI2_INPUT_CACHE_BYTE_ORDER 0x01020304u
+/** Size of the blocks at the start and at the end of the input file that are hashed */
+#define FMI2_INPUT_CACHE_HASH_BLOCK (64*1024)
+
+/** Header of a cache file, followed by the variable table and the data blocks */
+typedef struct fmi2_input_cache_header_t {
+	char magic[FMI2_INPUT_CACHE_MAGIC_LEN];
+	unsigned int byteOrder;
+	unsigned int realSize, intSize, boolSize;
+	unsigned long long sourceSize;
+	long long sourceMtime;
+	unsigned long long sourceHash;
+	unsigned long long numRows;
+	unsigned long long numReals, numInts, numBools;
+	/** Size of the variable table in bytes (a multiple of 8) */
+	unsigned long long varTableSize;
+} fmi2_input_cache_header_t;
+
+/**
+	Entry of the variable table, followed by the name (nameSize bytes including
+	the terminating zero). The variables are in the order of the columns of
+	the input file.
+*/
+typedef struct fmi2_input_cache_var_t {
+	unsigned int vr;
+	unsigned int type;
+	unsigned int nameSize;
+} fmi2_input_cache_var_t;
+
+struct fmi2_input_cache_map_t {
+	jm_callbacks* cb;
+	const char* data;
+	size_t size;
+#if defined(_WIN32) || defined(WIN32)
+	HANDLE file;
+	HANDLE mapping;
+#endif
+};
+
+static size_t fmi2_input_cache_align(size_t size) {
+	return (size + 7) & ~(size_t)7;
+}
+
+/* 64-bit FNV-1a */
+static void fmi2_input_cache_hash(unsigned long long* h, const void* data, size_t size) {
+	const unsigned char* p = (const unsigned char*)data;
+	size_t i;
+	for(i = 0; i < size; i++) {
+		*h ^= p[i];
+		*h *= 1099511628211ULL;
+	}
+}
+
+/*
+	Identify the input file by its size, modification time and a hash of the first and the last block.
+	Hashing the whole file would take as long as a good part of the parsing.
+*/
+static int fmi2_input_cache_source_id(const char* fileName, unsigned long long* size, long long* mtime, unsigned long long* hash) {
+	char* buf;
+	size_t len;
+	FILE* f;
+#if defined(_WIN32) || defined(WIN32)
+	struct _stati64 st;
+	if(_stati64(fileName, &st) != 0) return 0;
+#else
+	struct stat st;
+	if(stat(fileName, &st) != 0) return 0;
+#endif
+	*size = (unsigned long long)st.st_size;
+	*mtime = (long long)st.st_mtime;
+	*hash = 14695981039346656037ULL;
+
+	f = fopen(fileName, "rb");
+	if(!f) return 0;
+	buf = (char*)malloc(FMI2_INPUT_CACHE_HASH_BLOCK);
+	if(!buf) {
+		fclose(f);
+		return 0;
+	}
+	len = fread(buf, 1, FMI2_INPUT_CACHE_HASH_BLOCK, f);
+	fmi2_input_cache_hash(hash, buf, len);
+	if(*size > 2 * FMI2_INPUT_CACHE_HASH_BLOCK) {
+		if(fseek(f, -FMI2_INPUT_CACHE_HASH_BLOCK, SEEK_END) == 0) {
+			len = fread(buf, 1, FMI2_INPUT_CACHE_HASH_BLOCK, f);
+			fmi2_input_cache_hash(hash, buf, len);
+		}
+	}
+	free(buf);
+	fclose(f);
+	return 1;
+}
+
+static void fmi2_input_cache_file_name(fmu_check_data_t* cdata, char* buf, size_t bufSize) {
+	jm_snprintf(buf, bufSize, "%s" FMI2_INPUT_CACHE_EXT, cdata->inputFileName);
+}
+
+void fmi2_input_cache_unmap(fmi2_input_cache_map_t* map) {
+	if(!map) return;
+#if defined(_WIN32) || defined(WIN32)
+	if(map->data) UnmapViewOfFile(map->data);
+	if(map->mapping) CloseHandle(map->mapping);
+	if(map->file != INVALID_HANDLE_VALUE) CloseHandle(map->file);
+#else
+	if(map->data) munmap((void*)map->data, map->size);
+#endif
+	map->cb->free(map);
+}
+
+/* Map the whole file read-only. Returns NULL if it does not exist or cannot be mapped. */
+static fmi2_input_cache_map_t* fmi2_input_cache_map(jm_callbacks* cb, const char* fileName) {
+	fmi2_input_cache_map_t* map = (fmi2_input_cache_map_t*)cb->calloc(1, sizeof(fmi2_input_cache_map_t));
+	if(!map) return 0;
+	map->cb = cb;
+#if defined(_WIN32) || defined(WIN32)
+	{
+		LARGE_INTEGER size;
+		map->file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+		if((map->file == INVALID_HANDLE_VALUE) || !GetFileSizeEx(map->file, &size) || !size.QuadPart) {
+			fmi2_input_cache_unmap(map);
+			return 0;
+		}
+		map->size = (size_t)size.QuadPart;
+		map->mapping = CreateFileMappingA(map->file, 0, PAGE_READONLY, 0, 0, 0);
+		if(map->mapping) map->data = (const char*)MapViewOfFile(map->mapping, FILE_MAP_READ, 0, 0, 0);
+	}
+#else
+	{
+		struct stat st;
+		int fd = open(fileName, O_RDONLY);
+		if(fd < 0) {
+			fmi2_input_cache_unmap(map);
+			return 0;
+		}
+		if((fstat(fd, &st) == 0) && (st.st_size > 0)) {
+			void* data = mmap(0, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+			if(data != MAP_FAILED) {
+				map->data = (const char*)data;
+				map->size = (size_t)st.st_size;
+			}
+		}
+		/* the mapping stays valid after the file is closed */
+		close(fd);
+	}
+#endif
+	if(!map->data) {
+		fmi2_input_cache_unmap(map);
+		return 0;
+	}
+	return map;
+}
+
+jm_status_enu_t fmi2_input_cache_load(fmu_check_data_t* cdata) {
+	jm_callbacks* cb = &cdata->callbacks;
+	fmi2_csv_input_t* indata = &cdata->fmu2_inputData;
+	char fileName[MAX_URL_LENGTH];
+	fmi2_input_cache_map_t* map;
+	const fmi2_input_cache_header_t* hdr;
+	fmi2_import_variable_t** vars = 0;
+	unsigned long long sourceSize, sourceHash;
+	long long sourceMtime;
+	size_t numRows, numVars, i, pos, dataSize;
+	size_t numReals = 0, numInts = 0, numBools = 0;
+	const char* reason = 0;
+	const char* times;
+	const char* reals;
+	const char* ints;
+	const char* bools;
+
+	fmi2_input_cache_file_name(cdata, fileName, sizeof(fileName));
+	map = fmi2_input_cache_map(cb, fileName);
+	if(!map) {
+		jm_log_verbose(cb, fmu_checker_module, "No input data cache %s", fileName);
+		return jm_status_warning;
+	}
+	hdr = (const fmi2_input_cache_header_t*)map->data;
+
+	if(!fmi2_input_cache_source_id(cdata->inputFileName, &sourceSize, &sourceMtime, &sourceHash)) {
+		reason = "cannot read the input file";
+	}
+	else if((map->size < sizeof(*hdr)) ||
+		(memcmp(hdr->magic, FMI2_INPUT_CACHE_MAGIC, FMI2_INPUT_CACHE_MAGIC_LEN) != 0) ||
+		(hdr->byteOrder != FMI2_INPUT_CACHE_BYTE_ORDER) ||
+		(hdr->realSize != sizeof(fmi2_real_t)) || (hdr->intSize != sizeof(fmi2_integer_t)) ||
+		(hdr->boolSize != sizeof(fmi2_boolean_t))) {
+		reason = "not a cache file of this checker build";
+	}
+	else if((hdr->sourceSize != sourceSize) || (hdr->sourceMtime != sourceMtime) || (hdr->sourceHash != sourceHash)) {
+		reason = "the input file has changed";
+	}
+	if(reason) {
+		jm_log_verbose(cb, fmu_checker_module, "Ignoring input data cache %s: %s", fileName, reason);
+		fmi2_input_cache_unmap(map);
+		return jm_status_warning;
+	}
+
+	numRows = (size_t)hdr->numRows;
+	numVars = (size_t)(hdr->numReals + hdr->numInts + hdr->numBools);
+	dataSize = fmi2_input_cache_align(numRows * sizeof(double))
+		+ fmi2_input_cache_align(numRows * (size_t)hdr->numReals * sizeof(fmi2_real_t))
+		+ fmi2_input_cache_align(numRows * (size_t)hdr->numInts * sizeof(fmi2_integer_t))
+		+ fmi2_input_cache_align(numRows * (size_t)hdr->numBools * sizeof(fmi2_boolean_t));
+	if(map->size != sizeof(*hdr) + (size_t)hdr->varTableSize + dataSize) {
+		reason = "the file is truncated";
+	}
+	else if(numVars && !(vars = (fmi2_import_variable_t**)cb->calloc(numVars, sizeof(fmi2_import_variable_t*)))) {
+		reason = "out of memory";
+	}
+
+	/* resolve the variables and check that they still have the same value reference and type */
+	pos = sizeof(*hdr);
+	for(i = 0; !reason && (i < numVars); i++) {
+		fmi2_input_cache_var_t entry;
+		const char* name = map->data + pos + sizeof(entry);
+		fmi2_import_variable_t* v;
+		fmi2_base_type_enu_t type;
+		if(pos + sizeof(entry) > sizeof(*hdr) + hdr->varTableSize) {
+			reason = "the variable table is corrupt";
+			break;
+		}
+		/* the entries are not aligned */
+		memcpy(&entry, map->data + pos, sizeof(entry));
+		if((pos + sizeof(entry) + entry.nameSize > sizeof(*hdr) + hdr->varTableSize) ||
+			!entry.nameSize || name[entry.nameSize - 1]) {
+			reason = "the variable table is corrupt";
+			break;
+		}
+		v = fmi2_import_get_variable_by_name(cdata->fmu2, name);
+		type = v ? fmi2_import_get_variable_base_type(v) : fmi2_base_type_real;
+		if(type == fmi2_base_type_enum) type = fmi2_base_type_int;
+		if(!v || (fmi2_import_get_variable_vr(v) != entry.vr) || ((unsigned int)type != entry.type)) {
+			reason = "the input variables do not match the model description";
+			break;
+		}
+		if(type == fmi2_base_type_real) numReals++;
+		else if(type == fmi2_base_type_int) numInts++;
+		else if(type == fmi2_base_type_bool) numBools++;
+		vars[i] = v;
+		pos += sizeof(entry) + entry.nameSize;
+	}
+	/* the rows are laid out by the counts in the header */
+	if(!reason && ((numReals != hdr->numReals) || (numInts != hdr->numInts) || (numBools != hdr->numBools))) {
+		reason = "the variable table does not match the data sizes";
+	}
+	if(reason) {
+		jm_log_verbose(cb, fmu_checker_module, "Ignoring input data cache %s: %s", fileName, reason);
+		cb->free(vars);
+		fmi2_input_cache_unmap(map);
+		return jm_status_warning;
+	}
+
+	for(i = 0; i < numVars; i++) {
+		switch(fmi2_import_get_variable_base_type(vars[i])) {
+		case fmi2_base_type_real:
+			fmi2_import_var_list_push_back(indata->realInputs, vars[i]);
+			break;
+		case fmi2_base_type_bool:
+			fmi2_import_var_list_push_back(indata->boolInputs, vars[i]);
+			break;
+		default:
+			fmi2_import_var_list_push_back(indata->intInputs, vars[i]);
+			break;
+		}
+		fmi2_import_var_list_push_back(indata->allInputs, vars[i]);
+	}
+	cb->free(vars);
+
+	/* the time stamps are copied, the rows are used in place */
+	times = map->data + sizeof(*hdr) + (size_t)hdr->varTableSize;
+	reals = times + fmi2_input_cache_align(numRows * sizeof(double));
+	ints = reals + fmi2_input_cache_align(numRows * (size_t)hdr->numReals * sizeof(fmi2_real_t));
+	bools = ints + fmi2_input_cache_align(numRows * (size_t)hdr->numInts * sizeof(fmi2_integer_t));
+	if((fmi2_import_get_variable_list_size(indata->allInputs) != numVars) ||
+		!(indata->interpData = (fmi2_real_t*)fmu_check_arena_alloc(&cdata->arena, sizeof(fmi2_real_t) * (size_t)hdr->numReals)) ||
+		(jm_vector_resize(double)(&indata->timeStamps, numRows) != numRows) ||
+		(jm_vector_resize(jm_voidp)(indata->realInputData, numRows) != numRows) ||
+		(jm_vector_resize(jm_voidp)(indata->intInputData, numRows) != numRows) ||
+		(jm_vector_resize(jm_voidp)(indata->boolInputData, numRows) != numRows)) {
+		jm_log_error(cb, fmu_checker_module, "Internal error trying to create input variable lists. Possibly out of memory");
+		fmi2_input_cache_unmap(map);
+		return jm_status_error;
+	}
+	if(numRows) {
+		memcpy(jm_vector_get_itemp(double)(&indata->timeStamps, 0), times, numRows * sizeof(double));
+	}
+	for(i = 0; i < numRows; i++) {
+		*jm_vector_get_itemp(jm_voidp)(indata->realInputData, i) = (jm_voidp)(reals + i * (size_t)hdr->numReals * sizeof(fmi2_real_t));
+		*jm_vector_get_itemp(jm_voidp)(indata->intInputData, i) = (jm_voidp)(ints + i * (size_t)hdr->numInts * sizeof(fmi2_integer_t));
+		*jm_vector_get_itemp(jm_voidp)(indata->boolInputData, i) = (jm_voidp)(bools + i * (size_t)hdr->numBools * sizeof(fmi2_boolean_t));
+	}
+	indata->cacheMap = map;
+	jm_log_info(cb, fmu_checker_module, "Loaded %u input rows from the cache %s", (unsigned)numRows, fileName);
+	return jm_status_success;
+}
+
+/* Write zeros from size bytes up to the next multiple of 8 */
+static int fmi2_input_cache_pad(FILE* f, size_t size) {
+	static const char zeros[8] = {0};
+	size_t pad = fmi2_input_cache_align(size) - size;
+	return !pad || (fwrite(zeros, 1, pad, f) == pad);
+}
+
+/* Write the rows of one value type as a block */
+static int fmi2_input_cache_write_rows(FILE* f, jm_vector(jm_voidp)* rows, size_t rowSize) {
+	size_t i, numRows = jm_vector_get_size(jm_voidp)(rows);
+	for(i = 0; rowSize && (i < numRows); i++) {
+		if(fwrite(jm_vector_get_item(jm_voidp)(rows, i), 1, rowSize, f) != rowSize) return 0;
+	}
+	return fmi2_input_cache_pad(f, numRows * rowSize);
+}
+
+void fmi2_input_cache_save(fmu_check_data_t* cdata) {
+	jm_callbacks* cb = &cdata->callbacks;
+	fmi2_csv_input_t* indata = &cdata->fmu2_inputData;
+	fmi2_input_cache_header_t hdr;
+	char fileName[MAX_URL_LENGTH];
+	char tmpName[MAX_URL_LENGTH];
+	size_t numRows = jm_vector_get_size(double)(&indata->timeStamps);
+	size_t numVars = fmi2_import_get_variable_list_size(indata->allInputs);
+	size_t i;
+	FILE* f;
+	int ok;
+
+	memset(&hdr, 0, sizeof(hdr));
+	if(!fmi2_input_cache_source_id(cdata->inputFileName, &hdr.sourceSize, &hdr.sourceMtime, &hdr.sourceHash)) {
+		jm_log_warning(cb, fmu_checker_module, "Could not read %s for the input data cache", cdata->inputFileName);
+		return;
+	}
+	memcpy(hdr.magic, FMI2_INPUT_CACHE_MAGIC, FMI2_INPUT_CACHE_MAGIC_LEN);
+	hdr.byteOrder = FMI2_INPUT_CACHE_BYTE_ORDER;
+	hdr.realSize = sizeof(fmi2_real_t);
+	hdr.intSize = sizeof(fmi2_integer_t);
+	hdr.boolSize = sizeof(fmi2_boolean_t);
+	hdr.numRows = numRows;
+	hdr.numReals = fmi2_import_get_variable_list_size(indata->realInputs);
+	hdr.numInts = fmi2_import_get_variable_list_size(indata->intInputs);
+	hdr.numBools = fmi2_import_get_variable_list_size(indata->boolInputs);
+	for(i = 0; i < numVars; i++) {
+		hdr.varTableSize += sizeof(fmi2_input_cache_var_t) + strlen(fmi2_import_get_variable_name(fmi2_import_get_variable(indata->allInputs, i))) + 1;
+	}
+	hdr.varTableSize = fmi2_input_cache_align((size_t)hdr.varTableSize);
+
+	fmi2_input_cache_file_name(cdata, fileName, sizeof(fileName));
+	/* parallel runs may save the same cache; the rename makes the file appear complete */
+	jm_snprintf(tmpName, sizeof(tmpName), "%s.%p.tmp", fileName, (void*)cdata);
+	f = fopen(tmpName, "wb");
+	if(!f) {
+		jm_log_warning(cb, fmu_checker_module, "Could not open %s for writing the input data cache", tmpName);
+		return;
+	}
+
+	ok = (fwrite(&hdr, sizeof(hdr), 1, f) == 1);
+	{
+		size_t tableSize = 0;
+		for(i = 0; ok && (i < numVars); i++) {
+			fmi2_import_variable_t* v = fmi2_import_get_variable(indata->allInputs, i);
+			const char* name = fmi2_import_get_variable_name(v);
+			fmi2_input_cache_var_t entry;
+			fmi2_base_type_enu_t type = fmi2_import_get_variable_base_type(v);
+			entry.vr = fmi2_import_get_variable_vr(v);
+			entry.type = (unsigned int)((type == fmi2_base_type_enum) ? fmi2_base_type_int : type);
+			entry.nameSize = (unsigned int)strlen(name) + 1;
+			ok = (fwrite(&entry, sizeof(entry), 1, f) == 1) && (fwrite(name, 1, entry.nameSize, f) == entry.nameSize);
+			tableSize += sizeof(entry) + entry.nameSize;
+		}
+		ok = ok && fmi2_input_cache_pad(f, tableSize);
+	}
+	ok = ok && (!numRows || (fwrite(jm_vector_get_itemp(double)(&indata->timeStamps, 0), sizeof(double), numRows, f) == numRows));
+	ok = ok && fmi2_input_cache_pad(f, numRows * sizeof(double));
+	ok = ok && fmi2_input_cache_write_rows(f, indata->realInputData, (size_t)hdr.numReals * sizeof(fmi2_real_t));
+	ok = ok && fmi2_input_cache_write_rows(f, indata->intInputData, (size_t)hdr.numInts * sizeof(fmi2_integer_t));
+	ok = ok && fmi2_input_cache_write_rows(f, indata->boolInputData, (size_t)hdr.numBools * sizeof(fmi2_boolean_t));
+
+	if((fclose(f) != 0) || !ok) {
+		jm_log_warning(cb, fmu_checker_module, "Could not write the input data cache %s", tmpName);
+		remove(tmpName);
+		return;
+	}
+	/* an outdated cache is replaced (rename does not replace files on Windows) */
+	remove(fileName);
+	if(rename(tmpName, fileName) != 0) {
+		/* another run saved the cache first */
+		remove(tmpName);
+		return;
+	}
+	jm_log_info(cb, fmu_checker_module, "Saved the input data cache %s", fileName);
+}
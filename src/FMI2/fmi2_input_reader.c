@@ -14,6 +14,7 @@ Main function and command line options handling of the FMUChecker application.
 #include <stdarg.h>
 #include <errno.h>
 #include <assert.h>
+#include <float.h>
 
 #include <JM/jm_portability.h>
 #include <JM/jm_vector.h>
@@ -46,6 +47,9 @@ jm_status_enu_t fmi2_init_input_data(fmi2_csv_input_t* indata, jm_callbacks* cb,
 	indata->interpData = 0;
 
 	indata->eventIndex1=indata->eventIndex2=0;
+	indata->stream = 0;
+	indata->readError = 0;
+	indata->cacheMap = 0;
 
 	if(err){
 		jm_log_error(cb, fmu_checker_module, "Cannot allocate memory");
@@ -56,76 +60,137 @@ jm_status_enu_t fmi2_init_input_data(fmi2_csv_input_t* indata, jm_callbacks* cb,
 }
 
 void fmi2_free_input_data(fmi2_csv_input_t* indata) {
-	size_t i;
 	if(!indata || !indata->fmu) return;
+	fmi2_input_stream_close(indata->stream);
+	indata->stream = 0;
+	/* the rows point into the mapped cache file */
+	fmi2_input_cache_unmap(indata->cacheMap);
+	indata->cacheMap = 0;
 	jm_vector_free_data(double)(&indata->timeStamps);
 
 	fmi2_import_free_variable_list(indata->allInputs);
 	indata->allInputs = 0;
 	if(indata->boolInputData) {
-		for(i=0; i < jm_vector_get_size(jm_voidp)(indata->boolInputData); i++) {
-			void** data = jm_vector_get_itemp(jm_voidp)(indata->boolInputData, i);
-			free(*data);
-			*data = 0;
-		}
 		jm_vector_free(jm_voidp)(indata->boolInputData);
 		indata->boolInputData = 0;
 	}
 	fmi2_import_free_variable_list(indata->boolInputs);
 	indata->boolInputs = 0;
 	if(indata->intInputData) {
-		for(i=0; i < jm_vector_get_size(jm_voidp)(indata->intInputData); i++) {
-			void** data = jm_vector_get_itemp(jm_voidp)(indata->intInputData, i);
-			free(*data);
-			*data = 0;
-		}
 		jm_vector_free(jm_voidp)(indata->intInputData);
 		indata->intInputData = 0;
 	}
 	fmi2_import_free_variable_list(indata->intInputs);
 	indata->intInputs = 0;
 	if(indata->realInputData) {
-		for(i=0; i < jm_vector_get_size(jm_voidp)(indata->realInputData); i++) {
-			void** data = jm_vector_get_itemp(jm_voidp)(indata->realInputData, i);
-			free(*data);
-			*data = 0;
-		}
 		jm_vector_free(jm_voidp)(indata->realInputData);
 		indata->realInputData = 0;
 	}
 	fmi2_import_free_variable_list(indata->realInputs);
 	indata->realInputs = 0;
-	free(indata->interpData);
+	/* data rows and interpolation buffer are owned by the checker arena */
 	indata->interpData = 0;
 }
 
+/* Row access for the loaded data and for the window of the streaming reader. Rows are numbered from the start of the file. */
+static double fmi2_input_time(fmi2_csv_input_t* indata, size_t row) {
+	if(indata->stream) return fmi2_input_stream_time(indata->stream, row);
+	return jm_vector_get_item(double)(&indata->timeStamps, row);
+}
+
+static fmi2_real_t* fmi2_input_reals(fmi2_csv_input_t* indata, size_t row) {
+	if(indata->stream) return fmi2_input_stream_reals(indata->stream, row);
+	return (fmi2_real_t*)jm_vector_get_item(jm_voidp)(indata->realInputData, row);
+}
+
+static fmi2_integer_t* fmi2_input_ints(fmi2_csv_input_t* indata, size_t row) {
+	if(indata->stream) return fmi2_input_stream_ints(indata->stream, row);
+	return (fmi2_integer_t*)jm_vector_get_item(jm_voidp)(indata->intInputData, row);
+}
+
+static fmi2_boolean_t* fmi2_input_bools(fmi2_csv_input_t* indata, size_t row) {
+	if(indata->stream) return fmi2_input_stream_bools(indata->stream, row);
+	return (fmi2_boolean_t*)jm_vector_get_item(jm_voidp)(indata->boolInputData, row);
+}
+
+static double fmi2_input_start_time(fmi2_csv_input_t* indata) {
+	if(indata->stream) return fmi2_input_stream_start_time(indata->stream);
+	return jm_vector_get_item(double)(&indata->timeStamps, 0);
+}
+
+/** first row that can be accessed, rows before it are dropped by the streaming reader */
+static size_t fmi2_input_first_row(fmi2_csv_input_t* indata) {
+	return indata->stream ? fmi2_input_stream_first_row(indata->stream) : 0;
+}
+
+/**
+	Make the rows up to the first one after time t accessible. Returns the number of rows
+	up to the last accessible one and sets complete if it is the last row of the file.
+	Returns 0 if the data could not be read.
+*/
+static size_t fmi2_input_rows_until(fmi2_csv_input_t* indata, double t, int* complete) {
+	size_t endRow;
+	if(!indata->stream) {
+		*complete = 1;
+		return jm_vector_get_size(double)(&indata->timeStamps);
+	}
+	if(fmi2_input_stream_fill(indata->stream, t, &endRow, complete) != jm_status_success) {
+		indata->readError = 1;
+		return 0;
+	}
+	return endRow;
+}
+
+int fmi2_input_has_data(fmi2_csv_input_t* indata) {
+	return (indata->stream != 0) || (jm_vector_get_size(double)(&indata->timeStamps) != 0);
+}
+
+const fmi2_integer_t* fmi2_input_discrete_ints(fmi2_csv_input_t* indata) {
+	return fmi2_input_ints(indata, indata->discreteIndex);
+}
+
+const fmi2_boolean_t* fmi2_input_discrete_bools(fmi2_csv_input_t* indata) {
+	return fmi2_input_bools(indata, indata->discreteIndex);
+}
+
 void fmi2_update_input_interpolation(fmi2_csv_input_t* indata, double t) {
-	size_t i;
+	size_t i, numRows;
+	int complete;
 	
 	if( (t == indata->interpTime) ||
-		!jm_vector_get_size(double)(&indata->timeStamps)) {
+		!fmi2_input_has_data(indata)) {
 			return;
 	}
 
-	indata->interpTime = t;
-	if(t <= jm_vector_get_item(double)(&indata->timeStamps,0)) {
+	if(t <= fmi2_input_start_time(indata)) {
 		/* handle extrapolation on the left */
+		if(fmi2_input_first_row(indata)) {
+			/* the first rows were dropped by the streaming reader */
+			if((fmi2_input_stream_restart(indata->stream) != jm_status_success) ||
+				!fmi2_input_rows_until(indata, t, &complete)) {
+				indata->readError = 1;
+				return;
+			}
+		}
 		indata->interpIndex1 = indata->interpIndex2 = indata->discreteIndex = 0;
 		indata->interpLambda = 0.0;
 	}
-	else if(t >= jm_vector_get_last(double)(&indata->timeStamps)) {
+	else if(!(numRows = fmi2_input_rows_until(indata, t, &complete))) {
+		return;
+	}
+	else if(complete && (t >= fmi2_input_time(indata, numRows - 1))) {
 		/* handle extrapolation on the right */
 		indata->interpIndex1 = indata->interpIndex2 = indata->discreteIndex
-			= jm_vector_get_size(double)(&indata->timeStamps) - 1;
+			= numRows - 1;
 		indata->interpLambda = 1.0;
 	}
 	else {
 		/* linear interpolation, note that time is always increasing and so indices are growing */
 		double t1;
-		double t2 = jm_vector_get_item(double)(&indata->timeStamps, indata->interpIndex2);
+		double t2 = fmi2_input_time(indata, indata->interpIndex2);
 		while( t2 < t) {
 			indata->interpIndex2++;
-			t2 = jm_vector_get_item(double)(&indata->timeStamps, indata->interpIndex2);
+			t2 = fmi2_input_time(indata, indata->interpIndex2);
 		}
         if (t2 == t) {
             /* If we are exactly on the input time then use it for integers/booleans */
@@ -134,40 +199,58 @@ void fmi2_update_input_interpolation(fmi2_csv_input_t* indata, double t) {
             indata->discreteIndex = indata->interpIndex2 - 1;
         }
         indata->interpIndex1 = indata->interpIndex2 - 1;
-		t1 = jm_vector_get_item(double)(&indata->timeStamps, indata->interpIndex1);
+		t1 = fmi2_input_time(indata, indata->interpIndex1);
 		indata->interpLambda = (t - t1)/(t2 -t1);
 
 	}
+	indata->interpTime = t;
 
 	for(i = 0; i < fmi2_import_get_variable_list_size(indata->realInputs); i++) {
 		fmi2_import_variable_t* v = fmi2_import_get_variable(indata->realInputs, i);
 		fmi2_variability_enu_t variability = fmi2_import_get_variability(v);
 		if (variability > fmi2_variability_enu_discrete){
-			fmi2_real_t* v1 = (fmi2_real_t*)jm_vector_get_item(jm_voidp)(indata->realInputData,indata->interpIndex1);
-			fmi2_real_t* v2 = (fmi2_real_t*)jm_vector_get_item(jm_voidp)(indata->realInputData,indata->interpIndex2);
+			fmi2_real_t* v1 = fmi2_input_reals(indata, indata->interpIndex1);
+			fmi2_real_t* v2 = fmi2_input_reals(indata, indata->interpIndex2);
 			indata->interpData[i] = v1[i] * (1.0 - indata->interpLambda) + v2[i] * indata->interpLambda;
         } else {
             /*discrete real, no interpolation*/
-			fmi2_real_t* v1 = (fmi2_real_t*)jm_vector_get_item(jm_voidp)(indata->realInputData,indata->discreteIndex);
+			fmi2_real_t* v1 = fmi2_input_reals(indata, indata->discreteIndex);
 			indata->interpData[i] =  *v1;
 		}
 	}
+
+	/* the rows before the interpolation interval are not needed anymore */
+	if(indata->stream) {
+		fmi2_input_stream_release(indata->stream, indata->interpIndex1);
+	}
+}
+
+void fmi2_rewind_input_data(fmi2_csv_input_t* indata) {
+	indata->eventIndex1 = 0;
+	if(fmi2_input_has_data(indata)) {
+		fmi2_update_input_interpolation(indata, fmi2_input_start_time(indata)-1);
+	}
 }
 
 fmi2_status_t fmi2_set_inputs(fmu_check_data_t* cdata, double time) {
 	fmi2_status_t fmiStatus = fmi2_status_ok;
 	fmi2_csv_input_t* indata = &cdata->fmu2_inputData;
 
-	if(!jm_vector_get_size(double)(&indata->timeStamps)) 
+	if(!fmi2_input_has_data(indata)) 
 		return fmi2_status_ok;
 
 	fmi2_update_input_interpolation(indata, time);
+	if(indata->readError) {
+		return fmi2_status_error;
+	}
 
 	if(indata->realInputData && fmi2_import_get_variable_list_size(indata->realInputs)) {
 		const fmi2_value_reference_t* bv = fmi2_import_get_value_referece_list(indata->realInputs);
 		if(!bv) return fmi2_status_error;
+		fmu_check_watch(cdata, "fmi2SetReal (inputs)", time);
 		fmiStatus = fmi2_import_set_real(cdata->fmu2, bv, fmi2_import_get_variable_list_size(indata->realInputs), 
 			indata->interpData);
+		fmu_check_watch_end(cdata);
 	}
 	if(!fmi2_status_ok_or_warning(fmiStatus)) {
 		return fmiStatus;
@@ -176,8 +259,10 @@ fmi2_status_t fmi2_set_inputs(fmu_check_data_t* cdata, double time) {
 	if(indata->boolInputData && fmi2_import_get_variable_list_size(indata->boolInputs)) {
 		const fmi2_value_reference_t* bv = fmi2_import_get_value_referece_list(indata->boolInputs);
 		if(!bv) return fmi2_status_error;
+		fmu_check_watch(cdata, "fmi2SetBoolean (inputs)", time);
 		fmiStatus = fmi2_import_set_boolean(cdata->fmu2, bv, fmi2_import_get_variable_list_size(indata->boolInputs), 
-            (const fmi2_boolean_t*)jm_vector_get_item(jm_voidp)(indata->boolInputData,indata->discreteIndex));
+            fmi2_input_bools(indata, indata->discreteIndex));
+		fmu_check_watch_end(cdata);
 	}
 	if(!fmi2_status_ok_or_warning(fmiStatus)) {
 		return fmiStatus;
@@ -186,13 +271,28 @@ fmi2_status_t fmi2_set_inputs(fmu_check_data_t* cdata, double time) {
 	if(indata->intInputData && fmi2_import_get_variable_list_size(indata->intInputs)) {
 		const fmi2_value_reference_t* bv = fmi2_import_get_value_referece_list(indata->intInputs);
 		if(!bv) return fmi2_status_error;
+		fmu_check_watch(cdata, "fmi2SetInteger (inputs)", time);
 		fmiStatus = fmi2_import_set_integer(cdata->fmu2, bv, fmi2_import_get_variable_list_size(indata->intInputs), 
-            (const fmi2_integer_t*)jm_vector_get_item(jm_voidp)(indata->intInputData,indata->discreteIndex));
+            fmi2_input_ints(indata, indata->discreteIndex));
+		fmu_check_watch_end(cdata);
 	}
 
 	return fmiStatus;
 }
 
+/* Context of fmi2_parse_input_chunk_row() */
+typedef struct fmi2_input_row_context_t {
+	char sep;
+	fmi2_import_variable_list_t* allInputs;
+} fmi2_input_row_context_t;
+
+/* Row parser for fmu_check_parse_input_chunks() */
+static int fmi2_parse_input_chunk_row(void* context, FILE* file, double* time, void* parts[FMU_CHECK_INPUT_NUM_PARTS], size_t* badVar) {
+	fmi2_input_row_context_t* ctx = (fmi2_input_row_context_t*)context;
+	return fmi2_parse_input_row(file, ctx->sep, ctx->allInputs, time,
+		(fmi2_real_t*)parts[0], (fmi2_integer_t*)parts[1], (fmi2_boolean_t*)parts[2], badVar);
+}
+
 jm_status_enu_t fmi2_read_input_file(fmu_check_data_t* cdata) {
 	FILE* infile;
 	fmi2_csv_input_t* indata = &cdata->fmu2_inputData;
@@ -203,13 +303,22 @@ jm_status_enu_t fmi2_read_input_file(fmu_check_data_t* cdata) {
 	char namebuffer[NAMEBUFSIZE+1];
 	size_t namelen = 0;
 	int quotedFlg = 0;
-	size_t lineCnt = 0, varCnt = 0;
 	const char* fname = cdata->inputFileName;
 
 	if(!fname) return jm_status_success;
 	
 	jm_log_info(&cdata->callbacks, fmu_checker_module,"Opening input file %s", fname);
 
+	if(cdata->inputCache) {
+		/* a valid cache is used also with --stream-input: the mapped rows are paged in from the disk */
+		jm_status_enu_t status = fmi2_input_cache_load(cdata);
+		if(status == jm_status_error) return jm_status_error;
+		if(status == jm_status_success) {
+			fmi2_rewind_input_data(indata);
+			return jm_status_success;
+		}
+	}
+
 	infile = fopen(fname, "rb");
 
 	if(!infile) {
@@ -336,7 +445,7 @@ jm_status_enu_t fmi2_read_input_file(fmu_check_data_t* cdata) {
 		if(buf != '\n') buf = fgetc(infile);
 	}
 	if( 
-		!(indata->interpData = (fmi2_real_t*)malloc(sizeof(fmi2_real_t) * fmi2_import_get_variable_list_size(indata->realInputs))) ||
+		!(indata->interpData = (fmi2_real_t*)fmu_check_arena_alloc(&cdata->arena, sizeof(fmi2_real_t) * fmi2_import_get_variable_list_size(indata->realInputs))) ||
 		(fmi2_import_get_variable_list_size(indata->allInputs) !=
 		fmi2_import_get_variable_list_size(indata->realInputs)+
 		fmi2_import_get_variable_list_size(indata->intInputs)+
@@ -346,142 +455,184 @@ jm_status_enu_t fmi2_read_input_file(fmu_check_data_t* cdata) {
 			return jm_status_error;
 	}
 
+	if(cdata->streamInput) {
+		/* the rows are read during the simulation */
+		size_t numRows;
+		int complete;
+		indata->stream = fmi2_input_stream_open(&cdata->callbacks, infile, sep, indata->allInputs,
+			fmi2_import_get_variable_list_size(indata->realInputs),
+			fmi2_import_get_variable_list_size(indata->intInputs),
+			fmi2_import_get_variable_list_size(indata->boolInputs));
+		if(!indata->stream) return jm_status_error;
+		jm_log_info(&cdata->callbacks, fmu_checker_module,"Streaming input data with a window of %u rows", (unsigned)FMI2_INPUT_STREAM_WINDOW_ROWS);
+		numRows = fmi2_input_rows_until(indata, -DBL_MAX, &complete);
+		if(!numRows && !indata->readError) {
+			/* no data rows */
+			fmi2_input_stream_close(indata->stream);
+			indata->stream = 0;
+		}
+		if(indata->readError) {
+			return jm_status_error;
+		}
+		fmi2_rewind_input_data(indata);
+		return jm_status_success;
+	}
+
 	/* read input data */
-	lineCnt = 0, varCnt = 0;
-	while(!feof(infile)) {
-		size_t realVarCnt, intVarCnt, boolVarCnt;
-		int memErr = 0;
-		fmi2_real_t* realData = 0;
-		fmi2_integer_t* intData = 0;
-		fmi2_boolean_t* boolData = 0;
-
-		double time;
-		lineCnt++;
-		/* first column is time */
-		if(fscanf(infile,"%lg",&time) != 1) break;
-		/* allocate memory for the data and store pointers */
-		memErr |= (jm_vector_push_back(double)(&indata->timeStamps, time) == 0);
-		memErr |= (jm_vector_push_back(jm_voidp)(indata->realInputData,realData) == 0);
-		memErr |= (jm_vector_push_back(jm_voidp)(indata->intInputData,intData) == 0);
-		memErr |= (jm_vector_push_back(jm_voidp)(indata->boolInputData,boolData) == 0);
-		if(!memErr) {
-			realData = (fmi2_real_t*)malloc(sizeof(fmi2_real_t) * fmi2_import_get_variable_list_size(indata->realInputs));
-			intData = (fmi2_integer_t*)malloc(sizeof(fmi2_integer_t) * fmi2_import_get_variable_list_size(indata->intInputs));
-			boolData = (fmi2_boolean_t*)malloc(sizeof(fmi2_boolean_t) * fmi2_import_get_variable_list_size(indata->boolInputs));
+	{
+		long dataOffset = ftell(infile);
+		size_t partSize[FMU_CHECK_INPUT_NUM_PARTS];
+		fmu_check_input_rows_t rows;
+		fmi2_input_row_context_t context;
+		size_t i;
+
+		fclose(infile);
+		partSize[0] = sizeof(fmi2_real_t) * fmi2_import_get_variable_list_size(indata->realInputs);
+		partSize[1] = sizeof(fmi2_integer_t) * fmi2_import_get_variable_list_size(indata->intInputs);
+		partSize[2] = sizeof(fmi2_boolean_t) * fmi2_import_get_variable_list_size(indata->boolInputs);
+		context.sep = sep;
+		context.allInputs = indata->allInputs;
+		if(fmu_check_parse_input_chunks(cdata, fname, dataOffset, sep, partSize, fmi2_parse_input_chunk_row, &context,
+										&indata->timeStamps, &rows) != jm_status_success) {
+			if(rows.badLine) {
+				jm_log_error(indata->cb, fmu_checker_module, "Error parsing input file data [line %d, time '%g', variable '%s']",
+					(int)rows.badLine, rows.badTime, fmi2_import_get_variable_name(fmi2_import_get_variable(indata->allInputs, rows.badVar)));
+			}
+			return jm_status_error;
 		}
-		if(    (realData == 0)
-			|| (intData == 0)
-			|| (boolData == 0)
-			|| memErr) {
-				free(realData);
-				free(intData);
-				free(boolData);
-				fclose(infile);
-				jm_log_error(&cdata->callbacks, fmu_checker_module, "Out of memory while reading input file line %d", lineCnt);
+		/* store the data pointers */
+		if(    (jm_vector_resize(jm_voidp)(indata->realInputData, rows.numRows) != rows.numRows)
+			|| (jm_vector_resize(jm_voidp)(indata->intInputData, rows.numRows) != rows.numRows)
+			|| (jm_vector_resize(jm_voidp)(indata->boolInputData, rows.numRows) != rows.numRows)) {
+				jm_log_error(&cdata->callbacks, fmu_checker_module, "Out of memory while reading input file %s", fname);
 				return jm_status_error;
 		}
-		*(fmi2_real_t**)jm_vector_get_lastp(jm_voidp)(indata->realInputData) = realData;
-		*(fmi2_integer_t**)jm_vector_get_lastp(jm_voidp)(indata->intInputData) = intData;
-		*(fmi2_boolean_t**)jm_vector_get_lastp(jm_voidp)(indata->boolInputData) = boolData;
-
-		for(varCnt = realVarCnt = intVarCnt = boolVarCnt = 0; 
-			varCnt < fmi2_import_get_variable_list_size(indata->allInputs); 
-			varCnt++) {
-				fmi2_import_variable_t* v = fmi2_import_get_variable(indata->allInputs, varCnt);
-				fmi2_base_type_enu_t type = fmi2_import_get_variable_base_type(v);
-				int err = 0;
-				if(fgetc(infile) != sep) {
-					jm_log_error(&cdata->callbacks, fmu_checker_module, "Expected separator character, got '%c'[%x] instead. Parsing line %i", sep,sep,lineCnt);
+		for(i = 0; i < rows.numRows; i++) {
+			*jm_vector_get_itemp(jm_voidp)(indata->realInputData, i) = rows.parts[0] + i * partSize[0];
+			*jm_vector_get_itemp(jm_voidp)(indata->intInputData, i) = rows.parts[1] + i * partSize[1];
+			*jm_vector_get_itemp(jm_voidp)(indata->boolInputData, i) = rows.parts[2] + i * partSize[2];
+		}
+	}
+	if(cdata->inputCache) {
+		fmi2_input_cache_save(cdata);
+	}
+	if(jm_vector_get_size(double)(&indata->timeStamps)) {
+		fmi2_update_input_interpolation(indata, jm_vector_get_item(double)(&indata->timeStamps,0)-1);
+	}
+	return jm_status_success;
+}
+
+int fmi2_parse_input_row(FILE* infile, char sep, fmi2_import_variable_list_t* allInputs, double* time,
+						 fmi2_real_t* realData, fmi2_integer_t* intData, fmi2_boolean_t* boolData, size_t* badVar) {
+	size_t varCnt, realVarCnt, intVarCnt, boolVarCnt;
+	int ret = 1;
+	int buf;
+
+	/* first column is time */
+	if(fscanf(infile,"%lg",time) != 1) return 0;
+
+	for(varCnt = realVarCnt = intVarCnt = boolVarCnt = 0; 
+		varCnt < fmi2_import_get_variable_list_size(allInputs); 
+		varCnt++) {
+			fmi2_import_variable_t* v = fmi2_import_get_variable(allInputs, varCnt);
+			fmi2_base_type_enu_t type = fmi2_import_get_variable_base_type(v);
+			int err = 0;
+			if(fgetc(infile) != sep) {
+				*badVar = varCnt;
+				ret = -2;
+				break;
+			}
+			switch(type) {
+			case fmi2_base_type_real: 
+				{
+					double dbl;
+					err = (fscanf(infile,"%lg",&dbl) != 1);
+					realData[realVarCnt++] = dbl;
 					break;
 				}
-				switch(type) {
-				case fmi2_base_type_real: 
-					{
-						double dbl;
-						err = (fscanf(infile,"%lg",&dbl) != 1);
-						realData[realVarCnt++] = dbl;
-						break;
-					}
-				case fmi2_base_type_int:
-				case fmi2_base_type_enum: 
-					{
-						int intbuf;
-						err = (fscanf(infile,"%d",&intbuf) != 1);
-						intData[intVarCnt++] = intbuf;
-						break;
-					}
-				case fmi2_base_type_bool: 
-					{
-						int intbuf;
-						err = (fscanf(infile,"%d",&intbuf) != 1) || (intbuf != 0) && (intbuf != 1);
-						boolData[boolVarCnt++] = intbuf;
-						break;
-					}
-				default:
-					err = 1;
+			case fmi2_base_type_int:
+			case fmi2_base_type_enum: 
+				{
+					int intbuf;
+					err = (fscanf(infile,"%d",&intbuf) != 1);
+					intData[intVarCnt++] = intbuf;
 					break;
 				}
-				if(err) {
-					fclose(infile);
-					jm_log_error(indata->cb, fmu_checker_module, "Error parsing input file data [line %d, time '%g', variable '%s']",
-						lineCnt+1, time, fmi2_import_get_variable_name(v));
-					return jm_status_error;
+			case fmi2_base_type_bool: 
+				{
+					int intbuf;
+					err = (fscanf(infile,"%d",&intbuf) != 1) || (intbuf != 0) && (intbuf != 1);
+					boolData[boolVarCnt++] = intbuf;
+					break;
 				}
-		}
-		buf = fgetc(infile);
-		if(buf == '\r') {
-			buf = fgetc(infile);
-		}
+			default:
+				err = 1;
+				break;
+			}
+			if(err) {
+				*badVar = varCnt;
+				return -1;
+			}
 	}
-	if(!feof(infile) || ferror(infile)) {
-		fclose(infile);
-		jm_log_error(&cdata->callbacks, fmu_checker_module, "Could not process input file past line %d.", lineCnt+1);
-		return jm_status_error;
+	/* skip the end of line, the new line itself is left for the chunk parser to see where the next line starts */
+	buf = fgetc(infile);
+	if(buf == '\r') {
+		buf = fgetc(infile);
 	}
-	if(jm_vector_get_size(double)(&indata->timeStamps)) {
-		fmi2_update_input_interpolation(indata, jm_vector_get_item(double)(&indata->timeStamps,0)-1);
+	if(buf == '\n') {
+		ungetc(buf, infile);
 	}
-	return jm_status_success;
+	return ret;
 }
 
 /** Local helper function, checks if it makes seens to look for external events */
-static int fmi2_not_possible_to_have_external_event(fmi2_real_t tcur, fmi2_real_t tnext, fmi2_csv_input_t* indata) {
-    return jm_vector_get_size(double)(&indata->timeStamps) < 2             ||
-           tnext <= jm_vector_get_item(double)(&indata->timeStamps, 0)     ||
-           tcur  >= jm_vector_get_last(double)(&indata->timeStamps);
+static int fmi2_not_possible_to_have_external_event(fmi2_real_t tcur, fmi2_real_t tnext, fmi2_csv_input_t* indata, size_t numRows, int complete) {
+    return (complete && (numRows < 2))                                     ||
+           (tnext <= fmi2_input_start_time(indata))                        ||
+           (complete && (tcur >= fmi2_input_time(indata, numRows - 1)));
 }
 
 jm_status_enu_t fmi2_check_external_events(fmi2_real_t tcur, fmi2_real_t tnext, fmi2_event_info_t* eventInfo, fmi2_csv_input_t* indata){
-    size_t numberOfBools, numberOfInt, numberOfReals, cnt, timeIndex1;
+    size_t numberOfBools, numberOfInt, numberOfReals, cnt, timeIndex1, numRows;
+    int complete;
     double t1;
     fmi2_integer_t *i1, *i2;
     fmi2_real_t *r1, *r2;
     fmi2_boolean_t *b1, *b2;
 
-    if (fmi2_not_possible_to_have_external_event(tcur, tnext, indata)) {
+    if (!fmi2_input_has_data(indata)) {
+        return jm_status_success;
+    }
+    /* the rows up to the first one after tnext are needed */
+    numRows = fmi2_input_rows_until(indata, tnext, &complete);
+    if (!numRows) {
+        return jm_status_error;
+    }
+    if (fmi2_not_possible_to_have_external_event(tcur, tnext, indata, numRows, complete)) {
         return jm_status_success;
     }
 
     timeIndex1 = indata->eventIndex1;
-    if (timeIndex1 == 0) timeIndex1++; /* Need a previous value to check against */
-    t1 = jm_vector_get_item(double)(&indata->timeStamps, timeIndex1);
+    /* Need a previous value to check against. Rows dropped by the streaming reader are before tcur. */
+    if (timeIndex1 <= fmi2_input_first_row(indata)) timeIndex1 = fmi2_input_first_row(indata) + 1;
+    t1 = fmi2_input_time(indata, timeIndex1);
 
     /* Loop until we find a time after the current time */
     while (t1 < tcur) {
         timeIndex1++;
-        t1 = jm_vector_get_item(double)(&indata->timeStamps, timeIndex1);
+        t1 = fmi2_input_time(indata, timeIndex1);
     }
 
     /* Setup for loop */
     numberOfBools = fmi2_import_get_variable_list_size(indata->boolInputs);
     numberOfInt = fmi2_import_get_variable_list_size(indata->intInputs);
     numberOfReals = fmi2_import_get_variable_list_size(indata->realInputs);
-    b1 = (fmi2_boolean_t*)jm_vector_get_item(jm_voidp)(indata->boolInputData,timeIndex1-1);
-    b2 = (fmi2_boolean_t*)jm_vector_get_item(jm_voidp)(indata->boolInputData,timeIndex1);
-    i1 = (fmi2_integer_t*)jm_vector_get_item(jm_voidp)(indata->intInputData,timeIndex1-1);
-    i2 = (fmi2_integer_t*)jm_vector_get_item(jm_voidp)(indata->intInputData,timeIndex1);
-    r1 = (fmi2_real_t*)jm_vector_get_item(jm_voidp)(indata->realInputData,timeIndex1-1);
-    r2 = (fmi2_real_t*)jm_vector_get_item(jm_voidp)(indata->realInputData,timeIndex1);
+    b1 = fmi2_input_bools(indata, timeIndex1-1);
+    b2 = fmi2_input_bools(indata, timeIndex1);
+    i1 = fmi2_input_ints(indata, timeIndex1-1);
+    i2 = fmi2_input_ints(indata, timeIndex1);
+    r1 = fmi2_input_reals(indata, timeIndex1-1);
+    r2 = fmi2_input_reals(indata, timeIndex1);
 
     /* Check for any changes in discrete inputs occurring before the next time */
     while (t1 <= tnext) {
@@ -514,7 +665,7 @@ jm_status_enu_t fmi2_check_external_events(fmi2_real_t tcur, fmi2_real_t tnext,
             }
         }
 
-        if (jm_vector_get_size(double)(&indata->timeStamps) == timeIndex1 + 1) {
+        if (complete && (numRows == timeIndex1 + 1)) {
             /* At last time index, finished */
             indata->eventIndex1 = timeIndex1;
             return jm_status_success;
@@ -527,10 +678,10 @@ jm_status_enu_t fmi2_check_external_events(fmi2_real_t tcur, fmi2_real_t tnext,
 
         /* Increase time index and update values */
         timeIndex1++;
-        t1 = jm_vector_get_item(double)(&indata->timeStamps, timeIndex1);
-        b2 = (fmi2_boolean_t*)jm_vector_get_item(jm_voidp)(indata->boolInputData,timeIndex1);
-        i2 = (fmi2_integer_t*)jm_vector_get_item(jm_voidp)(indata->intInputData,timeIndex1);
-        r2 = (fmi2_real_t*)jm_vector_get_item(jm_voidp)(indata->realInputData,timeIndex1);
+        t1 = fmi2_input_time(indata, timeIndex1);
+        b2 = fmi2_input_bools(indata, timeIndex1);
+        i2 = fmi2_input_ints(indata, timeIndex1);
+        r2 = fmi2_input_reals(indata, timeIndex1);
     }
 
     timeIndex1 = indata->eventIndex1 = timeIndex1 - 1;
@@ -0,0 +1,358 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmi2_input_stream.c
+	Streaming reader for FMI 2.0 input files.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <fmuChecker.h>
+
+#define FMI2_INPUT_STREAM_MSG_SIZE 1000
+
+struct fmi2_input_stream_t {
+	jm_callbacks* cb;
+	FILE* file;
+	char sep;
+	/** File position of the first data line */
+	long dataOffset;
+	fmi2_import_variable_list_t* allInputs;
+	size_t numReals, numInts, numBools;
+
+	/** Protects the window and the reader state below */
+	fmu_check_mutex_t mutex;
+	/** Signaled when a row is added, rows are dropped, a message is taken or the reader is stopped */
+	fmu_check_cond_t cond;
+	fmu_check_thread_t* thread;
+
+	/** Ring of rows: the row in slot k has the time times[k] and the values reals[k*numReals]... */
+	size_t capacity;
+	double* times;
+	fmi2_real_t* reals;
+	fmi2_integer_t* ints;
+	fmi2_boolean_t* bools;
+	/** Slot of the first row in the window */
+	size_t head;
+	/** Absolute index of the first row in the window */
+	size_t firstRow;
+	/** Number of rows in the window */
+	size_t numRows;
+	/** Time of row 0 */
+	double startTime;
+
+	/** Set by the reader after the last row or an error */
+	int eof;
+	/** Set by the reader if the file could not be parsed, the text is in errorMessage */
+	int error;
+	int errorReported;
+	/** Set to stop the reader */
+	int stop;
+	/** Set while the reader waits for free slots */
+	int readerWaiting;
+	/** Message for the log, the reader waits until it is taken */
+	int hasMessage;
+	char message[FMI2_INPUT_STREAM_MSG_SIZE];
+	char errorMessage[FMI2_INPUT_STREAM_MSG_SIZE];
+
+	/** Row buffers of the reader thread */
+	fmi2_real_t* rowReals;
+	fmi2_integer_t* rowInts;
+	fmi2_boolean_t* rowBools;
+
+	/** Statistics */
+	size_t totalRows;
+	size_t maxRows;
+};
+
+/* Slot of a row. head and firstRow are only changed by the simulation thread. */
+static size_t fmi2_input_stream_slot(fmi2_input_stream_t* s, size_t row) {
+	return (s->head + row - s->firstRow) % s->capacity;
+}
+
+double fmi2_input_stream_time(fmi2_input_stream_t* s, size_t row) {
+	return s->times[fmi2_input_stream_slot(s, row)];
+}
+
+fmi2_real_t* fmi2_input_stream_reals(fmi2_input_stream_t* s, size_t row) {
+	return s->reals + fmi2_input_stream_slot(s, row) * s->numReals;
+}
+
+fmi2_integer_t* fmi2_input_stream_ints(fmi2_input_stream_t* s, size_t row) {
+	return s->ints + fmi2_input_stream_slot(s, row) * s->numInts;
+}
+
+fmi2_boolean_t* fmi2_input_stream_bools(fmi2_input_stream_t* s, size_t row) {
+	return s->bools + fmi2_input_stream_slot(s, row) * s->numBools;
+}
+
+size_t fmi2_input_stream_first_row(fmi2_input_stream_t* s) {
+	return s->firstRow;
+}
+
+double fmi2_input_stream_start_time(fmi2_input_stream_t* s) {
+	return s->startTime;
+}
+
+/* Reader thread: parse the data lines into the free slots of the window */
+static void fmi2_input_stream_main(void* data) {
+	fmi2_input_stream_t* s = (fmi2_input_stream_t*)data;
+	size_t lineCnt = 0;
+
+	for(;;) {
+		double time = 0;
+		size_t badVar = 0;
+		int ret = 0;
+
+		if(!feof(s->file)) {
+			lineCnt++;
+			ret = fmi2_parse_input_row(s->file, s->sep, s->allInputs, &time, s->rowReals, s->rowInts, s->rowBools, &badVar);
+		}
+
+		fmu_check_mutex_lock(&s->mutex);
+		if(ret == -1) {
+			jm_snprintf(s->errorMessage, FMI2_INPUT_STREAM_MSG_SIZE, "Error parsing input file data [line %d, time '%g', variable '%s']",
+				(int)lineCnt + 1, time, fmi2_import_get_variable_name(fmi2_import_get_variable(s->allInputs, badVar)));
+			s->error = 1;
+		}
+		else if((ret == 0) && (!feof(s->file) || ferror(s->file))) {
+			jm_snprintf(s->errorMessage, FMI2_INPUT_STREAM_MSG_SIZE, "Could not process input file past line %d.", (int)lineCnt + 1);
+			s->error = 1;
+		}
+		if(ret == -2) {
+			while(s->hasMessage && !s->stop) {
+				fmu_check_cond_wait(&s->cond, &s->mutex);
+			}
+			jm_snprintf(s->message, FMI2_INPUT_STREAM_MSG_SIZE, "Expected separator character, got '%c'[%x] instead. Parsing line %i",
+				s->sep, s->sep, (int)lineCnt);
+			s->hasMessage = 1;
+		}
+		if((ret == 0) || (ret == -1)) {
+			s->eof = 1;
+			fmu_check_cond_broadcast(&s->cond);
+			fmu_check_mutex_unlock(&s->mutex);
+			break;
+		}
+
+		s->readerWaiting = 1;
+		while((s->numRows == s->capacity) && !s->stop) {
+			fmu_check_cond_wait(&s->cond, &s->mutex);
+		}
+		s->readerWaiting = 0;
+		if(s->stop) {
+			fmu_check_mutex_unlock(&s->mutex);
+			break;
+		}
+		{
+			size_t slot = (s->head + s->numRows) % s->capacity;
+			s->times[slot] = time;
+			if(s->numReals) memcpy(s->reals + slot * s->numReals, s->rowReals, s->numReals * sizeof(fmi2_real_t));
+			if(s->numInts) memcpy(s->ints + slot * s->numInts, s->rowInts, s->numInts * sizeof(fmi2_integer_t));
+			if(s->numBools) memcpy(s->bools + slot * s->numBools, s->rowBools, s->numBools * sizeof(fmi2_boolean_t));
+		}
+		if(!s->firstRow && !s->numRows) s->startTime = time;
+		s->numRows++;
+		s->totalRows++;
+		if(s->numRows > s->maxRows) s->maxRows = s->numRows;
+		fmu_check_cond_broadcast(&s->cond);
+		fmu_check_mutex_unlock(&s->mutex);
+	}
+}
+
+/* Allocate a ring with the given capacity and move the rows of the window into it. Called with the mutex locked. */
+static jm_status_enu_t fmi2_input_stream_resize(fmi2_input_stream_t* s, size_t capacity) {
+	jm_callbacks* cb = s->cb;
+	double* times = (double*)cb->malloc(capacity * sizeof(double));
+	fmi2_real_t* reals = (fmi2_real_t*)cb->malloc(capacity * s->numReals * sizeof(fmi2_real_t) + 1);
+	fmi2_integer_t* ints = (fmi2_integer_t*)cb->malloc(capacity * s->numInts * sizeof(fmi2_integer_t) + 1);
+	fmi2_boolean_t* bools = (fmi2_boolean_t*)cb->malloc(capacity * s->numBools * sizeof(fmi2_boolean_t) + 1);
+	size_t i;
+
+	if(!times || !reals || !ints || !bools) {
+		cb->free(times);
+		cb->free(reals);
+		cb->free(ints);
+		cb->free(bools);
+		return jm_status_error;
+	}
+	for(i = 0; i < s->numRows; i++) {
+		size_t slot = (s->head + i) % s->capacity;
+		times[i] = s->times[slot];
+		memcpy(reals + i * s->numReals, s->reals + slot * s->numReals, s->numReals * sizeof(fmi2_real_t));
+		memcpy(ints + i * s->numInts, s->ints + slot * s->numInts, s->numInts * sizeof(fmi2_integer_t));
+		memcpy(bools + i * s->numBools, s->bools + slot * s->numBools, s->numBools * sizeof(fmi2_boolean_t));
+	}
+	cb->free(s->times);
+	cb->free(s->reals);
+	cb->free(s->ints);
+	cb->free(s->bools);
+	s->times = times;
+	s->reals = reals;
+	s->ints = ints;
+	s->bools = bools;
+	s->head = 0;
+	s->capacity = capacity;
+	return jm_status_success;
+}
+
+static jm_status_enu_t fmi2_input_stream_start(fmi2_input_stream_t* s) {
+	s->head = 0;
+	s->firstRow = 0;
+	s->numRows = 0;
+	s->eof = 0;
+	s->error = 0;
+	s->errorReported = 0;
+	s->stop = 0;
+	s->hasMessage = 0;
+	s->thread = fmu_check_thread_start(s->cb, fmi2_input_stream_main, s);
+	if(!s->thread) {
+		jm_log_error(s->cb, fmu_checker_module, "Could not start the input reader thread");
+		return jm_status_error;
+	}
+	return jm_status_success;
+}
+
+static void fmi2_input_stream_stop(fmi2_input_stream_t* s) {
+	if(!s->thread) return;
+	fmu_check_mutex_lock(&s->mutex);
+	s->stop = 1;
+	fmu_check_cond_broadcast(&s->cond);
+	fmu_check_mutex_unlock(&s->mutex);
+	fmu_check_thread_join(s->thread);
+	s->thread = 0;
+}
+
+fmi2_input_stream_t* fmi2_input_stream_open(jm_callbacks* cb, FILE* infile, char sep, fmi2_import_variable_list_t* allInputs,
+											size_t numReals, size_t numInts, size_t numBools) {
+	fmi2_input_stream_t* s = (fmi2_input_stream_t*)cb->calloc(1, sizeof(fmi2_input_stream_t));
+
+	if(!s) {
+		fclose(infile);
+		jm_log_error(cb, fmu_checker_module, "Could not allocate memory");
+		return 0;
+	}
+	s->cb = cb;
+	s->file = infile;
+	s->sep = sep;
+	s->dataOffset = ftell(infile);
+	s->allInputs = allInputs;
+	s->numReals = numReals;
+	s->numInts = numInts;
+	s->numBools = numBools;
+	fmu_check_mutex_init(&s->mutex);
+	fmu_check_cond_init(&s->cond);
+
+	s->rowReals = (fmi2_real_t*)cb->malloc(numReals * sizeof(fmi2_real_t) + 1);
+	s->rowInts = (fmi2_integer_t*)cb->malloc(numInts * sizeof(fmi2_integer_t) + 1);
+	s->rowBools = (fmi2_boolean_t*)cb->malloc(numBools * sizeof(fmi2_boolean_t) + 1);
+	s->capacity = 1;
+	if(!s->rowReals || !s->rowInts || !s->rowBools || (s->dataOffset < 0) ||
+		(fmi2_input_stream_resize(s, FMI2_INPUT_STREAM_WINDOW_ROWS) != jm_status_success)) {
+		jm_log_error(cb, fmu_checker_module, "Could not allocate memory for the input data window");
+		fmi2_input_stream_close(s);
+		return 0;
+	}
+	if(fmi2_input_stream_start(s) != jm_status_success) {
+		fmi2_input_stream_close(s);
+		return 0;
+	}
+	return s;
+}
+
+void fmi2_input_stream_close(fmi2_input_stream_t* s) {
+	jm_callbacks* cb;
+	if(!s) return;
+	cb = s->cb;
+	fmi2_input_stream_stop(s);
+	if(s->totalRows) {
+		jm_log_verbose(cb, fmu_checker_module, "Streamed %u input rows with at most %u rows in memory",
+			(unsigned)s->totalRows, (unsigned)s->maxRows);
+	}
+	if(s->file) fclose(s->file);
+	cb->free(s->times);
+	cb->free(s->reals);
+	cb->free(s->ints);
+	cb->free(s->bools);
+	cb->free(s->rowReals);
+	cb->free(s->rowInts);
+	cb->free(s->rowBools);
+	fmu_check_cond_destroy(&s->cond);
+	fmu_check_mutex_destroy(&s->mutex);
+	cb->free(s);
+}
+
+jm_status_enu_t fmi2_input_stream_fill(fmi2_input_stream_t* s, double t, size_t* endRow, int* complete) {
+	char message[FMI2_INPUT_STREAM_MSG_SIZE];
+
+	fmu_check_mutex_lock(&s->mutex);
+	for(;;) {
+		if(s->hasMessage) {
+			/* log outside of the lock, the logger may be slow */
+			memcpy(message, s->message, sizeof(message));
+			s->hasMessage = 0;
+			fmu_check_cond_broadcast(&s->cond);
+			fmu_check_mutex_unlock(&s->mutex);
+			jm_log_error(s->cb, fmu_checker_module, "%s", message);
+			fmu_check_mutex_lock(&s->mutex);
+			continue;
+		}
+		if(s->numRows && (s->times[(s->head + s->numRows - 1) % s->capacity] > t)) break;
+		if(s->error) {
+			int report = !s->errorReported;
+			memcpy(message, s->errorMessage, sizeof(message));
+			s->errorReported = 1;
+			fmu_check_mutex_unlock(&s->mutex);
+			if(report) jm_log_error(s->cb, fmu_checker_module, "%s", message);
+			return jm_status_error;
+		}
+		if(s->eof) break;
+		if(s->numRows == s->capacity) {
+			/* a single step needs more rows than fit into the window */
+			if(fmi2_input_stream_resize(s, 2 * s->capacity) != jm_status_success) {
+				fmu_check_mutex_unlock(&s->mutex);
+				jm_log_error(s->cb, fmu_checker_module, "Out of memory while reading the input file");
+				return jm_status_error;
+			}
+			jm_log_verbose(s->cb, fmu_checker_module, "Input data window enlarged to %u rows", (unsigned)s->capacity);
+		}
+		fmu_check_cond_broadcast(&s->cond);
+		fmu_check_cond_wait(&s->cond, &s->mutex);
+	}
+	*endRow = s->firstRow + s->numRows;
+	*complete = s->eof;
+	fmu_check_mutex_unlock(&s->mutex);
+	return jm_status_success;
+}
+
+void fmi2_input_stream_release(fmi2_input_stream_t* s, size_t row) {
+	size_t n;
+	if(row <= s->firstRow) return;
+
+	fmu_check_mutex_lock(&s->mutex);
+	n = row - s->firstRow;
+	if(n > s->numRows) n = s->numRows;
+	s->head = (s->head + n) % s->capacity;
+	s->firstRow += n;
+	s->numRows -= n;
+	/* wake the reader when a batch of slots is free rather than for every row */
+	if(s->readerWaiting && (s->capacity - s->numRows >= s->capacity / 8)) {
+		fmu_check_cond_broadcast(&s->cond);
+	}
+	fmu_check_mutex_unlock(&s->mutex);
+}
+
+jm_status_enu_t fmi2_input_stream_restart(fmi2_input_stream_t* s) {
+	fmi2_input_stream_stop(s);
+	clearerr(s->file);
+	if(fseek(s->file, s->dataOffset, SEEK_SET) != 0) {
+		jm_log_error(s->cb, fmu_checker_module, "Could not rewind the input file");
+		return jm_status_error;
+	}
+	jm_log_verbose(s->cb, fmu_checker_module, "Reading the input file from the start");
+	return fmi2_input_stream_start(s);
+}
@@ -12,16 +12,27 @@ Simulation loop for the FMI 2.0 model exchange FMUs
 #include <fmilib.h>
 
 
-/*Helper event iteration*/
-fmi2_status_t do_event_iteration(fmi2_import_t *fmu, fmi2_event_info_t *eventInfo)
+/*Helper event iteration. The number of iterations is limited by cdata->maxEventIterations.
+  Returns jm_status_error if the limit is reached. The status of the last FMU call is returned in fmistatus.*/
+static jm_status_enu_t do_event_iteration(fmu_check_data_t* cdata, fmi2_real_t tcur, fmi2_event_info_t *eventInfo, fmi2_status_t* fmistatus)
 {
-	fmi2_status_t fmistatus = fmi2_status_ok;
+	unsigned int iterations = 0;
+	*fmistatus = fmi2_status_ok;
 	eventInfo->newDiscreteStatesNeeded = fmi2_true;
 	eventInfo->terminateSimulation     = fmi2_false;
 	while (eventInfo->newDiscreteStatesNeeded && !eventInfo->terminateSimulation) {
-		fmistatus = fmi2_import_new_discrete_states(fmu, eventInfo);
+		if(iterations++ == cdata->maxEventIterations) {
+			jm_log_fatal(&cdata->callbacks, fmu_checker_module,
+				"Simulation terminated at time %g since the event iteration did not converge after %u fmi2NewDiscreteStates calls "
+				"(newDiscreteStatesNeeded is still true, see --max-event-iterations)", tcur, cdata->maxEventIterations);
+			return jm_status_error;
+		}
+		fmu_check_watch(cdata, "fmi2NewDiscreteStates", tcur);
+		*fmistatus = fmi2_import_new_discrete_states(cdata->fmu2, eventInfo);
+		fmu_check_watch_end(cdata);
+		if(!fmi2_status_ok_or_warning(*fmistatus)) break;
 	}
-	return fmistatus;
+	return jm_status_success;
 }
 
 
@@ -55,51 +66,26 @@ jm_status_enu_t fmi2_me_simulate(fmu_check_data_t* cdata)
 	n_states = fmi2_import_get_number_of_continuous_states(fmu);	
 	n_event_indicators = fmi2_import_get_number_of_event_indicators(fmu);
 
-	if(n_states) {
-		states = cb->calloc(n_states, sizeof(double));
-		states_der = cb->calloc(n_states, sizeof(double));
-		if(!states || !states_der) {
-			cb->free(states);
-			cb->free(states_der);
-			jm_log_fatal(cb, fmu_checker_module, "Could not allocated memory");
-			return jm_status_error;
-		}
-	}
-	if(n_event_indicators) {
-		event_indicators = cb->calloc(n_event_indicators, sizeof(double));
-		event_indicators_prev = cb->calloc(n_event_indicators, sizeof(double));
-
-		if( !event_indicators || !event_indicators_prev) {
-			cb->free(states);
-			cb->free(states_der);
-			cb->free(event_indicators);
-			cb->free(event_indicators_prev);
-			jm_log_fatal(cb, fmu_checker_module, "Could not allocated memory");
-			return jm_status_error;
-		}
+	/* the buffers are owned by the arena and released with the checker data */
+	states = fmu_check_arena_calloc(&cdata->arena, n_states, sizeof(double));
+	states_der = fmu_check_arena_calloc(&cdata->arena, n_states, sizeof(double));
+	event_indicators = fmu_check_arena_calloc(&cdata->arena, n_event_indicators, sizeof(double));
+	event_indicators_prev = fmu_check_arena_calloc(&cdata->arena, n_event_indicators, sizeof(double));
+	if(!states || !states_der || !event_indicators || !event_indicators_prev) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not allocated memory");
+		return jm_status_error;
 	}
 
-	cdata->instanceNameSavedPtr = 0;
-	cdata->instanceNameToCompare = "Test FMI 2.0 ME";
-
-	jmstatus = fmi2_import_instantiate(fmu, cdata->instanceNameToCompare,fmi2_model_exchange,0,0);
-
-	cdata->instanceNameSavedPtr = cdata->instanceNameToCompare;
+	fmu_check_phase_begin(cdata, fmu_check_phase_instantiate);
+	jmstatus = fmi2_instantiate_or_reset(cdata, "Test FMI 2.0 ME", fmi2_model_exchange, fmi2_false);
 
 	if (jmstatus == jm_status_error) {
 		jm_log_fatal(cb, fmu_checker_module, "Could not instantiate the model");
-		cb->free(states);
-		cb->free(states_der);
-		cb->free(event_indicators);
-		cb->free(event_indicators_prev);		
 		return jm_status_error;
 	}
 	
-	if (
-		fmi2_status_ok_or_warning(fmistatus = fmi2_set_inputs(cdata, tstart)) &&
-		fmi2_status_ok_or_warning(fmistatus =  fmi2_import_setup_experiment(fmu, toleranceControlled,relativeTolerance, tstart, fmi2_false, 0.0)) && 
-		fmi2_status_ok_or_warning(fmistatus = fmi2_import_enter_initialization_mode(fmu)) &&
-		fmi2_status_ok_or_warning(fmi2_import_exit_initialization_mode(fmu))) {
+	fmu_check_phase_begin(cdata, fmu_check_phase_initialize);
+	if (fmi2_status_ok_or_warning(fmistatus = fmi2_initialize_fmu(cdata, fmi2_model_exchange, toleranceControlled, relativeTolerance, tstart))) {
 
 			tcur = tstart;
 			hcur = hdef;
@@ -113,25 +99,36 @@ jm_status_enu_t fmi2_me_simulate(fmu_check_data_t* cdata)
 			eventInfo.nextEventTime                     = -0.0;
 
 			/* fmiExitInitializationMode leaves FMU in event mode */
-			do_event_iteration(fmu, &eventInfo);
-
-			if (!fmi2_status_ok_or_warning( fmistatus = fmi2_import_enter_continuous_time_mode(fmu))){
-				jm_log_fatal(cb, fmu_checker_module, "Could not enter continuous time mode");
+			if (do_event_iteration(cdata, tstart, &eventInfo, &fmistatus) != jm_status_success) {
 				jmstatus = jm_status_error;
 			}
-
-			if(( (n_states == 0) || 
-				fmi2_status_ok_or_warning(fmistatus = fmi2_import_get_continuous_states(fmu, states, n_states))
-				) &&
-				( (n_event_indicators == 0) || 
-				fmi2_status_ok_or_warning(fmistatus = fmi2_import_get_event_indicators(fmu, event_indicators_prev, n_event_indicators))
-				)){
-					jm_log_info(cb, fmu_checker_module, "Initialized FMU for simulation starting at time %g", tstart);
+			else if (!fmi2_status_ok_or_warning(fmistatus)) {
+				jm_log_fatal(cb, fmu_checker_module, "Event iteration failed after initialization");
+				jmstatus = jm_status_error;
 			}
 			else {
-				jm_log_fatal(cb, fmu_checker_module, "Failed to retrieve initial FMU states (FMU status: %s)", fmi2_status_to_string(fmistatus));
-				fmistatus = fmi2_status_fatal;
-				jmstatus = jm_status_error;
+				fmu_check_watch(cdata, "fmi2EnterContinuousTimeMode", tstart);
+				if (!fmi2_status_ok_or_warning( fmistatus = fmi2_import_enter_continuous_time_mode(fmu))){
+					jm_log_fatal(cb, fmu_checker_module, "Could not enter continuous time mode");
+					jmstatus = jm_status_error;
+				}
+				fmu_check_watch_end(cdata);
+
+				fmu_check_watch(cdata, "fmi2GetContinuousStates", tstart);
+				if(( (n_states == 0) || 
+					fmi2_status_ok_or_warning(fmistatus = fmi2_import_get_continuous_states(fmu, states, n_states))
+					) &&
+					( (n_event_indicators == 0) || 
+					fmi2_status_ok_or_warning(fmistatus = fmi2_import_get_event_indicators(fmu, event_indicators_prev, n_event_indicators))
+					)){
+						fmu_check_watch_end(cdata);
+						jm_log_info(cb, fmu_checker_module, "Initialized FMU for simulation starting at time %g", tstart);
+				}
+				else {
+					jm_log_fatal(cb, fmu_checker_module, "Failed to retrieve initial FMU states (FMU status: %s)", fmi2_status_to_string(fmistatus));
+					fmistatus = fmi2_status_fatal;
+					jmstatus = jm_status_error;
+				}
 			}
 	}
 	else {
@@ -141,7 +138,10 @@ jm_status_enu_t fmi2_me_simulate(fmu_check_data_t* cdata)
 	}
 
 
-	if((jmstatus != jm_status_error) && (fmi2_write_csv_data(cdata, tstart) != jm_status_success)) {
+	fmu_check_phase_begin(cdata, fmu_check_phase_simulate);
+	fmu_check_realtime_start(cdata, tstart);
+	fmi2_resample_start(cdata);
+	if((jmstatus == jm_status_error) || (fmi2_write_csv_data(cdata, tstart) != jm_status_success)) {
 		jmstatus = jm_status_error;
 	}
 	else while ((tcur < tend) && (!(eventInfo.terminateSimulation || terminateSimulation)) && fmi2_status_ok_or_warning(fmistatus) ) {
@@ -150,6 +150,7 @@ jm_status_enu_t fmi2_me_simulate(fmu_check_data_t* cdata)
 		int time_event = 0;
 
 		/* Get derivatives */
+		fmu_check_watch(cdata, "fmi2GetDerivatives", tcur);
 		if( (n_states > 0) &&  !fmi2_status_ok_or_warning(fmistatus = fmi2_import_get_derivatives(fmu, states_der, n_states))) {
 			if(fmistatus != fmi2_status_discard)
 				jm_log_fatal(cb, fmu_checker_module, "Could not retrieve time derivatives");
@@ -157,6 +158,7 @@ jm_status_enu_t fmi2_me_simulate(fmu_check_data_t* cdata)
 				jm_log_warning(cb, fmu_checker_module, "Could not retrieve time derivatives since FMU returned fmiDiscard");
 			break;
 		}
+		fmu_check_watch_end(cdata);
 
 		/* Choose time step and advance tcur */
 		tnext = tcur + hdef;
@@ -184,10 +186,12 @@ jm_status_enu_t fmi2_me_simulate(fmu_check_data_t* cdata)
 
         /* Set time */
         jm_log_verbose(cb, fmu_checker_module, "Simulation time: %g", tcur);
+        fmu_check_watch(cdata, "fmi2SetTime", tcur);
         if (!fmi2_status_ok_or_warning(fmistatus = fmi2_import_set_time(fmu, tcur))) {
             jm_log_fatal(cb, fmu_checker_module, "Could not set simulation time to %g", tcur);
             break;
         }
+        fmu_check_watch_end(cdata);
 
 		/* Set inputs */
 		if(!fmi2_status_ok_or_warning(fmistatus = fmi2_set_inputs(cdata, tcur))) {
@@ -201,6 +205,7 @@ jm_status_enu_t fmi2_me_simulate(fmu_check_data_t* cdata)
 		}
 
 		/* Set states */
+		fmu_check_watch(cdata, "fmi2SetContinuousStates", tcur);
 		if( (n_states > 0) && !fmi2_status_ok_or_warning(fmistatus = fmi2_import_set_continuous_states(fmu, states, n_states))) {
 			if(fmistatus != fmi2_status_discard)
 				jm_log_fatal(cb, fmu_checker_module, "Could not set continuous states");
@@ -208,8 +213,10 @@ jm_status_enu_t fmi2_me_simulate(fmu_check_data_t* cdata)
 				jm_log_warning(cb, fmu_checker_module, "Could not set continuous states since FMU returned fmiDiscard");
 			break;
 		}
+		fmu_check_watch_end(cdata);
 
 		/* Check if an event indicator has triggered */
+		fmu_check_watch(cdata, "fmi2GetEventIndicators", tcur);
 		if( (n_event_indicators > 0) && 
 			!fmi2_status_ok_or_warning(fmistatus = fmi2_import_get_event_indicators(fmu, event_indicators, n_event_indicators))
 			) {
@@ -219,6 +226,7 @@ jm_status_enu_t fmi2_me_simulate(fmu_check_data_t* cdata)
 					jm_log_warning(cb, fmu_checker_module, "Could not get event indicators since FMU returned fmiDiscard");
 				break;
 		}
+		fmu_check_watch_end(cdata);
 
 		for (k = 0; k < n_event_indicators; k++) {
 			if (event_indicators[k]*event_indicators_prev[k] < 0) {
@@ -228,10 +236,12 @@ jm_status_enu_t fmi2_me_simulate(fmu_check_data_t* cdata)
 		}
 
 		/* Step is completed */
+		fmu_check_watch(cdata, "fmi2CompletedIntegratorStep", tcur);
 		if(  !fmi2_status_ok_or_warning(fmistatus = fmi2_import_completed_integrator_step(fmu, fmi2_true, &enterEventMode, &terminateSimulation))){
 			jm_log_fatal(cb, fmu_checker_module, "Could not complete integrator step");
 			break;
 		}
+		fmu_check_watch_end(cdata);
 
 		/* Handle events */
 		if (enterEventMode || zero_crossning_event || time_event) {
@@ -248,16 +258,23 @@ jm_status_enu_t fmi2_me_simulate(fmu_check_data_t* cdata)
 				}
 			}
 
+			fmu_check_watch(cdata, "fmi2EnterEventMode", tcur);
 			if( !fmi2_status_ok_or_warning(fmistatus = fmi2_import_enter_event_mode(fmu))){
 				jm_log_fatal(cb, fmu_checker_module, "Could not enter event mode");
 				break;
 			}
+			fmu_check_watch_end(cdata);
 
-			if(!fmi2_status_ok_or_warning(fmistatus = do_event_iteration(fmu, &eventInfo))){
+			if(do_event_iteration(cdata, tcur, &eventInfo, &fmistatus) != jm_status_success) {
+				jmstatus = jm_status_error;
+				break;
+			}
+			if(!fmi2_status_ok_or_warning(fmistatus)){
 				jm_log_fatal(cb, fmu_checker_module, "Event iteration failed event mode");
 				break;
 			}
 
+			fmu_check_watch(cdata, "fmi2GetContinuousStates", tcur);
 			if( eventInfo.valuesOfContinuousStatesChanged &&
 				!fmi2_status_ok_or_warning(fmistatus = fmi2_import_get_continuous_states(fmu, states, n_states))) {
 					jm_log_fatal(cb, fmu_checker_module, "Could not get continuous states");
@@ -273,10 +290,13 @@ jm_status_enu_t fmi2_me_simulate(fmu_check_data_t* cdata)
 				jm_log_fatal(cb, fmu_checker_module, "Could not get event indicators");
 				break;
 			}
+			fmu_check_watch_end(cdata);
+			fmu_check_watch(cdata, "fmi2EnterContinuousTimeMode", tcur);
 			if( !fmi2_status_ok_or_warning(fmistatus = fmi2_import_enter_continuous_time_mode(fmu))){
 				jm_log_fatal(cb, fmu_checker_module, "Could not enter continuous time mode");
 				break;
 			}
+			fmu_check_watch_end(cdata);
 		}	
 		/* print current variable values*/
 		if(fmi2_write_csv_data(cdata, tcur) != jm_status_success) {
@@ -287,7 +307,10 @@ jm_status_enu_t fmi2_me_simulate(fmu_check_data_t* cdata)
 			jm_log_info(cb, fmu_checker_module, "FMU requested simulation termination");
 			break;
 		}
+		fmu_check_realtime_step(cdata, tcur);
 	} /* while */
+	fmu_check_watch_end(cdata);
+	fmu_check_realtime_report(cdata);
 
 	if(fmistatus == fmi2_status_discard) {
 		jm_log_warning(cb, fmu_checker_module, "Simulation loop terminated at time %g since FMU returned fmiDiscard. Running with shorter time step may help.", tcur);
@@ -300,18 +323,23 @@ jm_status_enu_t fmi2_me_simulate(fmu_check_data_t* cdata)
 		jm_log_info(cb, fmu_checker_module, "Simulation finished successfully at time %g", tcur);
 	}
 
+	fmu_check_phase_begin(cdata, fmu_check_phase_terminate);
 	if(fmistatus != fmi2_status_fatal) {
-		if(  (fmistatus = fmi2_import_terminate(fmu)) != fmi2_status_ok) {
+		fmu_check_watch(cdata, "fmi2Terminate", tcur);
+		fmistatus = fmi2_import_terminate(fmu);
+		fmu_check_watch_end(cdata);
+		if(fmistatus != fmi2_status_ok) {
 			jm_log_error(cb, fmu_checker_module, "fmiTerminate returned status: %s", fmi2_status_to_string(fmistatus));
 		}
 
-		fmi2_import_free_instance(fmu);
+		if(cdata->fmu2_reuse_instance && (jmstatus != jm_status_error) && fmi2_status_ok_or_warning(fmistatus)) {
+			/* the instance is reset for the next run */
+			cdata->fmu2_instance_alive = 1;
+		}
+		else
+			fmi2_import_free_instance(fmu);
 	}
-
-	cb->free(states);
-	cb->free(states_der);
-	cb->free(event_indicators);
-	cb->free(event_indicators_prev);
+	fmu_check_phase_end(cdata);
 
 	return 	jmstatus;
 }
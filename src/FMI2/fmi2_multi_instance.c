@@ -0,0 +1,507 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmi2_multi_instance.c
+	Concurrent multi-instance check of FMI 2.0 CS FMUs (--instances option).
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <fmuChecker.h>
+#include <fmilib.h>
+
+/** One instance with its own import of the FMU */
+typedef struct fmi2_multi_instance_member_t {
+	fmu_check_data_t cdata;
+	/** Instance name */
+	char name[32];
+	fmi2_column_values_t values;
+	/** Row as compared: time, reals, integers and booleans */
+	double* row;
+	int started;
+
+	/** Result of the last run */
+	fmi2_status_t status;
+	/** FMI function that failed (NULL on success) */
+	const char* function;
+	double failTime;
+	size_t numSteps;
+	size_t numRows;
+	double loopStart;
+	double loopEnd;
+	/** First row that differs from the single-instance run (-1 if none) and the value in the row (-1 for the number of rows) */
+	long divergedRow;
+	long divergedSlot;
+	double divergedTime;
+} fmi2_multi_instance_member_t;
+
+typedef struct fmi2_multi_instance_t {
+	fmu_check_data_t* cdata;
+	jm_callbacks* cb;
+	fmi2_multi_instance_member_t* members;
+	size_t numMembers;
+
+	fmi2_real_t tstart;
+	fmi2_real_t tend;
+	fmi2_real_t hstep;
+	fmi2_boolean_t canHandleVarStepSize;
+
+	/** Values per row */
+	size_t rowSize;
+	/** Set while the single-instance run keeps its rows */
+	int recording;
+	int outOfMemory;
+	double* refRows;
+	size_t numRefRows;
+	size_t refCapacity;
+
+	/** Start gate so that the instances start together */
+	fmu_check_mutex_t lock;
+	fmu_check_cond_t gate;
+	int go;
+} fmi2_multi_instance_t;
+
+/* Name of the variable of a row slot (see fmi2_multi_instance_row()) */
+static const char* fmi2_multi_instance_slot_name(fmu_check_data_t* cdata, long slot) {
+	fmi2_column_plan_t* plan = &cdata->fmu2_columns;
+	size_t i;
+
+	if(slot <= 0) return "time";
+	for(i = 0; i < plan->numReadCols; i++) {
+		fmi2_column_t* col = &plan->cols[i];
+		size_t s = 1 + col->index;
+		switch(col->type) {
+		case fmi2_base_type_str:
+			continue;
+		case fmi2_base_type_bool:
+			s += plan->numInts;
+			/* fall through */
+		case fmi2_base_type_int:
+		case fmi2_base_type_enum:
+			s += plan->numReals;
+			break;
+		default:
+			break;
+		}
+		if(s == (size_t)slot) return fmi2_import_get_variable_name(col->var);
+	}
+	return "?";
+}
+
+/* Keep the row of the single-instance run. Returns 0 if out of memory. */
+static int fmi2_multi_instance_keep_row(fmi2_multi_instance_t* mi, const double* row) {
+	if(mi->numRefRows == mi->refCapacity) {
+		size_t capacity = mi->refCapacity ? 2 * mi->refCapacity : 1024;
+		double* rows = (double*)mi->cb->realloc(mi->refRows, capacity * mi->rowSize * sizeof(double));
+		if(!rows) return 0;
+		mi->refRows = rows;
+		mi->refCapacity = capacity;
+	}
+	memcpy(mi->refRows + mi->numRefRows * mi->rowSize, row, mi->rowSize * sizeof(double));
+	mi->numRefRows++;
+	return 1;
+}
+
+/* Get the outputs after a step and keep or compare them. Runs on the instance thread. */
+static fmi2_status_t fmi2_multi_instance_row(fmi2_multi_instance_t* mi, fmi2_multi_instance_member_t* m, double time) {
+	fmi2_import_t* fmu = m->cdata.fmu2;
+	fmi2_column_plan_t* plan = &m->cdata.fmu2_columns;
+	double* row = m->row;
+	fmi2_status_t status = fmi2_status_ok, s;
+	size_t k, n = 0;
+
+	if(plan->numReals) {
+		s = fmi2_import_get_real(fmu, plan->vrReals, plan->numReals, m->values.reals);
+		if(s > status) status = s;
+	}
+	if(plan->numInts) {
+		s = fmi2_import_get_integer(fmu, plan->vrInts, plan->numInts, m->values.ints);
+		if(s > status) status = s;
+	}
+	if(plan->numBools) {
+		s = fmi2_import_get_boolean(fmu, plan->vrBools, plan->numBools, m->values.bools);
+		if(s > status) status = s;
+	}
+	fmu_check_watch_end(&m->cdata);
+	if(!fmi2_status_ok_or_warning(status)) return status;
+
+	row[n++] = time;
+	for(k = 0; k < plan->numReals; k++) row[n++] = m->values.reals[k];
+	for(k = 0; k < plan->numInts; k++) row[n++] = (double)m->values.ints[k];
+	for(k = 0; k < plan->numBools; k++) row[n++] = m->values.bools[k] ? 1.0 : 0.0;
+
+	if(mi->recording) {
+		if(!mi->outOfMemory && !fmi2_multi_instance_keep_row(mi, row)) mi->outOfMemory = 1;
+	}
+	else if(m->divergedRow < 0) {
+		const double* ref = mi->refRows + m->numRows * mi->rowSize;
+		if(m->numRows >= mi->numRefRows) {
+			m->divergedRow = (long)m->numRows;
+			m->divergedSlot = -1;
+			m->divergedTime = time;
+		}
+		else if(memcmp(row, ref, mi->rowSize * sizeof(double)) != 0) {
+			for(k = 0; (k < mi->rowSize) && (memcmp(&row[k], &ref[k], sizeof(double)) == 0); k++);
+			m->divergedRow = (long)m->numRows;
+			m->divergedSlot = (long)k;
+			m->divergedTime = time;
+		}
+	}
+	m->numRows++;
+	return status;
+}
+
+/* Instantiate, initialize and simulate one instance. Nothing is logged by the checker here. */
+static void fmi2_multi_instance_run(fmi2_multi_instance_t* mi, fmi2_multi_instance_member_t* m) {
+	fmi2_import_t* fmu = m->cdata.fmu2;
+	fmi2_real_t tcur = mi->tstart, hstep = mi->hstep;
+	fmi2_status_t status;
+
+	m->numSteps = 0;
+	m->numRows = 0;
+	m->divergedRow = -1;
+	m->divergedSlot = -1;
+	m->loopStart = m->loopEnd = fmu_check_wall_clock();
+
+	m->cdata.instanceNameSavedPtr = 0;
+	m->function = "fmi2Instantiate";
+	fmu_check_watch(&m->cdata, m->function, tcur);
+	if(fmi2_import_instantiate(fmu, m->name, fmi2_cosimulation, 0, fmi2_false) == jm_status_error) {
+		m->status = fmi2_status_error;
+		m->failTime = tcur;
+		fmu_check_watch_end(&m->cdata);
+		return;
+	}
+	fmu_check_watch_end(&m->cdata);
+	m->cdata.instanceNameSavedPtr = m->name;
+
+	m->function = "fmi2SetupExperiment";
+	fmu_check_watch(&m->cdata, m->function, tcur);
+	status = fmi2_import_setup_experiment(fmu, fmi2_false, fmi2_import_get_default_experiment_tolerance(fmu), tcur, fmi2_false, 0.0);
+	if(fmi2_status_ok_or_warning(status)) {
+		m->function = "fmi2EnterInitializationMode";
+		fmu_check_watch(&m->cdata, m->function, tcur);
+		status = fmi2_import_enter_initialization_mode(fmu);
+	}
+	if(fmi2_status_ok_or_warning(status)) {
+		m->function = "fmi2ExitInitializationMode";
+		fmu_check_watch(&m->cdata, m->function, tcur);
+		status = fmi2_import_exit_initialization_mode(fmu);
+	}
+	fmu_check_watch_end(&m->cdata);
+	if(fmi2_status_ok_or_warning(status)) {
+		m->function = "fmi2GetXXX";
+		fmu_check_watch(&m->cdata, m->function, tcur);
+		status = fmi2_multi_instance_row(mi, m, tcur);
+	}
+
+	m->loopStart = fmu_check_wall_clock();
+	while(fmi2_status_ok_or_warning(status) && (tcur < mi->tend)) {
+		fmi2_real_t tnext = tcur + hstep;
+		if((tnext > mi->tend - 1e-3*hstep) && mi->canHandleVarStepSize) { /* last step should be on tend */
+			hstep = mi->tend - tcur;
+			tnext = mi->tend;
+		}
+		m->function = "fmi2DoStep";
+		fmu_check_watch(&m->cdata, m->function, tcur);
+		status = fmi2_import_do_step(fmu, tcur, hstep, fmi2_true);
+		if(status == fmi2_status_discard) {
+			fmi2_boolean_t terminated = fmi2_false;
+			if(fmi2_status_ok_or_warning(fmi2_import_get_boolean_status(fmu, fmi2_terminated, &terminated)) && terminated) {
+				status = fmi2_status_ok;
+				fmu_check_watch_end(&m->cdata);
+				break;
+			}
+		}
+		fmu_check_watch_end(&m->cdata);
+		if(!fmi2_status_ok_or_warning(status)) break;
+		tcur = tnext;
+		m->numSteps++;
+		m->function = "fmi2GetXXX";
+		fmu_check_watch(&m->cdata, m->function, tcur);
+		status = fmi2_multi_instance_row(mi, m, tcur);
+	}
+	m->loopEnd = fmu_check_wall_clock();
+
+	if(fmi2_status_ok_or_warning(status)) {
+		m->function = "fmi2Terminate";
+		fmu_check_watch(&m->cdata, m->function, tcur);
+		status = fmi2_import_terminate(fmu);
+		fmu_check_watch_end(&m->cdata);
+		if(fmi2_status_ok_or_warning(status)) m->function = 0;
+	}
+	m->status = status;
+	m->failTime = tcur;
+	if(status != fmi2_status_fatal) {
+		fmi2_import_free_instance(fmu);
+	}
+}
+
+typedef struct fmi2_multi_instance_task_t {
+	fmi2_multi_instance_t* mi;
+	fmi2_multi_instance_member_t* member;
+} fmi2_multi_instance_task_t;
+
+/* Instance thread: wait at the gate and run */
+static void fmi2_multi_instance_thread(void* data) {
+	fmi2_multi_instance_task_t* task = (fmi2_multi_instance_task_t*)data;
+	fmi2_multi_instance_t* mi = task->mi;
+
+	fmu_check_mutex_lock(&mi->lock);
+	while(!mi->go) {
+		fmu_check_cond_wait(&mi->gate, &mi->lock);
+	}
+	fmu_check_mutex_unlock(&mi->lock);
+	if(task->member->started) {
+		fmi2_multi_instance_run(mi, task->member);
+	}
+}
+
+/* Parse the XML and load the CS binary for another instance. Messages were already reported for the checked FMU. */
+static jm_status_enu_t fmi2_multi_instance_load(fmi2_multi_instance_t* mi, fmi2_multi_instance_member_t* m, size_t i) {
+	fmu_check_data_t* cdata = &m->cdata;
+	fmi2_callback_functions_t callBackFunctions;
+	jm_log_level_enu_t logLevel;
+	jm_status_enu_t status = jm_status_error;
+
+	init_fmu_check_child_data(cdata, mi->cdata);
+	jm_snprintf(m->name, sizeof(m->name), "Test FMI 2.0 CS instance %u", (unsigned)(i + 1));
+	cdata->instanceNameToCompare = m->name;
+	/* the output columns and their value references are shared */
+	cdata->fmu2_columns = mi->cdata->fmu2_columns;
+
+	callBackFunctions.allocateMemory = check_calloc;
+	callBackFunctions.freeMemory = check_free;
+	callBackFunctions.logger = fmi2_checker_logger;
+	callBackFunctions.stepFinished = 0;
+	callBackFunctions.componentEnvironment = cdata;
+
+	logLevel = cdata->callbacks.log_level;
+	if(logLevel > jm_log_level_error) cdata->callbacks.log_level = jm_log_level_error;
+	cdata->context = fmi_import_allocate_context(&cdata->callbacks);
+	if(cdata->context) {
+		cdata->fmu2 = fmi2_import_parse_xml(cdata->context, mi->cdata->tmpPath, 0);
+	}
+	if(cdata->fmu2 && (fmi2_import_create_dllfmu(cdata->fmu2, fmi2_fmu_kind_cs, &callBackFunctions) != jm_status_error)) {
+		status = jm_status_success;
+	}
+	cdata->callbacks.log_level = logLevel;
+	if(status != jm_status_success) {
+		jm_log_fatal(mi->cb, fmu_checker_module, "Could not load instance %u of the FMU for the multi-instance check", (unsigned)(i + 1));
+		return jm_status_error;
+	}
+
+	if(fmi2_alloc_column_values(cdata, &m->values) != jm_status_success) return jm_status_error;
+	m->row = (double*)fmu_check_arena_calloc(&cdata->arena, mi->rowSize, sizeof(double));
+	if(!m->row) {
+		jm_log_fatal(mi->cb, fmu_checker_module, "Could not allocate memory");
+		return jm_status_error;
+	}
+	return jm_status_success;
+}
+
+/* Run the first n instances concurrently, one thread each */
+static jm_status_enu_t fmi2_multi_instance_run_concurrently(fmi2_multi_instance_t* mi, size_t n) {
+	jm_callbacks* cb = mi->cb;
+	fmi2_multi_instance_task_t* tasks = (fmi2_multi_instance_task_t*)cb->calloc(n, sizeof(fmi2_multi_instance_task_t));
+	fmu_check_thread_t** threads = (fmu_check_thread_t**)cb->calloc(n, sizeof(fmu_check_thread_t*));
+	jm_status_enu_t status = jm_status_success;
+	size_t i;
+
+	if(!tasks || !threads) {
+		if(tasks) cb->free(tasks);
+		if(threads) cb->free(threads);
+		jm_log_fatal(cb, fmu_checker_module, "Could not allocate memory");
+		return jm_status_error;
+	}
+	mi->go = 0;
+	for(i = 0; i < n; i++) {
+		tasks[i].mi = mi;
+		tasks[i].member = &mi->members[i];
+		mi->members[i].started = 1;
+		threads[i] = fmu_check_thread_start(cb, fmi2_multi_instance_thread, &tasks[i]);
+		if(!threads[i]) {
+			jm_log_fatal(cb, fmu_checker_module, "Could not start a thread for instance %u", (unsigned)(i + 1));
+			status = jm_status_error;
+			break;
+		}
+	}
+	if(status != jm_status_success) {
+		/* the started threads return without running */
+		for(i = 0; i < n; i++) mi->members[i].started = 0;
+	}
+	fmu_check_mutex_lock(&mi->lock);
+	mi->go = 1;
+	fmu_check_cond_broadcast(&mi->gate);
+	fmu_check_mutex_unlock(&mi->lock);
+	for(i = 0; i < n; i++) {
+		if(threads[i]) fmu_check_thread_join(threads[i]);
+	}
+	cb->free(tasks);
+	cb->free(threads);
+	return status;
+}
+
+/* Report the failures and differences of a run. Returns jm_status_error if there are any. */
+static jm_status_enu_t fmi2_multi_instance_report(fmi2_multi_instance_t* mi, size_t n) {
+	jm_callbacks* cb = mi->cb;
+	fmi2_multi_instance_member_t* first = 0;
+	size_t i, numFailed = 0, numDiverged = 0;
+
+	for(i = 0; i < n; i++) {
+		fmi2_multi_instance_member_t* m = &mi->members[i];
+		if(m->function) {
+			jm_log_error(cb, fmu_checker_module, "Instance %u of %u running concurrently failed in %s at time %g (FMU status: %s)",
+				(unsigned)(i + 1), (unsigned)n, m->function, m->failTime, fmi2_status_to_string(m->status));
+			numFailed++;
+			continue;
+		}
+		if((m->divergedRow < 0) && (m->numRows != mi->numRefRows)) {
+			m->divergedRow = (long)m->numRows;
+			m->divergedSlot = -1;
+			m->divergedTime = m->failTime;
+		}
+		if(m->divergedRow >= 0) {
+			numDiverged++;
+			if(!first || (m->divergedRow < first->divergedRow)) first = m;
+		}
+	}
+	if(first) {
+		if(first->divergedSlot < 0) {
+			jm_log_error(cb, fmu_checker_module, "Instance %u gave %u output rows instead of %u with %u instance(s) running concurrently",
+				(unsigned)(first - mi->members + 1), (unsigned)first->numRows, (unsigned)mi->numRefRows, (unsigned)n);
+		}
+		else {
+			jm_log_error(cb, fmu_checker_module, "Instance %u differs from the single-instance run at time %g in %s with %u instance(s) running concurrently",
+				(unsigned)(first - mi->members + 1), first->divergedTime, fmi2_multi_instance_slot_name(mi->cdata, first->divergedSlot), (unsigned)n);
+		}
+		jm_log_error(cb, fmu_checker_module, "%u of %u instance(s) differ from the single-instance run. The instances may share state (data race).",
+			(unsigned)numDiverged, (unsigned)n);
+	}
+	return (numFailed || numDiverged) ? jm_status_error : jm_status_success;
+}
+
+/* Steps per second over the first n instances */
+static double fmi2_multi_instance_throughput(fmi2_multi_instance_t* mi, size_t n) {
+	double start = mi->members[0].loopStart, end = mi->members[0].loopEnd;
+	size_t i, numSteps = 0;
+	for(i = 0; i < n; i++) {
+		fmi2_multi_instance_member_t* m = &mi->members[i];
+		if(m->loopStart < start) start = m->loopStart;
+		if(m->loopEnd > end) end = m->loopEnd;
+		numSteps += m->numSteps;
+	}
+	return (end > start) ? numSteps / (end - start) : 0.0;
+}
+
+jm_status_enu_t fmi2_multi_instance_check(fmu_check_data_t* cdata) {
+	jm_callbacks* cb = &cdata->callbacks;
+	fmi2_column_plan_t* plan = &cdata->fmu2_columns;
+	size_t numInstances = cdata->numInstances, numRefSteps = 0, numRuns = 0, n, i;
+	size_t runSizes[32];
+	double throughput[32];
+	fmi2_multi_instance_t mi;
+	jm_status_enu_t status = jm_status_success;
+
+	if(!(cdata->fmu2_kind & fmi2_fmu_kind_cs) || !cdata->do_test_cs) {
+		jm_log_warning(cb, fmu_checker_module, "The multi-instance check (--instances) is skipped since CS is not tested");
+		return jm_status_success;
+	}
+	if(fmi2_import_get_capability(cdata->fmu2, fmi2_cs_canBeInstantiatedOnlyOncePerProcess)) {
+		jm_log_info(cb, fmu_checker_module, "The multi-instance check is skipped since the FMU can only be instantiated once per process");
+		return jm_status_success;
+	}
+
+	memset(&mi, 0, sizeof(mi));
+	mi.cdata = cdata;
+	mi.cb = cb;
+	mi.rowSize = 1 + plan->numReals + plan->numInts + plan->numBools;
+	mi.tstart = fmi2_import_get_default_experiment_start(cdata->fmu2);
+	mi.tend = fmi2_import_get_default_experiment_stop(cdata->fmu2);
+	mi.canHandleVarStepSize = fmi2_import_get_capability(cdata->fmu2, fmi2_cs_canHandleVariableCommunicationStepSize);
+	prepare_time_step_info(cdata, &mi.tend, &mi.hstep);
+	fmu_check_mutex_init(&mi.lock);
+	fmu_check_cond_init(&mi.gate);
+
+	jm_log_info(cb, fmu_checker_module, "Loading %u instance(s) of the FMU for the multi-instance check", (unsigned)numInstances);
+	mi.members = (fmi2_multi_instance_member_t*)cb->calloc(numInstances, sizeof(fmi2_multi_instance_member_t));
+	/* lets the FMU logger find the checker data of an instance from the component environment */
+	cdata->instance_data = (fmu_check_data_t**)fmu_check_arena_calloc(&cdata->arena, numInstances, sizeof(fmu_check_data_t*));
+	if(!mi.members || !cdata->instance_data) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not allocate memory");
+		status = jm_status_error;
+	}
+	for(i = 0; (i < numInstances) && (status == jm_status_success); i++) {
+		cdata->instance_data[i] = &mi.members[i].cdata;
+		cdata->num_instance_data = mi.numMembers = i + 1;
+		status = fmi2_multi_instance_load(&mi, &mi.members[i], i);
+	}
+
+	/* reference: a single instance on this thread */
+	if(status == jm_status_success) {
+		fmi2_multi_instance_member_t* m = &mi.members[0];
+		mi.recording = 1;
+		fmi2_multi_instance_run(&mi, m);
+		mi.recording = 0;
+		if(m->function) {
+			jm_log_error(cb, fmu_checker_module, "The single-instance run failed in %s at time %g (FMU status: %s)",
+				m->function, m->failTime, fmi2_status_to_string(m->status));
+			status = jm_status_error;
+		}
+		else if(mi.outOfMemory) {
+			jm_log_error(cb, fmu_checker_module, "Could not allocate memory for keeping the output of the single-instance run");
+			status = jm_status_error;
+		}
+		else {
+			numRefSteps = m->numSteps;
+			runSizes[numRuns] = 1;
+			throughput[numRuns++] = fmi2_multi_instance_throughput(&mi, 1);
+		}
+	}
+
+	/* 2, 4, ... and numInstances concurrently after a successful reference run. Differences do not stop the scaling curve. */
+	n = 2;
+	while(numRuns && (n <= numInstances)) {
+		jm_log_verbose(cb, fmu_checker_module, "Simulating %u instance(s) concurrently", (unsigned)n);
+		if(fmi2_multi_instance_run_concurrently(&mi, n) != jm_status_success) {
+			status = jm_status_error;
+			break;
+		}
+		if(fmi2_multi_instance_report(&mi, n) != jm_status_success) {
+			status = jm_status_error;
+		}
+		runSizes[numRuns] = n;
+		throughput[numRuns++] = fmi2_multi_instance_throughput(&mi, n);
+		if(n == numInstances) break;
+		n = (2 * n > numInstances) ? numInstances : 2 * n;
+	}
+
+	if(numRuns) {
+		jm_log_info(cb, fmu_checker_module, "Multi-instance throughput with %u step(s) per instance on %u processor(s):",
+			(unsigned)numRefSteps, (unsigned)fmu_check_get_num_cpus());
+		for(i = 0; i < numRuns; i++) {
+			double speedUp = (throughput[0] > 0) ? throughput[i] / throughput[0] : 0.0;
+			jm_log_info(cb, fmu_checker_module, "%4u instance(s): %12.1f steps/s, speed-up %.2f, efficiency %.0f%%",
+				(unsigned)runSizes[i], throughput[i], speedUp, 100.0 * speedUp / runSizes[i]);
+		}
+	}
+	if((status == jm_status_success) && (numInstances > 1)) {
+		jm_log_info(cb, fmu_checker_module, "Up to %u concurrent instance(s) gave the same results as a single instance", (unsigned)numInstances);
+	}
+
+	for(i = 0; i < mi.numMembers; i++) {
+		clear_fmu_check_child_data(&mi.members[i].cdata, cdata);
+	}
+	cdata->instance_data = 0;
+	cdata->num_instance_data = 0;
+	if(mi.members) cb->free(mi.members);
+	if(mi.refRows) cb->free(mi.refRows);
+	fmu_check_cond_destroy(&mi.gate);
+	fmu_check_mutex_destroy(&mi.lock);
+	return status;
+}
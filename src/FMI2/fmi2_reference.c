@@ -0,0 +1,714 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmi2_reference.c
+	Comparison of the FMI 2.0 simulation output with a reference result (--reference option)
+	or of the CS output with the ME output (--compare-me-cs option).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#include <fmuChecker.h>
+#include <fmilib.h>
+
+struct fmi2_reference_shared_t {
+	/** Protects the kept rows and done */
+	fmu_check_mutex_t lock;
+	/** Signalled when a row is kept and when no more rows will be */
+	fmu_check_cond_t cond;
+	int done;
+};
+
+/* Per-signal tolerance from a tolerance file line "<pattern> <relTol> [<absTol>]" */
+typedef struct fmi2_reference_tol_t {
+	char* pattern;
+	double relTol;
+	double absTol;
+} fmi2_reference_tol_t;
+
+/* Read a whole file into the arena */
+static char* fmi2_reference_read_file(fmu_check_data_t* cdata, const char* fileName, const char* what) {
+	jm_callbacks* cb = &cdata->callbacks;
+	FILE* f = fopen(fileName, "rb");
+	char* text = 0;
+	long size;
+
+	if(!f) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not open %s %s (%s)", what, fileName, strerror(errno));
+		return 0;
+	}
+	if((fseek(f, 0, SEEK_END) == 0) && ((size = ftell(f)) >= 0) && (fseek(f, 0, SEEK_SET) == 0)) {
+		text = (char*)fmu_check_arena_alloc(&cdata->arena, (size_t)size + 1);
+		if(text && (fread(text, 1, (size_t)size, f) == (size_t)size)) {
+			text[size] = 0;
+		}
+		else {
+			text = 0;
+		}
+	}
+	if(!text) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not read %s %s", what, fileName);
+	}
+	fclose(f);
+	return text;
+}
+
+/*
+	Split the header line at *cur into names and advance *cur to the next line. Names are
+	zero terminated in place with the quotes removed. Returns the number of names or 0 if
+	a quoted name is not terminated.
+*/
+static size_t fmi2_reference_split_header(char** cur, char sep, char** names, size_t maxNames) {
+	char* s = *cur;
+	size_t n = 0;
+
+	for(;;) {
+		char *name, *end, ch;
+		while((*s == ' ') || (*s == '\t')) s++;
+		if(*s == '"') {
+			name = end = ++s;
+			for(;;) {
+				if(*s == 0) return 0;
+				if(*s == '"') {
+					if(s[1] != '"') break;
+					s++;
+				}
+				*end++ = *s++;
+			}
+			s++;
+			while((*s == ' ') || (*s == '\t')) s++;
+		}
+		else {
+			name = s;
+			while(*s && (*s != sep) && (*s != '\n') && (*s != '\r')) s++;
+			end = s;
+			while((end > name) && ((end[-1] == ' ') || (end[-1] == '\t'))) end--;
+		}
+		ch = *s;
+		*end = 0;
+		if(n < maxNames) names[n] = name;
+		n++;
+		if(ch != sep) break;
+		s++;
+	}
+	while(*s && (*s != '\n')) s++;
+	if(*s) s++;
+	*cur = s;
+	return n;
+}
+
+/* Parse the --ref-tol specification into the arena. Returns the number of per-signal tolerances or -1 on error. */
+static long fmi2_reference_parse_tol(fmu_check_data_t* cdata, fmi2_reference_tol_t** tols, double* relTol, double* absTol) {
+	jm_callbacks* cb = &cdata->callbacks;
+	const char* spec = cdata->referenceTolSpec;
+	char* text;
+	char* line;
+	size_t maxNum = 1;
+	long n = 0;
+
+	*relTol = FMI2_REFERENCE_DEFAULT_REL_TOL;
+	*absTol = 0;
+	*tols = 0;
+	if(!spec) return 0;
+	if(spec[0] != '@') {
+		int fields = sscanf(spec, "%lg,%lg", relTol, absTol);
+		if((fields < 1) || (*relTol < 0) || (*absTol < 0)) {
+			jm_log_fatal(cb, fmu_checker_module, "Expected <relTol>[,<absTol>] or @<file> after --ref-tol but got '%s'", spec);
+			return -1;
+		}
+		return 0;
+	}
+
+	text = fmi2_reference_read_file(cdata, spec + 1, "tolerance file");
+	if(!text) return -1;
+	for(line = text; *line; line++) {
+		if(*line == '\n') maxNum++;
+	}
+	*tols = (fmi2_reference_tol_t*)fmu_check_arena_calloc(&cdata->arena, maxNum, sizeof(fmi2_reference_tol_t));
+	if(!*tols) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not allocate memory");
+		return -1;
+	}
+	line = text;
+	while(*line) {
+		char* next = strchr(line, '\n');
+		char* pattern;
+		char* end;
+		fmi2_reference_tol_t* t = &(*tols)[n];
+		int fields;
+
+		if(next) *next++ = 0;
+		else next = line + strlen(line);
+		while((*line == ' ') || (*line == '\t')) line++;
+		if(!*line || (*line == '#') || (*line == '\r')) {
+			line = next;
+			continue;
+		}
+		pattern = line;
+		while(*line && (*line != ' ') && (*line != '\t')) line++;
+		end = line;
+		t->absTol = 0;
+		fields = sscanf(line, "%lg %lg", &t->relTol, &t->absTol);
+		*end = 0;
+		if((fields < 1) || (t->relTol < 0) || (t->absTol < 0)) {
+			jm_log_fatal(cb, fmu_checker_module, "Expected '<pattern> <relTol> [<absTol>]' in the tolerance file %s but got '%s'", spec + 1, pattern);
+			return -1;
+		}
+		t->pattern = pattern;
+		n++;
+		line = next;
+	}
+	return n;
+}
+
+/* Add a signal compared in the column with the tolerance of the first matching pattern */
+static void fmi2_reference_add_signal(fmi2_reference_t* ref, const fmi2_column_t* col, const char* name,
+									  const fmi2_reference_tol_t* tols, long numTols, double relTol, double absTol) {
+	fmi2_reference_signal_t* s = &ref->signals[ref->numSignals++];
+	long t;
+
+	s->col = col;
+	s->relTol = relTol;
+	s->absTol = absTol;
+	for(t = 0; t < numTols; t++) {
+		if(fmi2_column_pattern_match(tols[t].pattern, name)) {
+			s->relTol = tols[t].relTol;
+			s->absTol = tols[t].absTol;
+			break;
+		}
+	}
+}
+
+/* Allocate the per-signal arrays used by the comparison */
+static jm_status_enu_t fmi2_reference_alloc_work(fmu_check_data_t* cdata) {
+	fmi2_reference_t* ref = &cdata->fmu2_reference;
+	fmu_check_arena_t* arena = &cdata->arena;
+
+	ref->tol = (double*)fmu_check_arena_calloc(arena, ref->numSignals + 1, sizeof(double));
+	ref->sample = (double*)fmu_check_arena_calloc(arena, ref->numSignals + 1, sizeof(double));
+	ref->low = (double*)fmu_check_arena_calloc(arena, ref->numSignals + 1, sizeof(double));
+	ref->high = (double*)fmu_check_arena_calloc(arena, ref->numSignals + 1, sizeof(double));
+	ref->interp = (double*)fmu_check_arena_calloc(arena, ref->numSignals + 1, sizeof(double));
+	if(!ref->tol || !ref->sample || !ref->low || !ref->high || !ref->interp) {
+		jm_log_fatal(&cdata->callbacks, fmu_checker_module, "Could not allocate memory");
+		return jm_status_error;
+	}
+	return jm_status_success;
+}
+
+/* Tolerance of each signal from its largest absolute value and the tube width from the time span */
+static void fmi2_reference_set_tolerances(fmu_check_data_t* cdata) {
+	fmi2_reference_t* ref = &cdata->fmu2_reference;
+	size_t i, k;
+
+	for(k = 0; k < ref->numSignals; k++) ref->low[k] = 0;
+	for(i = 0; i < ref->numRows; i++) {
+		const double* row = ref->values + i * ref->numSignals;
+		for(k = 0; k < ref->numSignals; k++) {
+			double a = fabs(row[k]);
+			if(a > ref->low[k]) ref->low[k] = a;
+		}
+	}
+	for(k = 0; k < ref->numSignals; k++) {
+		double nominal = (ref->low[k] > 0) ? ref->low[k] : 1.0;
+		ref->tol[k] = ref->signals[k].absTol + ref->signals[k].relTol * nominal;
+	}
+	ref->tubeWidth = cdata->referenceTube * (ref->times[ref->numRows - 1] - ref->times[0]);
+}
+
+static const fmi2_column_t* fmi2_reference_find_column(fmu_check_data_t* cdata, const char* name) {
+	fmi2_column_plan_t* plan = &cdata->fmu2_columns;
+	size_t i;
+	for(i = 0; i < plan->numCols; i++) {
+		if(strcmp(fmi2_import_get_variable_name(plan->cols[i].var), name) == 0) return &plan->cols[i];
+	}
+	return 0;
+}
+
+jm_status_enu_t fmi2_reference_load(fmu_check_data_t* cdata) {
+	jm_callbacks* cb = &cdata->callbacks;
+	fmu_check_arena_t* arena = &cdata->arena;
+	fmi2_reference_t* ref = &cdata->fmu2_reference;
+	const char* fileName = cdata->referenceFileName;
+	char sep = cdata->CSV_separator;
+	fmi2_reference_tol_t* tols;
+	double relTol, absTol;
+	long numTols;
+	char* text;
+	char* cur;
+	char* p;
+	char** names;
+	long* signalOfColumn;
+	size_t numNames, maxRows = 1, numMissing = 0, k;
+	unsigned line = 1;
+
+	memset(ref, 0, sizeof(*ref));
+	numTols = fmi2_reference_parse_tol(cdata, &tols, &relTol, &absTol);
+	if(numTols < 0) return jm_status_error;
+	text = fmi2_reference_read_file(cdata, fileName, "reference file");
+	if(!text) return jm_status_error;
+
+	/* header: time and the signal names */
+	numNames = 1;
+	for(p = text; *p && (*p != '\n'); p++) {
+		if(*p == sep) numNames++;
+	}
+	names = (char**)fmu_check_arena_calloc(arena, numNames, sizeof(char*));
+	signalOfColumn = (long*)fmu_check_arena_calloc(arena, numNames, sizeof(long));
+	ref->signals = (fmi2_reference_signal_t*)fmu_check_arena_calloc(arena, numNames, sizeof(fmi2_reference_signal_t));
+	if(!names || !signalOfColumn || !ref->signals) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not allocate memory");
+		return jm_status_error;
+	}
+	cur = text;
+	numNames = fmi2_reference_split_header(&cur, sep, names, numNames);
+	if(numNames < 2) {
+		jm_log_fatal(cb, fmu_checker_module, "Expected the time and at least one signal in the header of the reference file %s", fileName);
+		return jm_status_error;
+	}
+	signalOfColumn[0] = -1;
+	for(k = 1; k < numNames; k++) {
+		const fmi2_column_t* col = fmi2_reference_find_column(cdata, names[k]);
+
+		signalOfColumn[k] = -1;
+		if(!col || (col->type == fmi2_base_type_str)) {
+			jm_log_verbose(cb, fmu_checker_module, "Reference signal %s is not a numeric output column and is not compared", names[k]);
+			numMissing++;
+			continue;
+		}
+		signalOfColumn[k] = (long)ref->numSignals;
+		fmi2_reference_add_signal(ref, col, names[k], tols, numTols, relTol, absTol);
+	}
+	if(numMissing) {
+		jm_log_warning(cb, fmu_checker_module, "%u signal(s) of the reference file are not in the output and are not compared (select them with --vars or -f)",
+			(unsigned)numMissing);
+	}
+
+	/* rows */
+	for(p = cur; *p; p++) {
+		if(*p == '\n') maxRows++;
+	}
+	ref->times = (double*)fmu_check_arena_alloc(arena, maxRows * sizeof(double));
+	ref->values = (double*)fmu_check_arena_alloc(arena, (maxRows * ref->numSignals + 1) * sizeof(double));
+	if(!ref->times || !ref->values) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not allocate memory");
+		return jm_status_error;
+	}
+	if(fmi2_reference_alloc_work(cdata) != jm_status_success) return jm_status_error;
+	while(*cur) {
+		double* row = ref->values + ref->numRows * ref->numSignals;
+		line++;
+		while((*cur == ' ') || (*cur == '\t') || (*cur == '\r')) cur++;
+		if(*cur == '\n') {
+			cur++;
+			continue;
+		}
+		if(!*cur) break;
+		for(k = 0; k < numNames; k++) {
+			char* end;
+			double v;
+			/* strtod would skip a line break and read the next line for an empty field */
+			while((*cur == ' ') || (*cur == '\t')) cur++;
+			v = strtod(cur, &end);
+			if((end == cur) || (*cur == '\n') || (*cur == '\r') || (*cur == '\v') || (*cur == '\f')) {
+				jm_log_fatal(cb, fmu_checker_module, "Could not parse a number in column %u on line %u of the reference file %s",
+					(unsigned)(k + 1), line, fileName);
+				return jm_status_error;
+			}
+			if(k == 0) ref->times[ref->numRows] = v;
+			else if(signalOfColumn[k] >= 0) row[signalOfColumn[k]] = v;
+			cur = end;
+			while((*cur == ' ') || (*cur == '\t')) cur++;
+			if(k + 1 < numNames) {
+				if(*cur != sep) {
+					jm_log_fatal(cb, fmu_checker_module, "Expected %u columns on line %u of the reference file %s",
+						(unsigned)numNames, line, fileName);
+					return jm_status_error;
+				}
+				cur++;
+			}
+		}
+		while(*cur && (*cur != '\n')) cur++;
+		if(*cur) cur++;
+		if(ref->numRows && (ref->times[ref->numRows] < ref->times[ref->numRows - 1])) {
+			jm_log_fatal(cb, fmu_checker_module, "Time is decreasing on line %u of the reference file %s", line, fileName);
+			return jm_status_error;
+		}
+		ref->numRows++;
+	}
+	if(!ref->numRows) {
+		jm_log_fatal(cb, fmu_checker_module, "No data rows in the reference file %s", fileName);
+		return jm_status_error;
+	}
+
+	fmi2_reference_set_tolerances(cdata);
+	ref->mode = fmi2_reference_compare;
+
+	jm_log_info(cb, fmu_checker_module, "Comparing %u signal(s) with %u rows of the reference file %s",
+		(unsigned)ref->numSignals, (unsigned)ref->numRows, fileName);
+	return jm_status_success;
+}
+
+jm_status_enu_t fmi2_reference_record_start(fmu_check_data_t* cdata) {
+	fmi2_reference_t* ref = &cdata->fmu2_reference;
+	fmi2_column_plan_t* plan = &cdata->fmu2_columns;
+	fmi2_reference_tol_t* tols;
+	double relTol, absTol;
+	long numTols;
+	size_t i;
+
+	fmi2_reference_free(cdata);
+	numTols = fmi2_reference_parse_tol(cdata, &tols, &relTol, &absTol);
+	if(numTols < 0) return jm_status_error;
+	ref->signals = (fmi2_reference_signal_t*)fmu_check_arena_calloc(&cdata->arena, plan->numCols + 1, sizeof(fmi2_reference_signal_t));
+	if(!ref->signals) {
+		jm_log_fatal(&cdata->callbacks, fmu_checker_module, "Could not allocate memory");
+		return jm_status_error;
+	}
+	for(i = 0; i < plan->numCols; i++) {
+		const fmi2_column_t* col = &plan->cols[i];
+		if(col->type == fmi2_base_type_str) continue;
+		fmi2_reference_add_signal(ref, col, fmi2_import_get_variable_name(col->var), tols, numTols, relTol, absTol);
+	}
+	if(fmi2_reference_alloc_work(cdata) != jm_status_success) return jm_status_error;
+	ref->mode = fmi2_reference_record;
+	return jm_status_success;
+}
+
+jm_status_enu_t fmi2_reference_record_end(fmu_check_data_t* cdata, const char* what) {
+	jm_callbacks* cb = &cdata->callbacks;
+	fmi2_reference_t* ref = &cdata->fmu2_reference;
+
+	ref->mode = fmi2_reference_off;
+	if(ref->outOfMemory) {
+		jm_log_error(cb, fmu_checker_module, "Could not allocate memory for keeping the %s output after %u row(s)", what, (unsigned)ref->numRows);
+		return jm_status_error;
+	}
+	if(!ref->numRows) {
+		jm_log_error(cb, fmu_checker_module, "There is no %s output to compare with", what);
+		return jm_status_error;
+	}
+	fmi2_reference_set_tolerances(cdata);
+	ref->mode = fmi2_reference_compare;
+	jm_log_verbose(cb, fmu_checker_module, "Kept %u signal(s) in %u rows of the %s output for the comparison",
+		(unsigned)ref->numSignals, (unsigned)ref->numRows, what);
+	return jm_status_success;
+}
+
+/* Make room for one more recorded row. Returns 0 if out of memory. */
+static int fmi2_reference_grow(fmu_check_data_t* cdata, fmi2_reference_t* ref) {
+	jm_callbacks* cb = &cdata->callbacks;
+	size_t capacity = ref->capacity ? 2 * ref->capacity : 1024;
+	double* times;
+	double* values;
+
+	times = (double*)cb->realloc(ref->times, capacity * sizeof(double));
+	if(!times) return 0;
+	ref->times = times;
+	values = (double*)cb->realloc(ref->values, (capacity * ref->numSignals + 1) * sizeof(double));
+	if(!values) return 0;
+	ref->values = values;
+	ref->capacity = capacity;
+	return 1;
+}
+
+/* Keep an output row as the reference. A row before the last one (a repeated step) replaces the rows after it. */
+static void fmi2_reference_record_row(fmu_check_data_t* cdata, double time, const double* sample) {
+	fmi2_reference_t* ref = &cdata->fmu2_reference;
+	size_t n = ref->numSignals, r;
+
+	if(ref->outOfMemory) return;
+	if(ref->shared) fmu_check_mutex_lock(&ref->shared->lock);
+	r = ref->numRows;
+	while((r > 0) && (ref->times[r - 1] > time)) r--;
+	if((r == ref->capacity) && !fmi2_reference_grow(cdata, ref)) {
+		ref->outOfMemory = 1;
+	}
+	else {
+		ref->times[r] = time;
+		memcpy(ref->values + r * n, sample, n * sizeof(double));
+		ref->numRows = r + 1;
+	}
+	if(ref->shared) {
+		fmu_check_cond_broadcast(&ref->shared->cond);
+		fmu_check_mutex_unlock(&ref->shared->lock);
+	}
+}
+
+void fmi2_reference_start(fmu_check_data_t* cdata) {
+	fmi2_reference_t* ref = &cdata->fmu2_reference;
+	size_t k;
+	ref->cursor = 0;
+	ref->numCompared = 0;
+	ref->numViolations = 0;
+	for(k = 0; k < ref->numSignals; k++) {
+		ref->signals[k].numViolations = 0;
+		ref->signals[k].maxDeviation = 0;
+	}
+}
+
+jm_status_enu_t fmi2_reference_share(fmu_check_data_t* cdata, fmu_check_data_t* other) {
+	fmi2_reference_t* ref = &cdata->fmu2_reference;
+	fmi2_reference_t* cmp = &other->fmu2_reference;
+	double tstart = fmi2_import_get_default_experiment_start(cdata->fmu2);
+	double tend = (cdata->stopTime > 0) ? cdata->stopTime : fmi2_import_get_default_experiment_stop(cdata->fmu2);
+	fmi2_reference_shared_t* shared;
+
+	memset(cmp, 0, sizeof(*cmp));
+	cmp->numSignals = ref->numSignals;
+	cmp->signals = (fmi2_reference_signal_t*)fmu_check_arena_calloc(&other->arena, ref->numSignals + 1, sizeof(fmi2_reference_signal_t));
+	cmp->nominal = (double*)fmu_check_arena_calloc(&other->arena, ref->numSignals + 1, sizeof(double));
+	shared = (fmi2_reference_shared_t*)cdata->callbacks.calloc(1, sizeof(fmi2_reference_shared_t));
+	if(!cmp->signals || !cmp->nominal || !shared) {
+		if(shared) cdata->callbacks.free(shared);
+		jm_log_fatal(&cdata->callbacks, fmu_checker_module, "Could not allocate memory");
+		return jm_status_error;
+	}
+	if(fmi2_reference_alloc_work(other) != jm_status_success) {
+		cdata->callbacks.free(shared);
+		return jm_status_error;
+	}
+	/* the columns are shared by the check data of both runs */
+	memcpy(cmp->signals, ref->signals, ref->numSignals * sizeof(fmi2_reference_signal_t));
+	fmu_check_mutex_init(&shared->lock);
+	fmu_check_cond_init(&shared->cond);
+	ref->shared = shared;
+	cmp->shared = shared;
+	cmp->source = ref;
+	cmp->tubeWidth = (tend > tstart) ? cdata->referenceTube * (tend - tstart) : 0;
+	cmp->mode = fmi2_reference_compare;
+	fmi2_reference_start(other);
+	return jm_status_success;
+}
+
+void fmi2_reference_share_end(fmu_check_data_t* cdata) {
+	fmi2_reference_shared_t* shared = cdata->fmu2_reference.shared;
+	if(!shared) return;
+	fmu_check_mutex_lock(&shared->lock);
+	shared->done = 1;
+	fmu_check_cond_broadcast(&shared->cond);
+	fmu_check_mutex_unlock(&shared->lock);
+}
+
+void fmi2_reference_unshare(fmu_check_data_t* cdata, fmu_check_data_t* other) {
+	fmi2_reference_shared_t* shared = cdata->fmu2_reference.shared;
+	if(!shared) return;
+	fmu_check_cond_destroy(&shared->cond);
+	fmu_check_mutex_destroy(&shared->lock);
+	cdata->callbacks.free(shared);
+	cdata->fmu2_reference.shared = 0;
+	other->fmu2_reference.shared = 0;
+	other->fmu2_reference.source = 0;
+}
+
+/* Reference values interpolated at time t (held at the ends) */
+static void fmi2_reference_interpolate(const fmi2_reference_t* ref, double t, double* out) {
+	size_t n = ref->numSignals, lo = 0, hi = ref->numRows - 1, k;
+	const double* a;
+	const double* b;
+	double w;
+
+	if(t <= ref->times[0]) {
+		memcpy(out, ref->values, n * sizeof(double));
+		return;
+	}
+	if(t >= ref->times[hi]) {
+		memcpy(out, ref->values + hi * n, n * sizeof(double));
+		return;
+	}
+	/* last row with time <= t */
+	while(hi - lo > 1) {
+		size_t mid = lo + (hi - lo) / 2;
+		if(ref->times[mid] <= t) lo = mid;
+		else hi = mid;
+	}
+	a = ref->values + lo * n;
+	b = ref->values + (lo + 1) * n;
+	w = (t - ref->times[lo]) / (ref->times[lo + 1] - ref->times[lo]);
+	for(k = 0; k < n; k++) {
+		out[k] = a[k] + w * (b[k] - a[k]);
+	}
+}
+
+/* Compare the sample of an output row with the rows of src, the reference or the kept output of another run */
+static jm_status_enu_t fmi2_reference_compare_row(fmu_check_data_t* cdata, const fmi2_reference_t* src, double time) {
+	fmi2_reference_t* ref = &cdata->fmu2_reference;
+	size_t n = ref->numSignals, r, k;
+	double* low = ref->low;
+	double* high = ref->high;
+	const double* tol = ref->tol;
+	const double* sample = ref->sample;
+	double tubeStart = time - ref->tubeWidth, tubeEnd = time + ref->tubeWidth;
+	int anyViolation = 0;
+
+	if(!src->numRows || (tubeEnd < src->times[0]) || (tubeStart > src->times[src->numRows - 1])) {
+		return jm_status_success;
+	}
+
+	/* the tube: values at both ends and all the rows in between */
+	fmi2_reference_interpolate(src, tubeStart, low);
+	memcpy(high, low, n * sizeof(double));
+	fmi2_reference_interpolate(src, tubeEnd, ref->interp);
+	for(k = 0; k < n; k++) {
+		double v = ref->interp[k];
+		low[k] = (v < low[k]) ? v : low[k];
+		high[k] = (v > high[k]) ? v : high[k];
+	}
+	/* the output times normally increase, but a co-simulation step may be repeated from an earlier time */
+	while((ref->cursor > 0) && (src->times[ref->cursor - 1] > tubeStart)) ref->cursor--;
+	while((ref->cursor < src->numRows) && (src->times[ref->cursor] <= tubeStart)) ref->cursor++;
+	for(r = ref->cursor; (r < src->numRows) && (src->times[r] < tubeEnd); r++) {
+		const double* row = src->values + r * n;
+		for(k = 0; k < n; k++) {
+			double v = row[k];
+			low[k] = (v < low[k]) ? v : low[k];
+			high[k] = (v > high[k]) ? v : high[k];
+		}
+	}
+
+	for(k = 0; k < n; k++) {
+		anyViolation |= (sample[k] < low[k] - tol[k]) | (sample[k] > high[k] + tol[k]) | (sample[k] != sample[k]);
+	}
+	ref->numCompared++;
+	if(!anyViolation) return jm_status_success;
+
+	for(k = 0; k < n; k++) {
+		fmi2_reference_signal_t* s = &ref->signals[k];
+		double dev;
+		if(sample[k] != sample[k]) {
+			dev = HUGE_VAL;
+		}
+		else {
+			dev = low[k] - tol[k] - sample[k];
+			if(sample[k] - high[k] - tol[k] > dev) dev = sample[k] - high[k] - tol[k];
+			if(dev <= 0) continue;
+		}
+		if(!s->numViolations) {
+			s->firstTime = time;
+			s->firstValue = sample[k];
+			s->firstLow = low[k] - tol[k];
+			s->firstHigh = high[k] + tol[k];
+		}
+		s->numViolations++;
+		if(dev > s->maxDeviation) s->maxDeviation = dev;
+		ref->numViolations++;
+	}
+	if(cdata->referenceMaxViolations && (ref->numViolations >= cdata->referenceMaxViolations)) {
+		jm_log_error(&cdata->callbacks, fmu_checker_module, "Stopping the simulation at time %g after %u violation(s) of the reference",
+			time, (unsigned)ref->numViolations);
+		return jm_status_error;
+	}
+	return jm_status_success;
+}
+
+/* Compare with the output kept by another thread once it has passed the tube of the row */
+static jm_status_enu_t fmi2_reference_compare_shared_row(fmu_check_data_t* cdata, double time) {
+	fmi2_reference_t* ref = &cdata->fmu2_reference;
+	const fmi2_reference_t* src = ref->source;
+	fmi2_reference_shared_t* shared = ref->shared;
+	double tubeEnd = time + ref->tubeWidth;
+	size_t n = ref->numSignals, i, k;
+	jm_status_enu_t status;
+
+	fmu_check_mutex_lock(&shared->lock);
+	while(!shared->done && (!src->numRows || (src->times[src->numRows - 1] <= tubeEnd))) {
+		fmu_check_cond_wait(&shared->cond, &shared->lock);
+	}
+	/* a repeated step may have replaced rows that were already included */
+	if(ref->numNominalRows > src->numRows) ref->numNominalRows = src->numRows;
+	for(i = ref->numNominalRows; i < src->numRows; i++) {
+		const double* row = src->values + i * n;
+		for(k = 0; k < n; k++) {
+			double a = fabs(row[k]);
+			if(a > ref->nominal[k]) ref->nominal[k] = a;
+		}
+	}
+	ref->numNominalRows = src->numRows;
+	for(k = 0; k < n; k++) {
+		double nominal = (ref->nominal[k] > 0) ? ref->nominal[k] : 1.0;
+		ref->tol[k] = ref->signals[k].absTol + ref->signals[k].relTol * nominal;
+	}
+	status = fmi2_reference_compare_row(cdata, src, time);
+	fmu_check_mutex_unlock(&shared->lock);
+	return status;
+}
+
+jm_status_enu_t fmi2_reference_row(fmu_check_data_t* cdata, double time, const fmi2_column_values_t* values) {
+	fmi2_reference_t* ref = &cdata->fmu2_reference;
+	size_t n = ref->numSignals, k;
+	double* sample = ref->sample;
+
+	if(!n) return jm_status_success;
+
+	for(k = 0; k < n; k++) {
+		const fmi2_column_t* col = ref->signals[k].col;
+		switch(col->type) {
+		case fmi2_base_type_real:
+			sample[k] = values->reals[col->index];
+			break;
+		case fmi2_base_type_bool:
+			sample[k] = values->bools[col->index] ? 1.0 : 0.0;
+			break;
+		default:
+			sample[k] = (double)values->ints[col->index];
+			break;
+		}
+	}
+	if(ref->mode == fmi2_reference_record) {
+		fmi2_reference_record_row(cdata, time, sample);
+		return jm_status_success;
+	}
+	if(ref->source) return fmi2_reference_compare_shared_row(cdata, time);
+	return fmi2_reference_compare_row(cdata, ref, time);
+}
+
+jm_status_enu_t fmi2_reference_report(fmu_check_data_t* cdata, const char* title) {
+	jm_callbacks* cb = &cdata->callbacks;
+	fmi2_reference_t* ref = &cdata->fmu2_reference;
+	const fmi2_reference_signal_t* first = 0;
+	size_t k, numPassed = 0;
+
+	for(k = 0; k < ref->numSignals; k++) {
+		fmi2_reference_signal_t* s = &ref->signals[k];
+		const char* name = fmi2_import_get_variable_name(s->col->var);
+		if(!s->numViolations) {
+			jm_log_verbose(cb, fmu_checker_module, "%s: signal %s passed", title, name);
+			numPassed++;
+			continue;
+		}
+		jm_log_error(cb, fmu_checker_module,
+			"%s: signal %s failed with %u violation(s), first at time %g (value %g outside [%g, %g]), largest deviation %g",
+			title, name, (unsigned)s->numViolations, s->firstTime, s->firstValue, s->firstLow, s->firstHigh, s->maxDeviation);
+		if(!first || (s->firstTime < first->firstTime)) first = s;
+	}
+	if(first) {
+		jm_log_error(cb, fmu_checker_module, "%s: first difference at time %g in signal %s",
+			title, first->firstTime, fmi2_import_get_variable_name(first->col->var));
+	}
+	jm_log_info(cb, fmu_checker_module, "%s: %u of %u signal(s) passed in %u compared output row(s)",
+		title, (unsigned)numPassed, (unsigned)ref->numSignals, (unsigned)ref->numCompared);
+	return (numPassed == ref->numSignals) ? jm_status_success : jm_status_error;
+}
+
+int fmi2_reference_only(fmu_check_data_t* cdata) {
+	return cdata->referenceFileName && !cdata->output_file_name;
+}
+
+void fmi2_reference_free(fmu_check_data_t* cdata) {
+	fmi2_reference_t* ref = &cdata->fmu2_reference;
+	jm_callbacks* cb = &cdata->callbacks;
+	/* a loaded reference is in the arena, only kept output is allocated here */
+	if(ref->capacity) {
+		if(ref->times) cb->free(ref->times);
+		if(ref->values) cb->free(ref->values);
+	}
+	memset(ref, 0, sizeof(*ref));
+}
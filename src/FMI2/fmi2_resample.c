@@ -0,0 +1,169 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmi2_resample.c
+	Resampling of the FMI 2.0 simulation output onto a fixed time grid (--resample option).
+*/
+
+#include <math.h>
+#include <string.h>
+
+#include <fmuChecker.h>
+#include <fmilib.h>
+
+static int fmi2_resample_alloc_sample(fmu_check_data_t* cdata, fmi2_resample_sample_t* s) {
+	fmu_check_arena_t* arena = &cdata->arena;
+	fmi2_column_plan_t* plan = &cdata->fmu2_columns;
+	s->reals = fmu_check_arena_calloc(arena, plan->numReals + 1, sizeof(fmi2_real_t));
+	s->ints = fmu_check_arena_calloc(arena, plan->numInts + 1, sizeof(fmi2_integer_t));
+	s->bools = fmu_check_arena_calloc(arena, plan->numBools + 1, sizeof(fmi2_boolean_t));
+	s->strOffsets = fmu_check_arena_calloc(arena, plan->numStrs + 1, sizeof(size_t));
+	s->strBuf = 0;
+	s->strBufSize = 0;
+	return s->reals && s->ints && s->bools && s->strOffsets;
+}
+
+/* Allocate the samples and the row values for the columns of the output column plan */
+static jm_status_enu_t fmi2_resample_setup(fmu_check_data_t* cdata, fmi2_resample_t* rs) {
+	if(fmi2_alloc_column_values(cdata, &rs->row) != jm_status_success) {
+		return jm_status_error;
+	}
+	if(!fmi2_resample_alloc_sample(cdata, &rs->samples[0]) || !fmi2_resample_alloc_sample(cdata, &rs->samples[1])) {
+		jm_log_fatal(&cdata->callbacks, fmu_checker_module, "Could not allocate memory");
+		return jm_status_error;
+	}
+	rs->setUp = 1;
+	return jm_status_success;
+}
+
+/* Read all the output values into the sample. The strings are copied since the FMU may reuse its buffers. */
+static jm_status_enu_t fmi2_resample_read(fmu_check_data_t* cdata, fmi2_resample_t* rs, fmi2_resample_sample_t* s, double time) {
+	fmi2_column_plan_t* plan = &cdata->fmu2_columns;
+	fmi2_column_values_t values;
+	size_t k, size = 0;
+
+	s->time = time;
+	values.reals = s->reals;
+	values.ints = s->ints;
+	values.bools = s->bools;
+	values.strs = rs->row.strs;
+	fmi2_read_column_values(cdata, &values);
+	if(!plan->numStrs) return jm_status_success;
+
+	for(k = 0; k < plan->numStrs; k++) {
+		size += (values.strs[k] ? strlen(values.strs[k]) : 0) + 1;
+	}
+	if(size > s->strBufSize) {
+		/* the old buffer stays in the arena; doubling keeps the waste bounded */
+		s->strBuf = (char*)fmu_check_arena_alloc(&cdata->arena, 2 * size);
+		s->strBufSize = s->strBuf ? 2 * size : 0;
+		if(!s->strBuf) {
+			jm_log_fatal(&cdata->callbacks, fmu_checker_module, "Could not allocate memory");
+			return jm_status_error;
+		}
+	}
+	size = 0;
+	for(k = 0; k < plan->numStrs; k++) {
+		const char* str = values.strs[k] ? values.strs[k] : "";
+		size_t len = strlen(str);
+		memcpy(s->strBuf + size, str, len + 1);
+		s->strOffsets[k] = size;
+		size += len + 1;
+	}
+	return jm_status_success;
+}
+
+/* Write the row for time t. Real values are interpolated between prev and cur with weight w of cur,
+   discrete values are taken from disc. */
+static jm_status_enu_t fmi2_resample_write_row(fmu_check_data_t* cdata, fmi2_resample_t* rs, double t,
+											   const fmi2_resample_sample_t* prev, const fmi2_resample_sample_t* cur,
+											   double w, const fmi2_resample_sample_t* disc) {
+	fmi2_column_plan_t* plan = &cdata->fmu2_columns;
+	fmi2_column_values_t values;
+	size_t k;
+
+	for(k = 0; k < plan->numReals; k++) {
+		rs->row.reals[k] = (w >= 1.0) ? cur->reals[k] : prev->reals[k] + w * (cur->reals[k] - prev->reals[k]);
+	}
+	for(k = 0; k < plan->numStrs; k++) {
+		rs->row.strs[k] = disc->strBuf + disc->strOffsets[k];
+	}
+	values.reals = rs->row.reals;
+	values.ints = disc->ints;
+	values.bools = disc->bools;
+	values.strs = rs->row.strs;
+	return fmi2_write_csv_row(cdata, t, &values);
+}
+
+static double fmi2_resample_grid_time(fmi2_resample_t* rs, size_t k) {
+	if(k >= rs->gridPoints) return rs->gridEnd;
+	return rs->gridStart + (rs->gridEnd - rs->gridStart) * k / rs->gridPoints;
+}
+
+void fmi2_resample_start(fmu_check_data_t* cdata) {
+	fmi2_resample_t* rs = &cdata->fmu2_resample;
+	rs->haveSample = 0;
+	rs->nextGridPoint = 0;
+	rs->prev = &rs->samples[0];
+	rs->cur = &rs->samples[1];
+}
+
+int fmi2_resample_enabled(fmu_check_data_t* cdata) {
+	return cdata->resampleOutput && (cdata->maxOutputPts > 0);
+}
+
+jm_status_enu_t fmi2_resample_write(fmu_check_data_t* cdata, double time) {
+	fmi2_resample_t* rs = &cdata->fmu2_resample;
+	fmi2_resample_sample_t* tmp;
+	double eps;
+
+	if(!rs->setUp && (fmi2_resample_setup(cdata, rs) != jm_status_success)) {
+		return jm_status_error;
+	}
+	if(!rs->prev) fmi2_resample_start(cdata);
+
+	tmp = rs->prev;
+	rs->prev = rs->cur;
+	rs->cur = tmp;
+
+	fmu_check_watch(cdata, "fmi2GetXXX (output)", time);
+	if(fmi2_resample_read(cdata, rs, rs->cur, time) != jm_status_success) {
+		fmu_check_watch_end(cdata);
+		return jm_status_error;
+	}
+	fmu_check_watch_end(cdata);
+	if(!rs->haveSample) {
+		/* the first sample starts the grid */
+		rs->haveSample = 1;
+		rs->prev = rs->cur;
+		rs->gridStart = time;
+		rs->gridEnd = (cdata->stopTime > time) ? cdata->stopTime : time;
+		rs->gridPoints = (rs->gridEnd > time) ? cdata->maxOutputPts : 0;
+		rs->nextGridPoint = 0;
+	}
+
+	/* grid points within rounding of the step time are written with the step values */
+	eps = 1e-9 * (rs->gridEnd - rs->gridStart);
+	while(rs->nextGridPoint <= rs->gridPoints) {
+		double t = fmi2_resample_grid_time(rs, rs->nextGridPoint);
+		jm_status_enu_t status;
+		if(t > time + eps) break;
+		if(t >= time - eps) {
+			status = fmi2_resample_write_row(cdata, rs, t, rs->cur, rs->cur, 1.0, rs->cur);
+		}
+		else {
+			double w = (t - rs->prev->time) / (time - rs->prev->time);
+			status = fmi2_resample_write_row(cdata, rs, t, rs->prev, rs->cur, w, rs->prev);
+		}
+		if(status != jm_status_success) return jm_status_error;
+		rs->nextGridPoint++;
+	}
+	if(rs->prev == rs->cur) {
+		rs->prev = (rs->cur == &rs->samples[0]) ? &rs->samples[1] : &rs->samples[0];
+	}
+	return jm_status_success;
+}
@@ -0,0 +1,268 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmi2_state_cache.c
+	Cache of serialized FMU states after initialization (--state-cache option).
+
+	The cache key is a hash of the GUID, the FMU type, the experiment setup
+	(start time and tolerance), the values of the current parameter set and
+	the input values at the start time. A cache file holds a short header
+	(magic, key and the wall clock time the initialization took) followed by
+	the bytes from fmi2SerializeFMUstate. Files are written under a temporary
+	name and renamed so that parallel runs never read a partial file.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <JM/jm_vector.h>
+#include <fmuChecker.h>
+#include <fmilib.h>
+
+#define FMI2_STATE_CACHE_MAGIC "FMUCHKS1"
+#define FMI2_STATE_CACHE_MAGIC_LEN 8
+
+/* 64-bit FNV-1a */
+static void fmi2_state_cache_hash(unsigned long long* h, const void* data, size_t size) {
+	const unsigned char* p = (const unsigned char*)data;
+	size_t i;
+	for(i = 0; i < size; i++) {
+		*h ^= p[i];
+		*h *= 1099511628211ULL;
+	}
+}
+
+static void fmi2_state_cache_hash_values(unsigned long long* h, const fmi2_value_reference_t* vr, size_t n, const void* values, size_t valueSize) {
+	fmi2_state_cache_hash(h, &n, sizeof(n));
+	if(!n) return;
+	fmi2_state_cache_hash(h, vr, n * sizeof(fmi2_value_reference_t));
+	fmi2_state_cache_hash(h, values, n * valueSize);
+}
+
+/* Must be called after fmi2_set_inputs() for the start time so that the interpolated inputs are up to date */
+static unsigned long long fmi2_state_cache_key(fmu_check_data_t* cdata, fmi2_type_t fmuType, fmi2_boolean_t toleranceControlled, fmi2_real_t relativeTolerance, fmi2_real_t tstart) {
+	unsigned long long h = 14695981039346656037ULL;
+	const char* GUID = fmi2_import_get_GUID(cdata->fmu2);
+	const fmi2_param_sets_t* p = cdata->fmu2_params;
+	fmi2_csv_input_t* indata = &cdata->fmu2_inputData;
+	int type = (int)fmuType;
+	int tol = (int)toleranceControlled;
+
+	fmi2_state_cache_hash(&h, GUID, strlen(GUID) + 1);
+	fmi2_state_cache_hash(&h, &type, sizeof(type));
+	fmi2_state_cache_hash(&h, &tol, sizeof(tol));
+	fmi2_state_cache_hash(&h, &relativeTolerance, sizeof(relativeTolerance));
+	fmi2_state_cache_hash(&h, &tstart, sizeof(tstart));
+
+	if(p) {
+		size_t k = cdata->fmu2_param_set;
+		fmi2_state_cache_hash_values(&h, p->realVr, p->numReal, p->realValues + k * p->numReal, sizeof(fmi2_real_t));
+		fmi2_state_cache_hash_values(&h, p->intVr, p->numInt, p->intValues + k * p->numInt, sizeof(fmi2_integer_t));
+		fmi2_state_cache_hash_values(&h, p->boolVr, p->numBool, p->boolValues + k * p->numBool, sizeof(fmi2_boolean_t));
+	}
+
+	if(fmi2_input_has_data(indata)) {
+		if(indata->realInputData) {
+			fmi2_state_cache_hash_values(&h, fmi2_import_get_value_referece_list(indata->realInputs),
+				fmi2_import_get_variable_list_size(indata->realInputs), indata->interpData, sizeof(fmi2_real_t));
+		}
+		if(indata->boolInputData) {
+			fmi2_state_cache_hash_values(&h, fmi2_import_get_value_referece_list(indata->boolInputs),
+				fmi2_import_get_variable_list_size(indata->boolInputs),
+				fmi2_input_discrete_bools(indata), sizeof(fmi2_boolean_t));
+		}
+		if(indata->intInputData) {
+			fmi2_state_cache_hash_values(&h, fmi2_import_get_value_referece_list(indata->intInputs),
+				fmi2_import_get_variable_list_size(indata->intInputs),
+				fmi2_input_discrete_ints(indata), sizeof(fmi2_integer_t));
+		}
+	}
+	return h;
+}
+
+/**
+	Restore the FMU state from the cache file.
+	Returns 1 if the state was restored, 0 if there is no usable cache file and
+	-1 if restoring failed after the FMU was called.
+*/
+static int fmi2_state_cache_restore(fmu_check_data_t* cdata, const char* fileName, unsigned long long key) {
+	jm_callbacks* cb = &cdata->callbacks;
+	fmi2_import_t* fmu = cdata->fmu2;
+	char magic[FMI2_STATE_CACHE_MAGIC_LEN];
+	unsigned long long fileKey, size;
+	double initTime, start, restoreTime;
+	fmi2_byte_t* buf;
+	fmi2_FMU_state_t state = 0;
+	fmi2_status_t fmistatus;
+	FILE* f = fopen(fileName, "rb");
+
+	if(!f) {
+		jm_log_verbose(cb, fmu_checker_module, "No cached FMU state in %s", fileName);
+		return 0;
+	}
+	if((fread(magic, 1, sizeof(magic), f) != sizeof(magic)) ||
+		(memcmp(magic, FMI2_STATE_CACHE_MAGIC, sizeof(magic)) != 0) ||
+		(fread(&fileKey, sizeof(fileKey), 1, f) != 1) || (fileKey != key) ||
+		(fread(&initTime, sizeof(initTime), 1, f) != 1) ||
+		(fread(&size, sizeof(size), 1, f) != 1) || (size == 0) || (size != (size_t)size)) {
+		jm_log_warning(cb, fmu_checker_module, "Ignoring invalid FMU state cache file %s", fileName);
+		fclose(f);
+		return 0;
+	}
+	buf = (fmi2_byte_t*)cb->malloc((size_t)size);
+	if(!buf) {
+		jm_log_warning(cb, fmu_checker_module, "Could not allocate memory for the cached FMU state");
+		fclose(f);
+		return 0;
+	}
+	if(fread(buf, 1, (size_t)size, f) != (size_t)size) {
+		jm_log_warning(cb, fmu_checker_module, "Ignoring truncated FMU state cache file %s", fileName);
+		cb->free(buf);
+		fclose(f);
+		return 0;
+	}
+	fclose(f);
+
+	start = fmu_check_wall_clock();
+	fmistatus = fmi2_import_de_serialize_fmu_state(fmu, buf, (size_t)size, &state);
+	cb->free(buf);
+	if(fmi2_status_ok_or_warning(fmistatus)) {
+		fmistatus = fmi2_import_set_fmu_state(fmu, state);
+		fmi2_import_free_fmu_state(fmu, &state);
+	}
+	restoreTime = fmu_check_wall_clock() - start;
+
+	if(!fmi2_status_ok_or_warning(fmistatus)) {
+		jm_log_warning(cb, fmu_checker_module, "Could not restore the cached FMU state from %s (FMU status: %s)", fileName, fmi2_status_to_string(fmistatus));
+		return -1;
+	}
+	jm_log_info(cb, fmu_checker_module, "Restored the FMU state from %s in %g s instead of initializing (initialization took %g s when the state was saved)",
+		fileName, restoreTime, initTime);
+	return 1;
+}
+
+/** Save the state of the just initialized FMU in the cache file */
+static void fmi2_state_cache_save(fmu_check_data_t* cdata, const char* fileName, unsigned long long key, double initTime) {
+	jm_callbacks* cb = &cdata->callbacks;
+	fmi2_import_t* fmu = cdata->fmu2;
+	fmi2_FMU_state_t state = 0;
+	fmi2_byte_t* buf = 0;
+	size_t bufSize = 0;
+	unsigned long long size;
+	char tmpName[MAX_URL_LENGTH];
+	fmi2_status_t fmistatus;
+	FILE* f;
+	int ok;
+
+	fmistatus = fmi2_import_get_fmu_state(fmu, &state);
+	if(fmi2_status_ok_or_warning(fmistatus)) {
+		fmistatus = fmi2_import_serialized_fmu_state_size(fmu, state, &bufSize);
+		if(fmi2_status_ok_or_warning(fmistatus)) {
+			buf = (fmi2_byte_t*)cb->malloc(bufSize ? bufSize : 1);
+			fmistatus = buf ? fmi2_import_serialize_fmu_state(fmu, state, buf, bufSize) : fmi2_status_error;
+		}
+		fmi2_import_free_fmu_state(fmu, &state);
+	}
+	if(!fmi2_status_ok_or_warning(fmistatus) || !bufSize) {
+		jm_log_warning(cb, fmu_checker_module, "Could not serialize the FMU state for the state cache (FMU status: %s)", fmi2_status_to_string(fmistatus));
+		cb->free(buf);
+		return;
+	}
+
+	/* parallel runs may save the same state; the rename makes the file appear complete */
+	jm_snprintf(tmpName, sizeof(tmpName), "%s.%p.tmp", fileName, (void*)cdata);
+	f = fopen(tmpName, "wb");
+	if(!f) {
+		jm_log_warning(cb, fmu_checker_module, "Could not open %s for writing the FMU state", tmpName);
+		cb->free(buf);
+		return;
+	}
+	size = bufSize;
+	ok = (fwrite(FMI2_STATE_CACHE_MAGIC, 1, FMI2_STATE_CACHE_MAGIC_LEN, f) == FMI2_STATE_CACHE_MAGIC_LEN) &&
+		(fwrite(&key, sizeof(key), 1, f) == 1) &&
+		(fwrite(&initTime, sizeof(initTime), 1, f) == 1) &&
+		(fwrite(&size, sizeof(size), 1, f) == 1) &&
+		(fwrite(buf, 1, bufSize, f) == bufSize);
+	ok = (fclose(f) == 0) && ok;
+	cb->free(buf);
+	if(!ok) {
+		jm_log_warning(cb, fmu_checker_module, "Could not write the FMU state to %s", tmpName);
+		remove(tmpName);
+		return;
+	}
+	if(rename(tmpName, fileName) != 0) {
+		/* another run saved the same state first (rename does not replace files on Windows) */
+		remove(tmpName);
+		jm_log_verbose(cb, fmu_checker_module, "FMU state cache file %s was not replaced", fileName);
+		return;
+	}
+	jm_log_info(cb, fmu_checker_module, "Saved the FMU state after initialization (%u bytes) to %s. Initialization took %g s",
+		(unsigned)bufSize, fileName, initTime);
+}
+
+static fmi2_status_t fmi2_set_start_values(fmu_check_data_t* cdata, fmi2_real_t tstart) {
+	fmi2_status_t fmistatus = fmi2_set_inputs(cdata, tstart);
+	if(fmi2_status_ok_or_warning(fmistatus)) {
+		fmistatus = fmi2_set_parameters(cdata);
+	}
+	return fmistatus;
+}
+
+fmi2_status_t fmi2_initialize_fmu(fmu_check_data_t* cdata, fmi2_type_t fmuType, fmi2_boolean_t toleranceControlled, fmi2_real_t relativeTolerance, fmi2_real_t tstart) {
+	jm_callbacks* cb = &cdata->callbacks;
+	fmi2_import_t* fmu = cdata->fmu2;
+	fmi2_status_t fmistatus;
+	char fileName[MAX_URL_LENGTH];
+	unsigned long long key = 0;
+	int useCache = 0;
+	double start, initTime;
+
+	fmistatus = fmi2_set_start_values(cdata, tstart);
+	if(!fmi2_status_ok_or_warning(fmistatus)) return fmistatus;
+
+	if(cdata->stateCacheDir) {
+		int isME = (fmuType == fmi2_model_exchange);
+		if(fmi2_import_get_capability(fmu, isME ? fmi2_me_canGetAndSetFMUstate : fmi2_cs_canGetAndSetFMUstate) &&
+			fmi2_import_get_capability(fmu, isME ? fmi2_me_canSerializeFMUstate : fmi2_cs_canSerializeFMUstate)) {
+			int restored;
+			useCache = 1;
+			key = fmi2_state_cache_key(cdata, fmuType, toleranceControlled, relativeTolerance, tstart);
+			jm_snprintf(fileName, sizeof(fileName), "%s" FMI_FILE_SEP "%08lx%08lx.fmu2state", cdata->stateCacheDir,
+				(unsigned long)(key >> 32), (unsigned long)(key & 0xFFFFFFFFUL));
+			restored = fmi2_state_cache_restore(cdata, fileName, key);
+			if(restored > 0) return fmi2_status_ok;
+			if(restored < 0) {
+				/* the instance may be left in any state; start over from the beginning */
+				fmistatus = fmi2_import_reset(fmu);
+				if(fmi2_status_ok_or_warning(fmistatus)) {
+					fmistatus = fmi2_set_start_values(cdata, tstart);
+				}
+				if(!fmi2_status_ok_or_warning(fmistatus)) return fmistatus;
+			}
+		}
+		else {
+			jm_log_info(cb, fmu_checker_module, "The FMU cannot serialize its state. The state cache is not used.");
+		}
+	}
+
+	start = fmu_check_wall_clock();
+	fmu_check_watch(cdata, "fmi2SetupExperiment/fmi2EnterInitializationMode/fmi2ExitInitializationMode", tstart);
+	if( fmi2_status_ok_or_warning(fmistatus = fmi2_import_setup_experiment(fmu, toleranceControlled, relativeTolerance, tstart, fmi2_false, 0.0)) &&
+		fmi2_status_ok_or_warning(fmistatus = fmi2_import_enter_initialization_mode(fmu))) {
+		fmistatus = fmi2_import_exit_initialization_mode(fmu);
+	}
+	fmu_check_watch_end(cdata);
+	if(fmi2_status_ok_or_warning(fmistatus)) {
+		initTime = fmu_check_wall_clock() - start;
+		jm_log_verbose(cb, fmu_checker_module, "Initialization took %g s", initTime);
+		if(useCache) {
+			fmi2_state_cache_save(cdata, fileName, key, initTime);
+		}
+	}
+	return fmistatus;
+}
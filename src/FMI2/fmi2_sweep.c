@@ -0,0 +1,618 @@
+/*
+    Copyright (C) 2012 Modelon AB <http://www.modelon.com>
+
+	You should have received a copy of the LICENSE-FMUChecker.txt
+    along with this program. If not, contact Modelon AB.
+*/
+/**
+	\file fmi2_sweep.c
+	Parameter sweep for FMI 2.0 FMUs (--sweep option).
+
+	The FMU is unpacked and its XML is parsed once. Each worker loads the
+	binary once and keeps its FMU instance between the runs. The instance is
+	reset with fmi2Reset before the next parameter set is applied. Several
+	workers run in parallel unless the FMU can only be instantiated once per
+	process. The result of run N is written to <base>_N<ext> where <base><ext>
+	is the output file name given with -o.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <JM/jm_vector.h>
+#include <fmuChecker.h>
+#include <fmilib.h>
+
+typedef struct fmi2_sweep_t {
+	fmu_check_data_t* cdata;
+	jm_callbacks* cb;
+	fmi2_param_sets_t params;
+	/** ME or CS */
+	fmi2_fmu_kind_enu_t kind;
+	/** Checker data of the workers. The first worker uses the main checker data. */
+	fmu_check_data_t** workers;
+	size_t numWorkers;
+	/** Protects nextRun */
+	fmu_check_mutex_t lock;
+	size_t nextRun;
+	/** Outcome and wall clock time of each run */
+	jm_status_enu_t* runStatus;
+	double* runTime;
+} fmi2_sweep_t;
+
+fmi2_status_t fmi2_set_parameters(fmu_check_data_t* cdata) {
+	const fmi2_param_sets_t* p = cdata->fmu2_params;
+	size_t k = cdata->fmu2_param_set;
+	fmi2_status_t fmistatus = fmi2_status_ok;
+
+	if(!p) return fmi2_status_ok;
+
+	if(p->numReal) {
+		fmistatus = fmi2_import_set_real(cdata->fmu2, p->realVr, p->numReal, p->realValues + k * p->numReal);
+	}
+	if(fmi2_status_ok_or_warning(fmistatus) && p->numInt) {
+		fmistatus = fmi2_import_set_integer(cdata->fmu2, p->intVr, p->numInt, p->intValues + k * p->numInt);
+	}
+	if(fmi2_status_ok_or_warning(fmistatus) && p->numBool) {
+		fmistatus = fmi2_import_set_boolean(cdata->fmu2, p->boolVr, p->numBool, p->boolValues + k * p->numBool);
+	}
+	if(!fmi2_status_ok_or_warning(fmistatus)) {
+		jm_log_error(&cdata->callbacks, fmu_checker_module, "Could not set the values of parameter set %u (FMU status: %s)",
+			(unsigned)(k + 1), fmi2_status_to_string(fmistatus));
+	}
+	return fmistatus;
+}
+
+jm_status_enu_t fmi2_instantiate_or_reset(fmu_check_data_t* cdata, fmi2_string_t instanceName, fmi2_type_t fmuType, fmi2_boolean_t visible) {
+	jm_status_enu_t jmstatus;
+
+	if(cdata->fmu2_instance_alive) {
+		fmi2_status_t fmistatus;
+		fmu_check_watch(cdata, "fmi2Reset", 0);
+		fmistatus = fmi2_import_reset(cdata->fmu2);
+		fmu_check_watch_end(cdata);
+		cdata->fmu2_instance_alive = 0;
+		if(fmi2_status_ok_or_warning(fmistatus)) {
+			return jm_status_success;
+		}
+		if(fmistatus == fmi2_status_fatal) {
+			jm_log_fatal(&cdata->callbacks, fmu_checker_module, "fmi2Reset returned status: %s", fmi2_status_to_string(fmistatus));
+			return jm_status_error;
+		}
+		jm_log_error(&cdata->callbacks, fmu_checker_module, "fmi2Reset returned status: %s. Creating a new instance.", fmi2_status_to_string(fmistatus));
+		fmi2_import_free_instance(cdata->fmu2);
+	}
+
+	if(fmu_check_unpack_wait(cdata, fmu_check_unpack_resources) != jm_status_success) {
+		return jm_status_error;
+	}
+	cdata->instanceNameToCompare = instanceName;
+	cdata->instanceNameSavedPtr = 0;
+
+	fmu_check_watch(cdata, "fmi2Instantiate", 0);
+	jmstatus = fmi2_import_instantiate(cdata->fmu2, instanceName, fmuType, 0, visible);
+	fmu_check_watch_end(cdata);
+
+	cdata->instanceNameSavedPtr = instanceName;
+	return jmstatus;
+}
+
+/* Split the line starting at *cur into fields and advance *cur to the next line.
+   Fields are zero terminated in place. Quoted fields may contain the separator
+   and doubled quotes. Returns 0 if a quoted field is not terminated properly. */
+static int fmi2_sweep_split_line(char** cur, char sep, jm_vector(jm_voidp)* fields) {
+	char* s = *cur;
+
+	jm_vector_resize(jm_voidp)(fields, 0);
+	for(;;) {
+		char *field, *end, ch;
+		while(((*s == ' ') || (*s == '\t')) && (*s != sep)) s++;
+		if(*s == '"') {
+			field = end = ++s;
+			for(;;) {
+				if(!*s) return 0;
+				if(*s == '"') {
+					if(s[1] != '"') break;
+					s++;
+				}
+				*end++ = *s++;
+			}
+			s++;
+			while(((*s == ' ') || (*s == '\t')) && (*s != sep)) s++;
+		}
+		else {
+			field = s;
+			while(*s && (*s != sep) && (*s != '\n') && (*s != '\r')) s++;
+			end = s;
+			while((end > field) && ((end[-1] == ' ') || (end[-1] == '\t'))) end--;
+		}
+		ch = *s;
+		*end = 0;
+		if(!jm_vector_push_back(jm_voidp)(fields, field)) return 0;
+		if(ch == sep) {
+			s++;
+			continue;
+		}
+		if(ch == '\r') {
+			s++;
+			if(*s == '\n') s++;
+		}
+		else if(ch == '\n') {
+			s++;
+		}
+		else if(ch != 0) {
+			return 0;
+		}
+		break;
+	}
+	*cur = s;
+	return 1;
+}
+
+/* Read the whole file into a zero terminated buffer in the arena */
+static char* fmi2_sweep_read_file(fmu_check_data_t* cdata, const char* fname) {
+	FILE* file = fopen(fname, "rb");
+	char* buf = 0;
+	long size;
+
+	if(!file) return 0;
+	if((fseek(file, 0, SEEK_END) == 0) && ((size = ftell(file)) >= 0) && (fseek(file, 0, SEEK_SET) == 0)) {
+		buf = (char*)fmu_check_arena_alloc(&cdata->arena, (size_t)size + 1);
+		if(buf && (fread(buf, 1, (size_t)size, file) == (size_t)size)) {
+			buf[size] = 0;
+		}
+		else {
+			buf = 0;
+		}
+	}
+	fclose(file);
+	return buf;
+}
+
+static int fmi2_sweep_parse_value(fmi2_base_type_enu_t type, const char* str, double* realValue, int* intValue) {
+	char* end;
+	switch(type) {
+	case fmi2_base_type_real:
+		*realValue = strtod(str, &end);
+		return (end != str) && !*end;
+	case fmi2_base_type_int:
+	case fmi2_base_type_enum:
+		*intValue = (int)strtol(str, &end, 10);
+		return (end != str) && !*end;
+	case fmi2_base_type_bool:
+		if((strcmp(str, "1") == 0) || (strcmp(str, "true") == 0)) {
+			*intValue = fmi2_true;
+			return 1;
+		}
+		if((strcmp(str, "0") == 0) || (strcmp(str, "false") == 0)) {
+			*intValue = fmi2_false;
+			return 1;
+		}
+		return 0;
+	default:
+		return 0;
+	}
+}
+
+/* Read the parameter file. The first line gives the variable names, each
+   following non-empty line is one parameter set. */
+static jm_status_enu_t fmi2_sweep_read_params(fmi2_sweep_t* sweep) {
+	fmu_check_data_t* cdata = sweep->cdata;
+	jm_callbacks* cb = sweep->cb;
+	const char* fname = cdata->sweepFileName;
+	fmi2_param_sets_t* p = &sweep->params;
+	jm_vector(jm_voidp) fields;
+	jm_vector(double) realValues;
+	jm_vector(int) intValues;
+	jm_vector(int) boolValues;
+	fmi2_import_variable_t** columns = 0;
+	size_t numColumns = 0, i;
+	unsigned lineNo = 1;
+	char* cur;
+	jm_status_enu_t status = jm_status_success;
+
+	jm_log_info(cb, fmu_checker_module, "Opening parameter file %s", fname);
+	cur = fmi2_sweep_read_file(cdata, fname);
+	if(!cur) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not read parameter file %s", fname);
+		return jm_status_error;
+	}
+
+	jm_vector_init(jm_voidp)(&fields, 0, cb);
+	jm_vector_init(double)(&realValues, 0, cb);
+	jm_vector_init(int)(&intValues, 0, cb);
+	jm_vector_init(int)(&boolValues, 0, cb);
+
+	if(!fmi2_sweep_split_line(&cur, cdata->CSV_separator, &fields)) {
+		jm_log_fatal(cb, fmu_checker_module, "%s:1: could not parse the variable names", fname);
+		status = jm_status_error;
+	}
+	else {
+		numColumns = jm_vector_get_size(jm_voidp)(&fields);
+		columns = (fmi2_import_variable_t**)fmu_check_arena_calloc(&cdata->arena, numColumns, sizeof(fmi2_import_variable_t*));
+		if(!columns) {
+			jm_log_fatal(cb, fmu_checker_module, "Could not allocate memory");
+			status = jm_status_error;
+		}
+	}
+	for(i = 0; (i < numColumns) && (status == jm_status_success); i++) {
+		const char* name = (const char*)jm_vector_get_item(jm_voidp)(&fields, i);
+		fmi2_import_variable_t* v = fmi2_import_get_variable_by_name(cdata->fmu2, name);
+		fmi2_causality_enu_t causality;
+
+		if(!v) {
+			jm_log_fatal(cb, fmu_checker_module, "%s:1: variable '%s' not found in the model description", fname, name);
+			status = jm_status_error;
+			break;
+		}
+		causality = fmi2_import_get_causality(v);
+		if(((causality != fmi2_causality_enu_parameter) && (causality != fmi2_causality_enu_input))
+			|| (fmi2_import_get_variability(v) == fmi2_variability_enu_constant)) {
+			jm_log_fatal(cb, fmu_checker_module, "%s:1: variable '%s' is not a parameter or an input", fname, name);
+			status = jm_status_error;
+			break;
+		}
+		switch(fmi2_import_get_variable_base_type(v)) {
+		case fmi2_base_type_real:
+			p->numReal++;
+			break;
+		case fmi2_base_type_int:
+		case fmi2_base_type_enum:
+			p->numInt++;
+			break;
+		case fmi2_base_type_bool:
+			p->numBool++;
+			break;
+		default:
+			jm_log_fatal(cb, fmu_checker_module, "%s:1: variable '%s' has type %s, which is not supported in parameter sweeps",
+				fname, name, fmi2_base_type_to_string(fmi2_import_get_variable_base_type(v)));
+			status = jm_status_error;
+			break;
+		}
+		columns[i] = v;
+	}
+
+	while((status == jm_status_success) && *cur) {
+		lineNo++;
+		if((*cur == '\n') || (*cur == '\r')) {
+			if((cur[0] == '\r') && (cur[1] == '\n')) cur++;
+			cur++;
+			continue;
+		}
+		if(!fmi2_sweep_split_line(&cur, cdata->CSV_separator, &fields)) {
+			jm_log_fatal(cb, fmu_checker_module, "%s:%u: could not parse the line", fname, lineNo);
+			status = jm_status_error;
+			break;
+		}
+		if(jm_vector_get_size(jm_voidp)(&fields) != numColumns) {
+			jm_log_fatal(cb, fmu_checker_module, "%s:%u: expected %u value(s) but found %u",
+				fname, lineNo, (unsigned)numColumns, (unsigned)jm_vector_get_size(jm_voidp)(&fields));
+			status = jm_status_error;
+			break;
+		}
+		for(i = 0; i < numColumns; i++) {
+			const char* str = (const char*)jm_vector_get_item(jm_voidp)(&fields, i);
+			fmi2_base_type_enu_t type = fmi2_import_get_variable_base_type(columns[i]);
+			double realValue = 0;
+			int intValue = 0, ok;
+
+			if(!fmi2_sweep_parse_value(type, str, &realValue, &intValue)) {
+				jm_log_fatal(cb, fmu_checker_module, "%s:%u: could not parse value '%s' for variable '%s'",
+					fname, lineNo, str, fmi2_import_get_variable_name(columns[i]));
+				status = jm_status_error;
+				break;
+			}
+			if(type == fmi2_base_type_real)
+				ok = jm_vector_push_back(double)(&realValues, realValue) != 0;
+			else if(type == fmi2_base_type_bool)
+				ok = jm_vector_push_back(int)(&boolValues, intValue) != 0;
+			else
+				ok = jm_vector_push_back(int)(&intValues, intValue) != 0;
+			if(!ok) {
+				jm_log_fatal(cb, fmu_checker_module, "Could not allocate memory");
+				status = jm_status_error;
+				break;
+			}
+		}
+		p->numSets++;
+	}
+
+	if((status == jm_status_success) && !p->numSets) {
+		jm_log_fatal(cb, fmu_checker_module, "No parameter sets found in %s", fname);
+		status = jm_status_error;
+	}
+	if(status == jm_status_success) {
+		/* copy the values to arrays suitable for the fmi2SetXXX calls */
+		size_t r = 0, n = 0, b = 0;
+		fmu_check_arena_t* arena = &cdata->arena;
+		p->realVr = (fmi2_value_reference_t*)fmu_check_arena_calloc(arena, p->numReal, sizeof(fmi2_value_reference_t));
+		p->intVr = (fmi2_value_reference_t*)fmu_check_arena_calloc(arena, p->numInt, sizeof(fmi2_value_reference_t));
+		p->boolVr = (fmi2_value_reference_t*)fmu_check_arena_calloc(arena, p->numBool, sizeof(fmi2_value_reference_t));
+		p->realValues = (fmi2_real_t*)fmu_check_arena_calloc(arena, p->numSets * p->numReal, sizeof(fmi2_real_t));
+		p->intValues = (fmi2_integer_t*)fmu_check_arena_calloc(arena, p->numSets * p->numInt, sizeof(fmi2_integer_t));
+		p->boolValues = (fmi2_boolean_t*)fmu_check_arena_calloc(arena, p->numSets * p->numBool, sizeof(fmi2_boolean_t));
+		if(!p->realVr || !p->intVr || !p->boolVr || !p->realValues || !p->intValues || !p->boolValues) {
+			jm_log_fatal(cb, fmu_checker_module, "Could not allocate memory");
+			status = jm_status_error;
+		}
+		for(i = 0; (i < numColumns) && (status == jm_status_success); i++) {
+			fmi2_value_reference_t vr = fmi2_import_get_variable_vr(columns[i]);
+			switch(fmi2_import_get_variable_base_type(columns[i])) {
+			case fmi2_base_type_real: p->realVr[r++] = vr; break;
+			case fmi2_base_type_bool: p->boolVr[b++] = vr; break;
+			default: p->intVr[n++] = vr; break;
+			}
+		}
+		for(i = 0; (i < p->numSets * p->numReal) && (status == jm_status_success); i++) {
+			p->realValues[i] = jm_vector_get_item(double)(&realValues, i);
+		}
+		for(i = 0; (i < p->numSets * p->numInt) && (status == jm_status_success); i++) {
+			p->intValues[i] = jm_vector_get_item(int)(&intValues, i);
+		}
+		for(i = 0; (i < p->numSets * p->numBool) && (status == jm_status_success); i++) {
+			p->boolValues[i] = jm_vector_get_item(int)(&boolValues, i);
+		}
+	}
+	if(status == jm_status_success) {
+		jm_log_info(cb, fmu_checker_module, "Read %u parameter set(s) with %u variable(s)", (unsigned)p->numSets, (unsigned)numColumns);
+	}
+
+	jm_vector_free_data(jm_voidp)(&fields);
+	jm_vector_free_data(double)(&realValues);
+	jm_vector_free_data(int)(&intValues);
+	jm_vector_free_data(int)(&boolValues);
+	return status;
+}
+
+/* Read the input data and load the FMU binary for a worker */
+static jm_status_enu_t fmi2_sweep_init_worker(fmi2_sweep_t* sweep, fmu_check_data_t* w) {
+	if((fmi2_init_input_data(&w->fmu2_inputData, &w->callbacks, w->fmu2) != jm_status_success)
+        || (fmi2_read_input_file(w) != jm_status_success)) {
+		return jm_status_error;
+	}
+	if(fmi2_check_load_dll(w, sweep->kind) != jm_status_success) {
+		return jm_status_error;
+	}
+	w->fmu2_params = &sweep->params;
+	w->fmu2_reuse_instance = 1;
+	return jm_status_success;
+}
+
+/* Set up an additional worker using the FMU unpacked by the main checker data */
+static jm_status_enu_t fmi2_sweep_load_worker(fmi2_sweep_t* sweep, fmu_check_data_t* w) {
+	fmu_check_data_t* cdata = sweep->cdata;
+	jm_callbacks* cb = &w->callbacks;
+
+	w->FMUPath = cdata->FMUPath;
+	/* shared with the main checker data, reset before the worker is cleared */
+	w->tmpPath = cdata->tmpPath;
+	w->unzipPath = cdata->unzipPath;
+	w->inputFileName = cdata->inputFileName;
+	w->version = cdata->version;
+
+	w->context = fmi_import_allocate_context(cb);
+	if(!w->context) return jm_status_error;
+	fmi_import_set_configuration(w->context, FMI_IMPORT_NAME_CHECK);
+
+	w->fmu2 = fmi2_import_parse_xml(w->context, w->tmpPath, 0);
+	if(!w->fmu2) {
+		jm_log_fatal(cb, fmu_checker_module, "Error parsing XML, exiting");
+		return jm_status_error;
+	}
+	w->modelName = fmi2_import_get_model_name(w->fmu2);
+	w->GUID = fmi2_import_get_GUID(w->fmu2);
+	w->fmu2_kind = fmi2_import_get_fmu_kind(w->fmu2);
+	w->vl2 = fmi2_import_get_variable_list(w->fmu2, 0);
+	if(!w->vl2) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not construct model variables list");
+		return jm_status_error;
+	}
+	/* the value references are the same in all the workers. The plan stays valid
+	   since the main checker data is cleared after the workers. */
+	w->fmu2_columns = cdata->fmu2_columns;
+	return fmi2_sweep_init_worker(sweep, w);
+}
+
+/* <base>_<run><ext> for the output file name <base><ext>. A compression suffix is kept: result.csv.gz gives result_1.csv.gz */
+static void fmi2_sweep_output_file_name(const char* outName, size_t run, char* buf, size_t bufSize) {
+	const char* end = outName + strlen(outName);
+	const char* ext = 0;
+	const char* slash = strrchr(outName, '/');
+	const char* backslash = strrchr(outName, '\\');
+	const char* cur;
+
+	switch(fmu_check_stream_kind(outName)) {
+	case fmu_check_stream_gzip: end -= 3; break;
+	case fmu_check_stream_zstd: end -= 4; break;
+	default: break;
+	}
+	for(cur = outName; cur < end; cur++) {
+		if(*cur == '.') ext = cur;
+	}
+	if(ext && ((slash && (ext < slash)) || (backslash && (ext < backslash)))) ext = 0;
+	if(!ext) ext = end;
+	jm_snprintf(buf, bufSize, "%.*s_%u%s", (int)(ext - outName), outName, (unsigned)run, ext);
+}
+
+static void fmi2_sweep_run(fmi2_sweep_t* sweep, fmu_check_data_t* w, size_t run) {
+	jm_callbacks* cb = &w->callbacks;
+	fmu_check_arena_mark_t mark;
+	char fileName[MAX_URL_LENGTH];
+	jm_status_enu_t status;
+	double start = fmu_check_wall_clock();
+
+	fmi2_sweep_output_file_name(sweep->cdata->output_file_name, run + 1, fileName, sizeof(fileName));
+	if(fmu_check_open_output(w, fileName) != jm_status_success) {
+		jm_log_error(cb, fmu_checker_module, "Run %u: could not open %s for writing", (unsigned)(run + 1), fileName);
+		sweep->runStatus[run] = jm_status_error;
+		return;
+	}
+	jm_log_verbose(cb, fmu_checker_module, "Run %u: writing simulation output to %s", (unsigned)(run + 1), fileName);
+
+	w->fmu2_param_set = run;
+	w->nextOutputTime = 0.0;
+	w->nextOutputStep = 0;
+	fmi2_rewind_input_data(&w->fmu2_inputData);
+
+	/* buffers allocated by the simulation are released after each run */
+	fmu_check_arena_mark(&w->arena, &mark);
+	status = fmi2_write_csv_header(w);
+	if(status == jm_status_success) {
+		status = (sweep->kind == fmi2_fmu_kind_me) ? fmi2_me_simulate(w) : fmi2_cs_simulate(w);
+	}
+	fmu_check_arena_release(&w->arena, &mark);
+	/* the output buffers were allocated after the mark */
+	memset(&w->fmu2_row, 0, sizeof(w->fmu2_row));
+	memset(&w->fmu2_resample, 0, sizeof(w->fmu2_resample));
+
+	if(fmu_check_close_output(w) != jm_status_success) {
+		status = jm_status_error;
+	}
+
+	sweep->runTime[run] = fmu_check_wall_clock() - start;
+	sweep->runStatus[run] = status;
+	jm_log_info(cb, fmu_checker_module, "Run %u %s in %g s", (unsigned)(run + 1),
+		(status == jm_status_error) ? "failed" : "finished", sweep->runTime[run]);
+}
+
+/* Thread pool task: a worker takes the next parameter set until all are done */
+static void fmi2_sweep_worker_task(void* data, size_t index) {
+	fmi2_sweep_t* sweep = (fmi2_sweep_t*)data;
+	fmu_check_data_t* w = sweep->workers[index];
+
+	for(;;) {
+		size_t run;
+		fmu_check_mutex_lock(&sweep->lock);
+		run = sweep->nextRun++;
+		fmu_check_mutex_unlock(&sweep->lock);
+		if(run >= sweep->params.numSets) break;
+		fmi2_sweep_run(sweep, w, run);
+	}
+}
+
+jm_status_enu_t fmi2_sweep_check(fmu_check_data_t* cdata) {
+	fmi2_sweep_t sweep;
+	jm_callbacks* cb = &cdata->callbacks;
+	jm_status_enu_t status;
+	fmu_check_thread_pool_t* pool = 0;
+	size_t i, numWorkers, numFailed = 0;
+	int oncePerProcess;
+	double wallStart, wallTime, runTimeSum = 0, runTimeMax = 0;
+
+	if(!cdata->do_simulate_flg) {
+		jm_log_verbose(cb, fmu_checker_module,"Simulation was not requested");
+		return jm_status_success;
+	}
+
+	memset(&sweep, 0, sizeof(sweep));
+	sweep.cdata = cdata;
+	sweep.cb = cb;
+
+	/* ME is used unless only CS is requested or supported */
+	if(cdata->require_cs && !cdata->require_me)
+		sweep.kind = fmi2_fmu_kind_cs;
+	else if(cdata->require_me || (cdata->fmu2_kind & fmi2_fmu_kind_me))
+		sweep.kind = fmi2_fmu_kind_me;
+	else
+		sweep.kind = fmi2_fmu_kind_cs;
+	if((cdata->fmu2_kind & sweep.kind) == 0) {
+		jm_log_fatal(cb, fmu_checker_module, "Parameter sweep with %s requested but the FMU kind is %s",
+			fmi2_fmu_kind_to_string(sweep.kind), fmi2_fmu_kind_to_string(cdata->fmu2_kind));
+		return jm_status_error;
+	}
+
+	status = fmi2_sweep_read_params(&sweep);
+	if(status != jm_status_success) {
+		return status;
+	}
+
+	oncePerProcess = fmi2_import_get_capability(cdata->fmu2, (sweep.kind == fmi2_fmu_kind_me) ?
+		fmi2_me_canBeInstantiatedOnlyOncePerProcess : fmi2_cs_canBeInstantiatedOnlyOncePerProcess);
+	numWorkers = cdata->num_threads ? cdata->num_threads : fmu_check_get_num_cpus();
+	if(numWorkers > sweep.params.numSets) numWorkers = sweep.params.numSets;
+	if(oncePerProcess && (numWorkers > 1)) {
+		jm_log_info(cb, fmu_checker_module, "FMU can only be instantiated once per process. Parameter sets are simulated one at a time.");
+		numWorkers = 1;
+	}
+
+	sweep.workers = (fmu_check_data_t**)fmu_check_arena_calloc(&cdata->arena, numWorkers, sizeof(fmu_check_data_t*));
+	sweep.runStatus = (jm_status_enu_t*)fmu_check_arena_calloc(&cdata->arena, sweep.params.numSets, sizeof(jm_status_enu_t));
+	sweep.runTime = (double*)fmu_check_arena_calloc(&cdata->arena, sweep.params.numSets, sizeof(double));
+	if(numWorkers > 1) {
+		/* lets the FMU logger find the checker data from the component environment */
+		cdata->instance_data = (fmu_check_data_t**)fmu_check_arena_calloc(&cdata->arena, numWorkers - 1, sizeof(fmu_check_data_t*));
+	}
+	if(!sweep.workers || !sweep.runStatus || !sweep.runTime || ((numWorkers > 1) && !cdata->instance_data)) {
+		jm_log_fatal(cb, fmu_checker_module, "Could not allocate memory");
+		return jm_status_error;
+	}
+
+	sweep.workers[0] = cdata;
+	sweep.numWorkers = 1;
+	status = fmi2_sweep_init_worker(&sweep, cdata);
+	for(i = 1; (i < numWorkers) && (status == jm_status_success); i++) {
+		fmu_check_data_t* w = (fmu_check_data_t*)fmu_check_arena_calloc(&cdata->arena, 1, sizeof(fmu_check_data_t));
+		if(!w) {
+			jm_log_fatal(cb, fmu_checker_module, "Could not allocate memory");
+			status = jm_status_error;
+			break;
+		}
+		init_fmu_check_child_data(w, cdata);
+		sweep.workers[i] = w;
+		sweep.numWorkers = i + 1;
+		cdata->instance_data[i - 1] = w;
+		cdata->num_instance_data = i;
+		status = fmi2_sweep_load_worker(&sweep, w);
+	}
+
+	if(status == jm_status_success) {
+		pool = fmu_check_thread_pool_create(cb, numWorkers);
+		if(!pool) {
+			jm_log_fatal(cb, fmu_checker_module, "Could not create the thread pool");
+			status = jm_status_error;
+		}
+	}
+	if(status == jm_status_success) {
+		jm_log_info(cb, fmu_checker_module, "Simulating %u parameter set(s) (%s) with %u FMU instance(s)",
+			(unsigned)sweep.params.numSets, fmi2_fmu_kind_to_string(sweep.kind), (unsigned)numWorkers);
+
+		fmu_check_mutex_init(&sweep.lock);
+		wallStart = fmu_check_wall_clock();
+		fmu_check_thread_pool_run(pool, fmi2_sweep_worker_task, &sweep, numWorkers);
+		wallTime = fmu_check_wall_clock() - wallStart;
+		fmu_check_mutex_destroy(&sweep.lock);
+
+		for(i = 0; i < sweep.params.numSets; i++) {
+			if(sweep.runStatus[i] == jm_status_error) numFailed++;
+			runTimeSum += sweep.runTime[i];
+			if(sweep.runTime[i] > runTimeMax) runTimeMax = sweep.runTime[i];
+		}
+		jm_log_info(cb, fmu_checker_module, "%u run(s) using %u thread(s) took %g s (%g s per run on average, %g s max)",
+			(unsigned)sweep.params.numSets, (unsigned)fmu_check_thread_pool_size(pool), wallTime,
+			runTimeSum / sweep.params.numSets, runTimeMax);
+		if(numFailed) {
+			jm_log_error(cb, fmu_checker_module, "Simulation failed for %u of %u parameter set(s)",
+				(unsigned)numFailed, (unsigned)sweep.params.numSets);
+			status = jm_status_error;
+		}
+	}
+	fmu_check_thread_pool_free(pool);
+
+	for(i = 0; i < sweep.numWorkers; i++) {
+		fmu_check_data_t* w = sweep.workers[i];
+		if(w->fmu2_instance_alive) {
+			fmi2_import_free_instance(w->fmu2);
+			w->fmu2_instance_alive = 0;
+		}
+		w->fmu2_params = 0;
+		w->fmu2_reuse_instance = 0;
+		if(i > 0) {
+			w->tmpPath = 0;
+			clear_fmu_check_child_data(w, cdata);
+		}
+	}
+	cdata->instance_data = 0;
+	cdata->num_instance_data = 0;
+	return status;
+}